@@ -0,0 +1,289 @@
+/*
+ * File: ai.c
+ * Author: [Your Name]
+ * Date: October 17, 2026
+ * Description: Computer opponent for Mini Battleship (see ai.h)
+ */
+
+#include <string.h>
+#include "ai.h"
+
+#define PLACE_TRIES 64              // random positions tried per ship before scanning for one
+#define FLEET_TRIES 16              // fresh starts before falling back to a packed layout
+#define LINE_MAX (PROTO_MAX_ROWS > PROTO_MAX_COLS ? PROTO_MAX_ROWS : PROTO_MAX_COLS)
+
+// What the attacker knows of a cell
+typedef enum {
+    VIEW_UNKNOWN,               // not fired at
+    VIEW_HIT,                   // hit, on a ship still afloat
+    VIEW_BLOCKED                // a miss, or part of a sunk ship: no ship afloat lies here
+} view_cell_t;
+
+static const char* level_names[AI_LEVELS] = { "easy", "normal", "hard" };
+
+int ai_parse_level(const char* text, size_t length) {
+    for (int level = 0; level < AI_LEVELS; level++) {
+        const char* name = level_names[level];
+        if (strlen(name) != length) continue;
+        size_t i = 0;
+        while (i < length && (text[i] | 0x20) == name[i]) i++;
+        if (i == length) return level;
+    }
+    return -1;
+}
+
+const char* ai_level_name(ai_level_t level) {
+    return level >= 0 && level < AI_LEVELS ? level_names[level] : "unknown";
+}
+
+uint64_t ai_seed(uint64_t seed) {
+    // splitmix64, which never maps two seeds to the same state
+    uint64_t z = seed + 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    z ^= z >> 31;
+    return z != 0 ? z : 1;
+}
+
+uint64_t ai_random(uint64_t* state) {
+    uint64_t x = *state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return x * 0x2545F4914F6CDD1DULL;
+}
+
+static int random_below(uint64_t* rng, int limit) {
+    return (int)((ai_random(rng) >> 32) % (uint64_t)limit);
+}
+
+// Places the next ship at a random position it fits, trying positions at
+// random first and then every one from a random start. Returns 0 if it
+// fits nowhere.
+static int place_ship(board_state_t* board, const board_config_t* config, uint64_t* rng) {
+    for (int i = 0; i < PLACE_TRIES; i++) {
+        int row = random_below(rng, config->rows);
+        int col = random_below(rng, config->cols);
+        int horizontal = random_below(rng, 2);
+        if (board_can_place(board, config, row, col, horizontal)) {
+            board_place(board, config, row, col, horizontal);
+            return 1;
+        }
+    }
+    
+    int positions = 2 * config->rows * config->cols;
+    int start = random_below(rng, positions);
+    for (int i = 0; i < positions; i++) {
+        int position = (start + i) % positions;
+        int cell = position / 2;
+        int horizontal = position & 1;
+        if (board_can_place(board, config, cell / config->cols, cell % config->cols, horizontal)) {
+            board_place(board, config, cell / config->cols, cell % config->cols, horizontal);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Lays the fleet out all across (or all down) in the first-fit packing
+// board_config_check() accepts fleets by. Returns 0 if it does not fit.
+static int pack_fleet(board_state_t* board, const board_config_t* config, int horizontal) {
+    int lines = horizontal ? config->rows : config->cols;
+    int line_length = horizontal ? config->cols : config->rows;
+    int order[PROTO_MAX_FLEET];
+    int line[PROTO_MAX_FLEET];
+    int offset[PROTO_MAX_FLEET];
+    int used[LINE_MAX];
+    
+    for (int i = 0; i < config->ship_count; i++) {
+        order[i] = i;
+    }
+    for (int i = 1; i < config->ship_count; i++) {
+        for (int j = i; j > 0 && config->ship_lengths[order[j]] > config->ship_lengths[order[j - 1]]; j--) {
+            int tmp = order[j];
+            order[j] = order[j - 1];
+            order[j - 1] = tmp;
+        }
+    }
+    memset(used, 0, sizeof(used));
+    for (int i = 0; i < config->ship_count; i++) {
+        int ship = order[i];
+        int l = 0;
+        while (l < lines && used[l] + config->ship_lengths[ship] > line_length) l++;
+        if (l == lines) return 0;
+        line[ship] = l;
+        offset[ship] = used[l];
+        used[l] += config->ship_lengths[ship];
+    }
+    
+    board_reset(board, config);
+    for (int ship = 0; ship < config->ship_count; ship++) {
+        int row = horizontal ? line[ship] : offset[ship];
+        int col = horizontal ? offset[ship] : line[ship];
+        board_place(board, config, row, col, horizontal);
+    }
+    return 1;
+}
+
+void ai_place_fleet(board_state_t* board, const board_config_t* config, uint64_t* rng) {
+    // Ships placed early can leave a crowded board no room for the rest;
+    // start over a few times before settling for a packed layout
+    for (int attempt = 0; attempt < FLEET_TRIES; attempt++) {
+        board_reset(board, config);
+        while (!board_fleet_placed(board, config) && place_ship(board, config, rng)) {}
+        if (board_fleet_placed(board, config)) return;
+    }
+    if (!pack_fleet(board, config, 1)) pack_fleet(board, config, 0);
+}
+
+// Adds to density every way a ship of length cells lies along one row or
+// column, count cells from first, stride apart, clear of blocked cells.
+// Each counts weight, and in target mode only ways through hits count,
+// weighted by the square of the hits they cover so that lines of hits
+// are followed. A difference array spreads each way over its cells.
+static void count_line(const unsigned char* view, int first, int stride, int count, int length,
+                       unsigned long weight, int targeting, unsigned long* density) {
+    unsigned long diff[LINE_MAX + 1];
+    int hits[LINE_MAX + 1];
+    int run = 0;
+    int any = 0;
+    
+    memset(diff, 0, (count + 1) * sizeof(diff[0]));
+    hits[0] = 0;
+    for (int k = 0; k < count; k++) {
+        unsigned char cell = view[first + k * stride];
+        hits[k + 1] = hits[k] + (cell == VIEW_HIT);
+        run = cell == VIEW_BLOCKED ? 0 : run + 1;
+        if (run < length) continue;
+        
+        int start = k + 1 - length;
+        unsigned long ways = weight;
+        if (targeting) {
+            unsigned long covered = (unsigned long)(hits[k + 1] - hits[start]);
+            if (covered == 0) continue;
+            ways *= covered * covered;
+        }
+        diff[start] += ways;
+        diff[k + 1] -= ways;
+        any = 1;
+    }
+    if (!any) return;
+    
+    unsigned long sum = 0;
+    for (int k = 0; k < count; k++) {
+        sum += diff[k];
+        density[first + k * stride] += sum;
+    }
+}
+
+// Density of every cell over the ships afloat: afloat[length] of each
+static void count_density(const unsigned char* view, const board_config_t* config, const int* afloat,
+                          int targeting, unsigned long* density) {
+    memset(density, 0, (size_t)config->rows * config->cols * sizeof(density[0]));
+    for (int length = 1; length <= LINE_MAX; length++) {
+        if (afloat[length] == 0) continue;
+        if (length <= config->cols) {
+            for (int row = 0; row < config->rows; row++) {
+                count_line(view, row * config->cols, 1, config->cols, length, afloat[length], targeting, density);
+            }
+        }
+        if (length <= config->rows && length > 1) {
+            for (int col = 0; col < config->cols; col++) {
+                count_line(view, col, config->cols, config->rows, length, afloat[length], targeting, density);
+            }
+        }
+    }
+}
+
+// The unknown cell of highest density on the lattice of cells whose row
+// plus column is a multiple of spacing, ties broken at random; -1 if no
+// such cell has any
+static int densest(const unsigned char* view, const unsigned long* density, const board_config_t* config,
+                   int spacing, uint64_t* rng) {
+    unsigned long best = 0;
+    int choice = -1;
+    int ties = 0;
+    for (int row = 0; row < config->rows; row++) {
+        for (int col = (spacing - row % spacing) % spacing; col < config->cols; col += spacing) {
+            int cell = row * config->cols + col;
+            if (view[cell] != VIEW_UNKNOWN || density[cell] == 0 || density[cell] < best) continue;
+            if (density[cell] > best) {
+                best = density[cell];
+                ties = 0;
+            }
+            // Reservoir sampling: each of the ties so far is kept with equal chance
+            if (random_below(rng, ++ties) == 0) choice = cell;
+        }
+    }
+    return choice;
+}
+
+// A random unknown cell on the lattice of cells whose row plus column is
+// a multiple of spacing, and for neighbours set, next to a hit. -1 if
+// there is none.
+static int random_cell(const unsigned char* view, const board_config_t* config, int spacing,
+                       int neighbours, uint64_t* rng) {
+    int choice = -1;
+    int seen = 0;
+    for (int row = 0; row < config->rows; row++) {
+        for (int col = 0; col < config->cols; col++) {
+            int cell = row * config->cols + col;
+            if (view[cell] != VIEW_UNKNOWN || (row + col) % spacing != 0) continue;
+            if (neighbours &&
+                !(row > 0 && view[cell - config->cols] == VIEW_HIT) &&
+                !(row + 1 < config->rows && view[cell + config->cols] == VIEW_HIT) &&
+                !(col > 0 && view[cell - 1] == VIEW_HIT) &&
+                !(col + 1 < config->cols && view[cell + 1] == VIEW_HIT)) {
+                continue;
+            }
+            if (random_below(rng, ++seen) == 0) choice = cell;
+        }
+    }
+    return choice;
+}
+
+int ai_choose_attack(const board_state_t* enemy, const board_config_t* config, ai_level_t level,
+                     uint64_t* rng) {
+    int cells = config->rows * config->cols;
+    unsigned char view[PROTO_MAX_CELLS];
+    unsigned long density[PROTO_MAX_CELLS];
+    int afloat[LINE_MAX + 1];
+    int open_hits = 0;
+    int shortest = LINE_MAX;
+    
+    // The board as its attacker sees it; ships still unseen read as water
+    board_cells(view, enemy, config, 0);
+    for (int cell = 0; cell < cells; cell++) {
+        view[cell] = view[cell] == HIT ? VIEW_HIT : view[cell] == MISS ? VIEW_BLOCKED : VIEW_UNKNOWN;
+    }
+    memset(afloat, 0, sizeof(afloat));
+    for (int i = 0; i < enemy->ships_placed; i++) {
+        const ship_t* ship = &enemy->fleet[i];
+        if (!ship->sunk) {
+            afloat[ship->length]++;
+            if (ship->length < shortest) shortest = ship->length;
+            continue;
+        }
+        for (int j = 0; j < ship->length; j++) {
+            view[ship->cell + j * ship->stride] = VIEW_BLOCKED;
+        }
+    }
+    for (int cell = 0; cell < cells; cell++) {
+        open_hits += view[cell] == VIEW_HIT;
+    }
+    
+    int choice = -1;
+    if (level == AI_EASY) {
+        if (open_hits > 0) choice = random_cell(view, config, 1, 1, rng);
+    } else if (open_hits > 0 || level == AI_HARD) {
+        count_density(view, config, afloat, open_hits > 0, density);
+        choice = densest(view, density, config, open_hits > 0 ? 1 : shortest, rng);
+    } else {
+        choice = random_cell(view, config, shortest, 0, rng);
+    }
+    
+    // Whatever the level found nothing for, any cell not fired at will do
+    if (choice < 0) choice = random_cell(view, config, 1, 0, rng);
+    return choice;
+}
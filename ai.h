@@ -0,0 +1,65 @@
+/*
+ * File: ai.h
+ * Author: [Your Name]
+ * Date: October 17, 2026
+ * Description: Computer opponent for Mini Battleship
+ *              The bot fires knowing only what a player would: which cells
+ *              of the enemy board it has fired at, which of those were
+ *              hits, and the ships it has sunk. For every cell not fired
+ *              at yet it counts the ways the ships still afloat could lie
+ *              across it (the probability density) and fires at the
+ *              likeliest. While a hit belongs to no sunk ship it is in
+ *              target mode and only counts the ways through such hits,
+ *              so it follows a ship along until it sinks before hunting
+ *              for the next one.
+ *
+ *              The count is a pass per ship length and direction over
+ *              each row or column, with a running length of open cells
+ *              and a difference array, so a move is a few microseconds
+ *              on a 10x10 board. The bot keeps no memory between moves
+ *              besides its random generator, and needs no allocation.
+ *
+ *              Levels:
+ *                EASY    fires at random, then next to its hits
+ *                NORMAL  hunts on a lattice spaced by the shortest ship
+ *                        afloat, then targets by density
+ *                HARD    hunts on that lattice by density, then targets
+ *                        by density
+ */
+
+#ifndef AI_H
+#define AI_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "board.h"
+
+typedef enum {
+    AI_EASY,
+    AI_NORMAL,
+    AI_HARD,
+    AI_LEVELS
+} ai_level_t;
+
+// Parses "easy", "normal" or "hard" in any case; -1 for anything else
+int ai_parse_level(const char* text, size_t length);
+
+// "easy", "normal" or "hard"
+const char* ai_level_name(ai_level_t level);
+
+// A generator state from any seed, zero included
+uint64_t ai_seed(uint64_t seed);
+
+// Next number from the generator (xorshift64*); one state per bot, or per
+// thread, so bots never share one
+uint64_t ai_random(uint64_t* state);
+
+// Places the whole fleet at random on a board with none of it placed
+void ai_place_fleet(board_state_t* board, const board_config_t* config, uint64_t* rng);
+
+// The cell to fire at next on enemy, the opponent's board, using only
+// what its attacker can see of it; -1 if every cell has been fired at
+int ai_choose_attack(const board_state_t* enemy, const board_config_t* config, ai_level_t level,
+                     uint64_t* rng);
+
+#endif
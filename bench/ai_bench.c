@@ -0,0 +1,96 @@
+#define _GNU_SOURCE
+
+/*
+ * File: bench/ai_bench.c
+ * Author: [Your Name]
+ * Date: October 17, 2026
+ * Description: Cost and strength of the computer opponent
+ *              For each board size and level, the bot fires at randomly
+ *              placed fleets until each is sunk. Prints the time per move
+ *              (the cost a bot game adds to the server) and the moves a
+ *              game takes (fewer is stronger; firing at random takes
+ *              nearly every cell).
+ *
+ * Usage: ./ai_bench [seconds per case]
+ *        gcc -Wall -Wextra -std=c99 -pedantic -O2 -o ai_bench bench/ai_bench.c ai.c board.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "../ai.h"
+
+typedef struct {
+    const char* size;
+    const char* fleet;
+} setup_t;
+
+static const setup_t setups[] = {
+    { "4x4", "2" },
+    { "10x10", "5,4,3,3,2" },
+    { "26x26", "5,4,3,3,2,2,2,2,2,2" },
+    { "99x26", "5,4,3,3,2,2,2,2,2,2" }
+};
+
+double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Plays whole games for at least seconds; sets the microseconds per move
+// and the moves per game
+void play_games(const board_config_t* config, ai_level_t level, double seconds,
+                double* move_us, double* game_moves) {
+    board_state_t board;
+    uint64_t rng = ai_seed(level);
+    unsigned long moves = 0, games = 0;
+    double thinking = 0;
+    if (board_init(&board, config) != 0) {
+        *move_us = *game_moves = 0;
+        return;
+    }
+    double start = now_seconds();
+    
+    do {
+        ai_place_fleet(&board, config, &rng);
+        double game_start = now_seconds();
+        while (!board_defeated(&board, config)) {
+            int sunk_length;
+            int cell = ai_choose_attack(&board, config, level, &rng);
+            if (cell < 0) break;
+            board_attack(&board, config, cell / config->cols, cell % config->cols, &sunk_length);
+            moves++;
+        }
+        thinking += now_seconds() - game_start;
+        games++;
+    } while (now_seconds() - start < seconds);
+    board_release(&board);
+    
+    *move_us = thinking * 1e6 / moves;
+    *game_moves = (double)moves / games;
+}
+
+int main(int argc, char* argv[]) {
+    double seconds = argc > 1 ? atof(argv[1]) : 1.0;
+    
+    printf("%-7s %6s %-7s %10s %12s %8s\n", "board", "ships", "level", "move us", "moves/game", "cells");
+    for (size_t s = 0; s < sizeof(setups) / sizeof(setups[0]); s++) {
+        board_config_t config;
+        board_config_default(&config);
+        if (board_config_set_size(&config, setups[s].size) < 0 ||
+            board_config_set_fleet(&config, setups[s].fleet) < 0 || board_config_check(&config) != NULL) {
+            fprintf(stderr, "Bad setup %s / %s\n", setups[s].size, setups[s].fleet);
+            return 1;
+        }
+        
+        for (int level = 0; level < AI_LEVELS; level++) {
+            double move_us, game_moves;
+            play_games(&config, (ai_level_t)level, seconds, &move_us, &game_moves);
+            printf("%-7s %6d %-7s %10.2f %12.1f %8d\n", setups[s].size, config.ship_count,
+                ai_level_name((ai_level_t)level), move_us, game_moves, config.rows * config.cols);
+        }
+    }
+    
+    return 0;
+}
@@ -0,0 +1,176 @@
+#define _GNU_SOURCE
+
+/*
+ * File: bench/board_bench.c
+ * Author: [Your Name]
+ * Date: October 17, 2026
+ * Description: Cost of the board rules and rendering as boards grow
+ *              For each board size, times placement checks, attacks (whole
+ *              games fired cell by cell in random order) and a full text
+ *              frame: both boards flattened and drawn side by side.
+ *
+ * Usage: ./board_bench [seconds per case]
+ *        gcc -Wall -Wextra -std=c99 -pedantic -O2 -o board_bench bench/board_bench.c board.c render.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../board.h"
+#include "../render.h"
+
+#define OUTPUT_SIZE (1 << 20)
+
+typedef struct {
+    const char* size;
+    const char* fleet;
+} setup_t;
+
+static const setup_t setups[] = {
+    { "4x4", "2" },
+    { "10x10", "5,4,3,3,2" },
+    { "26x26", "5,4,3,3,2,2,2,2,2,2" },
+    { "99x26", "5,4,3,3,2,2,2,2,2,2" }
+};
+
+char output[OUTPUT_SIZE];
+unsigned short order[PROTO_MAX_CELLS];
+size_t sink = 0;
+
+double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Places the fleet at random, as the load generator's bots do
+void place_fleet(board_state_t* board, const board_config_t* config, unsigned int* seed) {
+    board_reset(board, config);
+    while (!board_fleet_placed(board, config)) {
+        int horizontal = rand_r(seed) % 2;
+        int row = rand_r(seed) % config->rows;
+        int col = rand_r(seed) % config->cols;
+        if (board_can_place(board, config, row, col, horizontal)) {
+            board_place(board, config, row, col, horizontal);
+        }
+    }
+}
+
+// Nanoseconds per board_can_place() call at random positions
+double time_placement(const board_config_t* config, double seconds) {
+    board_state_t board;
+    unsigned int seed = 1;
+    unsigned long calls = 0;
+    if (board_init(&board, config) != 0) return 0;
+    double start = now_seconds(), elapsed;
+    
+    place_fleet(&board, config, &seed);
+    board.ships_placed = 0;     // check against a full board, never place
+    do {
+        for (int i = 0; i < 4096; i++) {
+            sink += board_can_place(&board, config, rand_r(&seed) % config->rows,
+                                    rand_r(&seed) % config->cols, i & 1);
+        }
+        calls += 4096;
+        elapsed = now_seconds() - start;
+    } while (elapsed < seconds);
+    board_release(&board);
+    return elapsed * 1e9 / calls;
+}
+
+// Nanoseconds per board_attack(), firing until the fleet is sunk
+double time_attacks(const board_config_t* config, double seconds) {
+    int cells = config->rows * config->cols;
+    board_state_t board;
+    unsigned int seed = 2;
+    unsigned long attacks = 0;
+    double setup_time = 0;
+    if (board_init(&board, config) != 0) return 0;
+    double start = now_seconds(), elapsed;
+    
+    for (int i = 0; i < cells; i++) {
+        order[i] = (unsigned short)i;
+    }
+    do {
+        double setup_start = now_seconds();
+        place_fleet(&board, config, &seed);
+        for (int i = cells - 1; i > 0; i--) {
+            int j = rand_r(&seed) % (i + 1);
+            unsigned short tmp = order[i];
+            order[i] = order[j];
+            order[j] = tmp;
+        }
+        setup_time += now_seconds() - setup_start;
+        
+        for (int i = 0; i < cells && !board_defeated(&board, config); i++) {
+            int sunk_length;
+            sink += board_attack(&board, config, order[i] / config->cols, order[i] % config->cols, &sunk_length);
+            attacks++;
+        }
+        elapsed = now_seconds() - start;
+    } while (elapsed < seconds);
+    board_release(&board);
+    return (elapsed - setup_time) * 1e9 / attacks;
+}
+
+// Microseconds per full text frame of both boards
+double time_frames(const board_config_t* config, double seconds, size_t* bytes) {
+    static unsigned char own[PROTO_MAX_CELLS], enemy[PROTO_MAX_CELLS];
+    board_state_t mine, theirs;
+    unsigned int seed = 3;
+    unsigned long frames = 0;
+    if (board_init(&mine, config) != 0) return 0;
+    if (board_init(&theirs, config) != 0) {
+        board_release(&mine);
+        return 0;
+    }
+    double start = now_seconds(), elapsed;
+    
+    // Boards a third of the way through a game
+    place_fleet(&mine, config, &seed);
+    place_fleet(&theirs, config, &seed);
+    for (int i = 0; i < config->rows * config->cols / 3; i++) {
+        int sunk_length;
+        board_attack(&mine, config, rand_r(&seed) % config->rows, rand_r(&seed) % config->cols, &sunk_length);
+        board_attack(&theirs, config, rand_r(&seed) % config->rows, rand_r(&seed) % config->cols, &sunk_length);
+    }
+    
+    do {
+        for (int i = 0; i < 64; i++) {
+            board_cells(own, &mine, config, 1);
+            board_cells(enemy, &theirs, config, 0);
+            *bytes = render_both_grids(output, sizeof(output), own, enemy, config->rows, config->cols, "opponent");
+            sink += *bytes;
+        }
+        frames += 64;
+        elapsed = now_seconds() - start;
+    } while (elapsed < seconds);
+    board_release(&mine);
+    board_release(&theirs);
+    return elapsed * 1e6 / frames;
+}
+
+int main(int argc, char* argv[]) {
+    double seconds = argc > 1 ? atof(argv[1]) : 1.0;
+    
+    printf("%-7s %6s %14s %12s %10s %12s\n", "board", "ships", "place ns", "attack ns", "frame us", "frame bytes");
+    for (size_t s = 0; s < sizeof(setups) / sizeof(setups[0]); s++) {
+        board_config_t config;
+        board_config_default(&config);
+        if (board_config_set_size(&config, setups[s].size) < 0 ||
+            board_config_set_fleet(&config, setups[s].fleet) < 0 || board_config_check(&config) != NULL) {
+            fprintf(stderr, "Bad setup %s / %s\n", setups[s].size, setups[s].fleet);
+            return 1;
+        }
+        
+        size_t bytes = 0;
+        double place = time_placement(&config, seconds);
+        double attack = time_attacks(&config, seconds);
+        double frame = time_frames(&config, seconds, &bytes);
+        printf("%-7s %6d %14.1f %12.1f %10.2f %12zu\n",
+            setups[s].size, config.ship_count, place, attack, frame, bytes);
+    }
+    
+    return sink == 0;
+}
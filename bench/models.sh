@@ -0,0 +1,45 @@
+#!/bin/sh
+#
+# File: bench/models.sh
+# Description: Runs the same load against the thread-per-connection, epoll,
+#              sharded epoll and io_uring server models and prints games/sec,
+#              open connections, server threads and resident memory for each,
+#              plus I/O system calls per command for the reactor models.
+#
+# Usage: bench/models.sh [players] [idle] [seconds]
+#        (run from the project root after building server and loadgen)
+
+PLAYERS=${1:-200}
+IDLE=${2:-2000}
+DURATION=${3:-10}
+PORT=${PORT:-19900}
+
+# Sums the reactor table the server prints on shutdown
+syscalls_per_command() {
+    awk '/Reactors/ { table = 1; getline; next }
+         table && $1 ~ /^[0-9]+$/ { syscalls += $4; commands += $5; next }
+         { table = 0 }
+         END { if (commands > 0) printf " syscalls/command=%.2f", syscalls / commands }' "$1"
+}
+
+for mode in threads epoll shards uring; do
+    ./server --mode "$mode" --port "$PORT" > /tmp/server_$mode.txt 2>&1 &
+    server_pid=$!
+    sleep 0.5
+
+    ./loadgen -p "$PORT" -c "$PLAYERS" -i "$IDLE" -d "$DURATION" > /tmp/loadgen_$mode.txt &
+    loadgen_pid=$!
+
+    # Sample the server halfway through, while every connection is open
+    sleep $((DURATION / 2))
+    threads=$(ls /proc/$server_pid/task | wc -l)
+    rss=$(awk '/VmRSS/ { print $2 " " $3 }' /proc/$server_pid/status)
+
+    wait $loadgen_pid
+    kill -INT $server_pid
+    wait $server_pid 2> /dev/null
+
+    echo "== $mode: server threads=$threads rss=$rss$(syscalls_per_command /tmp/server_$mode.txt)"
+    tail -n 1 /tmp/loadgen_$mode.txt
+    sleep 1
+done
@@ -0,0 +1,279 @@
+#define _GNU_SOURCE
+
+/*
+ * File: bench/parse_bench.c
+ * Author: [Your Name]
+ * Date: October 17, 2026
+ * Description: Microbenchmark and fuzzer for the text command parser
+ *              Feeds random lines built from verbs, positions, whitespace
+ *              and stray bytes to both the sscanf()/strcmp() decoder the
+ *              server used to run and proto_parse_text_command(), the
+ *              in-place decoder in protocol.c the server runs now, stopping
+ *              at the first line they decode differently, then reports
+ *              commands per second for both on typical commands.
+ *
+ * Usage: ./parse_bench [seconds per case] [fuzz lines]
+ *        gcc -Wall -Wextra -std=c99 -pedantic -O2 -o parse_bench bench/parse_bench.c protocol.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../protocol.h"
+
+#define MAX_LINE 240            // the legacy decoder keeps 255 bytes of arguments
+
+// What the server decodes from one line, in a form both decoders can fill
+typedef struct {
+    proto_command_type_t type;
+    int valid;
+    int row;
+    int col;
+    int horizontal;
+    unsigned int room_id;
+    int level;
+    unsigned char token[PROTO_TOKEN_BYTES];
+    char arg[256];
+} decoded_t;
+
+// The decoder as it was before the tokenizer, kept here as the baseline.
+// Usernames are kept whole, as the server now cuts them after decoding.
+
+static int legacy_parse_position(const char* text, int* col, int* row) {
+    char letter = text[0];
+    if (letter >= 'a' && letter <= 'z') letter = (char)(letter - 'a' + 'A');
+    if (letter < 'A' || letter > 'Z') return 0;
+    
+    int number = 0, digits = 0;
+    while (text[1 + digits] >= '0' && text[1 + digits] <= '9') {
+        number = number * 10 + (text[1 + digits] - '0');
+        if (++digits > 2) return 0;
+    }
+    if (digits == 0 || number == 0 || text[1 + digits] != '\0') return 0;
+    
+    *col = letter - 'A';
+    *row = number - 1;
+    return 1;
+}
+
+static void legacy_decode(const char* buffer, int has_username, decoded_t* cmd) {
+    char command[16] = "", args[256] = "";
+    sscanf(buffer, "%15s %255[^\n]", command, args);
+    
+    if (!has_username && strcmp(command, "CAPS") == 0) {
+        cmd->type = CMD_CAPS;
+        strcpy(cmd->arg, args);
+    } else if (strcmp(command, "WATCH") == 0) {
+        size_t digits = strspn(args, "0123456789");
+        cmd->type = CMD_WATCH;
+        strcpy(cmd->arg, args);
+        if (digits > 0 && digits <= 9 && args[digits] == '\0') {
+            cmd->valid = 1;
+            cmd->room_id = (unsigned int)strtoul(args, NULL, 10);
+        }
+    } else if (!has_username && strcmp(command, "RESUME") == 0) {
+        char token[40];
+        cmd->type = CMD_RESUME;
+        if (sscanf(args, "%39s", token) == 1 && strlen(token) == 2 * PROTO_TOKEN_BYTES &&
+            strspn(token, "0123456789abcdefABCDEF") == 2 * PROTO_TOKEN_BYTES) {
+            cmd->valid = 1;
+            for (int i = 0; i < PROTO_TOKEN_BYTES; i++) {
+                char byte[3] = { token[2 * i], token[2 * i + 1], '\0' };
+                cmd->token[i] = (unsigned char)strtoul(byte, NULL, 16);
+            }
+        }
+    } else if (!has_username && strlen(buffer) > 0) {
+        cmd->type = CMD_USERNAME;
+        strcpy(cmd->arg, buffer);
+    } else if (strcmp(command, "PLACE") == 0) {
+        char pos[8], orientation[16];
+        cmd->type = CMD_PLACE;
+        if (sscanf(args, "%7s %15s", pos, orientation) == 2 &&
+            legacy_parse_position(pos, &cmd->col, &cmd->row)) {
+            cmd->valid = 1;
+            cmd->horizontal = (strcmp(orientation, "H") == 0);
+        }
+    } else if (strcmp(command, "ATTACK") == 0) {
+        char pos[8];
+        cmd->type = CMD_ATTACK;
+        if (sscanf(args, "%7s", pos) == 1 && legacy_parse_position(pos, &cmd->col, &cmd->row)) {
+            cmd->valid = 1;
+        }
+    } else if (strcmp(command, "GRID") == 0 || strcmp(command, "RESYNC") == 0) {
+        cmd->type = CMD_GRID;
+    } else if (strcmp(command, "FRAMING") == 0) {
+        cmd->type = CMD_FRAMING;
+        strcpy(cmd->arg, args);
+    } else if (strcmp(command, "QUIT") == 0) {
+        cmd->type = CMD_QUIT;
+    } else if (strcmp(command, "BOT") == 0) {
+        cmd->type = CMD_BOT;
+        cmd->valid = 1;
+        cmd->level = -1;
+        sscanf(args, "%255s", cmd->arg);
+    }
+}
+
+// The server's decoder, plus copying out what it points at
+static void view_decode(const char* buffer, size_t length, int has_username, decoded_t* cmd) {
+    proto_command_t decoded;
+    memset(&decoded, 0, sizeof(decoded));
+    proto_parse_text_command(buffer, length, has_username, &decoded);
+    
+    cmd->type = decoded.type;
+    cmd->valid = decoded.valid;
+    cmd->row = decoded.row;
+    cmd->col = decoded.col;
+    cmd->horizontal = decoded.horizontal;
+    cmd->room_id = decoded.room_id;
+    cmd->level = decoded.level;
+    memcpy(cmd->token, decoded.token, sizeof(cmd->token));
+    if (decoded.arg.length > 0) memcpy(cmd->arg, decoded.arg.text, decoded.arg.length);
+    cmd->arg[decoded.arg.length] = '\0';
+}
+
+static int same_decoding(const decoded_t* a, const decoded_t* b) {
+    if (a->type != b->type || a->valid != b->valid || a->level != b->level || strcmp(a->arg, b->arg) != 0) {
+        return 0;
+    }
+    return !a->valid || (a->row == b->row && a->col == b->col && a->horizontal == b->horizontal &&
+                         a->room_id == b->room_id && memcmp(a->token, b->token, sizeof(a->token)) == 0);
+}
+
+// Pieces random lines are made of: near misses of every verb and argument
+static const char* pieces[] = {
+    "CAPS", "PLACE", "ATTACK", "GRID", "RESYNC", "FRAMING", "QUIT", "WATCH", "RESUME", "BOT",
+    "caps", "Place", "ATTACKS", "GRI", "RESYNCED", "FRAMINGS", "QUI", "CAPZ", "PLAC", "AT",
+    "watch", "WATCHES", "RESUM", "RESUMED", "Bot", "BOTS", "BO",
+    "BIN1", "LENGTH", "LINES", "H", "V", "h", "HH",
+    "easy", "Normal", "HARD", "expert",
+    "A1", "b3", "J10", "Z99", "z99", "A0", "A00", "A05", "A100", "B3x", "@1", "[2", "1A", "A",
+    "0", "7", "42", "123456789", "1234567890", "-1", "+5", "0x10",
+    "0123456789abcdef0123456789ABCDEF", "0123456789abcdef0123456789abcde",
+    "0123456789abcdef0123456789abcdef0", "0123456789abcdeg0123456789abcdef",
+    " ", "  ", "\t", "\r", "\n", "\v", "\f"
+};
+
+static unsigned long long rng_state = 0x9E3779B97F4A7C15ULL;
+
+static unsigned int next_random(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return (unsigned int)(rng_state >> 32);
+}
+
+// A random line of up to MAX_LINE bytes, NULs included; returns its length
+static size_t random_line(char* line) {
+    size_t length = 0;
+    int count = next_random() % 8;
+    for (int i = 0; i < count; i++) {
+        char piece[64];
+        size_t piece_length;
+        unsigned int choice = next_random() % 8;
+        if (choice == 0) {
+            // Stray bytes, NUL and high bytes among them
+            piece_length = 1 + next_random() % 4;
+            for (size_t j = 0; j < piece_length; j++) piece[j] = (char)(next_random() & 0xFF);
+        } else if (choice == 1) {
+            // A long word, past the legacy decoder's field widths
+            piece_length = 8 + next_random() % 40;
+            memset(piece, "AHPx9"[next_random() % 5], piece_length);
+        } else {
+            const char* text = pieces[next_random() % (sizeof(pieces) / sizeof(pieces[0]))];
+            piece_length = strlen(text);
+            memcpy(piece, text, piece_length);
+        }
+        if (length + piece_length + 1 > MAX_LINE) break;
+        memcpy(line + length, piece, piece_length);
+        length += piece_length;
+        if (next_random() % 3 != 0) line[length++] = ' ';
+    }
+    line[length] = '\0';
+    return length;
+}
+
+static void print_escaped(FILE* out, const char* line, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        unsigned char c = (unsigned char)line[i];
+        if (c >= 0x20 && c < 0x7F && c != '\\') fputc(c, out);
+        else fprintf(out, "\\x%02x", c);
+    }
+    fputc('\n', out);
+}
+
+// Both decoders must agree on every line, before and after the username
+static int fuzz(unsigned long lines) {
+    char line[MAX_LINE + 1];
+    for (unsigned long i = 0; i < lines; i++) {
+        size_t length = random_line(line);
+        for (int has_username = 0; has_username <= 1; has_username++) {
+            decoded_t expected, actual;
+            memset(&expected, 0, sizeof(expected));
+            memset(&actual, 0, sizeof(actual));
+            legacy_decode(line, has_username, &expected);
+            view_decode(line, length, has_username, &actual);
+            if (!same_decoding(&expected, &actual)) {
+                fprintf(stderr, "Decoders disagree (type %d vs %d, has_username %d) on: ",
+                    expected.type, actual.type, has_username);
+                print_escaped(stderr, line, length);
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+static const char* commands[] = {
+    "ATTACK B3", "ATTACK J10", "PLACE A1 H", "PLACE C2 V", "GRID", "ATTACK z99", "RESYNC", "QUIT"
+};
+#define COMMANDS (sizeof(commands) / sizeof(commands[0]))
+
+static volatile int sink;
+
+double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+double commands_per_second(int legacy, double seconds) {
+    size_t lengths[COMMANDS];
+    for (size_t i = 0; i < COMMANDS; i++) lengths[i] = strlen(commands[i]);
+    
+    unsigned long count = 0;
+    double start = now_seconds();
+    double elapsed;
+    do {
+        for (int i = 0; i < 4096; i++) {
+            size_t which = count % COMMANDS;
+            decoded_t cmd;
+            cmd.type = CMD_NONE;
+            cmd.valid = 0;
+            if (legacy) {
+                legacy_decode(commands[which], 1, &cmd);
+            } else {
+                view_decode(commands[which], lengths[which], 1, &cmd);
+            }
+            sink += cmd.type + cmd.row;
+            count++;
+        }
+        elapsed = now_seconds() - start;
+    } while (elapsed < seconds);
+    return count / elapsed;
+}
+
+int main(int argc, char* argv[]) {
+    double seconds = argc > 1 ? atof(argv[1]) : 1.0;
+    unsigned long lines = argc > 2 ? strtoul(argv[2], NULL, 10) : 1000000;
+    
+    if (!fuzz(lines)) return 1;
+    printf("fuzz: %lu random lines decoded alike\n", lines);
+    
+    double legacy = commands_per_second(1, seconds);
+    double views = commands_per_second(0, seconds);
+    printf("%-10s %14s %14s %8s\n", "decoder", "legacy cmd/s", "views cmd/s", "speedup");
+    printf("%-10s %14.0f %14.0f %7.1fx\n", "text", legacy, views, views / legacy);
+    return 0;
+}
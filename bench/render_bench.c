@@ -0,0 +1,266 @@
+#define _GNU_SOURCE
+
+/*
+ * File: bench/render_bench.c
+ * Author: [Your Name]
+ * Date: October 17, 2026
+ * Description: Microbenchmark for the grid renderers
+ *              Checks that the table-driven renderers in render.c produce the
+ *              same bytes as the snprintf/strcat code they replaced, then
+ *              reports frames per second for both.
+ *
+ * Usage: ./render_bench [seconds per case]
+ *        gcc -Wall -Wextra -std=c99 -pedantic -O2 -o render_bench bench/render_bench.c render.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../render.h"
+#include "../protocol.h"
+
+#define BOARDS 64
+#define MAX_SIDE 10
+#define OUTPUT_SIZE 65536
+
+// The renderers as they were before render.c switched to precomputed
+// glyphs, kept here as the baseline
+
+// strcat() that stops at the end of the buffer
+static void legacy_append(char* out, size_t size, const char* text) {
+    size_t used = strlen(out);
+    size_t len = strlen(text);
+    if (used + len >= size) len = size - used - 1;
+    memcpy(out + used, text, len);
+    out[used + len] = '\0';
+}
+
+// Letters padded to the cell pitch, as render.c now draws them; the
+// original's 16-byte buffer cut the padding down to one space
+static void legacy_append_column_headers(char* out, size_t size, int cols) {
+    for (int j = 0; j < cols; j++) {
+        char col_header[32];
+        snprintf(col_header, sizeof(col_header), "%s%s%c%s  ", BOLD, YELLOW, 'A' + j, RESET);
+        legacy_append(out, size, col_header);
+    }
+}
+
+static size_t legacy_render_grid(char* out, size_t size, const unsigned char* cells, int rows, int cols,
+                                 int show_ships, const char* title) {
+    snprintf(out, size,
+        "%s%s╔════════════════════════════════════════════════╗%s\n"
+        "%s%s║                    %s%-20s%s%s║%s\n"
+        "%s%s╚════════════════════════════════════════════════╝%s\n\n",
+        BOLD, CYAN, RESET,
+        BOLD, CYAN, WHITE, title, CYAN, BOLD, RESET,
+        BOLD, CYAN, RESET);
+    
+    // Column headers
+    legacy_append(out, size, "     ");
+    legacy_append_column_headers(out, size, cols);
+    legacy_append(out, size, "\n\n");
+    
+    // Grid rows with fancy borders
+    for (int i = 0; i < rows; i++) {
+        char row[256];
+        snprintf(row, sizeof(row), "  %s%s%d%s  ", BOLD, YELLOW, i + 1, RESET);
+        legacy_append(out, size, row);
+        
+        for (int j = 0; j < cols; j++) {
+            char cell[32];
+            switch (cells[i * cols + j]) {
+                case SHIP:
+                    if (show_ships) {
+                        snprintf(cell, sizeof(cell), "%s%s🚢%s ", BOLD, GREEN, RESET);
+                    } else {
+                        snprintf(cell, sizeof(cell), "%s%s⬜%s ", BOLD, BLUE, RESET);
+                    }
+                    break;
+                case HIT:
+                    snprintf(cell, sizeof(cell), "%s%s💥%s ", BOLD, RED, RESET);
+                    break;
+                case MISS:
+                    snprintf(cell, sizeof(cell), "%s%s💧%s ", BOLD, WHITE, RESET);
+                    break;
+                default:
+                    snprintf(cell, sizeof(cell), "%s%s⬜%s ", BOLD, BLUE, RESET);
+                    break;
+            }
+            legacy_append(out, size, cell);
+        }
+        legacy_append(out, size, "\n");
+    }
+    
+    legacy_append(out, size, "\n");
+    legacy_append(out, size, "Legend: ");
+    char legend[256];
+    snprintf(legend, sizeof(legend), 
+        "%s⬜%s=Water %s🚢%s=Ship %s💥%s=Hit %s💧%s=Miss\n\n",
+        BLUE, RESET, GREEN, RESET, RED, RESET, WHITE, RESET);
+    legacy_append(out, size, legend);
+    return strlen(out);
+}
+
+static size_t legacy_render_both_grids(char* out, size_t size, const unsigned char* own, const unsigned char* enemy,
+                                       int rows, int cols, const char* enemy_name) {
+    snprintf(out, size,
+        "%s%s╔══════════════════════════════════════════════════════════════════════════════════════════════════════════════════╗%s\n"
+        "%s%s║                                          %s🎯 BATTLE STATUS 🎯%s                                              %s║%s\n"
+        "%s%s╚══════════════════════════════════════════════════════════════════════════════════════════════════════════════════╝%s\n\n"
+        "%s%s📋 YOUR GRID%s                              %s🎯 ENEMY GRID (%s)%s\n"
+        "   (Shows your ship)                         (Shows your attacks)\n\n",
+        BOLD, MAGENTA, RESET,
+        BOLD, MAGENTA, WHITE, MAGENTA, BOLD, RESET,
+        BOLD, MAGENTA, RESET,
+        BOLD, GREEN, RESET, BOLD, enemy_name, RESET);
+    
+    // Your grid (left side)
+    legacy_append(out, size, "     ");
+    legacy_append_column_headers(out, size, cols);
+    
+    // Enemy grid headers (right side)
+    legacy_append(out, size, "           ");
+    legacy_append_column_headers(out, size, cols);
+    legacy_append(out, size, "\n\n");
+    
+    // Both grids side by side
+    for (int i = 0; i < rows; i++) {
+        char row[512];
+        snprintf(row, sizeof(row), "  %s%s%d%s  ", BOLD, YELLOW, i + 1, RESET);
+        legacy_append(out, size, row);
+        
+        // Your grid
+        for (int j = 0; j < cols; j++) {
+            char cell[32];
+            switch (own[i * cols + j]) {
+                case SHIP:
+                    snprintf(cell, sizeof(cell), "%s%s🚢%s ", BOLD, GREEN, RESET);
+                    break;
+                case HIT:
+                    snprintf(cell, sizeof(cell), "%s%s💥%s ", BOLD, RED, RESET);
+                    break;
+                case MISS:
+                    snprintf(cell, sizeof(cell), "%s%s💧%s ", BOLD, WHITE, RESET);
+                    break;
+                default:
+                    snprintf(cell, sizeof(cell), "%s%s⬜%s ", BOLD, BLUE, RESET);
+                    break;
+            }
+            legacy_append(out, size, cell);
+        }
+        
+        // Space between grids
+        snprintf(row, sizeof(row), "        %s%s%d%s  ", BOLD, YELLOW, i + 1, RESET);
+        legacy_append(out, size, row);
+        
+        // Enemy view
+        for (int j = 0; j < cols; j++) {
+            char cell[32];
+            switch (enemy[i * cols + j]) {
+                case HIT:
+                    snprintf(cell, sizeof(cell), "%s%s💥%s ", BOLD, RED, RESET);
+                    break;
+                case MISS:
+                    snprintf(cell, sizeof(cell), "%s%s💧%s ", BOLD, WHITE, RESET);
+                    break;
+                default:
+                    snprintf(cell, sizeof(cell), "%s%s❔%s ", BOLD, MAGENTA, RESET);
+                    break;
+            }
+            legacy_append(out, size, cell);
+        }
+        legacy_append(out, size, "\n");
+    }
+    
+    legacy_append(out, size, "\n");
+    return strlen(out);
+}
+
+double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+unsigned char own_boards[BOARDS][MAX_SIDE * MAX_SIDE];
+unsigned char enemy_boards[BOARDS][MAX_SIDE * MAX_SIDE];
+char output[OUTPUT_SIZE];
+size_t sink = 0;
+
+void fill_boards(void) {
+    unsigned int seed = 12345;
+    for (int b = 0; b < BOARDS; b++) {
+        for (int i = 0; i < MAX_SIDE * MAX_SIDE; i++) {
+            own_boards[b][i] = (unsigned char)(rand_r(&seed) % 4);
+            enemy_boards[b][i] = (unsigned char)(rand_r(&seed) % 4);
+        }
+    }
+}
+
+// Renders board b of the given size with one implementation. which: 0 is
+// render_both_grids, 1 is render_grid.
+size_t render_one(int legacy, int which, int b, int side) {
+    if (which == 0) {
+        return legacy
+            ? legacy_render_both_grids(output, sizeof(output), own_boards[b], enemy_boards[b], side, side, "opponent")
+            : render_both_grids(output, sizeof(output), own_boards[b], enemy_boards[b], side, side, "opponent");
+    }
+    return legacy
+        ? legacy_render_grid(output, sizeof(output), own_boards[b], side, side, 1, "YOUR GRID")
+        : render_grid(output, sizeof(output), own_boards[b], side, side, 1, "YOUR GRID");
+}
+
+// Both implementations must agree byte for byte on every test board
+int check_outputs(int which, int side) {
+    static char expected[OUTPUT_SIZE];
+    for (int b = 0; b < BOARDS; b++) {
+        size_t legacy_length = render_one(1, which, b, side);
+        memcpy(expected, output, legacy_length + 1);
+        size_t length = render_one(0, which, b, side);
+        if (length != legacy_length || memcmp(expected, output, length) != 0) {
+            fprintf(stderr, "Output mismatch: renderer %d, %dx%d board %d\n", which, side, side, b);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+double frames_per_second(int legacy, int which, int side, double seconds) {
+    unsigned long frames = 0;
+    double start = now_seconds();
+    double elapsed;
+    
+    do {
+        for (int i = 0; i < 1024; i++) {
+            sink += render_one(legacy, which, (int)(frames % BOARDS), side);
+            frames++;
+        }
+        elapsed = now_seconds() - start;
+    } while (elapsed < seconds);
+    return frames / elapsed;
+}
+
+int main(int argc, char* argv[]) {
+    double seconds = argc > 1 ? atof(argv[1]) : 1.0;
+    const char* names[] = { "both_grids", "grid" };
+    int sides[] = { 4, 9 };     // the baseline cannot pad two-digit row numbers
+    
+    fill_boards();
+    printf("%-12s %6s %9s %14s %14s %8s\n", "renderer", "board", "bytes", "legacy fps", "table fps", "speedup");
+    
+    for (int which = 0; which < 2; which++) {
+        for (int s = 0; s < 2; s++) {
+            int side = sides[s];
+            if (!check_outputs(which, side)) return 1;
+            
+            size_t bytes = render_one(0, which, 0, side);
+            double legacy = frames_per_second(1, which, side, seconds);
+            double table = frames_per_second(0, which, side, seconds);
+            printf("%-12s %3dx%-2d %9zu %14.0f %14.0f %7.1fx\n",
+                names[which], side, side, bytes, legacy, table, table / legacy);
+        }
+    }
+    
+    return sink == 0;
+}
@@ -0,0 +1,65 @@
+/*
+ * File: bitboard.h
+ * Author: [Your Name]
+ * Date: October 17, 2026
+ * Description: Boards as bitmasks, one bit per cell
+ *              Cell (row, col) is bit row * cols + col, packed into 64-bit
+ *              words. A mask is just its words, held wherever its owner
+ *              keeps them and sized for the board in hand; operations take
+ *              the number of words it uses, so a 4x4 or 8x8 board costs one
+ *              AND and takes one word however large boards may get.
+ */
+
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+#include <stdint.h>
+
+#define BITBOARD_MAX_CELLS (26 * 99)    // cells in the largest board held
+#define BITWORD_BITS 64
+
+// Words a board of this many cells uses
+#define bitboard_words(cells) (((cells) + BITWORD_BITS - 1) / BITWORD_BITS)
+#define BITBOARD_MAX_WORDS bitboard_words(BITBOARD_MAX_CELLS)
+
+typedef uint64_t bitword_t;
+
+static inline void bitboard_clear(bitword_t* board, int words) {
+    for (int i = 0; i < words; i++) board[i] = 0;
+}
+
+static inline void bitboard_set(bitword_t* board, int cell) {
+    board[cell / BITWORD_BITS] |= (bitword_t)1 << (cell % BITWORD_BITS);
+}
+
+static inline int bitboard_test(const bitword_t* board, int cell) {
+    return (int)((board[cell / BITWORD_BITS] >> (cell % BITWORD_BITS)) & 1);
+}
+
+// board |= other
+static inline void bitboard_merge(bitword_t* board, const bitword_t* other, int words) {
+    for (int i = 0; i < words; i++) board[i] |= other[i];
+}
+
+// Nonzero if the boards share a set cell
+static inline int bitboard_overlaps(const bitword_t* a, const bitword_t* b, int words) {
+    bitword_t any = 0;
+    for (int i = 0; i < words; i++) any |= a[i] & b[i];
+    return any != 0;
+}
+
+// Nonzero if every cell set in part is also set in board
+static inline int bitboard_covers(const bitword_t* board, const bitword_t* part, int words) {
+    bitword_t missing = 0;
+    for (int i = 0; i < words; i++) missing |= part[i] & ~board[i];
+    return missing == 0;
+}
+
+// A straight line of length cells starting at cell, each step stride cells
+// on: 1 for a horizontal ship, the column count for a vertical one
+static inline void bitboard_line(bitword_t* line, int words, int cell, int length, int stride) {
+    bitboard_clear(line, words);
+    for (int i = 0; i < length; i++) bitboard_set(line, cell + i * stride);
+}
+
+#endif
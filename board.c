@@ -0,0 +1,223 @@
+/*
+ * File: board.c
+ * Author: [Your Name]
+ * Date: October 17, 2026
+ * Description: Board rules of Mini Battleship (see board.h)
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "board.h"
+
+void board_config_default(board_config_t* config) {
+    config->rows = DEFAULT_ROWS;
+    config->cols = DEFAULT_COLS;
+    config->words = bitboard_words(DEFAULT_ROWS * DEFAULT_COLS);
+    board_config_set_fleet(config, DEFAULT_FLEET);
+}
+
+int board_config_set_size(board_config_t* config, const char* size) {
+    char* end;
+    long rows = strtol(size, &end, 10);
+    if (end == size || (*end != 'x' && *end != 'X')) return -1;
+    const char* second = end + 1;
+    long cols = strtol(second, &end, 10);
+    if (end == second || *end != '\0') return -1;
+    if (rows < 1 || rows > PROTO_MAX_ROWS || cols < 1 || cols > PROTO_MAX_COLS) return -1;
+    
+    config->rows = (int)rows;
+    config->cols = (int)cols;
+    config->words = bitboard_words(config->rows * config->cols);
+    return 0;
+}
+
+int board_config_set_fleet(board_config_t* config, const char* fleet) {
+    int lengths[PROTO_MAX_FLEET];
+    int count = 0;
+    const char* p = fleet;
+    
+    while (1) {
+        char* end;
+        long length = strtol(p, &end, 10);
+        if (end == p || length < 1 || length > PROTO_MAX_ROWS || count == PROTO_MAX_FLEET) return -1;
+        lengths[count++] = (int)length;
+        if (*end == '\0') break;
+        if (*end != ',') return -1;
+        p = end + 1;
+    }
+    
+    memcpy(config->ship_lengths, lengths, count * sizeof(int));
+    config->ship_count = count;
+    return 0;
+}
+
+// First-fit packing of the fleet into lines of line_length cells, lines
+// of them, longest ship first. Nonzero if every ship gets a place.
+static int fleet_packs(const board_config_t* config, int lines, int line_length) {
+    int order[PROTO_MAX_FLEET];
+    int free_cells[PROTO_MAX_ROWS];
+    
+    memcpy(order, config->ship_lengths, config->ship_count * sizeof(int));
+    for (int i = 1; i < config->ship_count; i++) {
+        for (int j = i; j > 0 && order[j] > order[j - 1]; j--) {
+            int tmp = order[j];
+            order[j] = order[j - 1];
+            order[j - 1] = tmp;
+        }
+    }
+    for (int i = 0; i < lines; i++) {
+        free_cells[i] = line_length;
+    }
+    
+    for (int i = 0; i < config->ship_count; i++) {
+        int line = 0;
+        while (line < lines && free_cells[line] < order[i]) line++;
+        if (line == lines) return 0;
+        free_cells[line] -= order[i];
+    }
+    return 1;
+}
+
+const char* board_config_check(const board_config_t* config) {
+    if (config->ship_count < 1) return "the fleet has no ships";
+    
+    int longest = config->rows > config->cols ? config->rows : config->cols;
+    for (int i = 0; i < config->ship_count; i++) {
+        if (config->ship_lengths[i] > longest) return "a ship is longer than the board";
+    }
+    
+    // Packing the ships all across or all down is enough to show a legal
+    // layout exists; fleets that only fit mixed are turned away
+    if (!fleet_packs(config, config->rows, config->cols) &&
+        !fleet_packs(config, config->cols, config->rows)) {
+        return "the fleet does not fit on the board";
+    }
+    return NULL;
+}
+
+int board_storage_words(const board_config_t* config) {
+    return (2 + config->ship_count) * config->words;
+}
+
+// The ship masks are written whole as each ship is placed
+void board_reset(board_state_t* board, const board_config_t* config) {
+    board->words = config->words;
+    bitboard_clear(board_ships(board), config->words);
+    bitboard_clear(board_shots(board), config->words);
+    board->ships_placed = 0;
+    board->ships_sunk = 0;
+}
+
+int board_init(board_state_t* board, const board_config_t* config) {
+    board->masks = malloc(board_storage_words(config) * sizeof(bitword_t));
+    if (board->masks == NULL) return -1;
+    board_reset(board, config);
+    return 0;
+}
+
+void board_release(board_state_t* board) {
+    free(board->masks);
+    board->masks = NULL;
+}
+
+int board_fleet_placed(const board_state_t* board, const board_config_t* config) {
+    return board->ships_placed >= config->ship_count;
+}
+
+int board_can_place(const board_state_t* board, const board_config_t* config,
+                    int row, int col, int horizontal) {
+    if (board_fleet_placed(board, config)) return 0;
+    int length = config->ship_lengths[board->ships_placed];
+    
+    // Check bounds
+    if (row < 0 || col < 0 || row >= config->rows || col >= config->cols) return 0;
+    if (horizontal) {
+        if (col + length > config->cols) return 0;
+    } else {
+        if (row + length > config->rows) return 0;
+    }
+    
+    // Check for overlaps
+    bitword_t ship[BITBOARD_MAX_WORDS];
+    bitboard_line(ship, config->words, row * config->cols + col, length, horizontal ? 1 : config->cols);
+    return !bitboard_overlaps(board_ships(board), ship, config->words);
+}
+
+void board_place(board_state_t* board, const board_config_t* config,
+                 int row, int col, int horizontal) {
+    int index = board->ships_placed++;
+    ship_t* ship = &board->fleet[index];
+    int cell = row * config->cols + col;
+    int length = config->ship_lengths[index];
+    int stride = horizontal ? 1 : config->cols;
+    ship->cell = (uint16_t)cell;
+    ship->length = (uint8_t)length;
+    ship->stride = (uint8_t)stride;
+    ship->first_word = (uint8_t)(cell / BITWORD_BITS);
+    ship->last_word = (uint8_t)((cell + (length - 1) * stride) / BITWORD_BITS);
+    ship->sunk = 0;
+    
+    bitword_t* mask = board_ship_mask(board, index);
+    bitboard_line(mask, config->words, cell, length, stride);
+    bitboard_merge(board_ships(board), mask, config->words);
+}
+
+int board_attack(board_state_t* board, const board_config_t* config, int row, int col, int* sunk_length) {
+    if (row < 0 || row >= config->rows || col < 0 || col >= config->cols) return -1;
+    int cell = row * config->cols + col;
+    bitword_t* shots = board_shots(board);
+    if (bitboard_test(shots, cell)) return -1; // Already attacked
+    
+    bitboard_set(shots, cell);
+    if (!bitboard_test(board_ships(board), cell)) {
+        return ATTACK_MISS;
+    }
+    
+    // The ship whose mask holds the cell is sunk once the shots cover it,
+    // which only the words it spans can tell
+    for (int i = 0; i < board->ships_placed; i++) {
+        const bitword_t* mask = board_ship_mask(board, i);
+        if (!bitboard_test(mask, cell)) continue;
+        
+        ship_t* ship = &board->fleet[i];
+        int first = ship->first_word;
+        if (!bitboard_covers(shots + first, mask + first, ship->last_word - first + 1)) {
+            return ATTACK_HIT;
+        }
+        ship->sunk = 1;
+        board->ships_sunk++;
+        *sunk_length = ship->length;
+        return ATTACK_SUNK;
+    }
+    return ATTACK_HIT;
+}
+
+int board_defeated(const board_state_t* board, const board_config_t* config) {
+    return board->ships_sunk >= config->ship_count;
+}
+
+cell_state_t board_cell(const board_state_t* board, int cell, int show_ships) {
+    int ship = bitboard_test(board_ships(board), cell);
+    if (bitboard_test(board_shots(board), cell)) return ship ? HIT : MISS;
+    return (ship && show_ships) ? SHIP : EMPTY;
+}
+
+void board_cells(unsigned char* out, const board_state_t* board, const board_config_t* config,
+                 int show_ships) {
+    int cells = config->rows * config->cols;
+    
+    // A word at a time: two mask bits give each cell's state directly
+    for (int w = 0; w < config->words; w++) {
+        bitword_t ships = show_ships ? board_ships(board)[w] : 0;
+        bitword_t shots = board_shots(board)[w];
+        bitword_t hits = board_ships(board)[w] & shots;
+        int base = w * BITWORD_BITS;
+        int count = cells - base < BITWORD_BITS ? cells - base : BITWORD_BITS;
+        
+        for (int i = 0; i < count; i++) {
+            int shot = (int)((shots >> i) & 1);
+            out[base + i] = shot ? (((hits >> i) & 1) ? HIT : MISS)
+                                 : (((ships >> i) & 1) ? SHIP : EMPTY);
+        }
+    }
+}
@@ -0,0 +1,117 @@
+/*
+ * File: board.h
+ * Author: [Your Name]
+ * Date: October 17, 2026
+ * Description: Board rules of Mini Battleship, independent of networking
+ *              A board_config_t gives the board size and the fleet; each
+ *              player's board_state_t records where their ships are and
+ *              which cells have been fired at as bitboards, and each ship
+ *              of the fleet as a mask of its own, so the ship a shot hits
+ *              is found with an AND and a ship is sunk once the shots cover
+ *              its mask. The masks are sized for the board in play and kept
+ *              in storage the board's owner provides.
+ */
+
+#ifndef BOARD_H
+#define BOARD_H
+
+#include <stdint.h>
+#include "bitboard.h"
+#include "protocol.h"
+
+#define DEFAULT_ROWS 4
+#define DEFAULT_COLS 4
+#define DEFAULT_FLEET "2"
+
+// Board size and fleet, fixed for the length of a game
+typedef struct {
+    int rows;
+    int cols;
+    int words;                              // bitboard words per board
+    int ship_count;
+    int ship_lengths[PROTO_MAX_FLEET];      // placement order
+} board_config_t;
+
+// A placed ship: length cells from cell, stride apart. Its mask can only
+// have bits in words first_word to last_word.
+typedef struct {
+    uint16_t cell;
+    uint8_t length;
+    uint8_t stride;
+    uint8_t first_word;
+    uint8_t last_word;
+    uint8_t sunk;
+} ship_t;
+
+// One player's board. masks points at board_storage_words() words: the
+// cells holding a ship, the cells the opponent has fired at, then one mask
+// per ship of the fleet.
+typedef struct {
+    bitword_t* masks;
+    int words;                  // per mask
+    int ships_placed;
+    int ships_sunk;
+    ship_t fleet[PROTO_MAX_FLEET];
+} board_state_t;
+
+// Enough mask storage for any configuration, for a board on the stack
+#define BOARD_MAX_STORAGE_WORDS ((2 + PROTO_MAX_FLEET) * BITBOARD_MAX_WORDS)
+
+#define board_ships(board) ((board)->masks)
+#define board_shots(board) ((board)->masks + (board)->words)
+#define board_ship_mask(board, i) ((board)->masks + (2 + (i)) * (board)->words)
+
+// Sets config to the 4x4 board with one 2-cell ship
+void board_config_default(board_config_t* config);
+
+// Parses a size such as "10x10" (rows x columns) or a fleet such as
+// "5,4,3,3,2". Return 0 on success, -1 with config unchanged otherwise.
+int board_config_set_size(board_config_t* config, const char* size);
+int board_config_set_fleet(board_config_t* config, const char* fleet);
+
+// Checks that every ship fits on the board and the fleet fits at all.
+// Returns NULL if so, otherwise what is wrong.
+const char* board_config_check(const board_config_t* config);
+
+// Words of mask storage a board of this configuration needs
+int board_storage_words(const board_config_t* config);
+
+// Clears the board for a new game. board->masks must hold
+// board_storage_words(config) words.
+void board_reset(board_state_t* board, const board_config_t* config);
+
+// For boards that keep their own storage: board_init() allocates it and
+// resets the board (-1 if memory ran out), board_release() frees it
+int board_init(board_state_t* board, const board_config_t* config);
+void board_release(board_state_t* board);
+
+// Nonzero once every ship of the fleet is on the board
+int board_fleet_placed(const board_state_t* board, const board_config_t* config);
+
+// Nonzero if the next ship of the fleet fits at (row, col) without
+// leaving the board or touching a ship already placed
+int board_can_place(const board_state_t* board, const board_config_t* config,
+                    int row, int col, int horizontal);
+
+// Places the next ship; board_can_place() must have allowed it
+void board_place(board_state_t* board, const board_config_t* config,
+                 int row, int col, int horizontal);
+
+// Fires at (row, col). Returns -1 if that is off the board or was already
+// fired at, otherwise an attack_result_t. *sunk_length is set to the
+// length of the ship an ATTACK_SUNK sank.
+int board_attack(board_state_t* board, const board_config_t* config, int row, int col, int* sunk_length);
+
+// Nonzero once every ship of the fleet has been sunk
+int board_defeated(const board_state_t* board, const board_config_t* config);
+
+// State of one cell as its owner sees it, or as the opponent does with
+// show_ships off: unshot ship cells look like water
+cell_state_t board_cell(const board_state_t* board, int cell, int show_ships);
+
+// One cell state per byte for every cell, the layout the renderers and
+// the wire format use
+void board_cells(unsigned char* out, const board_state_t* board, const board_config_t* config,
+                 int show_ships);
+
+#endif
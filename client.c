@@ -4,56 +4,194 @@
  * Date: August 27, 2025
  * Description: Mini Battleship Game Client
  *              Interactive client with enhanced visuals, colors, and username system
+ *              With --binary it negotiates the compact binary protocol and
+ *              renders the grids itself from the cell states it receives.
+ *              With --watch [room] it asks to spectate a game in progress
+ *              (the latest one if no room is given) instead of playing.
+ *              If the connection drops during a game it reconnects and
+ *              takes the seat back with the resume token the server gave
+ *              it, for as long as the server holds the seat.
+ *              Once the battle is on screen, updates redraw only the cells
+ *              that changed, in place, while messages scroll below the
+ *              grids.
  */
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <errno.h>
+#include <signal.h>
 #include <sys/types.h>
+#include <sys/ioctl.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <pthread.h>
+#include <poll.h>
+#include "framing.h"
+#include "protocol.h"
+#include "render.h"
 
 #define PORT 19845
-#define BUFFER_SIZE 4096
 #define SERVER_IP "127.0.0.1"
-
-// ANSI color codes
-const char* RESET = "\033[0m";
-const char* BOLD = "\033[1m";
-const char* RED = "\033[91m";
-const char* GREEN = "\033[92m";
-const char* YELLOW = "\033[93m";
-const char* BLUE = "\033[94m";
-const char* MAGENTA = "\033[95m";
-const char* CYAN = "\033[96m";
-const char* WHITE = "\033[97m";
+#define RECV_RING_SIZE 16384    // a full text state of the largest board is ~5 KB
+#define RECV_MAX_FRAME 8192
+#define RECONNECT_PAUSE_MS 250      // first wait between reconnection attempts, doubled each time
+#define RECONNECT_PAUSE_MAX_MS 4000
+#define BANNER_LINES 5
+#define MESSAGE_LINES 6             // fewest lines left below the grids to scroll messages in
 
 int sockfd;
+struct sockaddr_in server_addr;
 int game_active = 1;
 int waiting_for_username = 1;
+int use_binary = 0;
+int spectating = 0;             // set by --watch: never asked for a username
+input_ring_t server_input;
+
+// Set by the receive thread once the server's first message is on screen
+// (or the connection is gone), so the first prompt comes after the welcome
+int server_greeted = 0;
+pthread_mutex_t greeting_mutex = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t greeting_cond = PTHREAD_COND_INITIALIZER;
+
+// The name typed at the prompt, handed from the input thread to the
+// receive thread, which copies it to my_username once the server takes it
+char requested_username[PROTO_MAX_NAME + 1] = "";
+pthread_mutex_t username_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// What the client remembers about the game; the receive thread's alone
+char my_username[PROTO_MAX_NAME + 1] = "";
+char opponent_name[PROTO_MAX_NAME + 1] = "";
+int my_seat = 0;
+int battle_started = 0;
+int in_game = 0;                // seated in a game that is not over
+
+// Resume token from the server, and how long it holds a dropped seat
+unsigned char resume_token[PROTO_TOKEN_BYTES];
+int have_token = 0;
+unsigned int resume_grace = 0;
+int reconnecting = 0;           // sent RESUME on a new connection, no answer yet
+int resume_snapshot = 0;        // RESUMED seen: the GAME_CONFIG that follows is not a new game
+
+// Board size and fleet of the current game, from GAME_CONFIG
+typedef struct {
+    int rows;
+    int cols;
+    int ship_count;
+    int ship_lengths[PROTO_MAX_FLEET];
+} game_setup_t;
+
+game_setup_t setup = { 4, 4, 1, { 2 } };
+
+// Local copy of our view of both boards, loaded from full states and kept
+// current by GRID_DELTA updates
+typedef struct {
+    int rows;
+    int cols;
+    unsigned char own[PROTO_MAX_CELLS];
+    unsigned char enemy[PROTO_MAX_CELLS];
+    unsigned int seq;
+    int valid;
+} board_model_t;
+
+board_model_t board;
+
+// What the terminal shows of the battle view. While it is valid the
+// banner and both grids sit at the top of the screen, above a scrolling
+// region where messages and typing go, so an update only has to rewrite
+// the cells that differ from it.
+typedef struct {
+    int valid;
+    int rows;
+    int cols;
+    int term_rows;              // terminal size the view was drawn at
+    int term_cols;
+    char opponent[PROTO_MAX_NAME + 1];
+    unsigned char own[PROTO_MAX_CELLS];
+    unsigned char enemy[PROTO_MAX_CELLS];
+} screen_model_t;
+
+screen_model_t screen;
+
+// Writes to the terminal in one go, after whatever stdio still holds
+void write_screen(const char* data, size_t length) {
+    fflush(stdout);
+    while (length > 0) {
+        ssize_t written = write(STDOUT_FILENO, data, length);
+        if (written < 0 && errno == EINTR) continue;
+        if (written <= 0) return;
+        data += written;
+        length -= written;
+    }
+}
+
+// Gives the whole screen back to scrolling, keeping the cursor where it is
+static const char scroll_reset[] = "\0337\033[r\0338";
+
+void restore_scrolling(void) {
+    write_screen(scroll_reset, sizeof(scroll_reset) - 1);
+}
+
+// Interrupted mid-game: leave the terminal scrolling as usual
+void on_fatal_signal(int sig) {
+    ssize_t ignored = write(STDOUT_FILENO, scroll_reset, sizeof(scroll_reset) - 1);
+    (void)ignored;
+    signal(sig, SIG_DFL);
+    raise(sig);
+}
 
 void clear_screen(void) {
-    printf("\033[2J\033[H");
+    printf("\033[r\033[2J\033[H");
+    screen.valid = 0;
+}
+
+// "ONE ship (2 spaces) on a 4x4 grid" or "3 ships (4, 3, 2 spaces) on a
+// 10x10 grid"
+void describe_setup(char* out, size_t size) {
+    size_t used = (setup.ship_count == 1) ? (size_t)snprintf(out, size, "ONE ship (")
+                                          : (size_t)snprintf(out, size, "%d ships (", setup.ship_count);
+    for (int i = 0; i < setup.ship_count && used < size; i++) {
+        used += snprintf(out + used, size - used, "%s%d", i > 0 ? ", " : "", setup.ship_lengths[i]);
+    }
+    if (used < size) {
+        snprintf(out + used, size - used, " spaces) on a %dx%d grid", setup.rows, setup.cols);
+    }
+}
+
+// The banner, BANNER_LINES lines of it; returns its length as snprintf()
+int format_banner(char* out, size_t size) {
+    char subtitle[64];
+    int len = snprintf(subtitle, sizeof(subtitle), "%dx%d Grid • %d Ship%s",
+                       setup.rows, setup.cols, setup.ship_count, setup.ship_count == 1 ? "" : "s");
+    int width = len - 2;    // "•" is three bytes wide in one column
+    int left = (62 - width) / 2;
+    
+    return snprintf(out, size,
+        "%s%s"
+        "╔══════════════════════════════════════════════════════════════╗\n"
+        "║                    🚢 MINI BATTLESHIP 🚢                     ║\n"
+        "║%*s%s%*s║\n"
+        "╚══════════════════════════════════════════════════════════════╝\n"
+        "%s\n",
+        BOLD, CYAN, left, "", subtitle, 62 - width - left, "", RESET);
 }
 
 void print_banner(void) {
-    printf("%s%s", BOLD, CYAN);
-    printf("╔══════════════════════════════════════════════════════════════╗\n");
-    printf("║                    🚢 MINI BATTLESHIP 🚢                     ║\n");
-    printf("║                      4x4 Grid • 1 Ship                      ║\n");
-    printf("╚══════════════════════════════════════════════════════════════╝\n");
-    printf("%s\n", RESET);
+    char banner[1024];
+    format_banner(banner, sizeof(banner));
+    fputs(banner, stdout);
 }
 
 void print_instructions(void) {
+    char rule[96];
+    describe_setup(rule, sizeof(rule));
     printf("%s%s┌─ GAME RULES ─────────────────────────────────────────────┐%s\n", BOLD, YELLOW, RESET);
-    printf("%s│%s Each player places ONE ship (2 spaces) on a 4x4 grid     %s│%s\n", YELLOW, WHITE, YELLOW, RESET);
+    printf("%s│%s Each player places %-37s %s│%s\n", YELLOW, WHITE, rule, YELLOW, RESET);
     printf("%s│%s Ships can be placed horizontally (H) or vertically (V)   %s│%s\n", YELLOW, WHITE, YELLOW, RESET);
     printf("%s│%s Take turns attacking enemy positions                     %s│%s\n", YELLOW, WHITE, YELLOW, RESET);
-    printf("%s│%s First to sink opponent's ship wins!                      %s│%s\n", YELLOW, WHITE, YELLOW, RESET);
+    printf("%s│%s First to sink all the opponent's ships wins!             %s│%s\n", YELLOW, WHITE, YELLOW, RESET);
     printf("%s└─────────────────────────────────────────────────────────┘%s\n\n", YELLOW, RESET);
     
     printf("%s%s┌─ COMMANDS ───────────────────────────────────────────────┐%s\n", BOLD, GREEN, RESET);
@@ -61,13 +199,23 @@ void print_instructions(void) {
     printf("%s│%s ATTACK <pos>      - Attack position (e.g., ATTACK B3)   %s│%s\n", GREEN, WHITE, GREEN, RESET);
     printf("%s│%s GRID              - Show both grids                      %s│%s\n", GREEN, WHITE, GREEN, RESET);
     printf("%s│%s HELP              - Show this help                       %s│%s\n", GREEN, WHITE, GREEN, RESET);
+    printf("%s│%s BOT [level]       - Play the computer, not a person      %s│%s\n", GREEN, WHITE, GREEN, RESET);
     printf("%s│%s QUIT              - Exit game                            %s│%s\n", GREEN, WHITE, GREEN, RESET);
     printf("%s└─────────────────────────────────────────────────────────┘%s\n\n", GREEN, RESET);
 }
 
 void print_placement_help(void) {
+    char fleet[64];
+    if (setup.ship_count == 1) {
+        snprintf(fleet, sizeof(fleet), "Your ship is %d spaces long", setup.ship_lengths[0]);
+    } else {
+        int used = snprintf(fleet, sizeof(fleet), "Place your ships in order:");
+        for (int i = 0; i < setup.ship_count && used < (int)sizeof(fleet); i++) {
+            used += snprintf(fleet + used, sizeof(fleet) - used, " %d", setup.ship_lengths[i]);
+        }
+    }
     printf("%s%s┌─ SHIP PLACEMENT HELP ────────────────────────────────────┐%s\n", BOLD, MAGENTA, RESET);
-    printf("%s│%s Your ship is 2 spaces long                               %s│%s\n", MAGENTA, WHITE, MAGENTA, RESET);
+    printf("%s│%s %-56s %s│%s\n", MAGENTA, WHITE, fleet, MAGENTA, RESET);
     printf("%s│%s                                                         %s│%s\n", MAGENTA, WHITE, MAGENTA, RESET);
     printf("%s│%s Examples:                                                %s│%s\n", MAGENTA, WHITE, MAGENTA, RESET);
     printf("%s│%s   PLACE A1 H  →  🚢🚢⬜⬜  (horizontal at A1-B1)        %s│%s\n", MAGENTA, WHITE, MAGENTA, RESET);
@@ -78,109 +226,778 @@ void print_placement_help(void) {
     printf("%s└─────────────────────────────────────────────────────────┘%s\n\n", MAGENTA, RESET);
 }
 
+void print_win_banner(void) {
+    printf("\n%s%s", BOLD, GREEN);
+    printf("╔══════════════════════════════════════════════════════════════╗\n");
+    printf("║                        🎉 VICTORY! 🎉                        ║\n");
+    printf("║                   You sunk their ship!                       ║\n");
+    printf("╚══════════════════════════════════════════════════════════════╝\n");
+    printf("%s\n", RESET);
+    game_active = 0;
+}
+
+void print_lose_banner(void) {
+    printf("\n%s%s", BOLD, RED);
+    printf("╔══════════════════════════════════════════════════════════════╗\n");
+    printf("║                        💀 DEFEAT 💀                         ║\n");
+    printf("║                   Your ship was sunk!                       ║\n");
+    printf("╚══════════════════════════════════════════════════════════════╝\n");
+    printf("%s\n", RESET);
+    game_active = 0;
+}
+
+void send_command(const char* command) {
+    send(sockfd, command, strlen(command), 0);
+}
+
+// Sends one binary-protocol frame
+void send_frame(int opcode, const unsigned char* payload, size_t length) {
+    unsigned char frame[PROTO_MAX_PAYLOAD + 3];
+    size_t n = proto_encode_frame(frame, opcode, payload, length);
+    send(sockfd, frame, n, 0);
+}
+
+// Translates a typed command into a binary frame
+void send_binary_command(const char* input) {
+    char command[16] = "", pos[8] = "", orientation[16] = "";
+    int col, row;
+    int args = sscanf(input, "%15s %7s %15s", command, pos, orientation);
+    
+    if (waiting_for_username) {
+        size_t len = strlen(input);
+        if (len > PROTO_MAX_NAME) len = PROTO_MAX_NAME;
+        send_frame(OP_USERNAME, (const unsigned char*)input, len);
+    } else if (strcmp(command, "PLACE") == 0) {
+        if (args == 3 && proto_parse_position(pos, &col, &row)) {
+            unsigned char payload[3] = { (unsigned char)col, (unsigned char)row, strcmp(orientation, "H") == 0 };
+            send_frame(OP_PLACE, payload, 3);
+        } else {
+            printf("\n%s%s❌ Error: %s%s\n", BOLD, RED, proto_error_text(ERR_PLACE_FORMAT), RESET);
+        }
+    } else if (strcmp(command, "ATTACK") == 0) {
+        if (args >= 2 && proto_parse_position(pos, &col, &row)) {
+            unsigned char payload[2] = { (unsigned char)col, (unsigned char)row };
+            send_frame(OP_ATTACK, payload, 2);
+        } else {
+            printf("\n%s%s❌ Error: %s%s\n", BOLD, RED, proto_error_text(ERR_ATTACK_FORMAT), RESET);
+        }
+    } else if (strcmp(command, "GRID") == 0) {
+        send_frame(OP_GRID, NULL, 0);
+    } else if (strcmp(command, "QUIT") == 0) {
+        send_frame(OP_QUIT, NULL, 0);
+    } else if (strcmp(command, "BOT") == 0) {
+        // The level by number, or none for the server's default
+        static const char* levels[] = { "EASY", "NORMAL", "HARD" };
+        int level = -1;
+        for (int i = 0; pos[i]; i++) {
+            if (pos[i] >= 'a' && pos[i] <= 'z') pos[i] = pos[i] - 'a' + 'A';
+        }
+        for (int i = 0; i < 3; i++) {
+            if (strcmp(pos, levels[i]) == 0) level = i;
+        }
+        if (args < 2) {
+            send_frame(OP_BOT, NULL, 0);
+        } else if (level >= 0) {
+            unsigned char payload[1] = { (unsigned char)level };
+            send_frame(OP_BOT, payload, 1);
+        } else {
+            printf("\n%s%s❌ Error: %s%s\n", BOLD, RED, proto_error_text(ERR_BOT_FORMAT), RESET);
+        }
+    } else {
+        printf("\n%s%s❌ Error: Unknown command%s\n", BOLD, RED, RESET);
+    }
+}
+
+const char* seat_name(int seat) {
+    return seat == my_seat ? my_username : opponent_name;
+}
+
+// Clears the screen and draws the banner and both grids in one write().
+// With message_top set, the lines from there down become the scrolling
+// region and the screen model is kept; otherwise (a terminal too small to
+// hold the grids still) every update is drawn this way.
+void draw_battle_screen(int message_top, int term_rows, int term_cols) {
+    size_t size = 1024 + render_both_grids_size(board.rows, board.cols, opponent_name) + 64;
+    char* frame = malloc(size);
+    if (frame == NULL) return;
+    
+    size_t len = snprintf(frame, size, "\033[r\033[2J\033[H");
+    len += format_banner(frame + len, size - len);
+    len += render_both_grids(frame + len, size - len, board.own, board.enemy, board.rows, board.cols,
+        opponent_name);
+    if (message_top > 0) {
+        // Setting the region homes the cursor: move it back down after
+        len += snprintf(frame + len, size - len, "\033[%d;%dr\033[%d;1H", message_top, term_rows, message_top);
+    }
+    len += snprintf(frame + len, size - len, "%s> %s", BOLD, RESET);
+    write_screen(frame, len < size ? len : size - 1);
+    free(frame);
+    
+    screen.valid = message_top > 0;
+    screen.rows = board.rows;
+    screen.cols = board.cols;
+    screen.term_rows = term_rows;
+    screen.term_cols = term_cols;
+    snprintf(screen.opponent, sizeof(screen.opponent), "%s", opponent_name);
+    memcpy(screen.own, board.own, board.rows * board.cols);
+    memcpy(screen.enemy, board.enemy, board.rows * board.cols);
+}
+
+// Rewrites each cell the board model has and the screen does not, in
+// one write(), and puts the cursor back where messages and typing were
+void draw_changed_cells(void) {
+    int cells = board.rows * board.cols;
+    char frame[2 * PROTO_MAX_CELLS * 48 + 8];
+    size_t len = 0;
+    
+    for (int which = BOARD_OWN; which <= BOARD_ENEMY; which++) {
+        const unsigned char* wanted = which == BOARD_OWN ? board.own : board.enemy;
+        unsigned char* shown = which == BOARD_OWN ? screen.own : screen.enemy;
+        for (int cell = 0; cell < cells; cell++) {
+            if (wanted[cell] == shown[cell]) continue;
+            int line, column;
+            render_both_grids_cell_at(board.rows, board.cols, which, cell / board.cols, cell % board.cols,
+                &line, &column);
+            if (len == 0) len = snprintf(frame, sizeof(frame), "\0337");
+            len += snprintf(frame + len, sizeof(frame) - len, "\033[%d;%dH%s", BANNER_LINES + line + 1,
+                column + 1, render_both_grids_glyph(which, wanted[cell]));
+            shown[cell] = wanted[cell];
+        }
+    }
+    if (len == 0) return;
+    len += snprintf(frame + len, sizeof(frame) - len, "\0338");
+    write_screen(frame, len);
+}
+
+// Both grids side by side: drawn in full when the screen does not hold
+// them as they are (first time, resized, cleared), and otherwise only
+// the cells that changed
+void draw_battle_view(void) {
+    struct winsize ws;
+    int lines = BANNER_LINES + render_both_grids_lines(board.rows);
+    int fits = ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0 && ws.ws_row >= lines + MESSAGE_LINES &&
+               ws.ws_col >= render_both_grids_width(board.rows, board.cols);
+    
+    if (fits && screen.valid && screen.rows == board.rows && screen.cols == board.cols &&
+        screen.term_rows == ws.ws_row && screen.term_cols == ws.ws_col &&
+        strcmp(screen.opponent, opponent_name) == 0) {
+        draw_changed_cells();
+    } else {
+        draw_battle_screen(fits ? lines + 1 : 0, fits ? ws.ws_row : 0, fits ? ws.ws_col : 0);
+    }
+}
+
+// Draws the local board model: just our own grid while ships are being
+// placed, both grids side by side once the battle is on
+void draw_boards(void) {
+    if (battle_started) {
+        draw_battle_view();
+        return;
+    }
+    
+    size_t size = render_grid_size(board.rows, board.cols, "YOUR GRID");
+    char* art = malloc(size);
+    if (art == NULL) return;
+    render_grid(art, size, board.own, board.rows, board.cols, 1, "YOUR GRID");
+    printf("\n%s", art);
+    free(art);
+    fflush(stdout);
+}
+
+// Draws a spectator's view: both fleets, seat 0 in board.own and seat 1
+// in board.enemy, ships shown only where they were hit
+void draw_spectate_view(void) {
+    char titles[2][PROTO_MAX_NAME + 16];
+    size_t sizes[2];
+    for (int seat = 0; seat < 2; seat++) {
+        snprintf(titles[seat], sizeof(titles[seat]), "%s's fleet", seat_name(seat));
+        sizes[seat] = render_grid_size(board.rows, board.cols, titles[seat]);
+    }
+    char* art = malloc(sizes[0] + sizes[1]);
+    if (art == NULL) return;
+    size_t len = render_grid(art, sizes[0], board.own, board.rows, board.cols, 0, titles[0]);
+    render_grid(art + len, sizes[1], board.enemy, board.rows, board.cols, 0, titles[1]);
+    clear_screen();
+    print_banner();
+    printf("%s", art);
+    free(art);
+    fflush(stdout);
+}
+
+// Asks for a full state after missing an update
+void request_resync(void) {
+    board.valid = 0;
+    if (use_binary) {
+        send_frame(OP_RESYNC, NULL, 0);
+    } else {
+        send_command("RESYNC\n");
+    }
+}
+
+// A delta tagged seq applies only on top of version seq - 1. Returns 0,
+// after asking for a resync, when it does not follow the version we hold.
+int board_delta_follows(unsigned int seq) {
+    if (board.valid && seq == board.seq + 1) return 1;
+    request_resync();
+    return 0;
+}
+
+void board_set_cell(int which, int col, int row, int state) {
+    if (row < 0 || row >= board.rows || col < 0 || col >= board.cols) return;
+    unsigned char* cells = (which == BOARD_OWN) ? board.own : board.enemy;
+    cells[row * board.cols + col] = (unsigned char)state;
+}
+
+// Maps a PROTO_CELL_CHARS character back to its cell state
+int cell_from_char(char c) {
+    const char* found = strchr(PROTO_CELL_CHARS, c);
+    return (found != NULL && c != '\0') ? (int)(found - PROTO_CELL_CHARS) : EMPTY;
+}
+
+// Loads "<seq> <rows> <cols> <own> <enemy>" from a GRID or BOTH_GRIDS header
+int board_load_text(const char* args) {
+    unsigned int seq;
+    int rows, cols, offset = 0;
+    
+    if (sscanf(args, "%u %d %d %n", &seq, &rows, &cols, &offset) != 3 || offset == 0 ||
+        rows <= 0 || cols <= 0 || rows * cols > PROTO_MAX_CELLS) {
+        return 0;
+    }
+    // The two cell strings, each exactly rows * cols characters
+    const char* own = args + offset;
+    const char* enemy = own + rows * cols + 1;
+    if ((int)strcspn(own, " ") != rows * cols || own[rows * cols] != ' ' ||
+        (int)strcspn(enemy, " ") != rows * cols) {
+        return 0;
+    }
+    for (int i = 0; i < rows * cols; i++) {
+        board.own[i] = (unsigned char)cell_from_char(own[i]);
+        board.enemy[i] = (unsigned char)cell_from_char(enemy[i]);
+    }
+    board.rows = rows;
+    board.cols = cols;
+    board.seq = seq;
+    board.valid = 1;
+    return 1;
+}
+
+// The server accepted the name typed at the prompt
+void take_username(void) {
+    pthread_mutex_lock(&username_mutex);
+    snprintf(my_username, sizeof(my_username), "%s", requested_username);
+    pthread_mutex_unlock(&username_mutex);
+}
+
+// Shows how to place the fleet of a game that is starting and asks for
+// the first ship
+void announce_setup(void) {
+    print_placement_help();
+    printf("%s%s💡 Place your %d-space ship now!%s\n", BOLD, GREEN, setup.ship_lengths[0], RESET);
+}
+
+// The connection came back but the seat did not: nothing left to play
+void resume_failed(void) {
+    printf("%s%s💔 Could not get back into the game%s\n", BOLD, RED, RESET);
+    reconnecting = 0;
+    game_active = 0;
+}
+
+// Back in our seat after a dropped connection: the grids and the turn
+// follow in the snapshot
+void show_resumed(int seat, int playing, int remaining) {
+    my_seat = seat;
+    battle_started = playing;
+    in_game = 1;
+    reconnecting = 0;
+    waiting_for_username = 0;
+    resume_snapshot = 1;
+    clear_screen();
+    print_banner();
+    printf("%s%s📡 Reconnected! Back in the game against %s%s\n", BOLD, GREEN, opponent_name, RESET);
+    if (!playing && remaining > 0 && remaining <= setup.ship_count) {
+        printf("%s%s💡 Place your %d-space ship now! (%d left)%s\n", BOLD, GREEN,
+            setup.ship_lengths[setup.ship_count - remaining], remaining, RESET);
+    } else if (!playing) {
+        printf("%s%sWaiting for your opponent to place their ships...%s\n", BOLD, YELLOW, RESET);
+    }
+}
+
+// Something ran out of time: shows the server's text, or words for the
+// frame. Seat is -1 for our own connection's time, and for a placing
+// neither player finished; the server then ends the connection or game.
+void show_timeout(int reason, int seat, int missed, int limit, const char* text) {
+    if (text != NULL) {
+        printf("\n%s\n", text);
+    } else if (reason == TIMEOUT_TURN) {
+        printf("\n%s%s⏰ %s ran out of time (%d of %d in a row) ⏰%s\n", BOLD, YELLOW, seat_name(seat),
+            missed, limit, RESET);
+    } else if (reason == TIMEOUT_PLACING && seat >= 0) {
+        printf("\n%s%s⏰ %s did not place their fleet in time ⏰%s\n", BOLD, YELLOW, seat_name(seat), RESET);
+    } else if (reason == TIMEOUT_PLACING) {
+        printf("\n%s%s⏰ Neither fleet was placed in time; the game is off ⏰%s\n", BOLD, YELLOW, RESET);
+    } else {
+        printf("\n%s%s⏰ %s; disconnected ⏰%s\n", BOLD, YELLOW,
+            reason == TIMEOUT_HANDSHAKE ? "No username in time" : "Idle too long", RESET);
+    }
+    if (seat < 0) {
+        in_game = 0;
+        game_active = 0;
+    }
+}
+
+// Handles one line of the text protocol. Lines that do not start with a
+// known verb continue the previous message; grid art is skipped because
+// the client draws its own board model.
+void handle_text_line(char* line) {
+    static const char* verbs[] = {
+        "WELCOME", "CAPS_OK", "USERNAME_SET", "WAIT_PLAYER", "GAME_START", "SHIP_PLACED",
+        "BATTLE_START", "YOUR_TURN", "WAIT_TURN", "CONTINUE", "HIT", "MISS", "WIN", "LOSE",
+        "GAME_OVER", "ATTACK_RESULT", "ERROR", "GRID", "BOTH_GRIDS", "GRID_DELTA", "FRAMING_OK",
+        "GAME_CONFIG", "SUNK", "WATCHING", "SPECTATE", "WATCH_END", "RESUME_TOKEN", "RESUMED",
+        "OPPONENT_AWAY", "OPPONENT_BACK", "TIMEOUT", "SEAT"
+    };
+    static char last_verb[32] = "";
+    static int skipping_art = 0;
+    
+    char command[32] = "";
+    size_t len = strspn(line, "ABCDEFGHIJKLMNOPQRSTUVWXYZ_");
+    int known = 0;
+    if (len > 0 && len < sizeof(command) && (line[len] == ' ' || line[len] == '\0')) {
+        memcpy(command, line, len);
+        command[len] = '\0';
+        for (size_t i = 0; i < sizeof(verbs) / sizeof(verbs[0]); i++) {
+            if (strcmp(command, verbs[i]) == 0) known = 1;
+        }
+    }
+    
+    if (!known) {
+        if (skipping_art) return;
+        printf("%s\n", line);
+        return;
+    }
+    
+    const char* message = line + len;
+    if (*message == ' ') message++;
+    strcpy(last_verb, command);
+    skipping_art = 0;
+    
+    if (strcmp(command, "WELCOME") == 0) {
+        if (reconnecting) {
+            // Not a new player: RESUME has already been sent
+            skipping_art = 1;
+            return;
+        }
+        clear_screen();
+        print_banner();
+        printf("%s\n", message);
+        waiting_for_username = 1;
+    } else if (strcmp(command, "CAPS_OK") == 0) {
+        // Everything after this line is binary frames
+        server_input.mode = FRAMING_LENGTH;
+    } else if (strcmp(command, "USERNAME_SET") == 0) {
+        take_username();
+        printf("%s\n", message);
+        waiting_for_username = 0;
+    } else if (strcmp(command, "WAIT_PLAYER") == 0 || strcmp(command, "SHIP_PLACED") == 0) {
+        printf("%s\n", message);
+    } else if (strcmp(command, "GAME_START") == 0) {
+        battle_started = 0;
+        in_game = 1;
+        clear_screen();
+        print_banner();
+        printf("%s\n", message);
+    } else if (strcmp(command, "SEAT") == 0) {
+        // "<seat> <opponent>", sent after the GAME_START announcement
+        int seat, offset = 0;
+        if (sscanf(message, "%d%n", &seat, &offset) != 1 || message[offset] != ' ') return;
+        my_seat = seat;
+        snprintf(opponent_name, sizeof(opponent_name), "%s", message + offset + 1);
+    } else if (strcmp(command, "GAME_CONFIG") == 0) {
+        // "<rows> <cols> <length>...", one length per ship in placement order
+        game_setup_t parsed = { 0, 0, 0, { 0 } };
+        int offset = 0, used;
+        if (sscanf(message, "%d %d%n", &parsed.rows, &parsed.cols, &offset) != 2) return;
+        while (parsed.ship_count < PROTO_MAX_FLEET &&
+               sscanf(message + offset, "%d%n", &parsed.ship_lengths[parsed.ship_count], &used) == 1) {
+            parsed.ship_count++;
+            offset += used;
+        }
+        if (parsed.ship_count > 0) {
+            setup = parsed;
+            if (!spectating && !resume_snapshot) announce_setup();
+            resume_snapshot = 0;
+        }
+    } else if (strcmp(command, "BATTLE_START") == 0) {
+        battle_started = 1;
+        clear_screen();
+        print_banner();
+        printf("%s\n", message);
+        if (!spectating) print_instructions();
+    } else if (strcmp(command, "YOUR_TURN") == 0) {
+        printf("\n%s%s🎯 YOUR TURN!%s Attack with: %sATTACK <pos>%s\n", 
+            BOLD, GREEN, RESET, BOLD, RESET);
+        printf("%s> %s", BOLD, RESET);
+    } else if (strcmp(command, "WAIT_TURN") == 0) {
+        printf("\n%s%s⏳ WAITING...%s %s\n", BOLD, YELLOW, RESET, message);
+    } else if (strcmp(command, "CONTINUE") == 0) {
+        printf("\n%s%s🔥 KEEP FIRING!%s %s\n", BOLD, RED, RESET, message);
+        printf("%s> %s", BOLD, RESET);
+    } else if (strcmp(command, "HIT") == 0 || strcmp(command, "MISS") == 0 ||
+               strcmp(command, "SUNK") == 0 || strcmp(command, "GAME_OVER") == 0) {
+        printf("\n%s\n", message);
+    } else if (strcmp(command, "WIN") == 0) {
+        print_win_banner();
+    } else if (strcmp(command, "LOSE") == 0) {
+        print_lose_banner();
+    } else if (strcmp(command, "ATTACK_RESULT") == 0) {
+        printf("%s%s📢 %s%s\n", BOLD, CYAN, message, RESET);
+    } else if (strcmp(command, "ERROR") == 0) {
+        printf("\n%s%s❌ Error: %s%s\n", BOLD, RED, message, RESET);
+        if (reconnecting) resume_failed();
+    } else if (strcmp(command, "GRID") == 0 || strcmp(command, "BOTH_GRIDS") == 0) {
+        skipping_art = 1;
+        if (board_load_text(message)) {
+            draw_boards();
+        }
+    } else if (strcmp(command, "GRID_DELTA") == 0) {
+        // "<seq> <OWN|ENEMY> <pos> <cell>", the last three repeated per cell
+        unsigned int seq;
+        int offset = 0;
+        if (sscanf(message, "%u%n", &seq, &offset) != 1 || !board_delta_follows(seq)) return;
+        
+        char which[8], pos[8], cell;
+        int used;
+        while (sscanf(message + offset, " %7s %7s %c%n", which, pos, &cell, &used) == 3) {
+            int col, row;
+            offset += used;
+            if (proto_parse_position(pos, &col, &row)) {
+                board_set_cell(strcmp(which, "OWN") == 0 ? BOARD_OWN : BOARD_ENEMY, col, row, cell_from_char(cell));
+            }
+        }
+        board.seq = seq;
+        draw_boards();
+    } else if (strcmp(command, "WATCHING") == 0) {
+        // "<room> <message>"
+        const char* text = strchr(message, ' ');
+        printf("%s\n", text != NULL ? text + 1 : message);
+        waiting_for_username = 0;
+    } else if (strcmp(command, "SPECTATE") == 0) {
+        // The server draws both fleets below this line; show them as sent
+        clear_screen();
+        print_banner();
+    } else if (strcmp(command, "WATCH_END") == 0) {
+        printf("\n%s%s👋 The game has ended and the room is closed%s\n", BOLD, CYAN, RESET);
+        game_active = 0;
+    } else if (strcmp(command, "RESUME_TOKEN") == 0) {
+        // "<32 hex digits> <seconds held>"
+        char hex[2 * PROTO_TOKEN_BYTES + 1];
+        unsigned int grace;
+        if (sscanf(message, "%32s %u", hex, &grace) == 2) {
+            proto_view_t view = { hex, strlen(hex) };
+            have_token = proto_parse_token_view(view, resume_token);
+            resume_grace = grace;
+        }
+    } else if (strcmp(command, "RESUMED") == 0) {
+        // "<seat> <PLACING|PLAYING> <seat to move> <ships to place> <opponent>"
+        char state[16];
+        int seat, turn, remaining, offset = 0;
+        if (sscanf(message, "%d %15s %d %d %n", &seat, state, &turn, &remaining, &offset) < 4 || offset == 0) return;
+        snprintf(opponent_name, sizeof(opponent_name), "%s", message + offset);
+        show_resumed(seat, strcmp(state, "PLAYING") == 0, remaining);
+    } else if (strcmp(command, "OPPONENT_AWAY") == 0) {
+        // "<seconds held> <message>"
+        const char* text = strchr(message, ' ');
+        printf("\n%s\n", text != NULL ? text + 1 : message);
+    } else if (strcmp(command, "OPPONENT_BACK") == 0) {
+        printf("\n%s%s📡 %s is back!%s\n", BOLD, GREEN, opponent_name, RESET);
+    } else if (strcmp(command, "TIMEOUT") == 0) {
+        // "<HANDSHAKE|IDLE|TURN|PLACING> <seat or -1> <message>"
+        char reason[16];
+        int seat, offset = 0;
+        if (sscanf(message, "%15s %d %n", reason, &seat, &offset) < 2 || offset == 0) return;
+        int code = TIMEOUT_HANDSHAKE;
+        while (code < TIMEOUT_COUNT && strcmp(reason, proto_timeout_name(code)) != 0) code++;
+        show_timeout(code, seat, 0, 0, message + offset);
+    }
+}
+
+// Shows one binary frame the way the text protocol would have shown it
+void handle_binary_frame(const unsigned char* frame, size_t length) {
+    if (length == 0) return;
+    const unsigned char* payload = frame + 1;
+    size_t payload_length = length - 1;
+    
+    switch (frame[0]) {
+        case OP_USERNAME_SET:
+            take_username();
+            printf("%s%s⭐ Welcome, %s! ⭐%s\n", BOLD, CYAN, my_username, RESET);
+            waiting_for_username = 0;
+            break;
+        case OP_WAIT_PLAYER:
+            printf("%s%sWaiting for another player to join... (or type BOT to play the computer)%s\n",
+                BOLD, YELLOW, RESET);
+            break;
+        case OP_GAME_START:
+            if (payload_length < 1) break;
+            my_seat = payload[0];
+            snprintf(opponent_name, sizeof(opponent_name), "%.*s", (int)(payload_length - 1), payload + 1);
+            battle_started = 0;
+            in_game = 1;
+            clear_screen();
+            print_banner();
+            printf("%s%s🚢 Game Starting! 🚢%s\n%s vs %s\n", BOLD, MAGENTA, RESET, seat_name(0), seat_name(1));
+            break;
+        case OP_GAME_CONFIG: {
+            if (payload_length < 3) break;
+            int count = payload[2];
+            if (count < 1 || count > PROTO_MAX_FLEET || payload_length < 3 + (size_t)count) break;
+            setup.rows = payload[0];
+            setup.cols = payload[1];
+            setup.ship_count = count;
+            for (int i = 0; i < count; i++) {
+                setup.ship_lengths[i] = payload[3 + i];
+            }
+            if (!spectating && !resume_snapshot) announce_setup();
+            resume_snapshot = 0;
+            break;
+        }
+        case OP_SHIP_PLACED: {
+            int remaining = payload_length >= 1 ? payload[0] : 0;
+            if (remaining == 0 || remaining > setup.ship_count) {
+                printf("%s%s✅ Ship placed successfully!%s\n", BOLD, GREEN, RESET);
+            } else {
+                printf("%s%s✅ Ship placed! Next: %d-space ship (%d left)%s\n", BOLD, GREEN,
+                    setup.ship_lengths[setup.ship_count - remaining], remaining, RESET);
+            }
+            break;
+        }
+        case OP_BATTLE_START:
+            if (payload_length < 1) break;
+            battle_started = 1;
+            clear_screen();
+            print_banner();
+            printf("%s%s⚔️ BATTLE BEGINS! ⚔️%s\n%s goes first!\n", BOLD, RED, RESET, seat_name(payload[0]));
+            if (!spectating) print_instructions();
+            break;
+        case OP_YOUR_TURN:
+            printf("\n%s%s🎯 YOUR TURN!%s Attack with: %sATTACK <pos>%s\n", 
+                BOLD, GREEN, RESET, BOLD, RESET);
+            printf("%s> %s", BOLD, RESET);
+            break;
+        case OP_WAIT_TURN:
+            printf("\n%s%s⏳ WAITING...%s Wait for your opponent's move...\n", BOLD, YELLOW, RESET);
+            break;
+        case OP_CONTINUE:
+            printf("\n%s%s🔥 KEEP FIRING!%s You hit! Go again! Use ATTACK <pos>\n", BOLD, RED, RESET);
+            printf("%s> %s", BOLD, RESET);
+            break;
+        case OP_HIT:
+            if (payload_length < 2) break;
+            printf("\n%s%s🎯 HIT at %c%d! 🎯%s\n", BOLD, RED, 'A' + payload[0], payload[1] + 1, RESET);
+            break;
+        case OP_MISS:
+            if (payload_length < 2) break;
+            printf("\n%s%s💧 MISS at %c%d 💧%s\n", BOLD, BLUE, 'A' + payload[0], payload[1] + 1, RESET);
+            break;
+        case OP_SUNK:
+            if (payload_length < 3) break;
+            printf("\n%s%s🚢 SUNK their %d-space ship at %c%d! 🚢%s\n", BOLD, RED, payload[2],
+                'A' + payload[0], payload[1] + 1, RESET);
+            break;
+        case OP_ATTACK_RESULT:
+            if (payload_length < 4) break;
+            printf("%s%s📢 %s attacked %c%d - %s%s\n", BOLD, CYAN, seat_name(payload[0]),
+                'A' + payload[1], payload[2] + 1,
+                payload[3] == ATTACK_SUNK ? "Ship sunk! 🚢" : payload[3] == ATTACK_HIT ? "HIT! 💥" : "Miss 💧", RESET);
+            break;
+        case OP_WIN:
+            print_win_banner();
+            break;
+        case OP_LOSE:
+            print_lose_banner();
+            break;
+        case OP_GAME_OVER:
+            if (payload_length < 1) break;
+            printf("\n%s%s🏆 Game Over! %s wins! 🏆%s\n", BOLD, YELLOW, seat_name(payload[0]), RESET);
+            break;
+        case OP_GRID_STATE: {
+            if (payload_length < 6) break;
+            int rows = payload[4], cols = payload[5];
+            int cells = rows * cols;
+            size_t packed = (cells + 3) / 4;
+            if (cells > PROTO_MAX_CELLS || payload_length < 6 + 2 * packed) break;
+            
+            board.seq = proto_get_u32(payload);
+            board.rows = rows;
+            board.cols = cols;
+            proto_unpack_cells(board.own, payload + 6, cells);
+            proto_unpack_cells(board.enemy, payload + 6 + packed, cells);
+            board.valid = 1;
+            draw_boards();
+            break;
+        }
+        case OP_GRID_DELTA: {
+            if (payload_length < 5) break;
+            unsigned int seq = proto_get_u32(payload);
+            int count = payload[4];
+            if (payload_length < 5 + 4 * (size_t)count || !board_delta_follows(seq)) break;
+            
+            for (int i = 0; i < count; i++) {
+                const unsigned char* cell = payload + 5 + 4 * i;
+                board_set_cell(cell[0], cell[1], cell[2], cell[3]);
+            }
+            board.seq = seq;
+            draw_boards();
+            break;
+        }
+        case OP_WATCHING: {
+            // Spectators have no seat: seat 0's name is kept as ours so
+            // that seat_name() serves both
+            if (payload_length < 5 || payload_length < 5 + (size_t)payload[4]) break;
+            int first = payload[4];
+            int second = (int)(payload_length - 5 - first);
+            snprintf(my_username, sizeof(my_username), "%.*s", first, payload + 5);
+            snprintf(opponent_name, sizeof(opponent_name), "%.*s", second, payload + 5 + first);
+            my_seat = 0;
+            waiting_for_username = 0;
+            printf("%s%s👀 Watching %s vs %s (room %u)%s\n", BOLD, CYAN, my_username, opponent_name,
+                proto_get_u32(payload), RESET);
+            break;
+        }
+        case OP_SPECTATE: {
+            if (payload_length < 6) break;
+            int rows = payload[4], cols = payload[5];
+            int cells = rows * cols;
+            size_t packed = (cells + 3) / 4;
+            if (cells > PROTO_MAX_CELLS || payload_length < 6 + 2 * packed) break;
+            
+            board.seq = proto_get_u32(payload);
+            board.rows = rows;
+            board.cols = cols;
+            proto_unpack_cells(board.own, payload + 6, cells);
+            proto_unpack_cells(board.enemy, payload + 6 + packed, cells);
+            board.valid = 1;
+            draw_spectate_view();
+            break;
+        }
+        case OP_WATCH_END:
+            printf("\n%s%s👋 The game has ended and the room is closed%s\n", BOLD, CYAN, RESET);
+            game_active = 0;
+            break;
+        case OP_RESUME_TOKEN:
+            if (payload_length < PROTO_TOKEN_BYTES + 2) break;
+            memcpy(resume_token, payload, PROTO_TOKEN_BYTES);
+            resume_grace = proto_get_u16(payload + PROTO_TOKEN_BYTES);
+            have_token = 1;
+            break;
+        case OP_RESUMED:
+            if (payload_length < 4) break;
+            snprintf(opponent_name, sizeof(opponent_name), "%.*s", (int)(payload_length - 4), payload + 4);
+            show_resumed(payload[0], payload[1], payload[3]);
+            break;
+        case OP_OPPONENT_AWAY:
+            if (payload_length < 2) break;
+            printf("\n%s%s📡 %s lost their connection; their seat is held for %u seconds%s\n", BOLD, YELLOW,
+                opponent_name, proto_get_u16(payload), RESET);
+            break;
+        case OP_OPPONENT_BACK:
+            printf("\n%s%s📡 %s is back!%s\n", BOLD, GREEN, opponent_name, RESET);
+            break;
+        case OP_TIMEOUT:
+            if (payload_length < 4) break;
+            show_timeout(payload[0], payload[1] == 255 ? -1 : payload[1], payload[2], payload[3], NULL);
+            break;
+        case OP_ERROR:
+            if (payload_length < 1) break;
+            printf("\n%s%s❌ Error: %s%s\n", BOLD, RED, proto_error_text(payload[0]), RESET);
+            if (reconnecting) resume_failed();
+            break;
+    }
+}
+
+// Receives text lines, or binary frames once the server has confirmed
+// the binary protocol, and hands each to its handler
+void mark_greeted(void) {
+    pthread_mutex_lock(&greeting_mutex);
+    server_greeted = 1;
+    pthread_cond_signal(&greeting_cond);
+    pthread_mutex_unlock(&greeting_mutex);
+}
+
+// Opens a new connection after ours dropped mid-game and asks for our
+// seat back with the resume token (after the binary protocol again, if
+// we had it), trying with growing pauses for as long as the server said
+// it holds the seat. Returns -1 if no connection could be made in time.
+int reconnect(void) {
+    printf("\n%s%s🔌 Connection lost; reconnecting...%s\n", BOLD, YELLOW, RESET);
+    fflush(stdout);
+    
+    unsigned int waited_ms = 0, pause_ms = RECONNECT_PAUSE_MS;
+    while (game_active && waited_ms < resume_grace * 1000U) {
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd >= 0 && connect(fd, (struct sockaddr*)&server_addr, sizeof(server_addr)) == 0) {
+            int old = sockfd;
+            sockfd = fd;
+            close(old);
+            ring_attach(&server_input, server_input.data, RECV_RING_SIZE, RECV_MAX_FRAME);
+            reconnecting = 1;
+            if (use_binary) {
+                send_command("CAPS " PROTO_CAPABILITY "\n");
+                send_frame(OP_RESUME, resume_token, PROTO_TOKEN_BYTES);
+            } else {
+                char hex[2 * PROTO_TOKEN_BYTES + 1];
+                char command[64];
+                proto_format_token(hex, resume_token);
+                snprintf(command, sizeof(command), "RESUME %s\n", hex);
+                send_command(command);
+            }
+            return 0;
+        }
+        if (fd >= 0) close(fd);
+        poll(NULL, 0, (int)pause_ms);
+        waited_ms += pause_ms;
+        if (pause_ms < RECONNECT_PAUSE_MAX_MS) pause_ms *= 2;
+    }
+    return -1;
+}
+
 void* receive_messages(void* arg) {
     (void)arg;  // Suppress unused parameter warning
-    char buffer[BUFFER_SIZE];
     
     while (game_active) {
-        int bytes_received = recv(sockfd, buffer, BUFFER_SIZE - 1, 0);
+        char* dest;
+        size_t space = ring_write_space(&server_input, &dest);
+        ssize_t bytes_received = recv(sockfd, dest, space, 0);
+        if (bytes_received <= 0 && game_active && in_game && have_token && !reconnecting &&
+            reconnect() == 0) {
+            continue;
+        }
         if (bytes_received <= 0) {
             printf("\n%s%s🔌 Disconnected from server%s\n", BOLD, RED, RESET);
             game_active = 0;
+            mark_greeted();
             break;
         }
+        ring_commit(&server_input, bytes_received);
         
-        buffer[bytes_received] = '\0';
-        
-        char command[32], message[BUFFER_SIZE];
-        if (sscanf(buffer, "%s %[^\n]", command, message) >= 1) {
-            if (strcmp(command, "WELCOME") == 0) {
-                clear_screen();
-                print_banner();
-                printf("%s\n", message + 8); // Skip "WELCOME " prefix
-                waiting_for_username = 1;
-            } else if (strcmp(command, "USERNAME_SET") == 0) {
-                printf("%s\n", message + 13); // Skip "USERNAME_SET " prefix
-                waiting_for_username = 0;
-            } else if (strcmp(command, "WAIT_PLAYER") == 0) {
-                printf("%s\n", message + 12); // Skip "WAIT_PLAYER " prefix
-            } else if (strcmp(command, "GAME_START") == 0) {
-                clear_screen();
-                print_banner();
-                printf("%s\n", message + 11); // Skip "GAME_START " prefix
-                print_placement_help();
-                printf("%s%s💡 Place your ship now!%s\n", BOLD, GREEN, RESET);
-            } else if (strcmp(command, "SHIP_PLACED") == 0) {
-                printf("%s\n", message + 12); // Skip "SHIP_PLACED " prefix
-            } else if (strcmp(command, "BATTLE_START") == 0) {
-                clear_screen();
-                print_banner();
-                printf("%s\n", message + 13); // Skip "BATTLE_START " prefix
-                print_instructions();
-            } else if (strcmp(command, "YOUR_TURN") == 0) {
-                printf("\n%s%s🎯 YOUR TURN!%s Attack with: %sATTACK <pos>%s\n", 
-                    BOLD, GREEN, RESET, BOLD, RESET);
-                printf("%s> %s", BOLD, RESET);
-                fflush(stdout);
-            } else if (strcmp(command, "WAIT_TURN") == 0) {
-                printf("\n%s%s⏳ WAITING...%s %s\n", BOLD, YELLOW, RESET, message + 10);
-            } else if (strcmp(command, "CONTINUE") == 0) {
-                printf("\n%s%s🔥 KEEP FIRING!%s %s\n", BOLD, RED, RESET, message + 9);
-                printf("%s> %s", BOLD, RESET);
-                fflush(stdout);
-            } else if (strcmp(command, "HIT") == 0) {
-                printf("\n%s\n", message + 4); // Skip "HIT " prefix
-            } else if (strcmp(command, "MISS") == 0) {
-                printf("\n%s\n", message + 5); // Skip "MISS " prefix
-            } else if (strcmp(command, "WIN") == 0) {
-                printf("\n%s%s", BOLD, GREEN);
-                printf("╔══════════════════════════════════════════════════════════════╗\n");
-                printf("║                        🎉 VICTORY! 🎉                        ║\n");
-                printf("║                   You sunk their ship!                       ║\n");
-                printf("╚══════════════════════════════════════════════════════════════╝\n");
-                printf("%s\n", RESET);
-                game_active = 0;
-            } else if (strcmp(command, "LOSE") == 0) {
-                printf("\n%s%s", BOLD, RED);
-                printf("╔══════════════════════════════════════════════════════════════╗\n");
-                printf("║                        💀 DEFEAT 💀                         ║\n");
-                printf("║                   Your ship was sunk!                       ║\n");
-                printf("╚══════════════════════════════════════════════════════════════╝\n");
-                printf("%s\n", RESET);
-                game_active = 0;
-            } else if (strcmp(command, "GAME_OVER") == 0) {
-                printf("\n%s\n", message + 10); // Skip "GAME_OVER " prefix
-            } else if (strcmp(command, "ATTACK_RESULT") == 0) {
-                printf("%s%s📢 %s%s\n", BOLD, CYAN, message + 14, RESET);
-            } else if (strcmp(command, "ERROR") == 0) {
-                printf("\n%s%s❌ Error: %s%s\n", BOLD, RED, message + 6, RESET);
-            } else if (strcmp(command, "GRID") == 0) {
-                printf("\n%s", buffer + 5); // Skip "GRID\n"
-            } else if (strcmp(command, "BOTH_GRIDS") == 0) {
-                clear_screen();
-                print_banner();
-                printf("%s", buffer + 11); // Skip "BOTH_GRIDS\n"
-                printf("%s> %s", BOLD, RESET);
-                fflush(stdout);
+        char* frame;
+        size_t length;
+        frame_status_t status;
+        while (game_active && (status = ring_next_frame(&server_input, &frame, &length)) != FRAME_NONE) {
+            if (status == FRAME_TOO_LONG) continue;
+            if (server_input.mode == FRAMING_LENGTH) {
+                handle_binary_frame((const unsigned char*)frame, length);
             } else {
-                printf("%s", buffer);
+                handle_text_line(frame);
             }
-        } else {
-            printf("%s", buffer);
-        }
-        
-        if (!waiting_for_username && game_active) {
-            fflush(stdout);
         }
+        fflush(stdout);
+        if (!server_greeted) mark_greeted();
     }
     
     return NULL;
 }
 
-void send_command(const char* command) {
-    send(sockfd, command, strlen(command), 0);
-}
-
 void print_prompt(void) {
     if (waiting_for_username) {
         printf("%s%s👤 Username: %s", BOLD, CYAN, RESET);
@@ -190,9 +1007,23 @@ void print_prompt(void) {
     fflush(stdout);
 }
 
-int main(void) {
-    struct sockaddr_in servaddr;
+int main(int argc, char* argv[]) {
     char input[256];
+    const char* watch_room = NULL;
+    
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--binary") == 0) {
+            use_binary = 1;
+        } else if (strcmp(argv[i], "--watch") == 0) {
+            spectating = 1;
+            if (i + 1 < argc && argv[i + 1][0] >= '0' && argv[i + 1][0] <= '9') {
+                watch_room = argv[++i];
+            }
+        } else {
+            fprintf(stderr, "Usage: %s [--binary] [--watch [room]]\n", argv[0]);
+            exit(1);
+        }
+    }
     
     sockfd = socket(AF_INET, SOCK_STREAM, 0);
     if (sockfd < 0) {
@@ -200,11 +1031,11 @@ int main(void) {
         exit(1);
     }
     
-    memset(&servaddr, 0, sizeof(servaddr));
-    servaddr.sin_family = AF_INET;
-    servaddr.sin_port = htons(PORT);
+    memset(&server_addr, 0, sizeof(server_addr));
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_port = htons(PORT);
     
-    if (inet_pton(AF_INET, SERVER_IP, &servaddr.sin_addr) <= 0) {
+    if (inet_pton(AF_INET, SERVER_IP, &server_addr.sin_addr) <= 0) {
         perror("Invalid address");
         exit(1);
     }
@@ -212,19 +1043,49 @@ int main(void) {
     printf("%s%s🔗 Connecting to Mini Battleship server at %s:%d...%s\n", 
         BOLD, CYAN, SERVER_IP, PORT, RESET);
     
-    if (connect(sockfd, (struct sockaddr*)&servaddr, sizeof(servaddr)) < 0) {
+    if (connect(sockfd, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
         perror("Connection failed");
         exit(1);
     }
     
+    // Ask for the binary protocol before the username is sent
+    if (use_binary) {
+        send_command("CAPS " PROTO_CAPABILITY "\n");
+    }
+    
+    signal(SIGINT, on_fatal_signal);
+    signal(SIGTERM, on_fatal_signal);
+    
+    if (ring_init(&server_input, RECV_RING_SIZE, RECV_MAX_FRAME) < 0) {
+        perror("Buffer allocation failed");
+        exit(1);
+    }
     pthread_t recv_thread;
     if (pthread_create(&recv_thread, NULL, receive_messages, NULL) != 0) {
         perror("Thread creation failed");
         exit(1);
     }
     
-    // Wait a moment for the welcome message
-    usleep(100000);
+    // Wait for the welcome message before prompting
+    pthread_mutex_lock(&greeting_mutex);
+    while (!server_greeted) {
+        pthread_cond_wait(&greeting_cond, &greeting_mutex);
+    }
+    pthread_mutex_unlock(&greeting_mutex);
+    
+    // A spectator asks for the game in place of a username
+    if (spectating) {
+        waiting_for_username = 0;
+        if (use_binary) {
+            unsigned char payload[4];
+            proto_put_u32(payload, watch_room != NULL ? (unsigned int)strtoul(watch_room, NULL, 10) : 0);
+            send_frame(OP_WATCH, payload, watch_room != NULL ? 4 : 0);
+        } else {
+            snprintf(input, sizeof(input), "WATCH%s%s\n", watch_room != NULL ? " " : "",
+                watch_room != NULL ? watch_room : "");
+            send_command(input);
+        }
+    }
     
     while (game_active) {
         print_prompt();
@@ -241,8 +1102,13 @@ int main(void) {
         }
         
         if (strcmp(input, "QUIT") == 0 || strcmp(input, "quit") == 0) {
-            send_command("QUIT\n");
+            // Cleared first, so that the hangup is not taken for a dropped connection
             game_active = 0;
+            if (use_binary) {
+                send_frame(OP_QUIT, NULL, 0);
+            } else {
+                send_command("QUIT\n");
+            }
             break;
         } else if (strcmp(input, "HELP") == 0 || strcmp(input, "help") == 0) {
             if (!waiting_for_username) {
@@ -276,9 +1142,18 @@ int main(void) {
             }
         }
         
-        // Add newline for server protocol
-        strcat(input, "\n");
-        send_command(input);
+        if (waiting_for_username) {
+            pthread_mutex_lock(&username_mutex);
+            snprintf(requested_username, sizeof(requested_username), "%.*s", PROTO_MAX_NAME, input);
+            pthread_mutex_unlock(&username_mutex);
+        }
+        if (use_binary) {
+            send_binary_command(input);
+        } else {
+            // Add newline for server protocol
+            strcat(input, "\n");
+            send_command(input);
+        }
         
         if (waiting_for_username) {
             waiting_for_username = 0; // Will be reset by server response if needed
@@ -287,6 +1162,7 @@ int main(void) {
     
     pthread_cancel(recv_thread);
     close(sockfd);
+    restore_scrolling();
     
     printf("\n%s%s", BOLD, CYAN);
     printf("╔══════════════════════════════════════════════════════════════╗\n");
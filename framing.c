@@ -0,0 +1,166 @@
+/*
+ * File: framing.c
+ * Author: [Your Name]
+ * Date: October 17, 2026
+ * Description: Input ring buffer and frame parser (see framing.h)
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "framing.h"
+
+#define RING_MASK (ring->size - 1)
+
+int ring_init(input_ring_t* ring, unsigned int size, unsigned int max_frame) {
+    // Data and scratch share one allocation
+    char* memory = malloc(size + max_frame);
+    if (memory == NULL) return -1;
+    ring_attach(ring, memory, size, max_frame);
+    return 0;
+}
+
+void ring_attach(input_ring_t* ring, char* memory, unsigned int size, unsigned int max_frame) {
+    ring->data = memory;
+    ring->scratch = memory + size;
+    ring->size = size;
+    ring->max_frame = max_frame;
+    ring->head = 0;
+    ring->tail = 0;
+    ring->scanned = 0;
+    ring->skip = 0;
+    ring->discarding = 0;
+    ring->mode = FRAMING_LINES;
+}
+
+void ring_free(input_ring_t* ring) {
+    free(ring->data);
+    ring->data = NULL;
+    ring->scratch = NULL;
+}
+
+size_t ring_write_space(input_ring_t* ring, char** dest) {
+    unsigned int used = ring->head - ring->tail;
+    unsigned int offset = ring->head & RING_MASK;
+    unsigned int free_space = ring->size - used;
+    unsigned int contiguous = ring->size - offset;
+    
+    *dest = ring->data + offset;
+    return free_space < contiguous ? free_space : contiguous;
+}
+
+void ring_commit(input_ring_t* ring, size_t bytes) {
+    ring->head += bytes;
+}
+
+// Points *frame at length bytes starting at start, NUL-terminated. Frames
+// that sit in one piece are terminated in place over their delimiter;
+// wrapped frames are copied to scratch.
+static char* ring_frame_at(input_ring_t* ring, unsigned int start, size_t length, int in_place) {
+    unsigned int offset = start & RING_MASK;
+    
+    if (in_place && offset + length < ring->size) {
+        ring->data[offset + length] = '\0';
+        return ring->data + offset;
+    }
+    
+    size_t first = ring->size - offset;
+    if (first > length) first = length;
+    memcpy(ring->scratch, ring->data + offset, first);
+    memcpy(ring->scratch + first, ring->data, length - first);
+    ring->scratch[length] = '\0';
+    return ring->scratch;
+}
+
+static frame_status_t next_line(input_ring_t* ring, char** frame, size_t* length) {
+    while (1) {
+        unsigned int available = ring->head - ring->tail;
+        
+        while (ring->scanned < available &&
+               ring->data[(ring->tail + ring->scanned) & RING_MASK] != '\n') {
+            ring->scanned++;
+        }
+        
+        if (ring->scanned == available) {
+            // No delimiter yet: keep waiting unless the line is already too long
+            if (ring->discarding) {
+                ring->tail = ring->head;
+                ring->scanned = 0;
+                return FRAME_NONE;
+            }
+            if (available >= ring->max_frame) {
+                ring->discarding = 1;
+                ring->tail = ring->head;
+                ring->scanned = 0;
+                return FRAME_TOO_LONG;
+            }
+            return FRAME_NONE;
+        }
+        
+        unsigned int start = ring->tail;
+        size_t line_length = ring->scanned;
+        ring->tail += ring->scanned + 1;
+        ring->scanned = 0;
+        
+        if (ring->discarding) {
+            // End of an oversized line; resume with the next one
+            ring->discarding = 0;
+            continue;
+        }
+        if (line_length >= ring->max_frame) {
+            return FRAME_TOO_LONG;
+        }
+        
+        *frame = ring_frame_at(ring, start, line_length, 1);
+        if (line_length > 0 && (*frame)[line_length - 1] == '\r') {
+            (*frame)[--line_length] = '\0';
+        }
+        *length = line_length;
+        return FRAME_READY;
+    }
+}
+
+static frame_status_t next_length_prefixed(input_ring_t* ring, char** frame, size_t* length) {
+    if (ring->skip > 0) {
+        unsigned int available = ring->head - ring->tail;
+        unsigned int dropped = available < ring->skip ? available : ring->skip;
+        ring->tail += dropped;
+        ring->skip -= dropped;
+        if (ring->skip > 0) return FRAME_NONE;
+    }
+    
+    unsigned int available = ring->head - ring->tail;
+    if (available < 2) return FRAME_NONE;
+    
+    size_t frame_length = ((unsigned char)ring->data[ring->tail & RING_MASK] << 8) |
+                          (unsigned char)ring->data[(ring->tail + 1) & RING_MASK];
+    if (frame_length >= ring->max_frame) {
+        ring->tail += 2;
+        ring->skip = frame_length;
+        return FRAME_TOO_LONG;
+    }
+    if (available < 2 + frame_length) return FRAME_NONE;
+    
+    // The payload is followed by the next frame, so it is never terminated in place
+    *frame = ring_frame_at(ring, ring->tail + 2, frame_length, 0);
+    *length = frame_length;
+    ring->tail += 2 + frame_length;
+    return FRAME_READY;
+}
+
+frame_status_t ring_next_frame(input_ring_t* ring, char** frame, size_t* length) {
+    if (ring->mode == FRAMING_LENGTH) {
+        return next_length_prefixed(ring, frame, length);
+    }
+    return next_line(ring, frame, length);
+}
+
+size_t ring_pending(const input_ring_t* ring, char* out) {
+    unsigned int available = ring->head - ring->tail;
+    unsigned int offset = ring->tail & RING_MASK;
+    unsigned int first = ring->size - offset;
+    if (first > available) first = available;
+    
+    memcpy(out, ring->data + offset, first);
+    memcpy(out + first, ring->data, available - first);
+    return available;
+}
@@ -0,0 +1,69 @@
+/*
+ * File: framing.h
+ * Author: [Your Name]
+ * Date: October 17, 2026
+ * Description: Per-connection input buffering and command framing
+ *              recv() writes straight into a fixed ring buffer and the parser
+ *              hands back complete frames, however TCP split or merged them.
+ *              Frames are newline-terminated lines by default, or 2-byte
+ *              big-endian length-prefixed when a client opts in.
+ */
+
+#ifndef FRAMING_H
+#define FRAMING_H
+
+#include <stddef.h>
+
+#define INPUT_RING_SIZE 4096    // server default; sizes must be powers of two
+#define MAX_FRAME 1024          // server default longest frame, terminator included
+
+// How a connection delimits its frames
+typedef enum {
+    FRAMING_LINES,
+    FRAMING_LENGTH
+} framing_mode_t;
+
+// Result of asking for the next frame
+typedef enum {
+    FRAME_TOO_LONG = -1,        // oversized frame was dropped
+    FRAME_NONE = 0,             // need more input
+    FRAME_READY = 1             // *frame points at a NUL-terminated frame
+} frame_status_t;
+
+typedef struct {
+    char* data;
+    unsigned int size;          // bytes in data
+    unsigned int max_frame;     // longest frame accepted, terminator included
+    unsigned int head;          // total bytes written
+    unsigned int tail;          // total bytes consumed
+    unsigned int scanned;       // bytes after tail already searched for '\n'
+    unsigned int skip;          // bytes still to drop from an oversized frame
+    int discarding;             // dropping the rest of an oversized line
+    framing_mode_t mode;
+    char* scratch;              // holds frames that wrap past the ring's end
+} input_ring_t;
+
+// Allocates a ring of size bytes (a power of two) that accepts frames
+// shorter than max_frame, which must be less than size. Returns -1 if
+// the memory cannot be had.
+int ring_init(input_ring_t* ring, unsigned int size, unsigned int max_frame);
+void ring_free(input_ring_t* ring);
+
+// Sets up an empty ring over memory the caller owns, which must hold
+// size + max_frame bytes; ring_free() must not be called on it.
+void ring_attach(input_ring_t* ring, char* memory, unsigned int size, unsigned int max_frame);
+
+// Contiguous free space for the next recv(), which must be followed by
+// ring_commit() with the number of bytes actually received.
+size_t ring_write_space(input_ring_t* ring, char** dest);
+void ring_commit(input_ring_t* ring, size_t bytes);
+
+// Returns the next complete frame. Line frames lose their "\n" or "\r\n".
+// The frame stays valid until the next ring_write_space().
+frame_status_t ring_next_frame(input_ring_t* ring, char** frame, size_t* length);
+
+// Copies the bytes received and not yet taken as frames to out, which
+// must hold ring->size bytes, and returns how many there were
+size_t ring_pending(const input_ring_t* ring, char* out);
+
+#endif
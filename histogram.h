@@ -0,0 +1,91 @@
+/*
+ * File: histogram.h
+ * Author: [Your Name]
+ * Date: October 17, 2026
+ * Description: Fixed-size latency histogram with log-linear buckets
+ *              Values below 16 get a bucket each; above that every power of
+ *              two is split into 8 buckets, so a percentile read back is
+ *              within 12.5% of the true value at any scale. Recording is a
+ *              couple of shifts and an increment, with no allocation.
+ *              Each histogram has a single writer, which updates it with
+ *              relaxed atomic stores, so other threads may read (merge) it
+ *              at any time without a lock.
+ */
+
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <stdint.h>
+#include <string.h>
+
+#define HISTOGRAM_SUB_BITS 3
+#define HISTOGRAM_SUB_BUCKETS (1 << HISTOGRAM_SUB_BITS)
+#define HISTOGRAM_LINEAR (2 * HISTOGRAM_SUB_BUCKETS)
+#define HISTOGRAM_BUCKETS (HISTOGRAM_LINEAR + (64 - HISTOGRAM_SUB_BITS - 1) * HISTOGRAM_SUB_BUCKETS)
+
+typedef struct {
+    uint64_t counts[HISTOGRAM_BUCKETS];
+    uint64_t count;
+    uint64_t sum;
+    uint64_t max;
+} histogram_t;
+
+static inline void histogram_clear(histogram_t* h) {
+    memset(h, 0, sizeof(*h));
+}
+
+static inline int histogram_bucket(uint64_t value) {
+    if (value < HISTOGRAM_LINEAR) return (int)value;
+    int exponent = 63 - __builtin_clzll(value);
+    int sub = (int)(value >> (exponent - HISTOGRAM_SUB_BITS)) & (HISTOGRAM_SUB_BUCKETS - 1);
+    return HISTOGRAM_LINEAR + (exponent - HISTOGRAM_SUB_BITS - 1) * HISTOGRAM_SUB_BUCKETS + sub;
+}
+
+// Largest value that lands in bucket
+static inline uint64_t histogram_bucket_top(int bucket) {
+    if (bucket < HISTOGRAM_LINEAR) return (uint64_t)bucket;
+    int exponent = (bucket - HISTOGRAM_LINEAR) / HISTOGRAM_SUB_BUCKETS + HISTOGRAM_SUB_BITS + 1;
+    uint64_t sub = (uint64_t)((bucket - HISTOGRAM_LINEAR) % HISTOGRAM_SUB_BUCKETS);
+    uint64_t width = (uint64_t)1 << (exponent - HISTOGRAM_SUB_BITS);
+    return ((HISTOGRAM_SUB_BUCKETS + sub) << (exponent - HISTOGRAM_SUB_BITS)) + width - 1;
+}
+
+// Only the histogram's owner may record into it
+static inline void histogram_record(histogram_t* h, uint64_t value) {
+    uint64_t* bucket = &h->counts[histogram_bucket(value)];
+    __atomic_store_n(bucket, *bucket + 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&h->count, h->count + 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&h->sum, h->sum + value, __ATOMIC_RELAXED);
+    if (value > h->max) __atomic_store_n(&h->max, value, __ATOMIC_RELAXED);
+}
+
+// h += other, for folding per-thread histograms together; other may be
+// recorded into meanwhile
+static inline void histogram_merge(histogram_t* h, const histogram_t* other) {
+    for (int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        h->counts[i] += __atomic_load_n(&other->counts[i], __ATOMIC_RELAXED);
+    }
+    h->count += __atomic_load_n(&other->count, __ATOMIC_RELAXED);
+    h->sum += __atomic_load_n(&other->sum, __ATOMIC_RELAXED);
+    uint64_t max = __atomic_load_n(&other->max, __ATOMIC_RELAXED);
+    if (max > h->max) h->max = max;
+}
+
+// Value at or below which percentile percent of the samples fall, as the
+// top of its bucket (never above the largest value seen); 0 if empty
+static inline uint64_t histogram_percentile(const histogram_t* h, double percentile) {
+    if (h->count == 0) return 0;
+    uint64_t rank = (uint64_t)(percentile / 100.0 * (double)h->count + 0.5);
+    if (rank < 1) rank = 1;
+    uint64_t seen = 0;
+    for (int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        seen += h->counts[i];
+        if (seen >= rank) {
+            uint64_t top = histogram_bucket_top(i);
+            return top < h->max ? top : h->max;
+        }
+    }
+    return h->max;
+}
+
+#endif
@@ -0,0 +1,282 @@
+/*
+ * File: journal.c
+ * Author: [Your Name]
+ * Date: October 17, 2026
+ * Description: Append-only event log of every game (see journal.h)
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "journal.h"
+
+#define RECORD_BYTES sizeof(journal_record_t)
+
+static int enabled = 0;
+static char journal_dir[4096];
+static journal_sync_t sync_policy = JOURNAL_SYNC_NONE;
+static unsigned long sync_interval_ns = 0;
+static uint32_t next_game = 1;          // 0 is never a game
+
+// The open segment; guarded by journal_mutex, like the statistics
+static pthread_mutex_t journal_mutex = PTHREAD_MUTEX_INITIALIZER;
+static unsigned int segment_number = 0;
+static int segment_fd = -1;
+static char* segment_map = NULL;        // NULL once a segment could not be opened
+static size_t segment_used = 0;         // bytes appended
+static size_t segment_synced = 0;       // bytes known to be on disk
+static unsigned long last_sync_ns = 0;
+static journal_stats_t stats;
+
+// This thread's records not yet appended
+static __thread journal_record_t batch[JOURNAL_BATCH];
+static __thread int batch_count = 0;
+
+static unsigned long monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long)ts.tv_sec * 1000000000UL + (unsigned long)ts.tv_nsec;
+}
+
+int journal_parse_sync(const char* text, journal_sync_t* policy, unsigned int* interval_ms) {
+    if (strcmp(text, "none") == 0) {
+        *policy = JOURNAL_SYNC_NONE;
+        return 0;
+    }
+    if (strcmp(text, "batch") == 0) {
+        *policy = JOURNAL_SYNC_BATCH;
+        return 0;
+    }
+    char* end;
+    unsigned long ms = strtoul(text, &end, 10);
+    if (text[0] < '0' || text[0] > '9' || *end != '\0' || ms == 0 || ms > 3600000) return -1;
+    *policy = JOURNAL_SYNC_INTERVAL;
+    *interval_ms = (unsigned int)ms;
+    return 0;
+}
+
+// FNV-1a over everything before the check, folded to 16 bits
+uint16_t journal_check(const journal_record_t* record) {
+    const unsigned char* bytes = (const unsigned char*)record;
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < offsetof(journal_record_t, check); i++) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    return (uint16_t)((hash >> 16) ^ (hash & 0xFFFF));
+}
+
+void journal_segment_path(char* out, size_t size, const char* dir, unsigned int number) {
+    snprintf(out, size, "%s/journal-%06u.log", dir, number);
+}
+
+unsigned int journal_last_segment(const char* dir) {
+    DIR* listing = opendir(dir);
+    if (listing == NULL) return 0;
+    
+    unsigned int last = 0;
+    struct dirent* entry;
+    while ((entry = readdir(listing)) != NULL) {
+        const char* name = entry->d_name;
+        if (strncmp(name, "journal-", 8) != 0 || name[8] < '0' || name[8] > '9') continue;
+        char* end;
+        unsigned long number = strtoul(name + 8, &end, 10);
+        if (strcmp(end, ".log") == 0 && number > last && number <= 0xFFFFFFFFUL) {
+            last = (unsigned int)number;
+        }
+    }
+    closedir(listing);
+    return last;
+}
+
+// Game numbers go on from the highest one the last segment started, or
+// the one its header reserved if it started none
+static void resume_numbering(unsigned int number) {
+    char path[sizeof(journal_dir) + 32];
+    journal_segment_path(path, sizeof(path), journal_dir, number);
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return;
+    struct stat info;
+    if (fstat(fd, &info) < 0 || info.st_size < (off_t)RECORD_BYTES) {
+        close(fd);
+        return;
+    }
+    const journal_record_t* records = mmap(NULL, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (records == MAP_FAILED) return;
+    
+    size_t count = info.st_size / RECORD_BYTES;
+    if (records[0].type == JOURNAL_SEGMENT && records[0].check == journal_check(&records[0])) {
+        if (records[0].data.segment.next_game > next_game) next_game = records[0].data.segment.next_game;
+    }
+    for (size_t i = 1; i < count && records[i].check == journal_check(&records[i]); i++) {
+        if (records[i].type == JOURNAL_GAME_START && records[i].game >= next_game) {
+            next_game = records[i].game + 1;
+        }
+    }
+    munmap((void*)records, info.st_size);
+}
+
+// Caller holds journal_mutex (or is the only thread). Forces what was
+// appended since the last sync to disk.
+static void sync_segment(void) {
+    if (segment_used == segment_synced) return;
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t start = segment_synced & ~(page - 1);
+    msync(segment_map + start, segment_used - start, MS_SYNC);
+    segment_synced = segment_used;
+    last_sync_ns = monotonic_ns();
+    stats.syncs++;
+}
+
+// Caller holds journal_mutex. Creates and maps the segment, headed by a
+// JOURNAL_SEGMENT record. Returns -1 if any step fails.
+static int segment_open(unsigned int number, int restart) {
+    char path[sizeof(journal_dir) + 32];
+    journal_segment_path(path, sizeof(path), journal_dir, number);
+    int fd = open(path, O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd < 0) {
+        perror(path);
+        return -1;
+    }
+    if (ftruncate(fd, JOURNAL_SEGMENT_BYTES) < 0) {
+        perror(path);
+        close(fd);
+        return -1;
+    }
+    void* map = mmap(NULL, JOURNAL_SEGMENT_BYTES, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        perror(path);
+        close(fd);
+        return -1;
+    }
+    
+    journal_record_t header;
+    memset(&header, 0, sizeof(header));
+    header.type = JOURNAL_SEGMENT;
+    header.game = number;
+    header.data.segment.next_game = __atomic_load_n(&next_game, __ATOMIC_RELAXED);
+    header.data.segment.created = (uint32_t)time(NULL);
+    header.data.segment.restart = (uint8_t)restart;
+    header.check = journal_check(&header);
+    memcpy(map, &header, RECORD_BYTES);
+    
+    segment_number = number;
+    segment_fd = fd;
+    segment_map = map;
+    segment_used = RECORD_BYTES;
+    segment_synced = 0;
+    stats.segments++;
+    return 0;
+}
+
+// Caller holds journal_mutex. Unmaps the segment, cut to what it holds.
+static void segment_close(void) {
+    if (segment_map == NULL) return;
+    if (sync_policy != JOURNAL_SYNC_NONE) sync_segment();
+    munmap(segment_map, JOURNAL_SEGMENT_BYTES);
+    if (ftruncate(segment_fd, segment_used) < 0) perror("Journal segment truncate failed");
+    close(segment_fd);
+    segment_map = NULL;
+    segment_fd = -1;
+}
+
+int journal_open(const char* dir, journal_sync_t policy, unsigned int interval_ms, int restart) {
+    if (strlen(dir) >= sizeof(journal_dir)) {
+        fprintf(stderr, "Journal directory name too long: %s\n", dir);
+        return -1;
+    }
+    if (mkdir(dir, 0755) < 0 && errno != EEXIST) {
+        perror(dir);
+        return -1;
+    }
+    strcpy(journal_dir, dir);
+    sync_policy = policy;
+    sync_interval_ns = (unsigned long)interval_ms * 1000000UL;
+    
+    unsigned int last = journal_last_segment(dir);
+    if (last > 0) resume_numbering(last);
+    if (segment_open(last + 1, restart) < 0) return -1;
+    last_sync_ns = monotonic_ns();
+    __atomic_store_n(&enabled, 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
+int journal_enabled(void) {
+    return __atomic_load_n(&enabled, __ATOMIC_ACQUIRE);
+}
+
+uint32_t journal_next_game(void) {
+    return __atomic_fetch_add(&next_game, 1, __ATOMIC_RELAXED);
+}
+
+journal_record_t* journal_record(void) {
+    if (!journal_enabled()) return NULL;
+    if (batch_count == JOURNAL_BATCH) journal_flush();
+    journal_record_t* record = &batch[batch_count++];
+    memset(record, 0, sizeof(*record));
+    return record;
+}
+
+void journal_flush(void) {
+    if (batch_count == 0) return;
+    for (int i = 0; i < batch_count; i++) {
+        batch[i].check = journal_check(&batch[i]);
+    }
+    
+    pthread_mutex_lock(&journal_mutex);
+    const journal_record_t* next = batch;
+    size_t left = batch_count;
+    while (left > 0 && segment_map != NULL) {
+        size_t space = (JOURNAL_SEGMENT_BYTES - segment_used) / RECORD_BYTES;
+        if (space == 0) {
+            // Full: the next segment takes the rest. If it cannot be made
+            // the log stops here rather than leave a gap.
+            unsigned int number = segment_number + 1;
+            segment_close();
+            if (segment_open(number, 0) < 0) {
+                fprintf(stderr, "Journal stopped: records from here on are dropped\n");
+            }
+            continue;
+        }
+        size_t count = left < space ? left : space;
+        memcpy(segment_map + segment_used, next, count * RECORD_BYTES);
+        segment_used += count * RECORD_BYTES;
+        next += count;
+        left -= count;
+    }
+    stats.records += batch_count - left;
+    stats.dropped += left;
+    stats.batches++;
+    
+    if (segment_map != NULL && (sync_policy == JOURNAL_SYNC_BATCH ||
+        (sync_policy == JOURNAL_SYNC_INTERVAL && monotonic_ns() - last_sync_ns >= sync_interval_ns))) {
+        sync_segment();
+    }
+    pthread_mutex_unlock(&journal_mutex);
+    batch_count = 0;
+}
+
+void journal_close(void) {
+    if (!journal_enabled()) return;
+    journal_flush();
+    __atomic_store_n(&enabled, 0, __ATOMIC_RELEASE);
+    pthread_mutex_lock(&journal_mutex);
+    segment_close();
+    pthread_mutex_unlock(&journal_mutex);
+}
+
+void journal_get_stats(journal_stats_t* out) {
+    pthread_mutex_lock(&journal_mutex);
+    *out = stats;
+    pthread_mutex_unlock(&journal_mutex);
+}
@@ -0,0 +1,139 @@
+/*
+ * File: journal.h
+ * Author: [Your Name]
+ * Date: October 17, 2026
+ * Description: Append-only event log of every game
+ *              Each state transition of a game (its start, each player
+ *              joining, every ship placed, every attack with its result,
+ *              turn changes and the end) is one fixed-size 32-byte record.
+ *              Threads collect records in a batch of their own and append
+ *              whole batches to a memory-mapped segment file; a full
+ *              segment is closed and the next one started. How often the
+ *              mapped pages are forced to disk is a policy of its own.
+ *
+ *              Records are in host byte order. A record whose check does
+ *              not match marks the end of a segment, which is how a log
+ *              cut short by a crash is read back. Every server run starts
+ *              a new segment (a hot restart too, carrying its games on);
+ *              see replay.c for rebuilding games from them.
+ */
+
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "protocol.h"
+
+#define JOURNAL_SEGMENT_BYTES (64 * 1024 * 1024)   // 2M records per segment file
+#define JOURNAL_BATCH 256                           // records a thread holds before appending
+#define JOURNAL_NAME 20                             // bytes of a username kept (NUL-padded)
+
+typedef enum {
+    JOURNAL_SEGMENT = 1,    // first record of each file: game is the segment number
+    JOURNAL_GAME_START,     // config; step 0 of every game
+    JOURNAL_JOIN,           // seat, username
+    JOURNAL_PLACE,          // seat, the ship's row, col and orientation
+    JOURNAL_ATTACK,         // seat attacking, row, col, result and length sunk
+    JOURNAL_TURN,           // seat whose turn it now is
+    JOURNAL_GAME_OVER,      // seat that won
+    JOURNAL_LEAVE,          // seat that disconnected before the game was over
+    JOURNAL_FORFEIT,        // seat that lost by not coming back, or not moving, in time
+    JOURNAL_TIMEOUT,        // seat that ran out of time, why and how often in a row
+    JOURNAL_TYPES
+} journal_type_t;
+
+// One record. step numbers a game's records from 0: writers on different
+// threads may append them out of order, and readers put them back.
+typedef struct {
+    uint32_t game;              // journal-wide game number
+    uint16_t room;
+    uint16_t step;
+    union {
+        struct {
+            uint8_t rows;
+            uint8_t cols;
+            uint8_t ship_count;
+            uint8_t ship_lengths[PROTO_MAX_FLEET];
+        } config;
+        char username[JOURNAL_NAME];
+        struct {
+            uint8_t row;
+            uint8_t col;
+            uint8_t horizontal;
+        } place;
+        struct {
+            uint8_t row;
+            uint8_t col;
+            uint8_t result;     // an attack_result_t
+            uint8_t sunk_length;
+        } attack;
+        struct {
+            uint8_t reason;     // TIMEOUT_TURN or TIMEOUT_PLACING
+            uint8_t missed;     // turns run out in a row, this one included
+        } timeout;
+        struct {
+            uint32_t next_game; // first game number this file may start
+            uint32_t created;   // Unix time
+            uint8_t restart;    // a server started with this file, ending the games before it
+        } segment;
+    } data;
+    uint8_t type;
+    uint8_t seat;
+    uint16_t check;
+} journal_record_t;
+
+// When mapped pages are forced to disk. A record that is never synced
+// still survives the server crashing, just not the machine doing so.
+typedef enum {
+    JOURNAL_SYNC_NONE,          // leave it to the kernel
+    JOURNAL_SYNC_BATCH,         // before an append returns
+    JOURNAL_SYNC_INTERVAL       // once this many milliseconds have passed, checked per append
+} journal_sync_t;
+
+typedef struct {
+    unsigned long records;
+    unsigned long batches;
+    unsigned long segments;     // opened by this run
+    unsigned long syncs;
+    unsigned long dropped;      // records lost to a failed segment
+} journal_stats_t;
+
+// Parses "none", "batch" or a number of milliseconds into *policy and
+// *interval_ms. Returns -1 for anything else.
+int journal_parse_sync(const char* text, journal_sync_t* policy, unsigned int* interval_ms);
+
+// Starts a new segment in dir (created if need be) after the ones already
+// there, numbering games on from theirs. restart says the games those
+// left unfinished ended with the server that wrote them; a hot restart
+// carries them on instead. Returns -1, having said why on stderr, if the
+// log cannot be written.
+int journal_open(const char* dir, journal_sync_t policy, unsigned int interval_ms, int restart);
+
+// Nonzero once journal_open() has succeeded
+int journal_enabled(void);
+
+// A number for a game about to start, never used before in this log
+uint32_t journal_next_game(void);
+
+// Zeroes and returns the next record of this thread's batch, appending
+// the batch first if it is full, or returns NULL if no log is kept. The
+// record is the caller's to fill in until the next journal call.
+journal_record_t* journal_record(void);
+
+// Appends this thread's batch to the log
+void journal_flush(void);
+
+// Appends this thread's batch, syncs per the policy, cuts the current
+// segment to what it holds and stops logging
+void journal_close(void);
+
+void journal_get_stats(journal_stats_t* stats);
+
+// For readers: the check a record must carry, the path of segment number
+// in dir, and the highest segment number there (0 if there is none)
+uint16_t journal_check(const journal_record_t* record);
+void journal_segment_path(char* out, size_t size, const char* dir, unsigned int number);
+unsigned int journal_last_segment(const char* dir);
+
+#endif
@@ -0,0 +1,664 @@
+#define _GNU_SOURCE
+
+/*
+ * File: loadgen.c
+ * Author: [Your Name]
+ * Date: October 17, 2026
+ * Description: Load generator for the Mini Battleship server
+ *              Drives many bot players over real TCP connections from a single
+ *              epoll loop and reports connection counts and games per second.
+ *              With -b the bots negotiate the binary protocol, so the bytes
+ *              received per attack of the two protocols can be compared.
+ *              Bots play whatever board and fleet the server announces,
+ *              firing at random or hunting around their hits (-s hunt).
+ *              With -a each plays the server's computer opponent instead
+ *              of another bot, asking for it as soon as it is queued;
+ *              bots queued at the same moment may still be paired, and
+ *              only games against the computer are counted then.
+ *              Connect latency and the round trip of every command are
+ *              recorded and reported as percentiles at the end.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include "board.h"
+#include "histogram.h"
+#include "protocol.h"
+
+#define PORT 19845
+#define SERVER_IP "127.0.0.1"
+#define BOT_BUFFER 16384
+#define MAX_EVENTS 256
+#define PLACEMENT_TRIES 1000
+#define MAX_PENDING 16     // commands in flight per bot (a fleet's PLACEs at most)
+
+// Bot states
+typedef enum {
+    BOT_CONNECTING,
+    BOT_CONNECTED
+} bot_state_t;
+
+// How bots pick their next target
+typedef enum {
+    STRATEGY_RANDOM,        // every cell once, in shuffled order
+    STRATEGY_HUNT           // random until a hit, then its neighbours
+} strategy_t;
+
+// Commands whose round trip is timed, up to the server's reply
+typedef enum {
+    COMMAND_USERNAME,       // USERNAME_SET
+    COMMAND_PLACE,          // SHIP_PLACED
+    COMMAND_ATTACK,         // HIT, MISS, SUNK or WIN
+    COMMAND_TYPES
+} command_t;
+
+static const char* command_names[COMMAND_TYPES] = { "username", "place", "attack" };
+
+// A command sent and not yet answered
+typedef struct {
+    command_t command;
+    uint64_t sent;
+} pending_t;
+
+// One simulated player
+typedef struct {
+    int fd;
+    int id;
+    bot_state_t state;
+    int idle;
+    unsigned int rng;
+    board_config_t config;      // from the server's GAME_CONFIG
+    unsigned short targets[PROTO_MAX_CELLS];
+    int next_target;
+    bitword_t fired[BITBOARD_MAX_WORDS];    // cells attacked this game
+    unsigned short hunt[PROTO_MAX_CELLS];   // neighbours of hits, tried first
+    int hunt_count;
+    int last_target;
+    uint64_t connect_start;
+    int greeted;                // WELCOME seen since connecting
+    pending_t pending[MAX_PENDING];     // oldest first; the server answers in order
+    int pending_count;
+    int binary;                 // server confirmed the binary protocol
+    int against_computer;       // this game's opponent is the server's bot
+    char inbuf[BOT_BUFFER];
+    int inlen;
+} bot_t;
+
+// Global variables
+struct sockaddr_in servaddr;
+int epoll_fd = -1;
+int open_connections = 0;
+int peak_connections = 0;
+unsigned long games_completed = 0;
+unsigned long connects = 0;
+unsigned long connect_failures = 0;
+unsigned long bytes_received = 0;
+unsigned long attacks_sent = 0;
+int binary_protocol = 0;
+strategy_t strategy = STRATEGY_RANDOM;
+int computer_level = -1;        // -a: the server's bot at this level is every player's opponent
+static const char* computer_levels[] = { "easy", "normal", "hard" };    // as numbered by OP_BOT
+
+// Latencies in nanoseconds: connect() to WELCOME, and each command type
+histogram_t connect_latency;
+histogram_t command_latency[COMMAND_TYPES];
+
+double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+void raise_fd_limit(void) {
+    struct rlimit rl;
+    if (getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur < rl.rlim_max) {
+        rl.rlim_cur = rl.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &rl);
+    }
+}
+
+void bot_send(bot_t* bot, const char* message) {
+    send(bot->fd, message, strlen(message), MSG_NOSIGNAL);
+}
+
+void bot_send_frame(bot_t* bot, int opcode, const unsigned char* payload, size_t length) {
+    unsigned char frame[PROTO_MAX_PAYLOAD + 3];
+    size_t n = proto_encode_frame(frame, opcode, payload, length);
+    send(bot->fd, frame, n, MSG_NOSIGNAL);
+}
+
+// Notes the send time of a command so its reply can be timed
+void bot_expect(bot_t* bot, command_t command) {
+    if (bot->pending_count == MAX_PENDING) return;
+    bot->pending[bot->pending_count].command = command;
+    bot->pending[bot->pending_count].sent = now_ns();
+    bot->pending_count++;
+}
+
+// The server answered the oldest command in flight
+void bot_answered(bot_t* bot) {
+    if (bot->pending_count == 0) return;
+    pending_t* oldest = &bot->pending[0];
+    histogram_record(&command_latency[oldest->command], now_ns() - oldest->sent);
+    bot->pending_count--;
+    memmove(bot->pending, bot->pending + 1, bot->pending_count * sizeof(pending_t));
+}
+
+void bot_connect(bot_t* bot) {
+    bot->fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    if (bot->fd < 0) {
+        perror("Socket creation failed");
+        exit(1);
+    }
+    
+    // Reset on close so thousands of short games do not pile up in TIME_WAIT
+    struct linger lg = { .l_onoff = 1, .l_linger = 0 };
+    setsockopt(bot->fd, SOL_SOCKET, SO_LINGER, &lg, sizeof(lg));
+    int nodelay = 1;
+    setsockopt(bot->fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+    
+    bot->state = BOT_CONNECTING;
+    bot->binary = 0;
+    bot->inlen = 0;
+    bot->greeted = 0;
+    bot->pending_count = 0;
+    bot->against_computer = 0;
+    bot->connect_start = now_ns();
+    if (connect(bot->fd, (struct sockaddr*)&servaddr, sizeof(servaddr)) < 0 && errno != EINPROGRESS) {
+        perror("Connection failed");
+        exit(1);
+    }
+    
+    struct epoll_event ev = { .events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET, .data.ptr = bot };
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, bot->fd, &ev) < 0) {
+        perror("epoll_ctl failed");
+        exit(1);
+    }
+}
+
+void bot_disconnect(bot_t* bot) {
+    if (bot->state == BOT_CONNECTED) {
+        open_connections--;
+    }
+    close(bot->fd);
+    bot->fd = -1;
+}
+
+void bot_reconnect(bot_t* bot) {
+    bot_disconnect(bot);
+    bot_connect(bot);
+}
+
+void bot_place(bot_t* bot, int row, int col, int horizontal) {
+    bot_expect(bot, COMMAND_PLACE);
+    if (bot->binary) {
+        unsigned char payload[3] = { (unsigned char)col, (unsigned char)row, (unsigned char)horizontal };
+        bot_send_frame(bot, OP_PLACE, payload, 3);
+        return;
+    }
+    char command[32];
+    snprintf(command, sizeof(command), "PLACE %c%d %c\n", 'A' + col, row + 1, horizontal ? 'H' : 'V');
+    bot_send(bot, command);
+}
+
+// Lays out the whole fleet at random and sends every PLACE at once, then
+// shuffles the attack order for the new game
+void bot_start_game(bot_t* bot) {
+    board_config_t* config = &bot->config;
+    int cells = config->rows * config->cols;
+    bitword_t masks[BOARD_MAX_STORAGE_WORDS];
+    board_state_t board;
+    board.masks = masks;
+    
+    for (int i = 0; i < cells; i++) {
+        bot->targets[i] = (unsigned short)i;
+    }
+    for (int i = cells - 1; i > 0; i--) {
+        int j = rand_r(&bot->rng) % (i + 1);
+        unsigned short tmp = bot->targets[i];
+        bot->targets[i] = bot->targets[j];
+        bot->targets[j] = tmp;
+    }
+    bot->next_target = 0;
+    bot->hunt_count = 0;
+    bitboard_clear(bot->fired, config->words);
+    
+    board_reset(&board, config);
+    while (!board_fleet_placed(&board, config)) {
+        int tries = 0, row, col, horizontal;
+        do {
+            horizontal = rand_r(&bot->rng) % 2;
+            row = rand_r(&bot->rng) % config->rows;
+            col = rand_r(&bot->rng) % config->cols;
+        } while (!board_can_place(&board, config, row, col, horizontal) && ++tries < PLACEMENT_TRIES);
+        
+        if (tries == PLACEMENT_TRIES) {
+            // Crowded board: take the first spot that fits, or start over
+            int found = 0;
+            for (int cell = 0; cell < 2 * cells && !found; cell++) {
+                row = (cell / 2) / config->cols;
+                col = (cell / 2) % config->cols;
+                horizontal = cell % 2;
+                found = board_can_place(&board, config, row, col, horizontal);
+            }
+            if (!found) {
+                board_reset(&board, config);
+                continue;
+            }
+        }
+        board_place(&board, config, row, col, horizontal);
+    }
+    
+    for (int i = 0; i < board.ships_placed; i++) {
+        ship_t* ship = &board.fleet[i];
+        bot_place(bot, ship->cell / config->cols, ship->cell % config->cols, ship->stride == 1);
+    }
+}
+
+// Next cell not yet fired at: a neighbour of an earlier hit if hunting,
+// otherwise the next of the shuffled cells. -1 once every cell is used.
+int bot_next_target(bot_t* bot) {
+    while (bot->hunt_count > 0) {
+        int cell = bot->hunt[--bot->hunt_count];
+        if (!bitboard_test(bot->fired, cell)) return cell;
+    }
+    while (bot->next_target < bot->config.rows * bot->config.cols) {
+        int cell = bot->targets[bot->next_target++];
+        if (!bitboard_test(bot->fired, cell)) return cell;
+    }
+    return -1;
+}
+
+// Queues the unfired neighbours of a hit for the hunt strategy
+void bot_on_hit(bot_t* bot) {
+    if (strategy != STRATEGY_HUNT || bot->last_target < 0) return;
+    int cols = bot->config.cols;
+    int row = bot->last_target / cols, col = bot->last_target % cols;
+    int neighbours[4][2] = { { row - 1, col }, { row + 1, col }, { row, col - 1 }, { row, col + 1 } };
+    
+    for (int i = 0; i < 4; i++) {
+        int r = neighbours[i][0], c = neighbours[i][1];
+        if (r < 0 || r >= bot->config.rows || c < 0 || c >= cols) continue;
+        if (bitboard_test(bot->fired, r * cols + c) || bot->hunt_count == PROTO_MAX_CELLS) continue;
+        bot->hunt[bot->hunt_count++] = (unsigned short)(r * cols + c);
+    }
+}
+
+// The ship around the hunt is gone: back to searching
+void bot_on_sunk(bot_t* bot) {
+    bot->hunt_count = 0;
+}
+
+void bot_attack(bot_t* bot) {
+    int cols = bot->config.cols;
+    int cell = bot_next_target(bot);
+    bot->last_target = cell;
+    if (cell < 0) return;
+    
+    bitboard_set(bot->fired, cell);
+    attacks_sent++;
+    bot_expect(bot, COMMAND_ATTACK);
+    if (bot->binary) {
+        unsigned char payload[2] = { (unsigned char)(cell % cols), (unsigned char)(cell / cols) };
+        bot_send_frame(bot, OP_ATTACK, payload, 2);
+        return;
+    }
+    char command[32];
+    snprintf(command, sizeof(command), "ATTACK %c%d\n", 'A' + cell % cols, cell / cols + 1);
+    bot_send(bot, command);
+}
+
+// Reacts to one line from the server. Returns -1 when the game is over.
+int bot_handle_line(bot_t* bot, const char* line) {
+    char verb[32];
+    int len = 0;
+    
+    // Only lines that start with an upper-case verb matter; grid art is skipped
+    while (len < (int)sizeof(verb) - 1 && ((line[len] >= 'A' && line[len] <= 'Z') || line[len] == '_')) {
+        verb[len] = line[len];
+        len++;
+    }
+    if (len == 0 || (line[len] != ' ' && line[len] != '\0')) return 0;
+    verb[len] = '\0';
+    
+    if (strcmp(verb, "WELCOME") == 0) {
+        if (!bot->greeted) {
+            histogram_record(&connect_latency, now_ns() - bot->connect_start);
+            bot->greeted = 1;
+        }
+        if (!bot->idle && binary_protocol) {
+            bot_send(bot, "CAPS " PROTO_CAPABILITY "\n");
+        } else if (!bot->idle) {
+            char username[32];
+            snprintf(username, sizeof(username), "bot%d\n", bot->id);
+            bot_expect(bot, COMMAND_USERNAME);
+            bot_send(bot, username);
+        }
+    } else if (strcmp(verb, "CAPS_OK") == 0) {
+        char username[32];
+        int len = snprintf(username, sizeof(username), "bot%d", bot->id);
+        bot->binary = 1;
+        bot_expect(bot, COMMAND_USERNAME);
+        bot_send_frame(bot, OP_USERNAME, (const unsigned char*)username, len);
+    } else if (strcmp(verb, "SEAT") == 0) {
+        // "<seat> <opponent>"
+        const char* opponent = line[len] == ' ' ? strchr(line + len + 1, ' ') : NULL;
+        bot->against_computer = computer_level >= 0 && opponent != NULL && strncmp(opponent + 1, "Bot (", 5) == 0;
+    } else if (strcmp(verb, "WAIT_PLAYER") == 0 && computer_level >= 0) {
+        char request[32];
+        snprintf(request, sizeof(request), "BOT %s\n", computer_levels[computer_level]);
+        bot_send(bot, request);
+    } else if (strcmp(verb, "USERNAME_SET") == 0 || strcmp(verb, "SHIP_PLACED") == 0 ||
+               strcmp(verb, "MISS") == 0) {
+        bot_answered(bot);
+    } else if (strcmp(verb, "HIT") == 0) {
+        bot_answered(bot);
+        bot_on_hit(bot);
+    } else if (strcmp(verb, "SUNK") == 0) {
+        bot_answered(bot);
+        bot_on_sunk(bot);
+    } else if (strcmp(verb, "GAME_CONFIG") == 0) {
+        // "<rows> <cols> <length>..."
+        board_config_t config;
+        char fleet[64] = "";
+        if (sscanf(line + len, " %d %d %63[0-9 ]", &config.rows, &config.cols, fleet) != 3) return 0;
+        for (char* c = fleet; *c; c++) {
+            if (*c == ' ') *c = ',';
+        }
+        if (config.rows < 1 || config.rows > PROTO_MAX_ROWS || config.cols < 1 || config.cols > PROTO_MAX_COLS ||
+            board_config_set_fleet(&config, fleet) < 0) return 0;
+        config.words = bitboard_words(config.rows * config.cols);
+        bot->config = config;
+        bot_start_game(bot);
+    } else if (strcmp(verb, "YOUR_TURN") == 0 || strcmp(verb, "CONTINUE") == 0) {
+        bot_attack(bot);
+    } else if (strcmp(verb, "ERROR") == 0) {
+        // A BOT that lost the race to another player's join has no place in pending
+        if (strstr(line, "Not waiting") != NULL) return 0;
+        bot_answered(bot);
+        if (strstr(line, "Invalid attack") != NULL) bot_attack(bot);
+    } else if (strcmp(verb, "WIN") == 0) {
+        bot_answered(bot);
+        if (computer_level < 0 || bot->against_computer) games_completed++;
+    } else if (strcmp(verb, "LOSE") == 0 && bot->against_computer) {
+        games_completed++;      // no other bot of ours counts this game's win
+    } else if (strcmp(verb, "GAME_OVER") == 0) {
+        return -1;
+    }
+    return 0;
+}
+
+// Binary counterpart of bot_handle_line()
+int bot_handle_frame(bot_t* bot, const unsigned char* frame, int length) {
+    if (length == 0) return 0;
+    
+    switch (frame[0]) {
+        case OP_GAME_CONFIG: {
+            if (length < 4 || length < 4 + frame[3] || frame[3] < 1 || frame[3] > PROTO_MAX_FLEET) break;
+            board_config_t* config = &bot->config;
+            config->rows = frame[1];
+            config->cols = frame[2];
+            if (config->rows < 1 || config->rows > PROTO_MAX_ROWS ||
+                config->cols < 1 || config->cols > PROTO_MAX_COLS) break;
+            config->words = bitboard_words(config->rows * config->cols);
+            config->ship_count = frame[3];
+            for (int i = 0; i < config->ship_count; i++) {
+                config->ship_lengths[i] = frame[4 + i];
+            }
+            bot_start_game(bot);
+            break;
+        }
+        case OP_GAME_START:
+            bot->against_computer = computer_level >= 0 && length > 5 && memcmp(frame + 2, "Bot (", 5) == 0;
+            break;
+        case OP_YOUR_TURN:
+        case OP_CONTINUE:
+            bot_attack(bot);
+            break;
+        case OP_WAIT_PLAYER:
+            if (computer_level >= 0) {
+                unsigned char payload[1] = { (unsigned char)computer_level };
+                bot_send_frame(bot, OP_BOT, payload, 1);
+            }
+            break;
+        case OP_USERNAME_SET:
+        case OP_SHIP_PLACED:
+        case OP_MISS:
+            bot_answered(bot);
+            break;
+        case OP_HIT:
+            bot_answered(bot);
+            bot_on_hit(bot);
+            break;
+        case OP_SUNK:
+            bot_answered(bot);
+            bot_on_sunk(bot);
+            break;
+        case OP_ERROR:
+            if (length > 1 && frame[1] == ERR_NOT_WAITING) break;
+            bot_answered(bot);
+            if (length > 1 && frame[1] == ERR_BAD_ATTACK) bot_attack(bot);
+            break;
+        case OP_WIN:
+            bot_answered(bot);
+            if (computer_level < 0 || bot->against_computer) games_completed++;
+            break;
+        case OP_LOSE:
+            if (bot->against_computer) games_completed++;
+            break;
+        case OP_GAME_OVER:
+            return -1;
+    }
+    return 0;
+}
+
+// Reads everything available and handles each complete line or frame
+int bot_on_readable(bot_t* bot) {
+    while (1) {
+        ssize_t n = recv(bot->fd, bot->inbuf + bot->inlen, BOT_BUFFER - 1 - bot->inlen, 0);
+        if (n == 0) return -1;
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) return 0;
+            return -1;
+        }
+        bot->inlen += n;
+        bytes_received += n;
+        
+        // Lines until CAPS_OK switches the bot to length-prefixed frames
+        char* start = bot->inbuf;
+        char* end = bot->inbuf + bot->inlen;
+        while (start < end) {
+            if (bot->binary) {
+                if (end - start < 2) break;
+                int length = ((unsigned char)start[0] << 8) | (unsigned char)start[1];
+                if (end - start < 2 + length) break;
+                if (bot_handle_frame(bot, (const unsigned char*)start + 2, length) < 0) return -1;
+                start += 2 + length;
+            } else {
+                char* newline = memchr(start, '\n', end - start);
+                if (newline == NULL) break;
+                *newline = '\0';
+                if (bot_handle_line(bot, start) < 0) return -1;
+                start = newline + 1;
+            }
+        }
+        
+        bot->inlen -= start - bot->inbuf;
+        memmove(bot->inbuf, start, bot->inlen);
+        if (bot->inlen >= BOT_BUFFER - 1) {
+            bot->inlen = 0; // Oversized line: drop it
+        }
+    }
+}
+
+void bot_on_event(bot_t* bot, unsigned int events) {
+    if (bot->state == BOT_CONNECTING) {
+        int err = 0;
+        socklen_t len = sizeof(err);
+        getsockopt(bot->fd, SOL_SOCKET, SO_ERROR, &err, &len);
+        if (err != 0) {
+            connect_failures++;
+            bot_reconnect(bot);
+            return;
+        }
+        if (!(events & (EPOLLOUT | EPOLLIN))) return;
+        
+        bot->state = BOT_CONNECTED;
+        connects++;
+        open_connections++;
+        if (open_connections > peak_connections) {
+            peak_connections = open_connections;
+        }
+    }
+    
+    if (bot_on_readable(bot) < 0) {
+        bot_reconnect(bot);
+    }
+}
+
+// One row of the latency table, in microseconds
+void print_latency(const char* name, const histogram_t* h) {
+    printf("%-10s %9llu %9.1f %9.1f %9.1f %9.1f %9.1f\n", name, (unsigned long long)h->count,
+        histogram_percentile(h, 50) / 1e3, histogram_percentile(h, 90) / 1e3,
+        histogram_percentile(h, 99) / 1e3, histogram_percentile(h, 99.9) / 1e3, h->max / 1e3);
+}
+
+void usage(const char* prog) {
+    fprintf(stderr,
+        "Usage: %s [-h host] [-p port] [-c players] [-i idle] [-d seconds] [-b] [-s strategy] [-a level]\n"
+        "  -c  concurrent players, paired into games (default 100)\n"
+        "  -i  extra connections that never send a username (default 0)\n"
+        "  -d  test duration in seconds (default 10)\n"
+        "  -b  play over the binary protocol instead of text\n"
+        "  -s  random (fire at every cell in random order, default) or\n"
+        "      hunt (fire around each hit until the ship sinks)\n"
+        "  -a  play the server's computer opponent (easy, normal or hard), one\n"
+        "      game per player, instead of pairing players\n", prog);
+    exit(1);
+}
+
+int main(int argc, char* argv[]) {
+    const char* host = SERVER_IP;
+    int port = PORT;
+    int players = 100;
+    int idle = 0;
+    double duration = 10;
+    
+    int opt;
+    while ((opt = getopt(argc, argv, "h:p:c:i:d:bs:a:")) != -1) {
+        switch (opt) {
+            case 'h': host = optarg; break;
+            case 'p': port = atoi(optarg); break;
+            case 'c': players = atoi(optarg); break;
+            case 'i': idle = atoi(optarg); break;
+            case 'd': duration = atof(optarg); break;
+            case 'b': binary_protocol = 1; break;
+            case 's':
+                if (strcmp(optarg, "random") == 0) strategy = STRATEGY_RANDOM;
+                else if (strcmp(optarg, "hunt") == 0) strategy = STRATEGY_HUNT;
+                else usage(argv[0]);
+                break;
+            case 'a':
+                for (int level = 0; level < 3; level++) {
+                    if (strcmp(optarg, computer_levels[level]) == 0) computer_level = level;
+                }
+                if (computer_level < 0) usage(argv[0]);
+                break;
+            default: usage(argv[0]);
+        }
+    }
+    
+    signal(SIGPIPE, SIG_IGN);
+    raise_fd_limit();
+    
+    memset(&servaddr, 0, sizeof(servaddr));
+    servaddr.sin_family = AF_INET;
+    servaddr.sin_port = htons(port);
+    if (inet_pton(AF_INET, host, &servaddr.sin_addr) <= 0) {
+        perror("Invalid address");
+        exit(1);
+    }
+    
+    epoll_fd = epoll_create1(0);
+    if (epoll_fd < 0) {
+        perror("epoll_create1 failed");
+        exit(1);
+    }
+    
+    int total = players + idle;
+    bot_t* bots = calloc(total, sizeof(bot_t));
+    if (bots == NULL) {
+        perror("Bot allocation failed");
+        exit(1);
+    }
+    for (int i = 0; i < total; i++) {
+        bots[i].id = i;
+        bots[i].idle = (i >= players);
+        bots[i].rng = (unsigned int)(i * 2654435761u + 1);
+        bot_connect(&bots[i]);
+    }
+    
+    struct epoll_event events[MAX_EVENTS];
+    double start = now_seconds();
+    double end = start + duration;
+    double next_report = start + 1;
+    
+    while (now_seconds() < end) {
+        int n = epoll_wait(epoll_fd, events, MAX_EVENTS, 100);
+        if (n < 0 && errno != EINTR) {
+            perror("epoll_wait failed");
+            exit(1);
+        }
+        for (int i = 0; i < n; i++) {
+            bot_on_event(events[i].data.ptr, events[i].events);
+        }
+        
+        double t = now_seconds();
+        if (t >= next_report) {
+            printf("[%5.1fs] open=%d games=%lu\n", t - start, open_connections, games_completed);
+            fflush(stdout);
+            next_report += 1;
+        }
+    }
+    
+    double elapsed = now_seconds() - start;
+    printf("%-10s %9s %9s %9s %9s %9s %9s\n", "latency_us", "count", "p50", "p90", "p99", "p99.9", "max");
+    print_latency("connect", &connect_latency);
+    for (int i = 0; i < COMMAND_TYPES; i++) {
+        print_latency(command_names[i], &command_latency[i]);
+    }
+    
+    // The summary stays the last line; bench/models.sh reads it with tail
+    printf("players=%d idle=%d open=%d peak_open=%d connects=%lu failures=%lu "
+        "games=%lu elapsed=%.2fs games_per_sec=%.1f protocol=%s strategy=%s bytes_per_attack=%.1f opponent=%s\n",
+        players, idle, open_connections, peak_connections, connects, connect_failures,
+        games_completed, elapsed, games_completed / elapsed,
+        binary_protocol ? "binary" : "text", strategy == STRATEGY_HUNT ? "hunt" : "random", attacks_sent ? (double)bytes_received / attacks_sent : 0.0,
+        computer_level >= 0 ? computer_levels[computer_level] : "players");
+    
+    for (int i = 0; i < total; i++) {
+        if (bots[i].fd >= 0) close(bots[i].fd);
+    }
+    free(bots);
+    return 0;
+}
@@ -0,0 +1,241 @@
+/*
+ * File: logger.c
+ * Author: [Your Name]
+ * Date: October 17, 2026
+ * Description: Asynchronous server log (see logger.h)
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <signal.h>
+#include <pthread.h>
+#include <arpa/inet.h>
+#include "logger.h"
+#include "render.h"
+
+#define LOG_RECORDS 8192        // ring size, a power of two
+#define LOG_NAME 20
+#define LOG_TEXT 72
+#define LOG_BATCH 65536         // bytes formatted per write
+#define LOG_LINE_MAX 256        // longest line one record formats to
+#define LOG_IDLE_NS 2000000     // writer's sleep while the ring is empty
+
+// One event, 128 bytes. sequence is the ring's hand-off: a slot at ring
+// position p is free for the producer that claims p while sequence == p,
+// and holds a finished record for the writer once sequence == p + 1.
+typedef struct {
+    unsigned long sequence;
+    unsigned char event;
+    unsigned int number;
+    char player[LOG_NAME];
+    char other[LOG_NAME];
+    char text[LOG_TEXT];
+} log_record_t;
+
+static const log_level_t event_levels[LOG_EVENTS] = {
+    [LOG_CONNECT] = LOG_INFO,
+    [LOG_COMMAND] = LOG_DEBUG,
+    [LOG_OPCODE] = LOG_DEBUG,
+    [LOG_DISCONNECT] = LOG_INFO,
+    [LOG_NOT_READING] = LOG_WARN,
+    [LOG_GAME_START] = LOG_INFO,
+    [LOG_GAME_WON] = LOG_INFO,
+    [LOG_SEAT_HELD] = LOG_INFO,
+    [LOG_RESUMED] = LOG_INFO,
+    [LOG_TIMED_OUT] = LOG_INFO,
+    [LOG_TURN_TIMEOUT] = LOG_INFO
+};
+
+static const char* level_names[LOG_OFF + 1] = { "debug", "info", "warn", "off" };
+
+static log_level_t min_level = LOG_OFF;
+static log_record_t* records = NULL;
+static unsigned long tail = 0;          // next position to claim, shared by producers
+static unsigned long head = 0;          // next position to write, writer only
+static unsigned long dropped = 0;       // records lost to a full ring
+static int stop_requested = 0;
+static pthread_t writer;
+
+int logger_parse_level(const char* name) {
+    for (int level = LOG_DEBUG; level <= LOG_OFF; level++) {
+        if (strcmp(name, level_names[level]) == 0) return level;
+    }
+    return -1;
+}
+
+// Copies src into a field of size bytes, cut short if need be
+static void copy_field(char* dest, size_t size, const char* src) {
+    size_t length = 0;
+    if (src != NULL) {
+        length = strlen(src);
+        if (length >= size) length = size - 1;
+        memcpy(dest, src, length);
+    }
+    dest[length] = '\0';
+}
+
+int logger_wants(log_event_t event) {
+    return event_levels[event] >= __atomic_load_n(&min_level, __ATOMIC_RELAXED);
+}
+
+void logger_event(log_event_t event, unsigned int number,
+                  const char* player, const char* other, const char* text) {
+    if (!logger_wants(event)) return;
+    
+    // Claim the next position unless the writer has yet to free its slot
+    unsigned long position = __atomic_load_n(&tail, __ATOMIC_RELAXED);
+    log_record_t* record;
+    while (1) {
+        record = &records[position & (LOG_RECORDS - 1)];
+        unsigned long sequence = __atomic_load_n(&record->sequence, __ATOMIC_ACQUIRE);
+        long difference = (long)(sequence - position);
+        if (difference == 0) {
+            if (__atomic_compare_exchange_n(&tail, &position, position + 1, 1,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) break;
+        } else if (difference < 0) {
+            __atomic_fetch_add(&dropped, 1, __ATOMIC_RELAXED);
+            return;
+        } else {
+            position = __atomic_load_n(&tail, __ATOMIC_RELAXED);
+        }
+    }
+    
+    record->event = event;
+    record->number = number;
+    copy_field(record->player, LOG_NAME, player);
+    copy_field(record->other, LOG_NAME, other);
+    copy_field(record->text, LOG_TEXT, text);
+    __atomic_store_n(&record->sequence, position + 1, __ATOMIC_RELEASE);
+}
+
+// Formats one record as a line at out, which has room for LOG_LINE_MAX
+static int format_record(char* out, const log_record_t* record) {
+    switch (record->event) {
+        case LOG_CONNECT: {
+            struct in_addr address;
+            char text[INET_ADDRSTRLEN];
+            address.s_addr = record->number;
+            inet_ntop(AF_INET, &address, text, sizeof(text));
+            return snprintf(out, LOG_LINE_MAX, "%s%s⭐ New player connected from %s%s\n",
+                BOLD, GREEN, text, RESET);
+        }
+        case LOG_COMMAND:
+            return snprintf(out, LOG_LINE_MAX, "Player %s: %s\n", record->player, record->text);
+        case LOG_OPCODE:
+            return snprintf(out, LOG_LINE_MAX, "Player %s: [opcode 0x%02x]\n",
+                record->player, record->number);
+        case LOG_DISCONNECT:
+            return snprintf(out, LOG_LINE_MAX, "Player %s disconnected\n", record->player);
+        case LOG_NOT_READING:
+            return snprintf(out, LOG_LINE_MAX, "Player %s disconnected: not reading replies\n",
+                record->player);
+        case LOG_GAME_START:
+            return snprintf(out, LOG_LINE_MAX, "Room %u: game started: %s vs %s\n",
+                record->number, record->player, record->other);
+        case LOG_GAME_WON:
+            return snprintf(out, LOG_LINE_MAX, "Room %u: %s wins\n", record->number, record->player);
+        case LOG_SEAT_HELD:
+            return snprintf(out, LOG_LINE_MAX, "Room %u: holding %s's seat\n", record->number, record->player);
+        case LOG_RESUMED:
+            return snprintf(out, LOG_LINE_MAX, "Room %u: %s is back\n", record->number, record->player);
+        case LOG_TIMED_OUT:
+            return snprintf(out, LOG_LINE_MAX, "Player %s disconnected: %s timed out\n",
+                record->player, record->text);
+        case LOG_TURN_TIMEOUT:
+            return snprintf(out, LOG_LINE_MAX, "Room %u: %s ran out of time (%s)\n", record->number,
+                record->player, record->text);
+        default:
+            return 0;
+    }
+}
+
+static void write_batch(const char* batch, size_t length) {
+    if (length == 0) return;
+    fwrite(batch, 1, length, stdout);
+    fflush(stdout);
+}
+
+// Writes every finished record in the ring. Returns how many there were.
+static unsigned long write_pending(char* batch) {
+    size_t used = 0;
+    unsigned long count = 0;
+    while (1) {
+        log_record_t* record = &records[head & (LOG_RECORDS - 1)];
+        if (__atomic_load_n(&record->sequence, __ATOMIC_ACQUIRE) != head + 1) break;
+        
+        if (LOG_BATCH - used < LOG_LINE_MAX) {
+            write_batch(batch, used);
+            used = 0;
+        }
+        int length = format_record(batch + used, record);
+        if (length > 0) {
+            used += length < LOG_LINE_MAX ? (size_t)length : LOG_LINE_MAX - 1;
+        }
+        __atomic_store_n(&record->sequence, head + LOG_RECORDS, __ATOMIC_RELEASE);
+        head++;
+        count++;
+    }
+    
+    unsigned long lost = __atomic_exchange_n(&dropped, 0, __ATOMIC_RELAXED);
+    if (lost > 0) {
+        if (LOG_BATCH - used < LOG_LINE_MAX) {
+            write_batch(batch, used);
+            used = 0;
+        }
+        used += snprintf(batch + used, LOG_LINE_MAX,
+            "(%lu log lines dropped: the log writer fell behind)\n", lost);
+    }
+    write_batch(batch, used);
+    return count;
+}
+
+static void* writer_main(void* arg) {
+    (void)arg;
+    char* batch = malloc(LOG_BATCH);
+    if (batch == NULL) return NULL;
+    
+    // A stop seen before the ring was found empty means nothing is left
+    while (1) {
+        int stopping = __atomic_load_n(&stop_requested, __ATOMIC_ACQUIRE);
+        if (write_pending(batch) == 0) {
+            if (stopping) break;
+            struct timespec idle = { 0, LOG_IDLE_NS };
+            nanosleep(&idle, NULL);
+        }
+    }
+    free(batch);
+    return NULL;
+}
+
+void logger_init(log_level_t level) {
+    if (level >= LOG_OFF) return;
+    records = malloc(LOG_RECORDS * sizeof(log_record_t));
+    if (records == NULL) return;
+    for (unsigned long i = 0; i < LOG_RECORDS; i++) {
+        records[i].sequence = i;
+    }
+    
+    // Signals belong to the threads that wait on them, never the writer
+    sigset_t all, original;
+    sigfillset(&all);
+    pthread_sigmask(SIG_BLOCK, &all, &original);
+    int error = pthread_create(&writer, NULL, writer_main, NULL);
+    pthread_sigmask(SIG_SETMASK, &original, NULL);
+    if (error != 0) {
+        free(records);
+        records = NULL;
+        return;
+    }
+    min_level = level;
+}
+
+void logger_stop(void) {
+    if (records == NULL) return;
+    __atomic_store_n(&min_level, LOG_OFF, __ATOMIC_RELAXED);
+    __atomic_store_n(&stop_requested, 1, __ATOMIC_RELEASE);
+    pthread_join(writer, NULL);
+}
@@ -0,0 +1,62 @@
+/*
+ * File: logger.h
+ * Author: [Your Name]
+ * Date: October 17, 2026
+ * Description: Asynchronous server log
+ *              Threads serving connections never format text or touch
+ *              stdout: each event is copied as a fixed-size binary record
+ *              into a bounded lock-free ring, and one writer thread turns
+ *              the records into lines and writes them out in batches. When
+ *              the writer falls behind the ring fills and new records are
+ *              dropped and counted rather than waited for.
+ */
+
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <stddef.h>
+
+typedef enum {
+    LOG_DEBUG,          // every command received
+    LOG_INFO,           // connections and games
+    LOG_WARN,           // clients dropped for misbehaving
+    LOG_OFF
+} log_level_t;
+
+// Each event has a fixed level and line format; the fields it uses:
+typedef enum {
+    LOG_CONNECT,        // number: IPv4 address, network byte order
+    LOG_COMMAND,        // player, text: the command line
+    LOG_OPCODE,         // player, number: binary frame opcode
+    LOG_DISCONNECT,     // player
+    LOG_NOT_READING,    // player
+    LOG_GAME_START,     // number: room, player and other
+    LOG_GAME_WON,       // number: room, player: the winner
+    LOG_SEAT_HELD,      // number: room, player whose connection dropped
+    LOG_RESUMED,        // number: room, player back in their seat
+    LOG_TIMED_OUT,      // player dropped, text: what for (handshake, idle)
+    LOG_TURN_TIMEOUT,   // number: room, player who ran out of time, text: the turn or placing
+    LOG_EVENTS
+} log_event_t;
+
+// Parses "debug", "info", "warn" or "off"; -1 for anything else
+int logger_parse_level(const char* name);
+
+// Logs events at level and above from here on and starts the writer.
+// Call once, before any other thread starts; until then, or with LOG_OFF,
+// logger_event() does nothing.
+void logger_init(log_level_t level);
+
+// Whether event is logged at the current level, for callers that would
+// otherwise gather its fields for nothing
+int logger_wants(log_event_t event);
+
+// Records event for the writer; strings longer than a record holds are
+// cut short. NULL strings are logged as empty. Never blocks.
+void logger_event(log_event_t event, unsigned int number,
+                  const char* player, const char* other, const char* text);
+
+// Writes out every record logged so far and stops the writer
+void logger_stop(void);
+
+#endif
@@ -0,0 +1,429 @@
+/*
+ * File: outqueue.c
+ * Author: [Your Name]
+ * Date: October 17, 2026
+ * Description: Per-connection output queue (see outqueue.h)
+ */
+
+#define _GNU_SOURCE
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <pthread.h>
+#ifdef __linux__
+#include <time.h>
+#include <sys/ioctl.h>
+#include <netinet/in.h>
+#include <linux/errqueue.h>
+#include <linux/sockios.h>
+#endif
+#include "outqueue.h"
+
+__thread unsigned long outq_syscalls = 0;
+unsigned long outq_zerocopy_sends = 0;
+unsigned long outq_zerocopy_copied = 0;
+
+// A socket closed with zero-copy sends in flight, kept open with the
+// buffers they read from until the kernel is done with them
+typedef struct outq_parked {
+    struct outq_parked* next;
+    int fd;
+    output_queue_t queue;
+} outq_parked_t;
+
+static outq_parked_t* parked = NULL;
+static int parked_count = 0;
+static pthread_mutex_t parked_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+outq_shared_t* outq_shared_create(const void* data, size_t length) {
+    outq_shared_t* shared = malloc(sizeof(outq_shared_t) + length);
+    if (shared == NULL) return NULL;
+    shared->refcount = 1;
+    shared->length = length;
+    memcpy(shared->data, data, length);
+    return shared;
+}
+
+void outq_shared_ref(outq_shared_t* shared) {
+    __atomic_fetch_add(&shared->refcount, 1, __ATOMIC_RELAXED);
+}
+
+void outq_shared_unref(outq_shared_t* shared) {
+    if (__atomic_sub_fetch(&shared->refcount, 1, __ATOMIC_ACQ_REL) == 0) {
+        free(shared);
+    }
+}
+
+void outq_init(output_queue_t* queue) {
+    memset(queue, 0, sizeof(*queue));
+}
+
+static char* chunk_data(outq_chunk_t* chunk) {
+    return chunk->shared != NULL ? chunk->shared->data : chunk->data;
+}
+
+static void chunk_free(outq_chunk_t* chunk) {
+    if (chunk->shared != NULL) outq_shared_unref(chunk->shared);
+    free(chunk);
+}
+
+// Lets go of the buffers held for zero-copy sends up to and including id
+static void outq_release_zerocopy(output_queue_t* queue, unsigned int id) {
+    while (queue->zc_done != queue->zc_next && (int)(id - queue->zc_done) >= 0) {
+        outq_shared_t** held = &queue->zc_held[queue->zc_done % OUTQ_ZEROCOPY_SENDS];
+        if (*held != NULL) outq_shared_unref(*held);
+        *held = NULL;
+        queue->zc_done++;
+    }
+}
+
+// Sends already made keep their ids, so completions still line up if the
+// socket goes on being written to
+void outq_clear(output_queue_t* queue) {
+    outq_chunk_t* chunk = queue->head;
+    while (chunk != NULL) {
+        outq_chunk_t* next = chunk->next;
+        chunk_free(chunk);
+        chunk = next;
+    }
+    queue->head = NULL;
+    queue->tail = NULL;
+    queue->bytes = 0;
+}
+
+// Whether the kernel may still read from the buffers of the queue's
+// zero-copy sends: completions are outstanding and the socket has bytes
+// it has not seen acknowledged
+static int outq_zerocopy_pending(output_queue_t* queue, int fd) {
+    if (queue->zc_done == queue->zc_next) return 0;
+    outq_reap(queue, fd);
+    if (queue->zc_done == queue->zc_next) return 0;
+#ifdef SIOCOUTQ
+    int unsent;
+    if (ioctl(fd, SIOCOUTQ, &unsent) < 0 || unsent == 0) return 0;
+#endif
+    return 1;
+}
+
+void outq_close(output_queue_t* queue, int fd) {
+    outq_clear(queue);
+    outq_parked_t* node = NULL;
+    if (outq_zerocopy_pending(queue, fd)) node = malloc(sizeof(outq_parked_t));
+    if (node == NULL) {
+        // Nothing in flight, or no memory to wait with: closing is all that is left
+        close(fd);
+        outq_release_zerocopy(queue, queue->zc_next - 1);
+        return;
+    }
+
+    // Ends the stream after the queued bytes, as close() would have
+    shutdown(fd, SHUT_WR);
+    node->fd = fd;
+    node->queue = *queue;
+    pthread_mutex_lock(&parked_mutex);
+    node->next = parked;
+    parked = node;
+    __atomic_store_n(&parked_count, parked_count + 1, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&parked_mutex);
+    queue->zc_done = queue->zc_next;
+    memset(queue->zc_held, 0, sizeof(queue->zc_held));
+}
+
+int outq_sweep(void) {
+    if (__atomic_load_n(&parked_count, __ATOMIC_ACQUIRE) == 0) return 0;
+    pthread_mutex_lock(&parked_mutex);
+    outq_parked_t** link = &parked;
+    while (*link != NULL) {
+        outq_parked_t* node = *link;
+        if (outq_zerocopy_pending(&node->queue, node->fd)) {
+            link = &node->next;
+            continue;
+        }
+        close(node->fd);
+        outq_release_zerocopy(&node->queue, node->queue.zc_next - 1);
+        *link = node->next;
+        free(node);
+        parked_count--;
+    }
+    int count = parked_count;
+    __atomic_store_n(&parked_count, count, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&parked_mutex);
+    return count;
+}
+
+static void outq_link(output_queue_t* queue, outq_chunk_t* chunk) {
+    if (queue->tail != NULL) {
+        queue->tail->next = chunk;
+    } else {
+        queue->head = chunk;
+    }
+    queue->tail = chunk;
+    queue->bytes += chunk->end - chunk->start;
+}
+
+// Queues length bytes at data, which lie in shared, by reference
+static int outq_attach(output_queue_t* queue, outq_shared_t* shared, const char* data, size_t length) {
+    if (length == 0) return 0;
+    outq_chunk_t* chunk = malloc(sizeof(outq_chunk_t));
+    if (chunk == NULL) return -1;
+    outq_shared_ref(shared);
+    chunk->next = NULL;
+    chunk->shared = shared;
+    chunk->start = (size_t)(data - shared->data);
+    chunk->end = chunk->start + length;
+    chunk->size = chunk->end;       // nothing is ever appended to it
+    outq_link(queue, chunk);
+    return 0;
+}
+
+// Copies bytes onto the end of the queue, topping up the last chunk first
+static int outq_append(output_queue_t* queue, const char* data, size_t length) {
+    outq_chunk_t* tail = queue->tail;
+    if (tail != NULL && tail->size > tail->end) {
+        size_t room = tail->size - tail->end;
+        size_t n = length < room ? length : room;
+        memcpy(tail->data + tail->end, data, n);
+        tail->end += n;
+        queue->bytes += n;
+        data += n;
+        length -= n;
+    }
+    if (length == 0) return 0;
+
+    size_t size = length > OUTQ_CHUNK_SIZE ? length : OUTQ_CHUNK_SIZE;
+    outq_chunk_t* chunk = malloc(sizeof(outq_chunk_t) + size);
+    if (chunk == NULL) return -1;
+    chunk->next = NULL;
+    chunk->shared = NULL;
+    chunk->start = 0;
+    chunk->end = length;
+    chunk->size = size;
+    memcpy(chunk->data, data, length);
+    outq_link(queue, chunk);
+    return 0;
+}
+
+// Queues one caller buffer, by reference if it lies in a shared buffer
+static int outq_keep(output_queue_t* queue, const struct iovec* iov,
+                     outq_shared_t* const* owners, int i, size_t skip) {
+    const char* data = (const char*)iov[i].iov_base + skip;
+    size_t length = iov[i].iov_len - skip;
+    if (owners != NULL && owners[i] != NULL) return outq_attach(queue, owners[i], data, length);
+    return outq_append(queue, data, length);
+}
+
+// Whether the chunk goes out with MSG_ZEROCOPY: large enough to be worth
+// pinning, and its buffer stays put until the kernel lets it go
+static int outq_zerocopy_chunk(const output_queue_t* queue, const outq_chunk_t* chunk) {
+    return queue->zerocopy && chunk->shared != NULL && chunk->end - chunk->start >= OUTQ_ZEROCOPY_MIN &&
+           queue->zc_next - queue->zc_done < OUTQ_ZEROCOPY_SENDS;
+}
+
+// Drops sent bytes from the front of the queue; returns what is left of sent
+static size_t outq_drop(output_queue_t* queue, size_t sent) {
+    while (sent > 0 && queue->head != NULL) {
+        outq_chunk_t* chunk = queue->head;
+        size_t available = chunk->end - chunk->start;
+        size_t n = sent < available ? sent : available;
+        chunk->start += n;
+        queue->bytes -= n;
+        sent -= n;
+
+        if (chunk->start == chunk->end) {
+            queue->head = chunk->next;
+            if (queue->head == NULL) queue->tail = NULL;
+            chunk_free(chunk);
+        }
+    }
+    return sent;
+}
+
+int outq_write(output_queue_t* queue, int fd, const struct iovec* iov,
+               outq_shared_t* const* owners, int count) {
+    int next = 0;           // first caller buffer not completely written
+    size_t offset = 0;      // bytes of iov[next] already written
+
+    // Large shared buffers are sent from the queue, where a zero-copy send
+    // can hold on to them
+    for (int i = 0; queue->zerocopy && owners != NULL && i < count; i++) {
+        if (owners[i] != NULL && iov[i].iov_len >= OUTQ_ZEROCOPY_MIN) {
+            if (outq_push(queue, iov, owners, count) < 0) return -1;
+            count = 0;
+        }
+    }
+
+    while (1) {
+        struct iovec vec[OUTQ_MAX_IOV];
+        int n = 0;
+
+        // Queued bytes first; the caller's only once all of them fit. A
+        // zero-copy chunk goes alone, so no other bytes are pinned with it.
+        outq_chunk_t* zerocopy = NULL;
+        outq_chunk_t* chunk = queue->head;
+        for (; chunk != NULL && n < OUTQ_MAX_IOV; chunk = chunk->next) {
+            if (outq_zerocopy_chunk(queue, chunk)) {
+                if (n == 0) zerocopy = chunk;
+                break;
+            }
+            vec[n].iov_base = chunk_data(chunk) + chunk->start;
+            vec[n].iov_len = chunk->end - chunk->start;
+            n++;
+        }
+        if (zerocopy != NULL) {
+            vec[0].iov_base = chunk_data(zerocopy) + zerocopy->start;
+            vec[0].iov_len = zerocopy->end - zerocopy->start;
+            n = 1;
+        } else if (chunk == NULL) {
+            while (next < count && iov[next].iov_len == offset) {
+                next++;
+                offset = 0;
+            }
+            for (int i = next; i < count && n < OUTQ_MAX_IOV; i++) {
+                size_t skip = (i == next) ? offset : 0;
+                vec[n].iov_base = (char*)iov[i].iov_base + skip;
+                vec[n].iov_len = iov[i].iov_len - skip;
+                n++;
+            }
+        }
+        if (n == 0) return 0;
+
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = vec;
+        msg.msg_iovlen = n;
+        int flags = MSG_DONTWAIT | MSG_NOSIGNAL;
+#ifdef MSG_ZEROCOPY
+        if (zerocopy != NULL) flags |= MSG_ZEROCOPY;
+#endif
+        outq_syscalls++;
+        ssize_t sent = sendmsg(fd, &msg, flags);
+        if (sent < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            if (errno == ENOBUFS && zerocopy != NULL) {
+                // Out of memory to pin pages with: copy from now on
+                queue->zerocopy = 0;
+                continue;
+            }
+            return -1;
+        }
+        if (zerocopy != NULL) {
+            outq_shared_ref(zerocopy->shared);
+            queue->zc_held[queue->zc_next % OUTQ_ZEROCOPY_SENDS] = zerocopy->shared;
+            queue->zc_next++;
+            __atomic_fetch_add(&outq_zerocopy_sends, 1, __ATOMIC_RELAXED);
+        }
+
+        size_t left = outq_drop(queue, (size_t)sent);
+        while (left > 0) {
+            size_t remaining = iov[next].iov_len - offset;
+            if (left >= remaining) {
+                left -= remaining;
+                next++;
+                offset = 0;
+            } else {
+                offset += left;
+                left = 0;
+            }
+        }
+    }
+
+    // The socket is full: keep the rest of the caller's bytes for later
+    for (int i = next; i < count; i++) {
+        if (outq_keep(queue, iov, owners, i, i == next ? offset : 0) < 0) return -1;
+    }
+    return queue->bytes > 0 ? 1 : 0;
+}
+
+int outq_push(output_queue_t* queue, const struct iovec* iov, outq_shared_t* const* owners, int count) {
+    for (int i = 0; i < count; i++) {
+        if (outq_keep(queue, iov, owners, i, 0) < 0) return -1;
+    }
+    return 0;
+}
+
+int outq_peek(const output_queue_t* queue, struct iovec* vec, int max) {
+    int n = 0;
+    for (outq_chunk_t* chunk = queue->head; chunk != NULL && n < max; chunk = chunk->next) {
+        vec[n].iov_base = chunk_data(chunk) + chunk->start;
+        vec[n].iov_len = chunk->end - chunk->start;
+        n++;
+    }
+    return n;
+}
+
+void outq_consume(output_queue_t* queue, size_t bytes) {
+    outq_drop(queue, bytes);
+}
+
+size_t outq_copy(const output_queue_t* queue, size_t offset, char* out, size_t max) {
+    size_t copied = 0;
+    for (outq_chunk_t* chunk = queue->head; chunk != NULL && copied < max; chunk = chunk->next) {
+        size_t length = chunk->end - chunk->start;
+        if (offset >= length) {
+            offset -= length;
+            continue;
+        }
+        size_t count = length - offset;
+        if (count > max - copied) count = max - copied;
+        memcpy(out + copied, chunk_data(chunk) + chunk->start + offset, count);
+        copied += count;
+        offset = 0;
+    }
+    return copied;
+}
+
+int outq_enable_zerocopy(output_queue_t* queue, int fd) {
+#if defined(SO_ZEROCOPY) && defined(MSG_ZEROCOPY)
+    int one = 1;
+    if (setsockopt(fd, SOL_SOCKET, SO_ZEROCOPY, &one, sizeof(one)) < 0) return -1;
+    queue->zerocopy = 1;
+    return 0;
+#else
+    (void)queue;
+    (void)fd;
+    return -1;
+#endif
+}
+
+int outq_reap(output_queue_t* queue, int fd) {
+    int count = 0;
+#ifdef SO_EE_ORIGIN_ZEROCOPY
+    while (1) {
+        char control[128];
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        outq_syscalls++;
+        if (recvmsg(fd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+
+        // Each notification completes the sends with ids ee_info to ee_data
+        for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+            if (cmsg->cmsg_level != SOL_IP || cmsg->cmsg_type != IP_RECVERR) continue;
+            struct sock_extended_err* err = (struct sock_extended_err*)CMSG_DATA(cmsg);
+            if (err->ee_errno != 0 || err->ee_origin != SO_EE_ORIGIN_ZEROCOPY) continue;
+
+            if (err->ee_code & SO_EE_CODE_ZEROCOPY_COPIED) {
+                // The kernel copied after all, as it must for a local peer:
+                // pinning pages only costs here
+                __atomic_fetch_add(&outq_zerocopy_copied, err->ee_data - err->ee_info + 1, __ATOMIC_RELAXED);
+                queue->zerocopy = 0;
+            }
+            outq_release_zerocopy(queue, err->ee_data);
+            count++;
+        }
+    }
+#else
+    (void)queue;
+    (void)fd;
+#endif
+    return count;
+}
@@ -0,0 +1,120 @@
+/*
+ * File: outqueue.h
+ * Author: [Your Name]
+ * Date: October 17, 2026
+ * Description: Per-connection output queue
+ *              Replies are written with one gathering sendmsg() per batch and
+ *              never block: whatever the socket will not take right now is
+ *              copied into a list of chunks and written, in order, once the
+ *              socket is writable again. The caller watches the queued byte
+ *              count to apply backpressure or drop a reader that fell behind.
+ *
+ *              Bytes meant for many connections are built once as a shared
+ *              buffer and queued by reference, not copied. On Linux a queue
+ *              can send large shared buffers with MSG_ZEROCOPY, holding them
+ *              until the kernel reports it is done with their pages.
+ */
+
+#ifndef OUTQUEUE_H
+#define OUTQUEUE_H
+
+#include <stddef.h>
+#include <sys/uio.h>
+
+#define OUTQ_CHUNK_SIZE 16384   // chunks grow past this only for larger replies
+#define OUTQ_MAX_IOV 64         // buffers per sendmsg() call
+#define OUTQ_ZEROCOPY_MIN 16384 // smaller writes are cheaper to copy
+#define OUTQ_ZEROCOPY_SENDS 8   // zero-copy sends awaiting completion, per queue
+#define OUTQ_SWEEP_MS 100       // how often parked sockets are looked at
+
+// Immutable bytes shared by every queue they were written to; freed with
+// the last reference
+typedef struct {
+    int refcount;
+    size_t length;
+    char data[];
+} outq_shared_t;
+
+typedef struct outq_chunk {
+    struct outq_chunk* next;
+    outq_shared_t* shared;      // if set, the bytes are shared->data
+    size_t start;               // first byte not yet written
+    size_t end;                 // bytes filled
+    size_t size;
+    char data[];
+} outq_chunk_t;
+
+typedef struct {
+    outq_chunk_t* head;
+    outq_chunk_t* tail;
+    size_t bytes;               // queued and not yet written
+    int zerocopy;               // send large shared buffers with MSG_ZEROCOPY
+    unsigned int zc_done;       // id of the oldest zero-copy send not completed
+    unsigned int zc_next;       // id the kernel gives the next one
+    outq_shared_t* zc_held[OUTQ_ZEROCOPY_SENDS];    // by id, until completed
+} output_queue_t;
+
+// Zero-copy sends made and those the kernel copied anyway (loopback does),
+// over every queue
+extern unsigned long outq_zerocopy_sends;
+extern unsigned long outq_zerocopy_copied;
+
+// A shared buffer holding a copy of length bytes, with one reference for
+// the caller; NULL if memory ran out
+outq_shared_t* outq_shared_create(const void* data, size_t length);
+void outq_shared_ref(outq_shared_t* shared);
+void outq_shared_unref(outq_shared_t* shared);
+
+void outq_init(output_queue_t* queue);
+
+// Frees every queued chunk. Buffers of zero-copy sends still in flight stay
+// held, since the kernel pins their pages but not the allocation: freed,
+// the memory could be reused while the socket still has to send from it.
+// outq_reap() or outq_close() lets go of them.
+void outq_clear(output_queue_t* queue);
+
+// Clears the queue and closes its socket. If zero-copy sends may still be
+// reading from their buffers, the socket is shut down for writing instead
+// and parked with the buffers until outq_sweep() sees they are done.
+void outq_close(output_queue_t* queue, int fd);
+
+// Closes the parked sockets whose zero-copy sends have completed, or whose
+// bytes have all been acknowledged, and frees their buffers. Returns how
+// many are still parked; while any are, call it every OUTQ_SWEEP_MS or so.
+int outq_sweep(void);
+
+// Writes whatever is queued and then the count buffers in iov, as far as
+// the socket takes them without blocking (iov may be NULL to just flush).
+// The rest is queued. owners, if not NULL, gives the shared buffer each
+// iov entry lies in, or NULL for bytes that must be copied to be kept.
+// Returns 0 once everything is written, 1 if bytes remain queued, or -1
+// if the connection failed or memory ran out.
+int outq_write(output_queue_t* queue, int fd, const struct iovec* iov,
+               outq_shared_t* const* owners, int count);
+
+// sendmsg() calls made by outq_write() on this thread
+extern __thread unsigned long outq_syscalls;
+
+// For writers that complete asynchronously: outq_push() queues the count
+// buffers in iov behind what is already there (-1 if memory ran out),
+// outq_peek() points up to max iovecs at the queued bytes, which stay put
+// until outq_consume() drops the first bytes of them once written.
+// Appending never moves bytes already queued.
+int outq_push(output_queue_t* queue, const struct iovec* iov, outq_shared_t* const* owners, int count);
+int outq_peek(const output_queue_t* queue, struct iovec* vec, int max);
+void outq_consume(output_queue_t* queue, size_t bytes);
+
+// Copies up to max queued bytes, starting offset bytes in, to out, and
+// returns how many were copied. The queue is left as it was.
+size_t outq_copy(const output_queue_t* queue, size_t offset, char* out, size_t max);
+
+// Turns on MSG_ZEROCOPY for the socket. Returns -1 where it is unsupported.
+int outq_enable_zerocopy(output_queue_t* queue, int fd);
+
+// Reads the kernel's zero-copy completions off the socket's error queue and
+// lets go of the buffers they release. A socket reports them as an error
+// condition (EPOLLERR, POLLERR); returns how many were read, so the caller
+// can tell them from a real error.
+int outq_reap(output_queue_t* queue, int fd);
+
+#endif
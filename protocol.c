@@ -0,0 +1,296 @@
+/*
+ * File: protocol.c
+ * Author: [Your Name]
+ * Date: October 17, 2026
+ * Description: Binary frame encoding, text command decoding and error
+ *              and timeout wording (see protocol.h)
+ */
+
+#include <string.h>
+#include "protocol.h"
+
+static const char* error_texts[ERR_COUNT] = {
+    "Unknown error",
+    "Not in ship placement phase",
+    "Ship already placed",
+    "Invalid ship placement",
+    "Invalid format. Use: PLACE <pos> <H|V>",
+    "Not in battle phase",
+    "Not your turn",
+    "Invalid attack",
+    "Invalid format. Use: ATTACK <pos>",
+    "Not in a game",
+    "Command too long",
+    "Invalid format. Use: FRAMING <LINES|LENGTH>",
+    "Unsupported capability",
+    "Malformed frame",
+    "No such game in progress",
+    "Only a new connection can watch a game",
+    "Spectators cannot play",
+    "Unknown or expired resume token",
+    "Not waiting for an opponent",
+    "Invalid format. Use: BOT [EASY|NORMAL|HARD]"
+};
+
+const char* proto_error_text(int code) {
+    if (code <= 0 || code >= ERR_COUNT) return error_texts[0];
+    return error_texts[code];
+}
+
+static const char* timeout_names[TIMEOUT_COUNT] = {
+    "HANDSHAKE", "IDLE", "TURN", "PLACING"
+};
+
+const char* proto_timeout_name(int reason) {
+    if (reason < 0 || reason >= TIMEOUT_COUNT) return "UNKNOWN";
+    return timeout_names[reason];
+}
+
+int proto_parse_position(const char* text, int* col, int* row) {
+    proto_view_t view = { text, strlen(text) };
+    return proto_parse_position_view(view, col, row);
+}
+
+int proto_parse_position_view(proto_view_t view, int* col, int* row) {
+    if (view.length < 2 || view.length > 3) return 0;
+    unsigned int letter = (unsigned char)view.text[0] | 0x20;     // lower case
+    if (letter < 'a' || letter > 'z') return 0;
+    
+    unsigned int tens = (unsigned char)view.text[1] - '0';
+    if (tens > 9) return 0;
+    unsigned int number = tens;
+    if (view.length == 3) {
+        unsigned int ones = (unsigned char)view.text[2] - '0';
+        if (ones > 9) return 0;
+        number = tens * 10 + ones;
+    }
+    if (number == 0) return 0;
+    
+    *col = (int)(letter - 'a');
+    *row = (int)number - 1;
+    return 1;
+}
+
+int proto_parse_number_view(proto_view_t view, unsigned int* value) {
+    if (view.length == 0 || view.length > 9) return 0;
+    unsigned int number = 0;
+    for (size_t i = 0; i < view.length; i++) {
+        unsigned int digit = (unsigned char)view.text[i] - '0';
+        if (digit > 9) return 0;
+        number = number * 10 + digit;
+    }
+    *value = number;
+    return 1;
+}
+
+// The characters sscanf()'s %s stops at
+static int is_space(char c) {
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+int proto_next_token(const char** cursor, const char* end, proto_view_t* token) {
+    const char* p = *cursor;
+    while (p < end && is_space(*p)) p++;
+    const char* start = p;
+    while (p < end && !is_space(*p)) p++;
+    *cursor = p;
+    token->text = start;
+    token->length = (size_t)(p - start);
+    return p > start;
+}
+
+proto_view_t proto_rest_of_line(const char* cursor, const char* end) {
+    while (cursor < end && is_space(*cursor)) cursor++;
+    const char* newline = memchr(cursor, '\n', (size_t)(end - cursor));
+    proto_view_t rest = { cursor, (size_t)((newline != NULL ? newline : end) - cursor) };
+    return rest;
+}
+
+// Dispatch on the length first: no two verbs of one length share a first
+// letter, bar RESUME and RESYNC, which their fourth tells apart, so one
+// or two bytes pick the candidate and one memcmp() confirms it
+proto_verb_t proto_lookup_verb(proto_view_t word) {
+    const char* name;
+    proto_verb_t verb;
+    switch (word.length) {
+        case 3:
+            name = "BOT";
+            verb = VERB_BOT;
+            break;
+        case 4:
+            switch (word.text[0]) {
+                case 'C': name = "CAPS"; verb = VERB_CAPS; break;
+                case 'G': name = "GRID"; verb = VERB_GRID; break;
+                case 'Q': name = "QUIT"; verb = VERB_QUIT; break;
+                default: return VERB_NONE;
+            }
+            break;
+        case 5:
+            switch (word.text[0]) {
+                case 'P': name = "PLACE"; verb = VERB_PLACE; break;
+                case 'W': name = "WATCH"; verb = VERB_WATCH; break;
+                default: return VERB_NONE;
+            }
+            break;
+        case 6:
+            switch (word.text[0]) {
+                case 'A': name = "ATTACK"; verb = VERB_ATTACK; break;
+                case 'R':
+                    if (word.text[3] == 'U') {
+                        name = "RESUME";
+                        verb = VERB_RESUME;
+                    } else {
+                        name = "RESYNC";
+                        verb = VERB_RESYNC;
+                    }
+                    break;
+                default: return VERB_NONE;
+            }
+            break;
+        case 7:
+            name = "FRAMING";
+            verb = VERB_FRAMING;
+            break;
+        default:
+            return VERB_NONE;
+    }
+    return memcmp(word.text, name, word.length) == 0 ? verb : VERB_NONE;
+}
+
+int proto_view_equals(proto_view_t view, const char* text) {
+    return strlen(text) == view.length && memcmp(view.text, text, view.length) == 0;
+}
+
+void proto_format_token(char* out, const unsigned char* token) {
+    static const char digits[] = "0123456789abcdef";
+    for (int i = 0; i < PROTO_TOKEN_BYTES; i++) {
+        out[2 * i] = digits[token[i] >> 4];
+        out[2 * i + 1] = digits[token[i] & 15];
+    }
+    out[2 * PROTO_TOKEN_BYTES] = '\0';
+}
+
+static int hex_digit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    c |= 0x20;      // lower case
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+int proto_parse_token_view(proto_view_t view, unsigned char* token) {
+    if (view.length != 2 * PROTO_TOKEN_BYTES) return 0;
+    for (int i = 0; i < PROTO_TOKEN_BYTES; i++) {
+        int high = hex_digit(view.text[2 * i]), low = hex_digit(view.text[2 * i + 1]);
+        if (high < 0 || low < 0) return 0;
+        token[i] = (unsigned char)(high << 4 | low);
+    }
+    return 1;
+}
+
+void proto_parse_text_command(const char* buffer, size_t length, int has_username, proto_command_t* cmd) {
+    // The line ends at the first NUL, as it would for sscanf()
+    const char* end = memchr(buffer, '\0', length);
+    if (end == NULL) end = buffer + length;
+    
+    const char* cursor = buffer;
+    proto_view_t word;
+    proto_verb_t verb = proto_next_token(&cursor, end, &word) ? proto_lookup_verb(word) : VERB_NONE;
+    proto_view_t args = proto_rest_of_line(cursor, end);
+    
+    if (!has_username && verb == VERB_CAPS) {
+        cmd->type = CMD_CAPS;
+        cmd->arg = args;
+    } else if (verb == VERB_WATCH) {
+        cmd->type = CMD_WATCH;
+        cmd->arg = args;
+        cmd->valid = proto_parse_number_view(args, &cmd->room_id);
+    } else if (!has_username && verb == VERB_RESUME) {
+        const char* at = args.text;
+        proto_view_t token;
+        cmd->type = CMD_RESUME;
+        cmd->valid = proto_next_token(&at, args.text + args.length, &token) &&
+                     proto_parse_token_view(token, cmd->token);
+    } else if (!has_username && end > buffer) {
+        cmd->type = CMD_USERNAME;
+        cmd->arg.text = buffer;
+        cmd->arg.length = (size_t)(end - buffer);
+    } else if (verb == VERB_PLACE) {
+        const char* at = args.text;
+        proto_view_t pos, orientation;
+        cmd->type = CMD_PLACE;
+        if (proto_next_token(&at, args.text + args.length, &pos) &&
+            proto_next_token(&at, args.text + args.length, &orientation) &&
+            proto_parse_position_view(pos, &cmd->col, &cmd->row)) {
+            cmd->valid = 1;
+            cmd->horizontal = proto_view_equals(orientation, "H");
+        }
+    } else if (verb == VERB_ATTACK) {
+        const char* at = args.text;
+        proto_view_t pos;
+        cmd->type = CMD_ATTACK;
+        if (proto_next_token(&at, args.text + args.length, &pos) &&
+            proto_parse_position_view(pos, &cmd->col, &cmd->row)) {
+            cmd->valid = 1;
+        }
+    } else if (verb == VERB_GRID || verb == VERB_RESYNC) {
+        cmd->type = CMD_GRID;
+    } else if (verb == VERB_FRAMING) {
+        cmd->type = CMD_FRAMING;
+        cmd->arg = args;
+    } else if (verb == VERB_QUIT) {
+        cmd->type = CMD_QUIT;
+    } else if (verb == VERB_BOT) {
+        const char* at = args.text;
+        cmd->type = CMD_BOT;
+        cmd->valid = 1;
+        cmd->level = -1;
+        proto_next_token(&at, args.text + args.length, &cmd->arg);
+    }
+}
+
+size_t proto_encode_frame(unsigned char* out, int opcode, const unsigned char* payload, size_t payload_length) {
+    size_t length = payload_length + 1;
+    out[0] = (unsigned char)(length >> 8);
+    out[1] = (unsigned char)(length & 0xFF);
+    out[2] = (unsigned char)opcode;
+    if (payload_length > 0) {
+        memcpy(out + 3, payload, payload_length);
+    }
+    return length + 2;
+}
+
+void proto_put_u32(unsigned char* out, unsigned int value) {
+    out[0] = (unsigned char)(value >> 24);
+    out[1] = (unsigned char)(value >> 16);
+    out[2] = (unsigned char)(value >> 8);
+    out[3] = (unsigned char)value;
+}
+
+unsigned int proto_get_u32(const unsigned char* in) {
+    return ((unsigned int)in[0] << 24) | ((unsigned int)in[1] << 16) |
+           ((unsigned int)in[2] << 8) | in[3];
+}
+
+void proto_put_u16(unsigned char* out, unsigned int value) {
+    out[0] = (unsigned char)(value >> 8);
+    out[1] = (unsigned char)value;
+}
+
+unsigned int proto_get_u16(const unsigned char* in) {
+    return ((unsigned int)in[0] << 8) | in[1];
+}
+
+size_t proto_pack_cells(unsigned char* out, const unsigned char* cells, int count) {
+    size_t bytes = (count + 3) / 4;
+    memset(out, 0, bytes);
+    for (int i = 0; i < count; i++) {
+        out[i / 4] |= (unsigned char)((cells[i] & 3) << ((i % 4) * 2));
+    }
+    return bytes;
+}
+
+void proto_unpack_cells(unsigned char* cells, const unsigned char* packed, int count) {
+    for (int i = 0; i < count; i++) {
+        cells[i] = (packed[i / 4] >> ((i % 4) * 2)) & 3;
+    }
+}
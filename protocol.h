@@ -0,0 +1,280 @@
+/*
+ * File: protocol.h
+ * Author: [Your Name]
+ * Date: October 17, 2026
+ * Description: Mini Battleship wire protocol shared by server and clients
+ *              The text protocol (verb + ANSI art) is the default. A client
+ *              that sends "CAPS BIN1" before its username gets "CAPS_OK BIN1"
+ *              and from then on both directions use binary frames:
+ *
+ *                  [length: u16 big-endian][opcode: u8][payload]
+ *
+ *              where length counts the opcode and payload. Payloads have a
+ *              fixed layout per opcode; grids are sent as cell states and
+ *              the client does the rendering.
+ *
+ *              Each player's view of the boards is versioned. Full states
+ *              carry the sequence number, and after a move only the changed
+ *              cells go out as GRID_DELTA with the next one. A client that
+ *              sees a gap sends RESYNC for a full state.
+ *
+ *              Board size and fleet are per room and announced with
+ *              GAME_CONFIG right after GAME_START; ships are placed in fleet
+ *              order, one PLACE each. Positions are a column letter and a
+ *              row number, "A1" to "Z99".
+ *
+ *              A connection that sends "WATCH <room>" (or just "WATCH" for
+ *              the latest game) instead of a username becomes a spectator:
+ *              WATCHING and GAME_CONFIG, then a SPECTATE view of both boards
+ *              with unhit ships hidden, which comes again after every move.
+ *              Spectators also get BATTLE_START, ATTACK_RESULT and GAME_OVER,
+ *              and WATCH_END when the room closes. Views are numbered; GRID
+ *              asks for the current one.
+ *
+ *              With USERNAME_SET a player gets a RESUME_TOKEN. If the
+ *              connection drops during a game the seat is held for the
+ *              grace period the token came with, and the opponent is told
+ *              OPPONENT_AWAY. A new connection that sends "RESUME <token>"
+ *              instead of a username takes the seat back and gets one
+ *              snapshot: RESUMED, GAME_CONFIG and the full grid state,
+ *              then the turn (the opponent gets OPPONENT_BACK). A seat not
+ *              taken back in time forfeits the game.
+ *
+ *              Everything runs against the clock. A connection that names
+ *              no player in time, or sits idle between games too long, is
+ *              told TIMEOUT and closed. In a game the player to move has a
+ *              turn's time for it and both players a turn's time per ship
+ *              to place their fleet. A turn that runs out passes to the
+ *              opponent (TIMEOUT to both, then the turn); whoever lets
+ *              three in a row run out, or has not placed their fleet in
+ *              time, forfeits the game.
+ *
+ *              A player waiting for an opponent can send "BOT [level]" to
+ *              play the computer at once; otherwise the server seats one
+ *              after a wait of its choosing. The bot is announced like any
+ *              opponent, by name in SEAT (binary: GAME_START).
+ */
+
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+#include <stddef.h>
+
+#define PROTO_CAPABILITY "BIN1"
+#define PROTO_MAX_PAYLOAD 2045      // largest server frame, a full GRID_STATE
+#define PROTO_MAX_NAME 19
+#define PROTO_MAX_ROWS 99
+#define PROTO_MAX_COLS 26
+#define PROTO_MAX_CELLS (PROTO_MAX_ROWS * PROTO_MAX_COLS)
+#define PROTO_MAX_FLEET 10
+#define PROTO_CELL_CHARS ".SXO"     // EMPTY, SHIP, HIT, MISS in text grid states
+#define PROTO_TOKEN_BYTES 16        // resume token; 32 hex digits in the text protocol
+
+// Cell states, as stored by the server and sent in GRID_STATE frames
+typedef enum {
+    EMPTY = 0,
+    SHIP = 1,
+    HIT = 2,
+    MISS = 3
+} cell_state_t;
+
+// Boards a GRID_DELTA cell belongs to
+typedef enum {
+    BOARD_OWN = 0,
+    BOARD_ENEMY = 1
+} board_t;
+
+// Client -> server opcodes
+typedef enum {
+    OP_USERNAME = 0x01,             // name bytes
+    OP_PLACE = 0x02,                // col, row, horizontal
+    OP_ATTACK = 0x03,               // col, row
+    OP_GRID = 0x04,                 // (none)
+    OP_QUIT = 0x05,                 // (none)
+    OP_RESYNC = 0x06,               // (none)
+    OP_WATCH = 0x07,                // room (u32), or none for the latest game
+    OP_RESUME = 0x08,               // token
+    OP_BOT = 0x09                   // level (0 easy, 1 normal, 2 hard), or none for the server's default
+} client_opcode_t;
+
+// Server -> client opcodes
+typedef enum {
+    OP_USERNAME_SET = 0x41,         // (none)
+    OP_WAIT_PLAYER = 0x42,          // (none)
+    OP_GAME_START = 0x43,           // your seat, opponent name bytes
+    OP_SHIP_PLACED = 0x44,          // ships still to place
+    OP_BATTLE_START = 0x45,         // seat that moves first
+    OP_YOUR_TURN = 0x46,            // (none)
+    OP_WAIT_TURN = 0x47,            // (none)
+    OP_CONTINUE = 0x48,             // (none)
+    OP_HIT = 0x49,                  // col, row
+    OP_MISS = 0x4A,                 // col, row
+    OP_WIN = 0x4B,                  // (none)
+    OP_LOSE = 0x4C,                 // (none)
+    OP_GAME_OVER = 0x4D,            // winner seat
+    OP_ATTACK_RESULT = 0x4E,        // attacker seat, col, row, result
+    OP_GRID_STATE = 0x4F,           // seq (u32), rows, cols, own cells, enemy cells
+    OP_GRID_DELTA = 0x50,           // seq (u32), count, count x (board, col, row, state)
+    OP_GAME_CONFIG = 0x51,          // rows, cols, ship count, count x ship length
+    OP_SUNK = 0x52,                 // col, row, length of the ship sunk
+    OP_WATCHING = 0x53,             // room (u32), seat 0 name length, seat 0 name, seat 1 name
+    OP_SPECTATE = 0x54,             // view (u32), rows, cols, seat 0 cells, seat 1 cells
+    OP_WATCH_END = 0x55,            // (none)
+    OP_RESUME_TOKEN = 0x56,         // token, seconds a dropped seat is held (u16)
+    OP_RESUMED = 0x57,              // your seat, state (0 placing, 1 playing), seat to move, ships still to place, opponent name bytes
+    OP_OPPONENT_AWAY = 0x58,        // seconds held for (u16)
+    OP_OPPONENT_BACK = 0x59,        // (none)
+    OP_TIMEOUT = 0x5A,              // reason, seat that ran out of time, turns missed in a row, limit
+    OP_ERROR = 0x7F                 // error code
+} server_opcode_t;
+
+// Attack results, as returned by board_attack() and sent in ATTACK_RESULT.
+// Sinking the last ship ends the game and is reported with GAME_OVER.
+typedef enum {
+    ATTACK_MISS = 0,
+    ATTACK_HIT = 1,
+    ATTACK_SUNK = 2
+} attack_result_t;
+
+// Error codes; proto_error_text() gives the text-protocol wording
+typedef enum {
+    ERR_NOT_PLACING = 1,
+    ERR_ALREADY_PLACED,
+    ERR_BAD_PLACEMENT,
+    ERR_PLACE_FORMAT,
+    ERR_NOT_PLAYING,
+    ERR_NOT_YOUR_TURN,
+    ERR_BAD_ATTACK,
+    ERR_ATTACK_FORMAT,
+    ERR_NO_GAME,
+    ERR_TOO_LONG,
+    ERR_FRAMING_FORMAT,
+    ERR_BAD_CAPABILITY,
+    ERR_BAD_FRAME,
+    ERR_NO_SUCH_GAME,
+    ERR_CANNOT_WATCH,
+    ERR_SPECTATING,
+    ERR_BAD_TOKEN,
+    ERR_NOT_WAITING,
+    ERR_BOT_FORMAT,
+    ERR_COUNT
+} proto_error_t;
+
+const char* proto_error_text(int code);
+
+// What ran out of time, as sent in TIMEOUT; proto_timeout_name() gives
+// the word the text protocol uses
+typedef enum {
+    TIMEOUT_HANDSHAKE = 0,      // no username (or WATCH, RESUME) in time
+    TIMEOUT_IDLE,               // no command in time outside a game
+    TIMEOUT_TURN,               // a turn
+    TIMEOUT_PLACING,            // placing the fleet
+    TIMEOUT_COUNT
+} proto_timeout_t;
+
+const char* proto_timeout_name(int reason);
+
+// Parses a position such as "B3" or "z99" (column letter, then row 1-99)
+// into zero-based column and row. Returns 0 if it is not one.
+int proto_parse_position(const char* text, int* col, int* row);
+
+// Text commands are tokenized in place: a view is a stretch of the frame,
+// not NUL-terminated, valid as long as the frame is
+typedef struct {
+    const char* text;
+    size_t length;
+} proto_view_t;
+
+// Verbs of the text protocol, as sent (they are case-sensitive)
+typedef enum {
+    VERB_NONE,
+    VERB_CAPS,
+    VERB_PLACE,
+    VERB_ATTACK,
+    VERB_GRID,
+    VERB_RESYNC,
+    VERB_FRAMING,
+    VERB_QUIT,
+    VERB_WATCH,
+    VERB_RESUME,
+    VERB_BOT
+} proto_verb_t;
+
+// Skips whitespace from *cursor and takes the word that follows, up to
+// end, leaving *cursor just past it. Returns 0 if there is none.
+int proto_next_token(const char** cursor, const char* end, proto_view_t* token);
+
+// Everything from cursor to the end of the line, leading whitespace skipped
+proto_view_t proto_rest_of_line(const char* cursor, const char* end);
+
+// The verb word is, or VERB_NONE
+proto_verb_t proto_lookup_verb(proto_view_t word);
+
+// view holds exactly the NUL-terminated text
+int proto_view_equals(proto_view_t view, const char* text);
+
+// proto_parse_position() for a view
+int proto_parse_position_view(proto_view_t view, int* col, int* row);
+
+// Parses a decimal number of up to nine digits, such as a room number.
+// Returns 0 if the view is anything else.
+int proto_parse_number_view(proto_view_t view, unsigned int* value);
+
+// Resume tokens in the text protocol: 32 lower-case hex digits, written
+// NUL-terminated into out (which must hold 33 bytes). Parsing also takes
+// upper case and returns 0 if the view is anything else.
+void proto_format_token(char* out, const unsigned char* token);
+int proto_parse_token_view(proto_view_t view, unsigned char* token);
+
+// Client commands, decoded from either protocol
+typedef enum {
+    CMD_NONE,
+    CMD_USERNAME,
+    CMD_CAPS,
+    CMD_PLACE,
+    CMD_ATTACK,
+    CMD_GRID,
+    CMD_FRAMING,
+    CMD_QUIT,
+    CMD_WATCH,
+    CMD_RESUME,
+    CMD_BOT,
+    CMD_MALFORMED,
+    CMD_TYPES
+} proto_command_type_t;
+
+typedef struct {
+    proto_command_type_t type;
+    int valid;              // PLACE/ATTACK arguments parsed, WATCH named a room, RESUME token read, BOT level known
+    int row;
+    int col;
+    int horizontal;
+    unsigned int room_id;
+    int level;              // BOT: 0 easy, 1 normal, 2 hard, or -1 for the server's default
+    unsigned char token[PROTO_TOKEN_BYTES];     // RESUME, when valid
+    proto_view_t arg;       // username, capability, framing mode, room or BOT level name, in the frame
+} proto_command_t;
+
+// Decodes a text command line in place into cmd, which must start zeroed;
+// cmd->arg points into the line. Until the client has a username, any line
+// other than a capability request, WATCH or RESUME is taken as the
+// username, uncut. BOT leaves the level's name in cmd->arg for the caller
+// to look up, with level -1.
+void proto_parse_text_command(const char* buffer, size_t length, int has_username, proto_command_t* cmd);
+
+// Writes a complete frame into out, which must hold payload_length + 3
+// bytes. Returns the number of bytes written.
+size_t proto_encode_frame(unsigned char* out, int opcode, const unsigned char* payload, size_t payload_length);
+
+// Big-endian 32-bit fields (board sequence numbers) and 16-bit ones
+void proto_put_u32(unsigned char* out, unsigned int value);
+unsigned int proto_get_u32(const unsigned char* in);
+void proto_put_u16(unsigned char* out, unsigned int value);
+unsigned int proto_get_u16(const unsigned char* in);
+
+// Packs cell states four to a byte (2 bits each, first cell in the low
+// bits). Returns the number of bytes written: (count + 3) / 4.
+size_t proto_pack_cells(unsigned char* out, const unsigned char* cells, int count);
+void proto_unpack_cells(unsigned char* cells, const unsigned char* packed, int count);
+
+#endif
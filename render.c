@@ -0,0 +1,286 @@
+/*
+ * File: render.c
+ * Author: [Your Name]
+ * Date: October 17, 2026
+ * Description: Text rendering of Mini Battleship grids (see render.h)
+ *              Every constant piece of output, from each cell glyph to the
+ *              frame around the grids, is a precomputed string copied into
+ *              the output at a tracked offset; only row numbers, column
+ *              letters and names are produced per call.
+ */
+
+#include <string.h>
+#include "render.h"
+#include "protocol.h"
+
+// ANSI color codes
+const char* RESET = ANSI_RESET;
+const char* BOLD = ANSI_BOLD;
+const char* RED = ANSI_RED;
+const char* GREEN = ANSI_GREEN;
+const char* YELLOW = ANSI_YELLOW;
+const char* BLUE = ANSI_BLUE;
+const char* MAGENTA = ANSI_MAGENTA;
+const char* CYAN = ANSI_CYAN;
+const char* WHITE = ANSI_WHITE;
+
+// A constant string and its length
+typedef struct {
+    const char* text;
+    size_t length;
+} blob_t;
+
+#define BLOB(s) { s, sizeof(s) - 1 }
+
+// Cell glyphs, indexed by cell state
+static const blob_t own_cells[4] = {
+    BLOB(ANSI_BOLD ANSI_BLUE "⬜" ANSI_RESET " "),
+    BLOB(ANSI_BOLD ANSI_GREEN "🚢" ANSI_RESET " "),
+    BLOB(ANSI_BOLD ANSI_RED "💥" ANSI_RESET " "),
+    BLOB(ANSI_BOLD ANSI_WHITE "💧" ANSI_RESET " ")
+};
+
+// Own grid with ships drawn as water
+static const blob_t hidden_cells[4] = {
+    BLOB(ANSI_BOLD ANSI_BLUE "⬜" ANSI_RESET " "),
+    BLOB(ANSI_BOLD ANSI_BLUE "⬜" ANSI_RESET " "),
+    BLOB(ANSI_BOLD ANSI_RED "💥" ANSI_RESET " "),
+    BLOB(ANSI_BOLD ANSI_WHITE "💧" ANSI_RESET " ")
+};
+
+// What we know of the enemy's grid
+static const blob_t enemy_cells[4] = {
+    BLOB(ANSI_BOLD ANSI_MAGENTA "❔" ANSI_RESET " "),
+    BLOB(ANSI_BOLD ANSI_MAGENTA "❔" ANSI_RESET " "),
+    BLOB(ANSI_BOLD ANSI_RED "💥" ANSI_RESET " "),
+    BLOB(ANSI_BOLD ANSI_WHITE "💧" ANSI_RESET " ")
+};
+
+#define MAX_CELL_GLYPH (sizeof(ANSI_BOLD ANSI_MAGENTA "❔" ANSI_RESET " ") - 1)
+
+// Pieces around column letters and row numbers. A letter and its padding
+// are as wide as a cell: a two-column glyph and a space.
+static const blob_t label_start = BLOB(ANSI_BOLD ANSI_YELLOW);
+static const blob_t column_end = BLOB(ANSI_RESET "  ");
+static const blob_t row_start = BLOB("  " ANSI_BOLD ANSI_YELLOW);
+static const blob_t second_row_start = BLOB("        " ANSI_BOLD ANSI_YELLOW);
+static const blob_t row_end = BLOB(ANSI_RESET "  ");
+
+// Frame skeleton of render_grid(), split where the title goes
+static const blob_t grid_head = BLOB(
+    ANSI_BOLD ANSI_CYAN "╔════════════════════════════════════════════════╗" ANSI_RESET "\n"
+    ANSI_BOLD ANSI_CYAN "║                    " ANSI_WHITE);
+static const blob_t grid_after_title = BLOB(
+    ANSI_CYAN ANSI_BOLD "║" ANSI_RESET "\n"
+    ANSI_BOLD ANSI_CYAN "╚════════════════════════════════════════════════╝" ANSI_RESET "\n\n"
+    "     ");
+static const blob_t grid_legend = BLOB(
+    "\n"
+    "Legend: "
+    ANSI_BLUE "⬜" ANSI_RESET "=Water " ANSI_GREEN "🚢" ANSI_RESET "=Ship "
+    ANSI_RED "💥" ANSI_RESET "=Hit " ANSI_WHITE "💧" ANSI_RESET "=Miss\n\n");
+
+#define TITLE_WIDTH 20
+
+// Frame skeleton of render_both_grids(), split where the enemy's name goes
+static const blob_t both_head = BLOB(
+    ANSI_BOLD ANSI_MAGENTA "╔══════════════════════════════════════════════════════════════════════════════════════════════════════════════════╗" ANSI_RESET "\n"
+    ANSI_BOLD ANSI_MAGENTA "║                                          " ANSI_WHITE "🎯 BATTLE STATUS 🎯" ANSI_MAGENTA "                                              " ANSI_BOLD "║" ANSI_RESET "\n"
+    ANSI_BOLD ANSI_MAGENTA "╚══════════════════════════════════════════════════════════════════════════════════════════════════════════════════╝" ANSI_RESET "\n\n"
+    ANSI_BOLD ANSI_GREEN "📋 YOUR GRID" ANSI_RESET "                              " ANSI_BOLD "🎯 ENEMY GRID (");
+static const blob_t both_after_name = BLOB(
+    ")" ANSI_RESET "\n"
+    "   (Shows your ship)                         (Shows your attacks)\n\n"
+    "     ");
+static const blob_t both_between_headers = BLOB("           ");
+
+// Where render_both_grids() puts things on screen
+#define BOTH_FIRST_ROW 9            // lines above the first row of cells: frame, names, letters
+#define BOTH_FRAME_WIDTH 116        // columns of the frame around the heading
+#define CELL_WIDTH 3                // a two-column glyph and a space
+
+// Output buffer with a tracked write offset. Bytes that do not fit are
+// counted but not written, so the caller learns the size it needed.
+typedef struct {
+    char* out;
+    size_t size;
+    size_t used;
+} writer_t;
+
+static void put(writer_t* w, const char* data, size_t length) {
+    if (w->used + length < w->size) {
+        memcpy(w->out + w->used, data, length);
+    } else if (w->used + 1 < w->size) {
+        memcpy(w->out + w->used, data, w->size - 1 - w->used);
+    }
+    w->used += length;
+}
+
+static void put_blob(writer_t* w, const blob_t* blob) {
+    put(w, blob->text, blob->length);
+}
+
+static void put_char(writer_t* w, char c) {
+    put(w, &c, 1);
+}
+
+// Writes n right-aligned in width columns
+static void put_number(writer_t* w, int n, int width) {
+    char digits[12];
+    int len = 0;
+    do {
+        digits[sizeof(digits) - 1 - len++] = (char)('0' + n % 10);
+        n /= 10;
+    } while (n > 0);
+    for (int i = len; i < width; i++) {
+        put_char(w, ' ');
+    }
+    put(w, digits + sizeof(digits) - len, len);
+}
+
+static void put_spaces(writer_t* w, int count) {
+    for (int i = 0; i < count; i++) {
+        put_char(w, ' ');
+    }
+}
+
+// Columns the largest row number takes
+static int number_width(int rows) {
+    int width = 1;
+    while (rows >= 10) {
+        rows /= 10;
+        width++;
+    }
+    return width;
+}
+
+static size_t finish(writer_t* w) {
+    if (w->size > 0) {
+        w->out[w->used < w->size ? w->used : w->size - 1] = '\0';
+    }
+    return w->used;
+}
+
+static void put_column_headers(writer_t* w, int cols) {
+    for (int j = 0; j < cols; j++) {
+        put_blob(w, &label_start);
+        put_char(w, (char)('A' + j));
+        put_blob(w, &column_end);
+    }
+}
+
+static void put_row(writer_t* w, const blob_t* row_label, int row, int width, const blob_t* glyphs,
+                    const unsigned char* cells, int cols) {
+    put_blob(w, row_label);
+    put_number(w, row + 1, width);
+    put_blob(w, &row_end);
+    for (int j = 0; j < cols; j++) {
+        put_blob(w, &glyphs[cells[j] & 3]);
+    }
+}
+
+// Longest a row label can be: start, up to 10 digits, end
+static size_t row_label_size(const blob_t* row_label) {
+    return row_label->length + 10 + row_end.length;
+}
+
+// Room for the column header padding that wide row numbers add
+#define HEADER_PADDING 20
+
+size_t render_grid_size(int rows, int cols, const char* title) {
+    size_t title_length = strlen(title);
+    return grid_head.length + (title_length > TITLE_WIDTH ? title_length : TITLE_WIDTH) +
+           grid_after_title.length + HEADER_PADDING +
+           cols * (label_start.length + 1 + column_end.length) + 2 +
+           rows * (row_label_size(&row_start) + cols * MAX_CELL_GLYPH + 1) +
+           grid_legend.length + 1;
+}
+
+size_t render_both_grids_size(int rows, int cols, const char* enemy_name) {
+    return both_head.length + strlen(enemy_name) + both_after_name.length +
+           both_between_headers.length + HEADER_PADDING +
+           2 * cols * (label_start.length + 1 + column_end.length) + 2 +
+           rows * (row_label_size(&row_start) + row_label_size(&second_row_start) +
+                   2 * cols * MAX_CELL_GLYPH + 1) +
+           2;
+}
+
+size_t render_grid(char* out, size_t size, const unsigned char* cells, int rows, int cols,
+                   int show_ships, const char* title) {
+    writer_t w = { out, size, 0 };
+    const blob_t* glyphs = show_ships ? own_cells : hidden_cells;
+    
+    put_blob(&w, &grid_head);
+    size_t title_length = strlen(title);
+    put(&w, title, title_length);
+    for (size_t i = title_length; i < TITLE_WIDTH; i++) {
+        put_char(&w, ' ');
+    }
+    put_blob(&w, &grid_after_title);
+    
+    // Column letters line up with the cells after the widest row number
+    int width = number_width(rows);
+    put_spaces(&w, width - 1);
+    put_column_headers(&w, cols);
+    put(&w, "\n\n", 2);
+    
+    for (int i = 0; i < rows; i++) {
+        put_row(&w, &row_start, i, width, glyphs, cells + i * cols, cols);
+        put_char(&w, '\n');
+    }
+    
+    put_blob(&w, &grid_legend);
+    return finish(&w);
+}
+
+size_t render_both_grids(char* out, size_t size, const unsigned char* own, const unsigned char* enemy,
+                         int rows, int cols, const char* enemy_name) {
+    writer_t w = { out, size, 0 };
+    
+    put_blob(&w, &both_head);
+    put(&w, enemy_name, strlen(enemy_name));
+    put_blob(&w, &both_after_name);
+    
+    int width = number_width(rows);
+    put_spaces(&w, width - 1);
+    put_column_headers(&w, cols);
+    put_blob(&w, &both_between_headers);
+    put_spaces(&w, width - 1);
+    put_column_headers(&w, cols);
+    put(&w, "\n\n", 2);
+    
+    // Both grids side by side
+    for (int i = 0; i < rows; i++) {
+        put_row(&w, &row_start, i, width, own_cells, own + i * cols, cols);
+        put_row(&w, &second_row_start, i, width, enemy_cells, enemy + i * cols, cols);
+        put_char(&w, '\n');
+    }
+    
+    put_char(&w, '\n');
+    return finish(&w);
+}
+
+int render_both_grids_lines(int rows) {
+    // The rows, then the line that ends the output
+    return BOTH_FIRST_ROW + rows + 1;
+}
+
+int render_both_grids_width(int rows, int cols) {
+    // Each row: label, own cells, the second label, enemy cells
+    int width = number_width(rows);
+    int grids = 2 * (width + 4) + 6 + 2 * cols * CELL_WIDTH;
+    return grids > BOTH_FRAME_WIDTH ? grids : BOTH_FRAME_WIDTH;
+}
+
+void render_both_grids_cell_at(int rows, int cols, int which, int row, int col, int* line, int* column) {
+    // A row label is two spaces (eight before the enemy's), the number
+    // and two spaces
+    int label = number_width(rows) + 4;
+    *line = BOTH_FIRST_ROW + row;
+    *column = label + col * CELL_WIDTH;
+    if (which == BOARD_ENEMY) *column += cols * CELL_WIDTH + 6 + label;
+}
+
+const char* render_both_grids_glyph(int which, int state) {
+    return (which == BOARD_ENEMY ? enemy_cells : own_cells)[state & 3].text;
+}
@@ -0,0 +1,64 @@
+/*
+ * File: render.h
+ * Author: [Your Name]
+ * Date: October 17, 2026
+ * Description: Text rendering of Mini Battleship grids
+ *              Used by the server for text-protocol clients and by the client
+ *              to draw grids it received as cell states.
+ */
+
+#ifndef RENDER_H
+#define RENDER_H
+
+#include <stddef.h>
+
+// ANSI color codes, as literals for building constant strings
+#define ANSI_RESET "\033[0m"
+#define ANSI_BOLD "\033[1m"
+#define ANSI_RED "\033[91m"
+#define ANSI_GREEN "\033[92m"
+#define ANSI_YELLOW "\033[93m"
+#define ANSI_BLUE "\033[94m"
+#define ANSI_MAGENTA "\033[95m"
+#define ANSI_CYAN "\033[96m"
+#define ANSI_WHITE "\033[97m"
+
+// ...and as variables for everything else
+extern const char* RESET;
+extern const char* BOLD;
+extern const char* RED;
+extern const char* GREEN;
+extern const char* YELLOW;
+extern const char* BLUE;
+extern const char* MAGENTA;
+extern const char* CYAN;
+extern const char* WHITE;
+
+// Both renderers take row-major cell_state_t values, one per byte, and
+// write a NUL-terminated string into out. Like snprintf() they return the
+// length of the complete output, so a result >= size means it was cut
+// short; the *_size() functions give a buffer size that always suffices.
+
+// One grid under a title; ships are drawn as water unless show_ships is set
+size_t render_grid(char* out, size_t size, const unsigned char* cells, int rows, int cols,
+                   int show_ships, const char* title);
+size_t render_grid_size(int rows, int cols, const char* title);
+
+// The player's own grid beside their view of the enemy's grid
+size_t render_both_grids(char* out, size_t size, const unsigned char* own, const unsigned char* enemy,
+                         int rows, int cols, const char* enemy_name);
+size_t render_both_grids_size(int rows, int cols, const char* enemy_name);
+
+// Layout of render_both_grids() output, for redrawing single cells in
+// place: the lines it ends (so the next output starts that many lines
+// down), the screen columns its widest line takes, and the line and
+// column (both from 0) where the glyph of a cell of board which
+// (BOARD_OWN or BOARD_ENEMY) starts
+int render_both_grids_lines(int rows);
+int render_both_grids_width(int rows, int cols);
+void render_both_grids_cell_at(int rows, int cols, int which, int row, int col, int* line, int* column);
+
+// The glyph render_both_grids() draws for a cell in the given state
+const char* render_both_grids_glyph(int which, int state);
+
+#endif
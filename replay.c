@@ -0,0 +1,451 @@
+#define _GNU_SOURCE
+
+/*
+ * File: replay.c
+ * Author: [Your Name]
+ * Date: October 17, 2026
+ * Description: Rebuilds games from the server's journal (see journal.h)
+ *              Reads every segment in a journal directory in order and
+ *              plays each game again with the server's own board rules,
+ *              checking that every ship placed was legal and every attack
+ *              had the result the server logged. Prints totals and the
+ *              replay rate, or, for one game or room, its moves and the
+ *              boards as they stand at the end of the log.
+ *
+ * Usage: ./replay [-g game | -r room] [-v] [-n times] DIR
+ *        gcc -Wall -Wextra -std=c99 -pedantic -O2 -o replay replay.c journal.c board.c protocol.c render.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "board.h"
+#include "journal.h"
+#include "protocol.h"
+#include "render.h"
+
+#define MAX_ROOMS 65536         // one per value of a record's room
+
+// A room's current game as rebuilt so far, plus records that arrived
+// ahead of their turn
+typedef struct {
+    int active;                 // a game is under way
+    uint32_t game;
+    int room;
+    uint16_t next_step;
+    board_config_t config;
+    board_state_t boards[2];
+    bitword_t* masks;           // storage behind both boards
+    int mask_words;
+    char names[2][JOURNAL_NAME + 1];
+    int current_player;
+    int winner;                 // -1 until GAME_OVER
+    int left[2];
+    int moves;
+    journal_record_t* pending;
+    int pending_count;
+    int pending_capacity;
+} room_state_t;
+
+static room_state_t* rooms[MAX_ROOMS];
+
+// What to show, from the command line
+static long show_game = -1;
+static long show_room = -1;
+static int show_all = 0;        // -v alone: every game's moves
+static int verbose = 0;
+
+// Totals over one pass of the log
+typedef struct {
+    unsigned long segments;
+    unsigned long records;
+    unsigned long games;        // started
+    unsigned long won;
+    unsigned long forfeited;    // one player did not come back, or move, in time
+    unsigned long abandoned;    // both players left before it was won
+    unsigned long interrupted;  // still on when the server restarted or the log ends
+    unsigned long timeouts;     // turns or fleet placements that ran out of time
+    unsigned long mismatches;   // moves the rules reject or that scored differently
+    unsigned long orphans;      // records whose game never reached them
+} totals_t;
+
+static totals_t totals;
+
+// The last game shown, kept to print once the log is read
+static room_state_t shown;
+static int have_shown = 0;
+
+static int selected(const room_state_t* state, int room) {
+    return show_all || (show_game >= 0 && state->game == (uint32_t)show_game) ||
+           (show_room >= 0 && room == show_room);
+}
+
+static const char* seat_label(const room_state_t* state, int seat) {
+    return state->names[seat][0] != '\0' ? state->names[seat] : (seat == 0 ? "seat 0" : "seat 1");
+}
+
+static void print_boards(const room_state_t* state) {
+    unsigned char cells[PROTO_MAX_CELLS];
+    for (int seat = 0; seat < 2; seat++) {
+        char title[JOURNAL_NAME + 16];
+        snprintf(title, sizeof(title), "%s's fleet", seat_label(state, seat));
+        size_t size = render_grid_size(state->config.rows, state->config.cols, title);
+        char* art = malloc(size);
+        if (art == NULL) return;
+        board_cells(cells, &state->boards[seat], &state->config, 1);
+        render_grid(art, size, cells, state->config.rows, state->config.cols, 1, title);
+        printf("%s", art);
+        free(art);
+    }
+}
+
+// Gives the state's two boards room for the game's masks, keeping the
+// storage of earlier games when it is large enough
+static int fit_boards(room_state_t* state, const board_config_t* config) {
+    int words = board_storage_words(config);
+    if (2 * words > state->mask_words) {
+        bitword_t* grown = realloc(state->masks, 2 * words * sizeof(bitword_t));
+        if (grown == NULL) return -1;
+        state->masks = grown;
+        state->mask_words = 2 * words;
+    }
+    state->boards[0].masks = state->masks;
+    state->boards[1].masks = state->masks + words;
+    return 0;
+}
+
+// Keeps the game's state for the summary printed at the end
+static void remember(const room_state_t* state, int room) {
+    if (!selected(state, room)) return;
+    bitword_t* masks = shown.masks;
+    int mask_words = shown.mask_words;
+    shown = *state;
+    shown.pending = NULL;
+    shown.masks = masks;
+    shown.mask_words = mask_words;
+    have_shown = 0;
+    if (state->config.ship_count > 0) {
+        if (fit_boards(&shown, &state->config) != 0) return;
+        int words = board_storage_words(&state->config);
+        memcpy(shown.masks, state->boards[0].masks, words * sizeof(bitword_t));
+        memcpy(shown.masks + words, state->boards[1].masks, words * sizeof(bitword_t));
+    }
+    have_shown = 1;
+}
+
+// The game in the room is over, or cut off by a restart
+static void finish(room_state_t* state, int room, int interrupted) {
+    if (interrupted) {
+        totals.interrupted++;
+        if (verbose && selected(state, room)) printf("game %u: interrupted\n", state->game);
+    }
+    remember(state, room);
+    state->active = 0;
+}
+
+static void mismatch(const room_state_t* state, const journal_record_t* record, const char* what) {
+    totals.mismatches++;
+    if (verbose || selected(state, record->room)) {
+        printf("game %u step %u: %s\n", record->game, record->step, what);
+    }
+}
+
+// Plays one record on the room's game, which it is known to follow
+static void apply(room_state_t* state, const journal_record_t* record) {
+    int room = record->room;
+    int seat = record->seat & 1;
+    int show = verbose && selected(state, room);
+    state->next_step = (uint16_t)(record->step + 1);
+    
+    switch (record->type) {
+        case JOURNAL_GAME_START: {
+            board_config_t config;
+            config.rows = record->data.config.rows;
+            config.cols = record->data.config.cols;
+            config.words = bitboard_words(config.rows * config.cols);
+            config.ship_count = record->data.config.ship_count;
+            if (config.ship_count > PROTO_MAX_FLEET) config.ship_count = 0;
+            for (int i = 0; i < config.ship_count; i++) {
+                config.ship_lengths[i] = record->data.config.ship_lengths[i];
+            }
+            
+            state->active = 1;
+            state->game = record->game;
+            state->room = room;
+            state->config = config;
+            state->current_player = 0;
+            state->winner = -1;
+            state->left[0] = state->left[1] = 0;
+            state->moves = 0;
+            state->names[0][0] = state->names[1][0] = '\0';
+            totals.games++;
+            if (config.rows > PROTO_MAX_ROWS || config.cols > PROTO_MAX_COLS ||
+                board_config_check(&config) != NULL) {
+                mismatch(state, record, "impossible board or fleet");
+                state->config.ship_count = 0;
+                finish(state, room, 0);
+                return;
+            }
+            if (fit_boards(state, &state->config) != 0) {
+                perror("Board allocation failed");
+                exit(1);
+            }
+            board_reset(&state->boards[0], &state->config);
+            board_reset(&state->boards[1], &state->config);
+            if (verbose && selected(state, room)) {
+                printf("game %u: room %d, %dx%d board, %d ships\n", state->game, room,
+                    config.rows, config.cols, config.ship_count);
+            }
+            break;
+        }
+        case JOURNAL_JOIN: {
+            // A player taking their seat back after a dropped connection
+            // joins a second time
+            int again = state->names[seat][0] != '\0';
+            memcpy(state->names[seat], record->data.username, JOURNAL_NAME);
+            state->names[seat][JOURNAL_NAME] = '\0';
+            if (show) printf("  %s %s seat %d\n", state->names[seat], again ? "is back in" : "joins as", seat);
+            break;
+        }
+        case JOURNAL_PLACE: {
+            int row = record->data.place.row, col = record->data.place.col;
+            int horizontal = record->data.place.horizontal;
+            board_state_t* board = &state->boards[seat];
+            if (board_fleet_placed(board, &state->config) ||
+                !board_can_place(board, &state->config, row, col, horizontal)) {
+                mismatch(state, record, "illegal placement");
+                break;
+            }
+            board_place(board, &state->config, row, col, horizontal);
+            if (show) printf("  %s places at %c%d %s\n", seat_label(state, seat), 'A' + col, row + 1,
+                              horizontal ? "H" : "V");
+            break;
+        }
+        case JOURNAL_ATTACK: {
+            int row = record->data.attack.row, col = record->data.attack.col;
+            int sunk_length = 0;
+            int result = board_attack(&state->boards[1 - seat], &state->config, row, col, &sunk_length);
+            if (result != record->data.attack.result ||
+                (result == ATTACK_SUNK && sunk_length != record->data.attack.sunk_length)) {
+                mismatch(state, record, "attack scored differently");
+            }
+            state->moves++;
+            if (show) printf("  %s attacks %c%d: %s\n", seat_label(state, seat), 'A' + col, row + 1,
+                              result == ATTACK_SUNK ? "sunk" : result == ATTACK_HIT ? "hit" :
+                              result == ATTACK_MISS ? "miss" : "illegal");
+            break;
+        }
+        case JOURNAL_TURN:
+            state->current_player = seat;
+            break;
+        case JOURNAL_GAME_OVER:
+            if (!board_defeated(&state->boards[1 - seat], &state->config)) {
+                mismatch(state, record, "winner's opponent still has ships");
+            }
+            state->winner = seat;
+            totals.won++;
+            if (show) printf("  %s wins after %d attacks\n", seat_label(state, seat), state->moves);
+            finish(state, room, 0);
+            break;
+        case JOURNAL_FORFEIT:
+            state->winner = 1 - seat;
+            totals.forfeited++;
+            if (show) printf("  %s forfeits, %s wins\n", seat_label(state, seat), seat_label(state, 1 - seat));
+            finish(state, room, 0);
+            break;
+        case JOURNAL_TIMEOUT:
+            totals.timeouts++;
+            if (show && record->data.timeout.reason == TIMEOUT_PLACING) {
+                printf("  %s ran out of time to place their fleet\n", seat_label(state, seat));
+            } else if (show) {
+                printf("  %s ran out of time (%d in a row)\n", seat_label(state, seat),
+                    record->data.timeout.missed);
+            }
+            break;
+        case JOURNAL_LEAVE:
+            state->left[seat] = 1;
+            if (show) printf("  %s leaves\n", seat_label(state, seat));
+            if (state->left[0] && state->left[1]) {
+                totals.abandoned++;
+                finish(state, room, 0);
+            }
+            break;
+        default:
+            mismatch(state, record, "unknown record type");
+            break;
+    }
+}
+
+// Whether the record is the one the room's game expects next: its next
+// step, or the start of a new game once the last one is over
+static int expected(const room_state_t* state, const journal_record_t* record) {
+    if (state->active) return record->game == state->game && record->step == state->next_step;
+    return record->type == JOURNAL_GAME_START && record->step == 0;
+}
+
+// Writers on different threads may append a room's records out of order;
+// those that come early wait in the room's pending list
+static void replay_record(const journal_record_t* record) {
+    room_state_t* state = rooms[record->room];
+    if (state == NULL) {
+        state = calloc(1, sizeof(room_state_t));
+        if (state == NULL) {
+            perror("Room state allocation failed");
+            exit(1);
+        }
+        rooms[record->room] = state;
+    }
+    
+    if (!expected(state, record)) {
+        if (state->pending_count == state->pending_capacity) {
+            int capacity = state->pending_capacity ? 2 * state->pending_capacity : 8;
+            journal_record_t* grown = realloc(state->pending, capacity * sizeof(journal_record_t));
+            if (grown == NULL) {
+                perror("Pending record allocation failed");
+                exit(1);
+            }
+            state->pending = grown;
+            state->pending_capacity = capacity;
+        }
+        state->pending[state->pending_count++] = *record;
+        return;
+    }
+    
+    apply(state, record);
+    int found = 1;
+    while (found && state->pending_count > 0) {
+        found = 0;
+        for (int i = 0; i < state->pending_count; i++) {
+            if (expected(state, &state->pending[i])) {
+                journal_record_t next = state->pending[i];
+                state->pending[i] = state->pending[--state->pending_count];
+                apply(state, &next);
+                found = 1;
+                break;
+            }
+        }
+    }
+}
+
+// Ends every game still on: the server restarted, or the log is over.
+// Records still waiting for their turn never got it.
+static void interrupt_all(void) {
+    for (int room = 0; room < MAX_ROOMS; room++) {
+        room_state_t* state = rooms[room];
+        if (state == NULL) continue;
+        if (state->active) finish(state, room, 1);
+        totals.orphans += state->pending_count;
+        state->pending_count = 0;
+    }
+}
+
+// Replays one segment file; returns -1 if it cannot be read
+static int replay_segment(const char* path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return -1;
+    struct stat info;
+    if (fstat(fd, &info) < 0) {
+        close(fd);
+        return -1;
+    }
+    size_t count = info.st_size / sizeof(journal_record_t);
+    if (count == 0) {
+        close(fd);
+        return 0;
+    }
+    const journal_record_t* records = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (records == MAP_FAILED) return -1;
+    madvise((void*)records, info.st_size, MADV_SEQUENTIAL);
+    
+    totals.segments++;
+    if (records[0].type == JOURNAL_SEGMENT && records[0].check == journal_check(&records[0]) &&
+        records[0].data.segment.restart) {
+        interrupt_all();
+    }
+    // The first record that fails its check is where the server stopped
+    for (size_t i = 1; i < count && records[i].check == journal_check(&records[i]); i++) {
+        totals.records++;
+        replay_record(&records[i]);
+    }
+    munmap((void*)records, info.st_size);
+    return 0;
+}
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void usage(const char* prog) {
+    fprintf(stderr,
+        "Usage: %s [-g game | -r room] [-v] [-n times] DIR\n"
+        "  -g  show one game: its players, result and final boards\n"
+        "  -r  show the last game played in a room\n"
+        "  -v  list every move of the game shown (of every game without -g or -r)\n"
+        "  -n  replay the whole log this many times, to time it (default 1)\n", prog);
+    exit(1);
+}
+
+int main(int argc, char* argv[]) {
+    int times = 1;
+    int opt;
+    while ((opt = getopt(argc, argv, "g:r:vn:")) != -1) {
+        switch (opt) {
+            case 'g': show_game = atol(optarg); break;
+            case 'r': show_room = atol(optarg); break;
+            case 'v': verbose = 1; break;
+            case 'n': times = atoi(optarg); break;
+            default: usage(argv[0]);
+        }
+    }
+    if (optind != argc - 1 || times < 1) usage(argv[0]);
+    const char* dir = argv[optind];
+    show_all = verbose && show_game < 0 && show_room < 0;
+    
+    unsigned int last = journal_last_segment(dir);
+    if (last == 0) {
+        fprintf(stderr, "No journal segments in %s\n", dir);
+        return 1;
+    }
+    
+    double start = now_seconds();
+    for (int pass = 0; pass < times; pass++) {
+        memset(&totals, 0, sizeof(totals));
+        for (unsigned int number = 1; number <= last; number++) {
+            char path[4096 + 32];
+            journal_segment_path(path, sizeof(path), dir, number);
+            replay_segment(path);
+        }
+        interrupt_all();
+    }
+    double elapsed = now_seconds() - start;
+    
+    if (have_shown && (show_game >= 0 || show_room >= 0)) {
+        printf("game %u in room %d: %s vs %s, %d attacks, ", shown.game, shown.room,
+            seat_label(&shown, 0), seat_label(&shown, 1), shown.moves);
+        if (shown.winner >= 0) {
+            printf("won by %s\n", seat_label(&shown, shown.winner));
+        } else {
+            printf("%s\n", shown.left[0] || shown.left[1] ? "abandoned" : "not finished");
+        }
+        if (shown.config.ship_count > 0) print_boards(&shown);
+    } else if (show_game >= 0 || show_room >= 0) {
+        printf("No such game in the journal\n");
+    }
+    
+    printf("%lu segments, %lu records, %lu games: %lu won, %lu forfeited, %lu abandoned, %lu interrupted\n",
+        totals.segments, totals.records, totals.games, totals.won, totals.forfeited, totals.abandoned,
+        totals.interrupted);
+    printf("%lu turns or fleet placements ran out of time\n", totals.timeouts);
+    printf("%lu mismatches, %lu orphaned records\n", totals.mismatches, totals.orphans);
+    printf("replayed %d time%s in %.3f s: %.0f records/s, %.0f games/min\n", times, times == 1 ? "" : "s",
+        elapsed, totals.records * times / elapsed, totals.games * times / elapsed * 60);
+    return totals.mismatches > 0 ? 2 : 0;
+}
@@ -1,9 +1,41 @@
+#define _GNU_SOURCE
+
 /*
  * File: server.c
  * Author: [Your Name]
  * Date: August 27, 2025
- * Description: Mini Battleship Game Server (4x4 grid, single 2x1 ship)
- *              Simple multiplayer naval combat with usernames and visual interface
+ * Description: Mini Battleship Game Server (4x4 grid and one 2-cell ship
+ *              by default; --board and --fleet change both)
+ *              Simple multiplayer naval combat with usernames and visual interface.
+ *              One process hosts many games at once: players are paired by a
+ *              matchmaking queue and each pair gets its own room.
+ *              Connections are served either by an edge-triggered epoll
+ *              reactor (default on Linux), by one such reactor per core,
+ *              each accepting on its own SO_REUSEPORT listener, by a
+ *              single-threaded io_uring loop that batches its accepts,
+ *              receives and sends, or by one thread per connection.
+ *              Game state is guarded per room and replies are queued while a
+ *              lock is held, then written once every lock is released,
+ *              without blocking: each connection keeps what its socket
+ *              cannot take yet, and a client that stops reading is paused
+ *              and finally disconnected instead of stalling anyone else.
+ *              Any number of spectators can watch a game: each update is
+ *              serialized once and queued to all of them by reference.
+ *              With --journal every move of every game is appended to a
+ *              memory-mapped event log (see journal.h) that replay.c reads.
+ *              SIGUSR2 hands the listener, every connection and every game
+ *              to a new copy of the binary (see upgrade.h) and exits, so the
+ *              server can be upgraded without dropping a player.
+ *              Turns, the handshake and idle connections are timed on a
+ *              hierarchical timing wheel per reactor (see wheel.h): a turn
+ *              not taken in time passes to the opponent, and connections
+ *              that never pick a username or sit idle in the lobby are
+ *              closed.
+ *              A player left waiting for an opponent, or asking for one
+ *              with BOT, is seated against the computer (see ai.h); the
+ *              bot's moves are timed on the room's timer like any other.
+ *              Every command is timed phase by phase (see trace.h); the
+ *              percentiles are printed with the lock statistics.
  */
 
 #include <stdio.h>
@@ -14,22 +46,61 @@
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
+#include <netinet/tcp.h>
 #include <signal.h>
 #include <pthread.h>
+#include <errno.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/select.h>
+#include <sys/resource.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <time.h>
+#ifdef __linux__
+#include <sched.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#endif
+#include "ai.h"
+#include "board.h"
+#include "framing.h"
+#include "journal.h"
+#include "logger.h"
+#include "outqueue.h"
+#include "protocol.h"
+#include "render.h"
+#include "trace.h"
+#include "upgrade.h"
+#include "uring.h"
+#include "wheel.h"
 
 #define PORT 19845
-#define BUFFER_SIZE 1024
-#define GRID_SIZE 4
-#define SHIP_SIZE 2
 #define MAX_USERNAME 20
-
-// Cell states
-typedef enum {
-    EMPTY = 0,
-    SHIP = 1,
-    HIT = 2,
-    MISS = 3
-} cell_state_t;
+#define MAX_ROOMS 65536
+#define MAX_SESSIONS (2 * MAX_ROOMS)        // default --max-sessions
+#define MAX_EVENTS 256
+#define EPOLL_LISTENER 0                    // epoll data of a listening socket (sessions: their handle)
+#define EPOLL_MAILBOX 1                     // and of a shard's mailbox
+#define URING_ENTRIES 4096                  // io_uring submission queue size
+#define URING_BUFFERS 1024                  // provided receive buffers
+#define URING_BUFFER_SIZE 4096
+#define URING_SEND_IOV 8                    // queue chunks per send request
+#define OUTPUT_PAUSE_BYTES (256 * 1024)     // stop running a client's commands past this backlog
+#define OUTPUT_HIGH_WATER (4 * 1024 * 1024) // and disconnect it past this one
+#define RESUME_GRACE 60                     // default --resume-grace, seconds
+#define RESUME_GRACE_MAX 65535
+#define HANDSHAKE_TIMEOUT 30                // default --handshake-timeout, seconds
+#define IDLE_TIMEOUT 600                    // default --idle-timeout
+#define TURN_TIMEOUT 60                     // default --turn-timeout
+#define TIMEOUT_MAX 86400
+#define MISSED_TURNS_MAX 3                  // turns run out in a row that forfeit the game
+#define BOT_WAIT 20                         // default --bot-wait, seconds
+#define BOT_THINK_MS 500                    // default --bot-think
+#define BOT_THINK_MAX 60000
+#define TIMER_SESSION 0                     // tags of the timers on a wheel
+#define TIMER_ROOM 1
 
 // Game states
 typedef enum {
@@ -40,586 +111,4516 @@ typedef enum {
     GAME_OVER
 } game_state_t;
 
+struct session;
+
 // Player structure
 typedef struct {
-    int socket;
+    struct session* session;
     int player_id;
     char username[MAX_USERNAME];
     int has_username;
-    cell_state_t grid[GRID_SIZE][GRID_SIZE];
-    cell_state_t enemy_view[GRID_SIZE][GRID_SIZE];
-    int ship_placed;
-    int ship_hits;
+    board_state_t board;
+    unsigned int board_seq;     // bumped on every change to either board
+    unsigned char token[PROTO_TOKEN_BYTES];     // takes the seat back after a drop
+    int held;                   // connection dropped, seat kept until held_until
+    unsigned long held_until;   // now_ns() deadline
+    int bot;                    // played by the computer, with no session
+    ai_level_t bot_level;
 } player_t;
 
 // Game structure
 typedef struct {
+    board_config_t config;
     player_t players[2];
     int current_player;
     game_state_t state;
-    int players_connected;
+    int players_connected;      // bots included
+    int bots;
 } game_t;
 
+struct shard;
+
+// Room structure: one game plus its slot in the room table
+typedef struct {
+    pthread_mutex_t lock;
+    game_t game;
+    bitword_t* board_masks;         // behind both players' boards, kept for the slot's next game
+    int board_mask_words;
+    int room_id;
+    unsigned int generation;
+    int in_use;
+    int next_free;
+    struct shard* shard;            // serving both players (epoll models)
+    struct session* spectators;
+    int spectator_count[2];         // on the text and binary protocols
+    unsigned int spectate_seq;      // number of the latest spectator view
+    uint32_t journal_game;          // the game's number in the journal
+    uint16_t journal_step;          // and that of its next record
+    wheel_timer_t timer;            // on its shard's wheel (see room_schedule())
+    unsigned long timer_due;        // now_ns() the timer was last set for, 0 if not set
+    unsigned long turn_deadline;    // now_ns() the move (or placing) is due by, 0 if untimed
+    int missed[2];                  // turns each player let run out in a row
+    unsigned long bot_due;          // now_ns() the bot to move fires at, 0 if it is not its turn
+    uint64_t bot_rng;
+} room_t;
+
+// I/O models the server can run
+typedef enum {
+    MODEL_THREADS,
+    MODEL_EPOLL,
+    MODEL_SHARDS,
+    MODEL_URING
+} io_model_t;
+
+// Connection phases
+typedef enum {
+    SESSION_HANDSHAKE,      // waiting for a username
+    SESSION_LOBBY,          // has a username, not in a room
+    SESSION_IN_ROOM,        // seated in a room
+    SESSION_WATCHING        // spectating a room
+} session_phase_t;
+
+// Per-connection state machine. Sessions are reference counted: other
+// threads may hold one while queued replies for it are being written.
+// They live in the session table, one cache-aligned slot each; a slot's
+// first three fields outlast the sessions that use it.
+typedef struct session {
+    int index;              // slot in the session table
+    unsigned int generation;    // bumped each time the slot is released
+    int next_free;
+    int socket;
+    int refcount;
+    pthread_mutex_t send_lock;
+    output_queue_t output;  // replies the socket has not taken yet (send_lock)
+    int output_failed;      // connection dropped; replies are discarded
+    int input_paused;       // not running commands until output drains
+    int wake_pipe[2];       // threads model: wakes the owner to flush output
+    input_ring_t input;
+    int binary;             // negotiated the binary protocol
+    session_phase_t phase;
+    char username[MAX_USERNAME];
+    int has_username;
+    unsigned char token[PROTO_TOKEN_BYTES];     // resume token issued with the username
+    int has_token;
+    int quitting;           // sent QUIT: the seat is not held
+    wheel_timer_t timer;    // handshake and idle deadlines (see session_on_timer())
+    unsigned long handshake_at;     // now_ns() the session last began waiting for a username
+    unsigned long active_at;        // and last ran a command or returned to the lobby
+    int timer_fired;        // threads model: for the session's own thread to look into
+    room_t* room;
+    int seat;
+    int waiting;
+    unsigned long waiting_at;   // now_ns() it joined the matchmaking queue
+    struct session* prev_waiting;
+    struct session* next_waiting;
+    room_t* watching;       // room spectated, guarded by its lock
+    struct session* prev_spectator;
+    struct session* next_spectator;
+    struct shard* shard;    // reactor serving the connection (epoll models)
+    int closed;
+    int mail_pending;       // posted to a shard's mailbox, not yet read
+    struct session* next_mail;
+    struct session* mail_partner;
+    room_t* mail_room;      // or the room it was handed over to watch
+    unsigned int mail_room_generation;
+    int mail_resume;        // or to take its seat back in, with its token
+    int recv_armed;         // uring model: multishot receive outstanding
+    int recv_cancelling;
+    int send_inflight;      // uring model: a send of queued output is outstanding
+    struct msghdr send_msg;
+    struct iovec send_iov[URING_SEND_IOV];
+    char* held;             // uring model: received while paused, not yet in input
+    size_t held_length;
+    size_t held_capacity;
+} __attribute__((aligned(64))) session_t;
+
+// Names one session rather than its slot: the slot index in the high half,
+// the slot's generation shifted past the low three bits (left free for the
+// uring model's operation tag). Looking a handle up fails once the session
+// has ended, so an event outliving it cannot reach the slot's next user.
+typedef uint64_t session_handle_t;
+
+#define SESSION_GENERATION_MASK 0x1FFFFFFFu
+
+// Shards model: one epoll reactor per thread with its own listener.
+// Both players of a room are always served by the same shard, so rooms
+// and sessions need no locks; only the registry is shared. Other threads
+// reach a shard through its mailbox, a lock-free stack of sessions woken
+// by an eventfd.
+typedef struct shard {
+    int id;
+    pthread_t thread;
+    int listen_fd;
+    int epoll_fd;
+    int wake_fd;
+    session_t* mailbox;
+    unsigned long accepted;
+    unsigned long handoffs_in;  // connections moved here to join a game
+    unsigned long syscalls;     // on the I/O path; see reactor_account()
+    unsigned long commands;
+    timer_wheel_t timers;       // its sessions' and rooms' deadlines
+} shard_t;
+
+// Room table: fixed array of rooms recycled through a free list. Slots
+// are set up on first use, so untouched ones never become resident.
+typedef struct {
+    room_t* rooms;
+    int capacity;
+    int initialized;        // slots below this have been set up
+    int free_head;
+    int active;
+    int latest;             // room of the game started last
+    unsigned long games_started;
+    unsigned long games_finished;
+} room_table_t;
+
+// Session table: every session's slot and input ring, reserved at startup
+// and recycled through a free list like the room table, so accepting a
+// connection allocates nothing. Pages are only touched once a slot is used.
+typedef struct {
+    session_t* sessions;
+    char* input;            // INPUT_SLOT_SIZE bytes per slot
+    int capacity;
+    int initialized;        // slots below this have been handed out
+    int free_head;
+    int active;
+} session_table_t;
+
+#define INPUT_SLOT_SIZE (INPUT_RING_SIZE + MAX_FRAME)
+
+// Matchmaking queue: players with a username waiting for an opponent
+typedef struct {
+    session_t* head;
+    session_t* tail;
+    int length;
+} match_queue_t;
+
+// Seats held for players whose connection dropped, found by their resume
+// token: open addressing with linear probing, keyed on the token's first
+// bytes (random already). A room holds at most one seat at a time, so
+// twice as many slots as rooms keeps every probe short.
+typedef struct {
+    unsigned char token[PROTO_TOKEN_BYTES];
+    room_t* room;           // NULL: free slot
+    unsigned int generation;
+} held_seat_t;
+
+typedef struct {
+    held_seat_t* slots;
+    unsigned int mask;      // slot count - 1
+    int count;
+} held_table_t;
+
+// Lock contention counters, one set per lock class
+typedef struct {
+    const char* name;
+    unsigned long acquisitions;
+    unsigned long contended;
+    unsigned long wait_ns;
+} lock_stats_t;
+
+// Replies produced while locks are held; written out by outbox_flush()
+typedef struct {
+    session_t* target;
+    size_t offset;
+    size_t length;
+} outbox_entry_t;
+
+typedef struct {
+    char* data;
+    size_t used;
+    size_t capacity;
+    outbox_entry_t* entries;
+    int count;
+    int max_entries;
+} outbox_t;
+
+// Updates for one room's spectators, produced while it is locked. Each is
+// serialized once per protocol, appended to a shared buffer, and
+// outbox_flush() queues that same buffer to every spectator by reference,
+// so a room's thousandth spectator costs a write and no formatting.
+typedef struct {
+    room_t* room;
+    outq_shared_t* update[2];       // for the text and binary protocols
+    size_t capacity[2];
+    session_t** viewers;            // the room's spectators, referenced
+    int viewer_count;
+    int viewer_capacity;
+} fanout_t;
+
+// Names of the commands in the trace, by proto_command_type_t
+static const char* command_names[CMD_TYPES] = {
+    "unknown", "username", "caps", "place", "attack", "grid", "framing", "quit", "watch", "resume", "bot", "malformed"
+};
+
 // Global variables
 int listen_fd = -1;
-game_t game;
-pthread_mutex_t game_mutex = PTHREAD_MUTEX_INITIALIZER;
-
-// ANSI color codes
-const char* RESET = "\033[0m";
-const char* BOLD = "\033[1m";
-const char* RED = "\033[91m";
-const char* GREEN = "\033[92m";
-const char* YELLOW = "\033[93m";
-const char* BLUE = "\033[94m";
-const char* MAGENTA = "\033[95m";
-const char* CYAN = "\033[96m";
-const char* WHITE = "\033[97m";
+volatile sig_atomic_t shutdown_requested = 0;
+volatile sig_atomic_t stats_requested = 0;
+volatile sig_atomic_t upgrade_requested = 0;
+int server_port = PORT;
+#ifdef __linux__
+io_model_t io_model = MODEL_EPOLL;
+#else
+io_model_t io_model = MODEL_THREADS;
+#endif
+int tracing = 1;
+int log_level = LOG_INFO;       // --log-level
+int shard_count = 0;            // --shards, default one per online CPU
+int pin_shards = 0;
+shard_t* shards = NULL;
+board_config_t default_config;     // board and fleet new rooms start with
+room_table_t room_table;
+session_table_t session_table;
+int max_sessions = MAX_SESSIONS;
+int resume_grace = RESUME_GRACE;   // --resume-grace; 0 frees a dropped player's seat at once
+int handshake_timeout = HANDSHAKE_TIMEOUT;  // --handshake-timeout, --idle-timeout and
+int idle_timeout = IDLE_TIMEOUT;            // --turn-timeout; 0 never times out
+int turn_timeout = TURN_TIMEOUT;
+int bot_wait = BOT_WAIT;           // --bot-wait; 0 never seats a bot unasked
+int bot_think = BOT_THINK_MS;      // --bot-think, milliseconds a bot takes over a move
+ai_level_t bot_level = AI_NORMAL;  // --bot-level, for bots not asked for at a level
+int random_fd = -1;                // resume tokens are read from here
+held_table_t held_table;
+const char* journal_dir = NULL;    // --journal
+journal_sync_t journal_sync = JOURNAL_SYNC_NONE;
+unsigned int journal_interval = 0;
+char* server_path = NULL;          // this binary, run again by a hot restart
+char** server_argv;
+pid_t successor = 0;               // the process a hot restart handed over to
+match_queue_t match_queue;
+pthread_mutex_t registry_mutex = PTHREAD_MUTEX_INITIALIZER;
+pthread_mutex_t session_table_mutex = PTHREAD_MUTEX_INITIALIZER;
+pthread_mutex_t held_mutex = PTHREAD_MUTEX_INITIALIZER;     // taken last, never held across another
+pthread_mutex_t timer_mutex = PTHREAD_MUTEX_INITIALIZER;    // so is this one
+lock_stats_t registry_lock_stats = { "registry", 0, 0, 0 };
+lock_stats_t room_lock_stats = { "room", 0, 0, 0 };
+lock_stats_t send_lock_stats = { "send", 0, 0, 0 };
+lock_stats_t session_lock_stats = { "sessions", 0, 0, 0 };
+lock_stats_t held_lock_stats = { "held", 0, 0, 0 };
+lock_stats_t timer_lock_stats = { "timers", 0, 0, 0 };
+timer_wheel_t thread_timers;        // threads model: every timer, run by the accept loop
+int timer_pipe[2] = { -1, -1 };     // wakes the accept loop for a timer due before it would
+uint64_t timer_wakeup = UINT64_MAX; // now_ms() the accept loop next wakes at (timer_mutex)
+unsigned long timeouts[TIMEOUT_COUNT];    // by proto_timeout_t
+unsigned long timeout_forfeits = 0;       // games lost to the clock
+unsigned long bot_games = 0;              // bots seated
+unsigned long bot_moves = 0;
+unsigned long bot_move_ns = 0;            // spent choosing them
+static __thread outbox_t outbox;
+static __thread fanout_t fanout;
+unsigned long spectator_updates = 0;      // shared buffers built for spectators
+unsigned long spectator_writes = 0;       // and queued to one of them
+unsigned long spectator_bytes = 0;
+static __thread char* render_buffer;       // text grids are drawn here before queueing
+static __thread size_t render_capacity;
+static __thread unsigned long io_syscalls;      // accept, recv, epoll and eventfd calls
+static __thread unsigned long commands_run;
 
+// SIGINT asks for shutdown, SIGUSR1 for a statistics dump and SIGUSR2 for
+// a hot restart; the I/O loops act on the flags once the blocking call
+// they are in is interrupted.
 void signal_handler(int sig) {
-    (void)sig;  // Suppress unused parameter warning
-    printf("\n%s%s🛑 Shutting down server...%s\n", BOLD, RED, RESET);
-    if (listen_fd != -1) {
-        close(listen_fd);
+    if (sig == SIGUSR1) {
+        stats_requested = 1;
+    } else if (sig == SIGUSR2) {
+        upgrade_requested = 1;
+    } else {
+        shutdown_requested = 1;
     }
-    exit(0);
 }
 
-void init_game(void) {
-    memset(&game, 0, sizeof(game_t));
-    game.state = WAITING_FOR_PLAYERS;
-    game.current_player = 0;
+unsigned long now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long)ts.tv_sec * 1000000000UL + ts.tv_nsec;
+}
+
+// The epoll and io_uring reactors own every room and session on one
+// thread, so locking is only needed in the thread-per-connection model.
+// Shards share nothing but the registry, the session table and the
+// held seats; each runs its own timing wheel.
+static int lock_needed(pthread_mutex_t* mutex) {
+    if (io_model == MODEL_SHARDS) {
+        return mutex == &registry_mutex || mutex == &session_table_mutex || mutex == &held_mutex;
+    }
+    return io_model == MODEL_THREADS;
+}
+
+void lock_acquire(pthread_mutex_t* mutex, lock_stats_t* stats) {
+    if (!lock_needed(mutex)) return;
     
-    for (int p = 0; p < 2; p++) {
-        game.players[p].socket = -1;
-        game.players[p].player_id = p;
-        game.players[p].has_username = 0;
-        game.players[p].ship_placed = 0;
-        game.players[p].ship_hits = 0;
-        strcpy(game.players[p].username, "");
-        
-        for (int i = 0; i < GRID_SIZE; i++) {
-            for (int j = 0; j < GRID_SIZE; j++) {
-                game.players[p].grid[i][j] = EMPTY;
-                game.players[p].enemy_view[i][j] = EMPTY;
-            }
-        }
+    if (pthread_mutex_trylock(mutex) != 0) {
+        unsigned long start = now_ns();
+        pthread_mutex_lock(mutex);
+        unsigned long end = now_ns();
+        __atomic_fetch_add(&stats->contended, 1, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&stats->wait_ns, end - start, __ATOMIC_RELAXED);
+        trace_lock_wait(start, end);
     }
+    __atomic_fetch_add(&stats->acquisitions, 1, __ATOMIC_RELAXED);
 }
 
-void send_message(int socket, const char* message) {
-    send(socket, message, strlen(message), 0);
+void lock_release(pthread_mutex_t* mutex) {
+    if (!lock_needed(mutex)) return;
+    pthread_mutex_unlock(mutex);
 }
 
-void send_colorful_grid(int socket, cell_state_t grid[GRID_SIZE][GRID_SIZE], int show_ships, const char* title) {
-    char buffer[2048];
-    char grid_str[1024] = "";
-    
-    snprintf(grid_str, sizeof(grid_str), 
-        "%s%s╔════════════════════════════════════════════════╗%s\n"
-        "%s%s║                    %s%-20s%s%s║%s\n"
-        "%s%s╚════════════════════════════════════════════════╝%s\n\n",
-        BOLD, CYAN, RESET,
-        BOLD, CYAN, WHITE, title, CYAN, BOLD, RESET,
-        BOLD, CYAN, RESET);
+// The wheel a reactor's sessions and rooms are timed on; in the threads
+// model (no shard) everyone shares one, run by the accept loop
+static timer_wheel_t* timer_wheel(shard_t* shard) {
+    return shard != NULL ? &shard->timers : &thread_timers;
+}
+
+// Sets the timer to go off once deadline (now_ns()) has passed, on the
+// shard's wheel. The accept loop is woken if it would sleep past it.
+static void timer_schedule(shard_t* shard, wheel_timer_t* timer, unsigned long deadline) {
+    uint64_t deadline_ms = (deadline + 999999UL) / 1000000UL;
+    lock_acquire(&timer_mutex, &timer_lock_stats);
+    wheel_schedule(timer_wheel(shard), timer, deadline_ms);
+    int wake = io_model == MODEL_THREADS && deadline_ms < timer_wakeup;
+    if (wake) timer_wakeup = deadline_ms;
+    lock_release(&timer_mutex);
+    if (wake) {
+        ssize_t ignored = write(timer_pipe[1], "", 1);
+        (void)ignored;
+    }
+}
+
+static void timer_cancel(shard_t* shard, wheel_timer_t* timer) {
+    lock_acquire(&timer_mutex, &timer_lock_stats);
+    wheel_cancel(timer_wheel(shard), timer);
+    lock_release(&timer_mutex);
+}
+
+void print_lock_stats(void) {
+    lock_stats_t* all[] = { &registry_lock_stats, &room_lock_stats, &send_lock_stats, &session_lock_stats,
+                            &held_lock_stats, &timer_lock_stats };
     
-    // Column headers
-    strcat(grid_str, "     ");
-    for (int j = 0; j < GRID_SIZE; j++) {
-        char col_header[16];
-        snprintf(col_header, sizeof(col_header), "%s%s%c%s   ", BOLD, YELLOW, 'A' + j, RESET);
-        strcat(grid_str, col_header);
+    printf("%s%s📊 Lock contention%s\n", BOLD, CYAN, RESET);
+    printf("  %-10s %14s %12s %12s\n", "lock", "acquisitions", "contended", "wait ms");
+    for (int i = 0; i < (int)(sizeof(all) / sizeof(all[0])); i++) {
+        printf("  %-10s %14lu %12lu %12.2f\n", all[i]->name,
+            __atomic_load_n(&all[i]->acquisitions, __ATOMIC_RELAXED),
+            __atomic_load_n(&all[i]->contended, __ATOMIC_RELAXED),
+            __atomic_load_n(&all[i]->wait_ns, __ATOMIC_RELAXED) / 1e6);
+    }
+    fflush(stdout);
+}
+
+void print_trace_stats(void) {
+    if (!tracing) return;
+    printf("%s%s📊 Command latency by phase%s\n", BOLD, CYAN, RESET);
+    trace_print(stdout, command_names);
+    fflush(stdout);
+}
+
+void session_table_init(int capacity) {
+    size_t sessions_size = (size_t)capacity * sizeof(session_t);
+    size_t input_size = (size_t)capacity * INPUT_SLOT_SIZE;
+    void* sessions = mmap(NULL, sessions_size, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    void* input = mmap(NULL, input_size, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (sessions == MAP_FAILED || input == MAP_FAILED) {
+        perror("Session table allocation failed");
+        exit(1);
+    }
+    session_table.sessions = sessions;
+    session_table.input = input;
+    session_table.capacity = capacity;
+    session_table.initialized = 0;
+    session_table.active = 0;
+    session_table.free_head = -1;
+}
+
+// Takes a free slot, or the next never-used one, with everything past the
+// slot's own fields zeroed. NULL once every slot is taken.
+static session_t* session_slot_alloc(void) {
+    session_t* session = NULL;
+    lock_acquire(&session_table_mutex, &session_lock_stats);
+    if (session_table.free_head != -1) {
+        session = &session_table.sessions[session_table.free_head];
+        session_table.free_head = session->next_free;
+    } else if (session_table.initialized < session_table.capacity) {
+        session = &session_table.sessions[session_table.initialized];
+        session->index = session_table.initialized++;
+        __atomic_store_n(&session->generation, 1, __ATOMIC_RELAXED);
     }
-    strcat(grid_str, "\n\n");
+    if (session != NULL) session_table.active++;
+    lock_release(&session_table_mutex);
+    if (session == NULL) return NULL;
     
-    // Grid rows with fancy borders
-    for (int i = 0; i < GRID_SIZE; i++) {
-        char row[256];
-        snprintf(row, sizeof(row), "  %s%s%d%s  ", BOLD, YELLOW, i + 1, RESET);
-        strcat(grid_str, row);
-        
-        for (int j = 0; j < GRID_SIZE; j++) {
-            char cell[32];
-            switch (grid[i][j]) {
-                case EMPTY:
-                    snprintf(cell, sizeof(cell), "%s%s⬜%s ", BOLD, BLUE, RESET);
-                    break;
-                case SHIP:
-                    if (show_ships) {
-                        snprintf(cell, sizeof(cell), "%s%s🚢%s ", BOLD, GREEN, RESET);
-                    } else {
-                        snprintf(cell, sizeof(cell), "%s%s⬜%s ", BOLD, BLUE, RESET);
-                    }
-                    break;
-                case HIT:
-                    snprintf(cell, sizeof(cell), "%s%s💥%s ", BOLD, RED, RESET);
-                    break;
-                case MISS:
-                    snprintf(cell, sizeof(cell), "%s%s💧%s ", BOLD, WHITE, RESET);
-                    break;
-            }
-            strcat(grid_str, cell);
-        }
-        strcat(grid_str, "\n");
-    }
-    
-    strcat(grid_str, "\n");
-    strcat(grid_str, "Legend: ");
-    char legend[256];
-    snprintf(legend, sizeof(legend), 
-        "%s⬜%s=Water %s🚢%s=Ship %s💥%s=Hit %s💧%s=Miss\n\n",
-        BLUE, RESET, GREEN, RESET, RED, RESET, WHITE, RESET);
-    strcat(grid_str, legend);
-    
-    snprintf(buffer, sizeof(buffer), "GRID\n%s", grid_str);
-    send_message(socket, buffer);
-}
-
-void send_both_grids(int player_id) {
-    player_t* player = &game.players[player_id];
-    int enemy_id = 1 - player_id;
-    
-    char combined[4096];
-    snprintf(combined, sizeof(combined),
-        "%s%s╔══════════════════════════════════════════════════════════════════════════════════════════════════════════════════╗%s\n"
-        "%s%s║                                          %s🎯 BATTLE STATUS 🎯%s                                              %s║%s\n"
-        "%s%s╚══════════════════════════════════════════════════════════════════════════════════════════════════════════════════╝%s\n\n"
-        "%s%s📋 YOUR GRID%s                              %s🎯 ENEMY GRID (%s)%s\n"
-        "   (Shows your ship)                         (Shows your attacks)\n\n",
-        BOLD, MAGENTA, RESET,
-        BOLD, MAGENTA, WHITE, MAGENTA, BOLD, RESET,
-        BOLD, MAGENTA, RESET,
-        BOLD, GREEN, RESET, BOLD, game.players[enemy_id].username, RESET);
-    
-    // Your grid (left side)
-    strcat(combined, "     ");
-    for (int j = 0; j < GRID_SIZE; j++) {
-        char col_header[16];
-        snprintf(col_header, sizeof(col_header), "%s%s%c%s   ", BOLD, YELLOW, 'A' + j, RESET);
-        strcat(combined, col_header);
-    }
-    
-    // Enemy grid headers (right side)
-    strcat(combined, "           ");
-    for (int j = 0; j < GRID_SIZE; j++) {
-        char col_header[16];
-        snprintf(col_header, sizeof(col_header), "%s%s%c%s   ", BOLD, YELLOW, 'A' + j, RESET);
-        strcat(combined, col_header);
-    }
-    strcat(combined, "\n\n");
-    
-    // Both grids side by side
-    for (int i = 0; i < GRID_SIZE; i++) {
-        char row[512];
-        snprintf(row, sizeof(row), "  %s%s%d%s  ", BOLD, YELLOW, i + 1, RESET);
-        strcat(combined, row);
-        
-        // Your grid
-        for (int j = 0; j < GRID_SIZE; j++) {
-            char cell[32];
-            switch (player->grid[i][j]) {
-                case EMPTY:
-                    snprintf(cell, sizeof(cell), "%s%s⬜%s ", BOLD, BLUE, RESET);
-                    break;
-                case SHIP:
-                    snprintf(cell, sizeof(cell), "%s%s🚢%s ", BOLD, GREEN, RESET);
-                    break;
-                case HIT:
-                    snprintf(cell, sizeof(cell), "%s%s💥%s ", BOLD, RED, RESET);
-                    break;
-                case MISS:
-                    snprintf(cell, sizeof(cell), "%s%s💧%s ", BOLD, WHITE, RESET);
-                    break;
-            }
-            strcat(combined, cell);
-        }
-        
-        // Space between grids
-        snprintf(row, sizeof(row), "        %s%s%d%s  ", BOLD, YELLOW, i + 1, RESET);
-        strcat(combined, row);
-        
-        // Enemy view
-        for (int j = 0; j < GRID_SIZE; j++) {
-            char cell[32];
-            switch (player->enemy_view[i][j]) {
-                case EMPTY:
-                    snprintf(cell, sizeof(cell), "%s%s❔%s ", BOLD, MAGENTA, RESET);
-                    break;
-                case HIT:
-                    snprintf(cell, sizeof(cell), "%s%s💥%s ", BOLD, RED, RESET);
-                    break;
-                case MISS:
-                    snprintf(cell, sizeof(cell), "%s%s💧%s ", BOLD, WHITE, RESET);
-                    break;
-                default:
-                    snprintf(cell, sizeof(cell), "%s%s❔%s ", BOLD, MAGENTA, RESET);
-                    break;
-            }
-            strcat(combined, cell);
+    memset(&session->socket, 0, sizeof(session_t) - offsetof(session_t, socket));
+    return session;
+}
+
+// Ends the session in its slot: handles to it stop resolving, and the
+// slot goes back on the free list
+static void session_slot_release(session_t* session) {
+    unsigned int generation = (session->generation + 1) & SESSION_GENERATION_MASK;
+    __atomic_store_n(&session->generation, generation != 0 ? generation : 1, __ATOMIC_RELEASE);
+    
+    lock_acquire(&session_table_mutex, &session_lock_stats);
+    session->next_free = session_table.free_head;
+    session_table.free_head = session->index;
+    session_table.active--;
+    lock_release(&session_table_mutex);
+}
+
+session_handle_t session_handle(session_t* session) {
+    unsigned int generation = __atomic_load_n(&session->generation, __ATOMIC_RELAXED);
+    return (uint64_t)session->index << 32 | (uint64_t)generation << 3;
+}
+
+// The session handle names, or NULL if it has ended. 0 is never a handle.
+session_t* session_lookup(session_handle_t handle) {
+    uint64_t index = handle >> 32;
+    if (index >= (uint64_t)session_table.capacity) return NULL;
+    session_t* session = &session_table.sessions[index];
+    unsigned int generation = __atomic_load_n(&session->generation, __ATOMIC_ACQUIRE);
+    return ((uint64_t)generation << 3) == (handle & 0xFFFFFFFFu) ? session : NULL;
+}
+
+void session_ref(session_t* session) {
+    __atomic_fetch_add(&session->refcount, 1, __ATOMIC_RELAXED);
+}
+
+// The socket is closed with the last reference so that a reply queued by
+// another thread can never reach a recycled descriptor.
+void session_unref(session_t* session) {
+    if (__atomic_sub_fetch(&session->refcount, 1, __ATOMIC_ACQ_REL) == 0) {
+        outq_close(&session->output, session->socket);
+        if (session->wake_pipe[0] >= 0) {
+            close(session->wake_pipe[0]);
+            close(session->wake_pipe[1]);
         }
-        strcat(combined, "\n");
+        pthread_mutex_destroy(&session->send_lock);
+        free(session->held);
+        session_slot_release(session);
+    }
+}
+
+// Sets up a new game in the room on config, growing the room's board
+// storage if the game needs more. Returns -1 if it could not.
+int init_game(room_t* room, const board_config_t* config) {
+    game_t* game = &room->game;
+    int words = board_storage_words(config);
+    if (2 * words > room->board_mask_words) {
+        bitword_t* grown = realloc(room->board_masks, 2 * words * sizeof(bitword_t));
+        if (grown == NULL) return -1;
+        room->board_masks = grown;
+        room->board_mask_words = 2 * words;
     }
     
-    strcat(combined, "\n");
+    memset(game, 0, sizeof(game_t));
+    game->config = *config;
+    game->state = WAITING_FOR_PLAYERS;
+    game->current_player = 0;
     
-    char buffer[5120];
-    snprintf(buffer, sizeof(buffer), "BOTH_GRIDS\n%s", combined);
-    send_message(player->socket, buffer);
+    for (int p = 0; p < 2; p++) {
+        game->players[p].session = NULL;
+        game->players[p].player_id = p;
+        game->players[p].has_username = 0;
+        strcpy(game->players[p].username, "");
+        game->players[p].board.masks = room->board_masks + p * words;
+        board_reset(&game->players[p].board, &game->config);
+    }
+    return 0;
 }
 
-int validate_ship_placement(int player_id, int row, int col, int horizontal) {
-    player_t* player = &game.players[player_id];
-    
-    // Check bounds
-    if (horizontal) {
-        if (col + SHIP_SIZE > GRID_SIZE) return 0;
-    } else {
-        if (row + SHIP_SIZE > GRID_SIZE) return 0;
+void room_table_init(int capacity) {
+    room_table.rooms = calloc(capacity, sizeof(room_t));
+    if (room_table.rooms == NULL) {
+        perror("Room table allocation failed");
+        exit(1);
     }
-    
-    // Check for overlaps
-    for (int i = 0; i < SHIP_SIZE; i++) {
-        int r = row + (horizontal ? 0 : i);
-        int c = col + (horizontal ? i : 0);
-        if (player->grid[r][c] != EMPTY) return 0;
+    room_table.capacity = capacity;
+    room_table.initialized = 0;
+    room_table.active = 0;
+    room_table.free_head = -1;
+    room_table.latest = -1;
+}
+
+// Sizes the held seat table for rooms rooms; calloc() leaves the slots
+// untouched until seats are held
+void held_table_init(int rooms) {
+    unsigned int slots = 16;
+    while (slots < 2 * (unsigned int)rooms) slots *= 2;
+    held_table.slots = calloc(slots, sizeof(held_seat_t));
+    if (held_table.slots == NULL) {
+        perror("Held seat table allocation failed");
+        exit(1);
     }
-    
-    return 1;
+    held_table.mask = slots - 1;
+    held_table.count = 0;
 }
 
-void place_ship(int player_id, int row, int col, int horizontal) {
-    player_t* player = &game.players[player_id];
-    
-    for (int i = 0; i < SHIP_SIZE; i++) {
-        int r = row + (horizontal ? 0 : i);
-        int c = col + (horizontal ? i : 0);
-        player->grid[r][c] = SHIP;
+static unsigned int held_home(const unsigned char* token) {
+    uint32_t key;
+    memcpy(&key, token, sizeof(key));
+    return key & held_table.mask;
+}
+
+// Caller holds held_mutex. The slot holding token, or the free slot where
+// it would go.
+static unsigned int held_probe(const unsigned char* token) {
+    unsigned int slot = held_home(token);
+    while (held_table.slots[slot].room != NULL &&
+           memcmp(held_table.slots[slot].token, token, PROTO_TOKEN_BYTES) != 0) {
+        slot = (slot + 1) & held_table.mask;
     }
-    
-    player->ship_placed = 1;
+    return slot;
 }
 
-int process_attack(int attacker_id, int row, int col) {
-    int defender_id = 1 - attacker_id;
-    player_t* attacker = &game.players[attacker_id];
-    player_t* defender = &game.players[defender_id];
-    
-    if (row < 0 || row >= GRID_SIZE || col < 0 || col >= GRID_SIZE) return -1;
-    if (attacker->enemy_view[row][col] != EMPTY) return -1; // Already attacked
+// Caller holds held_mutex. Returns 0 if the table is full.
+static int held_insert(const unsigned char* token, room_t* room) {
+    if ((unsigned int)held_table.count >= held_table.mask) return 0;
+    held_seat_t* entry = &held_table.slots[held_probe(token)];
+    if (entry->room == NULL) held_table.count++;
+    memcpy(entry->token, token, PROTO_TOKEN_BYTES);
+    entry->room = room;
+    entry->generation = room->generation;
+    return 1;
+}
+
+// Caller holds held_mutex. Copies the entry for token into out; returns
+// 0 if there is none.
+static int held_find(const unsigned char* token, held_seat_t* out) {
+    held_seat_t* entry = &held_table.slots[held_probe(token)];
+    if (entry->room == NULL) return 0;
+    *out = *entry;
+    return 1;
+}
+
+// Caller holds held_mutex. Removes token's entry, moving back any that
+// follow it in the run and could sit in its place, so that no probe ever
+// stops short at the hole.
+static void held_remove(const unsigned char* token) {
+    unsigned int hole = held_probe(token);
+    if (held_table.slots[hole].room == NULL) return;
+    held_table.count--;
     
-    if (defender->grid[row][col] == SHIP) {
-        defender->grid[row][col] = HIT;
-        attacker->enemy_view[row][col] = HIT;
-        defender->ship_hits++;
-        
-        if (defender->ship_hits >= SHIP_SIZE) {
-            return 2; // Ship sunk (game over)
+    unsigned int next = hole;
+    while (1) {
+        next = (next + 1) & held_table.mask;
+        held_seat_t* entry = &held_table.slots[next];
+        if (entry->room == NULL) break;
+        unsigned int home = held_home(entry->token);
+        // Movable unless its home lies cyclically in (hole, next]
+        if (((next - home) & held_table.mask) >= ((next - hole) & held_table.mask)) {
+            held_table.slots[hole] = *entry;
+            hole = next;
         }
-        return 1; // Hit
-    } else {
-        defender->grid[row][col] = MISS;
-        attacker->enemy_view[row][col] = MISS;
-        return 0; // Miss
     }
+    held_table.slots[hole].room = NULL;
 }
 
-void broadcast_message(const char* message) {
-    for (int i = 0; i < 2; i++) {
-        if (game.players[i].socket != -1) {
-            send_message(game.players[i].socket, message);
-        }
+// Fills token with bytes from the kernel's generator, read a block at a
+// time per thread. Returns 0 if none could be read.
+static int random_token(unsigned char* token) {
+    static __thread unsigned char pool[256];
+    static __thread size_t left = 0;
+    if (left < PROTO_TOKEN_BYTES) {
+        ssize_t got = read(random_fd, pool, sizeof(pool));
+        left = got > 0 ? (size_t)got : 0;
+        if (left < PROTO_TOKEN_BYTES) return 0;
     }
+    left -= PROTO_TOKEN_BYTES;
+    memcpy(token, pool + left, PROTO_TOKEN_BYTES);
+    return 1;
 }
 
-void* handle_client(void* arg) {
-    int client_socket = *(int*)arg;
-    free(arg);
-    
-    char buffer[BUFFER_SIZE];
-    int player_id = -1;
-    
-    pthread_mutex_lock(&game_mutex);
+// Caller holds the room lock. Starts the room's next journal record, or
+// returns NULL if no journal is kept.
+static journal_record_t* room_journal(room_t* room, journal_type_t type, int seat) {
+    journal_record_t* record = journal_record();
+    if (record == NULL) return NULL;
+    record->game = room->journal_game;
+    record->room = (uint16_t)room->room_id;
+    record->step = room->journal_step++;
+    record->type = (uint8_t)type;
+    record->seat = (uint8_t)seat;
+    return record;
+}
+
+// Caller holds the room lock. Numbers the room's new game and logs its
+// board and fleet.
+static void journal_game_start(room_t* room) {
+    if (!journal_enabled()) return;
+    room->journal_game = journal_next_game();
+    room->journal_step = 0;
     
-    if (game.players_connected >= 2) {
-        send_message(client_socket, "ERROR Game is full\n");
-        pthread_mutex_unlock(&game_mutex);
-        close(client_socket);
+    const board_config_t* config = &room->game.config;
+    journal_record_t* record = room_journal(room, JOURNAL_GAME_START, 0);
+    if (record == NULL) return;
+    record->data.config.rows = (uint8_t)config->rows;
+    record->data.config.cols = (uint8_t)config->cols;
+    record->data.config.ship_count = (uint8_t)config->ship_count;
+    for (int i = 0; i < config->ship_count; i++) {
+        record->data.config.ship_lengths[i] = (uint8_t)config->ship_lengths[i];
+    }
+}
+
+// Caller must hold registry_mutex. Reuses a freed room if there is one,
+// otherwise sets up the next never-used slot. Returns the room locked.
+room_t* room_alloc(void) {
+    room_t* room;
+    if (room_table.free_head != -1) {
+        room = &room_table.rooms[room_table.free_head];
+        room_table.free_head = room->next_free;
+    } else if (room_table.initialized < room_table.capacity) {
+        room = &room_table.rooms[room_table.initialized];
+        pthread_mutex_init(&room->lock, NULL);
+        wheel_timer_init(&room->timer, TIMER_ROOM);
+        room->room_id = room_table.initialized++;
+    } else {
         return NULL;
     }
     
-    player_id = game.players_connected;
-    game.players[player_id].socket = client_socket;
-    game.players_connected++;
-    
-    char welcome_msg[256];
-    snprintf(welcome_msg, sizeof(welcome_msg), 
-        "WELCOME %s%s🎉 Welcome to Mini Battleship! 🎉%s\nPlease enter your username (max %d chars):\n", 
-        BOLD, GREEN, RESET, MAX_USERNAME - 1);
-    send_message(client_socket, welcome_msg);
-    
-    pthread_mutex_unlock(&game_mutex);
+    lock_acquire(&room->lock, &room_lock_stats);
+    if (init_game(room, &default_config) != 0) {
+        room->next_free = room_table.free_head;
+        room_table.free_head = room->room_id;
+        lock_release(&room->lock);
+        return NULL;
+    }
+    room_table.active++;
+    room_table.games_started++;
+    room_table.latest = room->room_id;
+    room->next_free = -1;
+    room->in_use = 1;
+    room->generation++;
+    room->spectate_seq = 0;
+    room->timer_due = 0;
+    room->turn_deadline = 0;
+    room->missed[0] = room->missed[1] = 0;
+    room->bot_due = 0;
+    journal_game_start(room);
+    return room;
+}
+
+// Caller must hold registry_mutex
+room_t* room_lookup(int room_id) {
+    if (room_id < 0 || room_id >= room_table.initialized) return NULL;
+    room_t* room = &room_table.rooms[room_id];
+    return room->in_use ? room : NULL;
+}
+
+// Locks the room the session is seated in. The pointer is read without a
+// lock, so it is only trusted once the seat is confirmed under the room lock.
+room_t* room_acquire(session_t* session) {
+    room_t* room = __atomic_load_n(&session->room, __ATOMIC_ACQUIRE);
+    if (room == NULL) return NULL;
     
-    while (1) {
-        int bytes_received = recv(client_socket, buffer, BUFFER_SIZE - 1, 0);
-        if (bytes_received <= 0) break;
-        
-        buffer[bytes_received] = '\0';
-        // Remove newline
-        char* newline = strchr(buffer, '\n');
-        if (newline) *newline = '\0';
-        
-        printf("Player %d: %s\n", player_id + 1, buffer);
-        
-        pthread_mutex_lock(&game_mutex);
-        
-        // Handle username input
-        if (!game.players[player_id].has_username && strlen(buffer) > 0) {
-            strncpy(game.players[player_id].username, buffer, MAX_USERNAME - 1);
-            game.players[player_id].username[MAX_USERNAME - 1] = '\0';
-            game.players[player_id].has_username = 1;
-            
-            char user_confirm[256];
-            snprintf(user_confirm, sizeof(user_confirm), 
-                "USERNAME_SET %s%s⭐ Welcome, %s! ⭐%s\n", 
-                BOLD, CYAN, game.players[player_id].username, RESET);
-            send_message(client_socket, user_confirm);
-            
-            // Check if both players have usernames
-            if (game.players[0].has_username && game.players[1].has_username && game.players_connected == 2) {
-                game.state = PLACING_SHIPS;
-                char start_msg[512];
-                snprintf(start_msg, sizeof(start_msg),
-                    "GAME_START %s%s🚢 Game Starting! 🚢%s\n"
-                    "%s vs %s\n"
-                    "Each player places ONE 2-space ship on a 4x4 grid.\n"
-                    "Use: PLACE <pos> <H|V> (e.g., PLACE A1 H)\n",
-                    BOLD, MAGENTA, RESET,
-                    game.players[0].username, game.players[1].username);
-                broadcast_message(start_msg);
-                printf("Game started: %s vs %s\n", 
-                    game.players[0].username, game.players[1].username);
-            } else if (game.players_connected == 1) {
-                // First player - show waiting message
-                char waiting_msg[256];
-                snprintf(waiting_msg, sizeof(waiting_msg),
-                    "WAIT_PLAYER %s%sWaiting for another player to join...%s\n",
-                    BOLD, YELLOW, RESET);
-                send_message(client_socket, waiting_msg);
-            }
-            
-            pthread_mutex_unlock(&game_mutex);
-            continue;
+    lock_acquire(&room->lock, &room_lock_stats);
+    int seat = session->seat;
+    if (room->in_use && seat >= 0 && room->game.players[seat].session == session) {
+        return room;
+    }
+    lock_release(&room->lock);
+    return NULL;
+}
+
+void spectators_end(room_t* room);
+
+// Caller must hold the room lock. Stops holding the seat for its token.
+void seat_release(room_t* room, int seat) {
+    player_t* player = &room->game.players[seat];
+    if (!player->held) return;
+    lock_acquire(&held_mutex, &held_lock_stats);
+    held_remove(player->token);
+    lock_release(&held_mutex);
+    player->held = 0;
+}
+
+// Caller must hold the room lock. Detaches any remaining players and
+// spectators, and gives up any seat still held (the player leaves for
+// good, unless the game is already over); the slot is not reusable until
+// room_free() puts it back on the free list.
+void room_close(room_t* room) {
+    spectators_end(room);
+    timer_cancel(room->shard, &room->timer);
+    room->timer_due = 0;
+    room->turn_deadline = 0;
+    room->bot_due = 0;
+    for (int p = 0; p < 2; p++) {
+        if (room->game.players[p].held) {
+            seat_release(room, p);
+            if (room->game.state != GAME_OVER) room_journal(room, JOURNAL_LEAVE, p);
         }
-        
-        char command[16], args[256];
-        sscanf(buffer, "%s %[^\n]", command, args);
-        
-        if (strcmp(command, "PLACE") == 0) {
-            if (game.state != PLACING_SHIPS) {
-                send_message(client_socket, "ERROR Not in ship placement phase\n");
-            } else if (game.players[player_id].ship_placed) {
-                send_message(client_socket, "ERROR Ship already placed\n");
-            } else {
-                char pos[4], orientation[16];
-                if (sscanf(args, "%s %s", pos, orientation) == 2) {
-                    int col = pos[0] - 'A';
-                    int row = pos[1] - '1';
-                    int horizontal = (strcmp(orientation, "H") == 0);
-                    
-                    if (validate_ship_placement(player_id, row, col, horizontal)) {
-                        place_ship(player_id, row, col, horizontal);
-                        char success_msg[256];
-                        snprintf(success_msg, sizeof(success_msg),
-                            "SHIP_PLACED %s%s✅ Ship placed successfully!%s\n",
-                            BOLD, GREEN, RESET);
-                        send_message(client_socket, success_msg);
-                        
-                        send_colorful_grid(client_socket, game.players[player_id].grid, 1, "YOUR GRID");
-                        
-                        if (game.players[0].ship_placed && game.players[1].ship_placed) {
-                            game.state = PLAYING;
-                            char battle_msg[512];
-                            snprintf(battle_msg, sizeof(battle_msg),
-                                "BATTLE_START %s%s⚔️ BATTLE BEGINS! ⚔️%s\n"
-                                "%s goes first!\n",
-                                BOLD, RED, RESET, game.players[0].username);
-                            broadcast_message(battle_msg);
-                            
-                            send_message(game.players[0].socket, "YOUR_TURN It's your turn! Use ATTACK <pos>\n");
-                            send_message(game.players[1].socket, "WAIT_TURN Wait for your opponent's move...\n");
-                        }
-                    } else {
-                        send_message(client_socket, "ERROR Invalid ship placement\n");
-                    }
-                } else {
-                    send_message(client_socket, "ERROR Invalid format. Use: PLACE <pos> <H|V>\n");
-                }
-            }
-        } else if (strcmp(command, "ATTACK") == 0) {
-            if (game.state != PLAYING) {
-                send_message(client_socket, "ERROR Not in battle phase\n");
-            } else if (game.current_player != player_id) {
-                send_message(client_socket, "ERROR Not your turn\n");
-            } else {
-                char pos[4];
-                if (sscanf(args, "%s", pos) == 1) {
-                    int col = pos[0] - 'A';
-                    int row = pos[1] - '1';
-                    
-                    int result = process_attack(player_id, row, col);
-                    if (result == -1) {
-                        send_message(client_socket, "ERROR Invalid attack\n");
-                    } else {
-                        char result_msg[512];
-                        char broadcast_msg[512];
-                        
-                        if (result == 2) { // Ship sunk - game over
-                            snprintf(result_msg, sizeof(result_msg),
-                                "WIN %s%s🎉 VICTORY! You sunk their ship! 🎉%s\n",
-                                BOLD, GREEN, RESET);
-                            send_message(client_socket, result_msg);
-                            
-                            snprintf(result_msg, sizeof(result_msg),
-                                "LOSE %s%s💀 DEFEAT! Your ship was sunk! 💀%s\n",
-                                BOLD, RED, RESET);
-                            send_message(game.players[1 - player_id].socket, result_msg);
-                            
-                            snprintf(broadcast_msg, sizeof(broadcast_msg),
-                                "GAME_OVER %s%s🏆 Game Over! %s wins! 🏆%s\n",
-                                BOLD, YELLOW, game.players[player_id].username, RESET);
-                            broadcast_message(broadcast_msg);
-                            
-                            game.state = GAME_OVER;
-                        } else if (result == 1) { // Hit
-                            snprintf(result_msg, sizeof(result_msg),
-                                "HIT %s%s🎯 HIT at %s! 🎯%s\n",
-                                BOLD, RED, pos, RESET);
-                            send_message(client_socket, result_msg);
-                            
-                            snprintf(broadcast_msg, sizeof(broadcast_msg),
-                                "ATTACK_RESULT %s attacked %s - HIT! 💥\n",
-                                game.players[player_id].username, pos);
-                            broadcast_message(broadcast_msg);
-                            
-                            // Same player continues after hit
-                        } else { // Miss
-                            snprintf(result_msg, sizeof(result_msg),
-                                "MISS %s%s💧 MISS at %s 💧%s\n",
-                                BOLD, BLUE, pos, RESET);
-                            send_message(client_socket, result_msg);
-                            
-                            snprintf(broadcast_msg, sizeof(broadcast_msg),
-                                "ATTACK_RESULT %s attacked %s - Miss 💧\n",
-                                game.players[player_id].username, pos);
-                            broadcast_message(broadcast_msg);
-                            
-                            // Switch turns on miss
-                            game.current_player = 1 - game.current_player;
-                        }
-                        
-                        // Send updated grids to both players
-                        for (int i = 0; i < 2; i++) {
-                            send_both_grids(i);
-                        }
-                        
-                        if (game.state == PLAYING) {
-                            if (result == 0) { // Only switch turn message on miss
-                                send_message(game.players[game.current_player].socket, 
-                                    "YOUR_TURN Your turn! Use ATTACK <pos>\n");
-                                send_message(game.players[1 - game.current_player].socket, 
-                                    "WAIT_TURN Wait for your opponent's move...\n");
-                            } else { // Hit - same player continues
-                                send_message(client_socket, "CONTINUE You hit! Go again! Use ATTACK <pos>\n");
-                            }
-                        }
-                    }
-                } else {
-                    send_message(client_socket, "ERROR Invalid format. Use: ATTACK <pos>\n");
-                }
-            }
-        } else if (strcmp(command, "GRID") == 0) {
-            send_both_grids(player_id);
-        } else if (strcmp(command, "QUIT") == 0) {
-            break;
+        session_t* session = room->game.players[p].session;
+        if (session != NULL) {
+            session->seat = -1;
+            session->phase = SESSION_LOBBY;
+            session->active_at = now_ns();
+            __atomic_store_n(&session->room, NULL, __ATOMIC_RELEASE);
+            room->game.players[p].session = NULL;
         }
-        
-        pthread_mutex_unlock(&game_mutex);
     }
+    room->in_use = 0;
+}
+
+void matchmaking_retry(void);
+static void room_start_clock(room_t* room);
+static void session_arm_timer(session_t* session);
+#ifdef __linux__
+void shard_post(shard_t* shard, session_t* session, session_t* partner);
+void shard_hand_over(session_t* session, shard_t* shard, session_t* partner);
+int shard_matchmake(session_t* session);
+int uring_send(session_t* session, const struct iovec* iov, outq_shared_t* const* owners, int count);
+#endif
+
+// Returns a closed room to the free list; other rooms are never touched.
+// Must be called without the room lock (lock order is registry, then room).
+void room_free(room_t* room, int finished) {
+    lock_acquire(&registry_mutex, &registry_lock_stats);
+    if (finished) {
+        room_table.games_finished++;
+    }
+    room->next_free = room_table.free_head;
+    room_table.free_head = room->room_id;
+    room_table.active--;
+    matchmaking_retry();
+    lock_release(&registry_mutex);
+}
+
+// Caller must hold the room lock
+void room_seat_player(room_t* room, int seat, session_t* session) {
+    player_t* player = &room->game.players[seat];
+    player->session = session;
+    strcpy(player->username, session->username);
+    player->has_username = 1;
+    memcpy(player->token, session->token, PROTO_TOKEN_BYTES);
+    room->game.players_connected++;
+    room->shard = session->shard;
     
-    pthread_mutex_lock(&game_mutex);
-    game.players_connected--;
-    if (game.players_connected == 0) {
-        init_game();
+    journal_record_t* record = room_journal(room, JOURNAL_JOIN, seat);
+    if (record != NULL) {
+        memcpy(record->data.username, player->username, strlen(player->username));
     }
-    pthread_mutex_unlock(&game_mutex);
     
-    close(client_socket);
-    printf("Player %s disconnected\n", 
-        strlen(game.players[player_id].username) > 0 ? 
-        game.players[player_id].username : "Unknown");
-    return NULL;
+    session->seat = seat;
+    session->phase = SESSION_IN_ROOM;
+    __atomic_store_n(&session->room, room, __ATOMIC_RELEASE);
 }
 
-int main(void) {
-    struct sockaddr_in servaddr, cliaddr;
-    socklen_t clilen = sizeof(cliaddr);
-    
-    signal(SIGINT, signal_handler);
-    init_game();
+// Caller must hold the room lock. Seats the computer, playing at level,
+// with its fleet already placed.
+void room_seat_bot(room_t* room, int seat, ai_level_t level) {
+    game_t* game = &room->game;
+    player_t* player = &game->players[seat];
+    player->bot = 1;
+    player->bot_level = level;
+    snprintf(player->username, MAX_USERNAME, "Bot (%s)", ai_level_name(level));
+    player->has_username = 1;
+    game->players_connected++;
+    game->bots++;
+    room->bot_rng = ai_seed(now_ns() ^ ((uint64_t)room->room_id << 32) ^ room->generation);
+    __atomic_fetch_add(&bot_games, 1, __ATOMIC_RELAXED);
     
-    listen_fd = socket(AF_INET, SOCK_STREAM, 0);
-    if (listen_fd < 0) {
-        perror("Socket creation failed");
-        exit(1);
+    journal_record_t* record = room_journal(room, JOURNAL_JOIN, seat);
+    if (record != NULL) {
+        memcpy(record->data.username, player->username, strlen(player->username));
     }
-    
-    int opt = 1;
-    if (setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt))) {
-        perror("setsockopt failed");
-        exit(1);
+    ai_place_fleet(&player->board, &game->config, &room->bot_rng);
+    player->board_seq++;
+    for (int i = 0; i < player->board.ships_placed; i++) {
+        const ship_t* ship = &player->board.fleet[i];
+        record = room_journal(room, JOURNAL_PLACE, seat);
+        if (record != NULL) {
+            record->data.place.row = (uint8_t)(ship->cell / game->config.cols);
+            record->data.place.col = (uint8_t)(ship->cell % game->config.cols);
+            record->data.place.horizontal = (uint8_t)(ship->stride == 1);
+        }
     }
+}
+
+// Caller must hold registry_mutex
+void match_queue_remove(session_t* session) {
+    if (!session->waiting) return;
     
-    memset(&servaddr, 0, sizeof(servaddr));
-    servaddr.sin_family = AF_INET;
-    servaddr.sin_addr.s_addr = INADDR_ANY;
-    servaddr.sin_port = htons(PORT);
-    
-    if (bind(listen_fd, (struct sockaddr*)&servaddr, sizeof(servaddr)) < 0) {
-        perror("Bind failed");
-        exit(1);
+    if (session->prev_waiting) {
+        session->prev_waiting->next_waiting = session->next_waiting;
+    } else {
+        match_queue.head = session->next_waiting;
+    }
+    if (session->next_waiting) {
+        session->next_waiting->prev_waiting = session->prev_waiting;
+    } else {
+        match_queue.tail = session->prev_waiting;
+    }
+    session->prev_waiting = NULL;
+    session->next_waiting = NULL;
+    session->waiting = 0;
+    match_queue.length--;
+}
+
+// Caller must hold registry_mutex. Puts the session at the back of the queue.
+void match_queue_append(session_t* session) {
+    session->waiting = 1;
+    session->waiting_at = now_ns();
+    session->next_waiting = NULL;
+    session->prev_waiting = match_queue.tail;
+    if (match_queue.tail) {
+        match_queue.tail->next_waiting = session;
+    } else {
+        match_queue.head = session;
     }
+    match_queue.tail = session;
+    match_queue.length++;
+}
+
+// Caller must hold registry_mutex. Pairs the session with the longest-waiting
+// player and returns their new room (locked), or queues it and returns NULL.
+room_t* matchmaking_enqueue(session_t* session) {
+    session_t* opponent = match_queue.head;
     
-    if (listen(listen_fd, 5) < 0) {
-        perror("Listen failed");
-        exit(1);
+    if (opponent != NULL) {
+        room_t* room = room_alloc();
+        if (room != NULL) {
+            match_queue_remove(opponent);
+            room_seat_player(room, 0, opponent);
+            room_seat_player(room, 1, session);
+            room->game.state = PLACING_SHIPS;
+            room_start_clock(room);
+            return room;
+        }
+        // No free room: wait in line until one is released
     }
     
-    printf("%s%s🚢 Mini Battleship Server 🚢%s\n", BOLD, CYAN, RESET);
-    printf("%s%sRunning on port %d%s\n", BOLD, GREEN, PORT, RESET);
-    printf("%s%sWaiting for players to join...%s\n", BOLD, YELLOW, RESET);
+    match_queue_append(session);
+    session_arm_timer(session);     // for the bot that takes the other seat
+    return NULL;
+}
+
+// Caller must hold registry_mutex. Takes the session out of the queue and
+// seats it against the computer, playing at level, in a new room returned
+// locked; NULL, leaving it queued, if there is no free room.
+room_t* matchmaking_bot(session_t* session, ai_level_t level) {
+    room_t* room = room_alloc();
+    if (room == NULL) return NULL;
+    match_queue_remove(session);
+    room_seat_player(room, 0, session);
+    room_seat_bot(room, 1, level);
+    room->game.state = PLACING_SHIPS;
+    room_start_clock(room);
+    return room;
+}
+
+// Writes iov to the session behind anything already queued for it; what
+// the socket cannot take now stays queued, by reference where owners has
+// a shared buffer for it. A session that failed or fell too far behind is
+// shut down, which its own I/O loop sees as a hangup. Caller holds
+// session->send_lock.
+void session_write(session_t* session, const struct iovec* iov, outq_shared_t* const* owners, int count) {
+    if (session->output_failed) return;
+
+#ifdef __linux__
+    int status = io_model == MODEL_URING ? uring_send(session, iov, owners, count)
+                                         : outq_write(&session->output, session->socket, iov, owners, count);
+#else
+    int status = outq_write(&session->output, session->socket, iov, owners, count);
+#endif
+    if (status < 0 || session->output.bytes > OUTPUT_HIGH_WATER) {
+        if (status >= 0) {
+            logger_event(LOG_NOT_READING, 0, session->has_username ? session->username : "?",
+                NULL, NULL);
+        }
+        // A send still in progress reads the queue; its completion clears it
+        if (!session->send_inflight) {
+            outq_clear(&session->output);
+        }
+        session->output_failed = 1;
+        shutdown(session->socket, SHUT_RDWR);
+    } else if (status > 0 && session->wake_pipe[1] >= 0) {
+        // Thread model: the owner may be asleep without watching POLLOUT
+        ssize_t ignored = write(session->wake_pipe[1], "", 1);
+        (void)ignored;
+    }
+}
+
+// Collects the zero-copy completions the socket reports as an error, and
+// returns how many there were: none means the error is real
+int session_reap(session_t* session) {
+    lock_acquire(&session->send_lock, &send_lock_stats);
+    int count = outq_reap(&session->output, session->socket);
+    lock_release(&session->send_lock);
+    return count;
+}
+
+size_t session_backlog(session_t* session) {
+    lock_acquire(&session->send_lock, &send_lock_stats);
+    size_t bytes = session->output.bytes;
+    lock_release(&session->send_lock);
+    return bytes;
+}
+
+// Shuts down a session a reply could not be queued for, as session_write()
+// does one that fell behind: it must not play on without it
+static void session_reply_lost(session_t* session) {
+    lock_acquire(&session->send_lock, &send_lock_stats);
+    session->output_failed = 1;
+    shutdown(session->socket, SHUT_RDWR);
+    lock_release(&session->send_lock);
+}
+
+// Copies a reply into this thread's outbox. Safe to call with locks held:
+// nothing is sent until outbox_flush(). If the outbox cannot grow, the
+// target is shut down instead (taking only its send_lock, which nothing
+// holds while queueing).
+void queue_bytes(session_t* target, const char* data, size_t len) {
+    if (target == NULL) return;
     
-    while (1) {
-        int* client_socket = malloc(sizeof(int));
-        *client_socket = accept(listen_fd, (struct sockaddr*)&cliaddr, &clilen);
-        
-        if (*client_socket < 0) {
-            perror("Accept failed");
-            free(client_socket);
-            continue;
+    if (outbox.used + len > outbox.capacity) {
+        size_t capacity = outbox.capacity ? outbox.capacity : 16384;
+        while (capacity < outbox.used + len) capacity *= 2;
+        char* buffer = realloc(outbox.data, capacity);
+        if (buffer == NULL) {
+            session_reply_lost(target);
+            return;
         }
-        
-        printf("%s%s⭐ New player connected from %s%s\n", 
-            BOLD, GREEN, inet_ntoa(cliaddr.sin_addr), RESET);
-        
-        pthread_t thread_id;
-        if (pthread_create(&thread_id, NULL, handle_client, client_socket) != 0) {
-            perror("Thread creation failed");
-            close(*client_socket);
-            free(client_socket);
+        outbox.data = buffer;
+        outbox.capacity = capacity;
+    }
+    if (outbox.count == outbox.max_entries) {
+        int max_entries = outbox.max_entries ? outbox.max_entries * 2 : 32;
+        outbox_entry_t* entries = realloc(outbox.entries, max_entries * sizeof(outbox_entry_t));
+        if (entries == NULL) {
+            session_reply_lost(target);
+            return;
         }
-        pthread_detach(thread_id);
+        outbox.entries = entries;
+        outbox.max_entries = max_entries;
     }
     
-    close(listen_fd);
-    return 0;
-}
\ No newline at end of file
+    memcpy(outbox.data + outbox.used, data, len);
+    session_ref(target);
+    outbox.entries[outbox.count].target = target;
+    outbox.entries[outbox.count].offset = outbox.used;
+    outbox.entries[outbox.count].length = len;
+    outbox.count++;
+    outbox.used += len;
+}
+
+void queue_message(session_t* target, const char* message) {
+    queue_bytes(target, message, strlen(message));
+}
+
+// Queues one binary-protocol frame
+void queue_frame(session_t* target, int opcode, const unsigned char* payload, size_t length) {
+    unsigned char frame[PROTO_MAX_PAYLOAD + 3];
+    size_t n = proto_encode_frame(frame, opcode, payload, length);
+    queue_bytes(target, (const char*)frame, n);
+}
+
+// Queues this thread's spectator updates to each spectator they are for:
+// one reference to the shared buffer, not a copy
+static void fanout_flush(void) {
+    for (int i = 0; i < fanout.viewer_count; i++) {
+        session_t* viewer = fanout.viewers[i];
+        outq_shared_t* update = fanout.update[viewer->binary];
+        if (update != NULL) {
+            struct iovec iov = { update->data, update->length };
+            lock_acquire(&viewer->send_lock, &send_lock_stats);
+            session_write(viewer, &iov, &update, 1);
+            lock_release(&viewer->send_lock);
+            __atomic_fetch_add(&spectator_writes, 1, __ATOMIC_RELAXED);
+            __atomic_fetch_add(&spectator_bytes, update->length, __ATOMIC_RELAXED);
+        }
+        session_unref(viewer);
+    }
+    for (int binary = 0; binary <= 1; binary++) {
+        if (fanout.update[binary] != NULL) {
+            __atomic_fetch_add(&spectator_updates, 1, __ATOMIC_RELAXED);
+            outq_shared_unref(fanout.update[binary]);
+        }
+        fanout.update[binary] = NULL;
+        fanout.capacity[binary] = 0;
+    }
+    fanout.viewer_count = 0;
+    fanout.room = NULL;
+}
+
+// Appends the journal records made since the last flush, then writes every
+// queued reply, in order per target, with one gathering write per target,
+// then the spectator updates. Must be called with no locks
+// held except each target's own send lock, which keeps concurrent writers
+// to the same socket from interleaving.
+void outbox_flush(void) {
+    struct iovec iov[OUTQ_MAX_IOV];
+    
+    // What the replies report is logged before they go out
+    journal_flush();
+    trace_sending();
+    for (int i = 0; i < outbox.count; i++) {
+        session_t* target = outbox.entries[i].target;
+        if (target == NULL) continue;
+        
+        int count = 0;
+        for (int j = i; j < outbox.count && count < OUTQ_MAX_IOV; j++) {
+            outbox_entry_t* entry = &outbox.entries[j];
+            if (entry->target != target) continue;
+            iov[count].iov_base = outbox.data + entry->offset;
+            iov[count].iov_len = entry->length;
+            count++;
+            entry->target = NULL;
+        }
+        
+        lock_acquire(&target->send_lock, &send_lock_stats);
+        session_write(target, iov, NULL, count);
+        lock_release(&target->send_lock);
+        for (int j = 0; j < count; j++) {
+            session_unref(target);
+        }
+    }
+    outbox.count = 0;
+    outbox.used = 0;
+    
+    if (fanout.room != NULL) {
+        fanout_flush();
+    }
+}
+
+// Writes cell states as one PROTO_CELL_CHARS character each, the machine-
+// readable state carried on GRID and BOTH_GRIDS header lines
+char* grid_state_string(char* out, const unsigned char* cells, int count) {
+    for (int cell = 0; cell < count; cell++) {
+        *out++ = PROTO_CELL_CHARS[cells[cell] & 3];
+    }
+    return out;
+}
+
+// Binary clients get both boards as packed cell states and draw them
+// themselves
+void send_grid_state(game_t* game, int player_id) {
+    player_t* player = &game->players[player_id];
+    const board_config_t* config = &game->config;
+    int count = config->rows * config->cols;
+    unsigned char cells[PROTO_MAX_CELLS];
+    unsigned char payload[6 + 2 * ((PROTO_MAX_CELLS + 3) / 4)];
+    size_t length = 0;
+    
+    proto_put_u32(payload, player->board_seq);
+    length += 4;
+    payload[length++] = (unsigned char)config->rows;
+    payload[length++] = (unsigned char)config->cols;
+    board_cells(cells, &player->board, config, 1);
+    length += proto_pack_cells(payload + length, cells, count);
+    board_cells(cells, &game->players[1 - player_id].board, config, 0);
+    length += proto_pack_cells(payload + length, cells, count);
+    queue_frame(player->session, OP_GRID_STATE, payload, length);
+}
+
+// Writes "<verb> <seq> <rows> <cols> <own> <enemy>\n", the header of a
+// full text state
+size_t grid_state_header(char* out, const char* verb, game_t* game, int player_id,
+                         const unsigned char* own_cells, const unsigned char* enemy_cells) {
+    const board_config_t* config = &game->config;
+    int count = config->rows * config->cols;
+    char* end = out + sprintf(out, "%s %u %d %d ", verb, game->players[player_id].board_seq,
+                              config->rows, config->cols);
+    end = grid_state_string(end, own_cells, count);
+    *end++ = ' ';
+    end = grid_state_string(end, enemy_cells, count);
+    *end++ = '\n';
+    return end - out;
+}
+
+// Longest grid_state_header() output: verb, numbers and both cell strings
+#define GRID_HEADER_SIZE(config) (64 + 2 * (size_t)(config)->rows * (config)->cols)
+
+// Returns this thread's render buffer grown to at least needed bytes, or
+// NULL if it cannot be
+static char* render_scratch(size_t needed) {
+    if (needed > render_capacity) {
+        size_t capacity = render_capacity ? render_capacity : 8192;
+        while (capacity < needed) capacity *= 2;
+        char* buffer = realloc(render_buffer, capacity);
+        if (buffer == NULL) return NULL;
+        render_buffer = buffer;
+        render_capacity = capacity;
+    }
+    return render_buffer;
+}
+
+// A client thread of the threads model frees its outbox and render buffer
+// on exit; reactor threads keep theirs for good
+void thread_buffers_free(void) {
+    free(outbox.data);
+    free(outbox.entries);
+    free(render_buffer);
+    free(fanout.viewers);
+    memset(&outbox, 0, sizeof(outbox));
+    memset(&fanout, 0, sizeof(fanout));
+    render_buffer = NULL;
+    render_capacity = 0;
+}
+
+// The player's own grid, shown after placing their ship
+void send_colorful_grid(game_t* game, int player_id) {
+    player_t* player = &game->players[player_id];
+    const board_config_t* config = &game->config;
+    const char* title = "YOUR GRID";
+    size_t size = GRID_HEADER_SIZE(config) + render_grid_size(config->rows, config->cols, title);
+    char* buffer = render_scratch(size);
+    unsigned char cells[PROTO_MAX_CELLS], enemy[PROTO_MAX_CELLS];
+    if (buffer == NULL) return;
+    
+    board_cells(cells, &player->board, config, 1);
+    board_cells(enemy, &game->players[1 - player_id].board, config, 0);
+    size_t len = grid_state_header(buffer, "GRID", game, player_id, cells, enemy);
+    len += render_grid(buffer + len, size - len, cells, config->rows, config->cols, 1, title);
+    queue_bytes(player->session, buffer, len);
+}
+
+void send_both_grids(game_t* game, int player_id) {
+    player_t* player = &game->players[player_id];
+    if (player->session == NULL) return;
+    if (player->session->binary) {
+        send_grid_state(game, player_id);
+        return;
+    }
+    
+    const board_config_t* config = &game->config;
+    const char* enemy_name = game->players[1 - player_id].username;
+    size_t size = GRID_HEADER_SIZE(config) + render_both_grids_size(config->rows, config->cols, enemy_name);
+    char* buffer = render_scratch(size);
+    unsigned char own[PROTO_MAX_CELLS], enemy[PROTO_MAX_CELLS];
+    if (buffer == NULL) return;
+    
+    board_cells(own, &player->board, config, 1);
+    board_cells(enemy, &game->players[1 - player_id].board, config, 0);
+    size_t len = grid_state_header(buffer, "BOTH_GRIDS", game, player_id, own, enemy);
+    len += render_both_grids(buffer + len, size - len, own, enemy, config->rows, config->cols, enemy_name);
+    queue_bytes(player->session, buffer, len);
+}
+
+// Sends the one cell of a player's view that a move changed, tagged with
+// the view's new sequence number
+void send_grid_delta(game_t* game, int player_id, board_t board, int row, int col) {
+    player_t* player = &game->players[player_id];
+    session_t* target = player->session;
+    if (target == NULL) return;
+    
+    int cell = row * game->config.cols + col;
+    cell_state_t state = (board == BOARD_OWN) ? board_cell(&player->board, cell, 1)
+                                              : board_cell(&game->players[1 - player_id].board, cell, 0);
+    if (target->binary) {
+        unsigned char payload[9];
+        proto_put_u32(payload, player->board_seq);
+        payload[4] = 1;
+        payload[5] = (unsigned char)board;
+        payload[6] = (unsigned char)col;
+        payload[7] = (unsigned char)row;
+        payload[8] = (unsigned char)state;
+        queue_frame(target, OP_GRID_DELTA, payload, sizeof(payload));
+    } else {
+        char delta[64];
+        snprintf(delta, sizeof(delta), "GRID_DELTA %u %s %c%d %c\n", player->board_seq,
+            board == BOARD_OWN ? "OWN" : "ENEMY", 'A' + col, row + 1, PROTO_CELL_CHARS[state & 3]);
+        queue_message(target, delta);
+    }
+}
+
+// Fires at the defender's board and moves both players' views on a
+// version. Returns -1 for an illegal attack, otherwise an attack_result_t.
+int process_attack(game_t* game, int attacker_id, int row, int col, int* sunk_length) {
+    player_t* attacker = &game->players[attacker_id];
+    player_t* defender = &game->players[1 - attacker_id];
+    
+    int result = board_attack(&defender->board, &game->config, row, col, sunk_length);
+    if (result != -1) {
+        attacker->board_seq++;
+        defender->board_seq++;
+    }
+    return result;
+}
+
+// Takes a reference to each of the room's spectators: the audience of
+// every update the current command produces. Commands only ever update
+// one room.
+static int fanout_begin(room_t* room) {
+    if (fanout.room == room) return 1;
+    if (fanout.room != NULL) return 0;
+    
+    int count = room->spectator_count[0] + room->spectator_count[1];
+    if (count > fanout.viewer_capacity) {
+        int capacity = fanout.viewer_capacity ? fanout.viewer_capacity : 64;
+        while (capacity < count) capacity *= 2;
+        session_t** viewers = realloc(fanout.viewers, capacity * sizeof(session_t*));
+        if (viewers == NULL) return 0;
+        fanout.viewers = viewers;
+        fanout.viewer_capacity = capacity;
+    }
+    fanout.viewer_count = 0;
+    for (session_t* viewer = room->spectators; viewer != NULL; viewer = viewer->next_spectator) {
+        session_ref(viewer);
+        fanout.viewers[fanout.viewer_count++] = viewer;
+    }
+    fanout.room = room;
+    return 1;
+}
+
+// Appends to the update for spectators on one protocol. Until it is
+// flushed this thread holds the only reference, so it may still grow.
+static void fanout_append(int binary, const void* data, size_t length) {
+    outq_shared_t* update = fanout.update[binary];
+    size_t used = update != NULL ? update->length : 0;
+    if (used + length > fanout.capacity[binary]) {
+        size_t capacity = fanout.capacity[binary] ? fanout.capacity[binary] : 4096;
+        while (capacity < used + length) capacity *= 2;
+        outq_shared_t* grown = realloc(update, sizeof(outq_shared_t) + capacity);
+        if (grown == NULL) return;
+        if (update == NULL) {
+            grown->refcount = 1;
+            grown->length = 0;
+        }
+        fanout.update[binary] = update = grown;
+        fanout.capacity[binary] = capacity;
+    }
+    memcpy(update->data + used, data, length);
+    update->length += length;
+}
+
+// Caller holds the room lock. Queues an update for the room's spectators:
+// the text for those on the text protocol, the frame for the others.
+void spectators_queue(room_t* room, const char* text, size_t text_length,
+                      const unsigned char* frame, size_t frame_length) {
+    if (room->spectators == NULL || !fanout_begin(room)) return;
+    if (room->spectator_count[0] > 0) fanout_append(0, text, text_length);
+    if (room->spectator_count[1] > 0) fanout_append(1, frame, frame_length);
+}
+
+// A spectator's view of the room: each board as the other player sees it,
+// ships hidden until hit. For text clients, a state line
+// "SPECTATE <room> <view> <rows> <cols> <seat 0 cells> <seat 1 cells>"
+// and both grids drawn, in this thread's render buffer; returns its
+// length, or 0 if there is no memory for it.
+static size_t spectate_text(room_t* room, char** out) {
+    game_t* game = &room->game;
+    const board_config_t* config = &game->config;
+    int count = config->rows * config->cols;
+    char titles[2][MAX_USERNAME + 16];
+    size_t size = 64 + 2 * (size_t)count;
+    for (int p = 0; p < 2; p++) {
+        snprintf(titles[p], sizeof(titles[p]), "%s's fleet", game->players[p].username);
+        size += render_grid_size(config->rows, config->cols, titles[p]);
+    }
+    char* buffer = render_scratch(size);
+    if (buffer == NULL) return 0;
+    
+    unsigned char cells[2][PROTO_MAX_CELLS];
+    board_cells(cells[0], &game->players[0].board, config, 0);
+    board_cells(cells[1], &game->players[1].board, config, 0);
+    char* end = buffer + sprintf(buffer, "SPECTATE %d %u %d %d ", room->room_id, room->spectate_seq,
+                                 config->rows, config->cols);
+    end = grid_state_string(end, cells[0], count);
+    *end++ = ' ';
+    end = grid_state_string(end, cells[1], count);
+    *end++ = '\n';
+    size_t len = end - buffer;
+    for (int p = 0; p < 2; p++) {
+        len += render_grid(buffer + len, size - len, cells[p], config->rows, config->cols, 0, titles[p]);
+    }
+    *out = buffer;
+    return len;
+}
+
+// The same view as a binary frame; returns its length
+static size_t spectate_frame(room_t* room, unsigned char* frame) {
+    game_t* game = &room->game;
+    const board_config_t* config = &game->config;
+    int count = config->rows * config->cols;
+    unsigned char cells[PROTO_MAX_CELLS];
+    unsigned char payload[6 + 2 * ((PROTO_MAX_CELLS + 3) / 4)];
+    size_t length = 0;
+    
+    proto_put_u32(payload, room->spectate_seq);
+    length += 4;
+    payload[length++] = (unsigned char)config->rows;
+    payload[length++] = (unsigned char)config->cols;
+    for (int p = 0; p < 2; p++) {
+        board_cells(cells, &game->players[p].board, config, 0);
+        length += proto_pack_cells(payload + length, cells, count);
+    }
+    return proto_encode_frame(frame, OP_SPECTATE, payload, length);
+}
+
+// Caller holds the room lock. Sends every spectator the next view, after
+// a move changed one.
+void spectators_send_view(room_t* room) {
+    if (room->spectators == NULL) return;
+    room->spectate_seq++;
+    if (!fanout_begin(room)) return;
+    
+    if (room->spectator_count[0] > 0) {
+        char* text;
+        size_t len = spectate_text(room, &text);
+        if (len > 0) fanout_append(0, text, len);
+    }
+    if (room->spectator_count[1] > 0) {
+        unsigned char frame[PROTO_MAX_PAYLOAD + 3];
+        fanout_append(1, frame, spectate_frame(room, frame));
+    }
+}
+
+// Sends an update to both players and every spectator, in the form each
+// negotiated: text is the text-protocol line, opcode and payload the
+// frame. Each form is built once, however many are watching.
+void broadcast(room_t* room, const char* text, int opcode, const unsigned char* payload, size_t length) {
+    unsigned char frame[PROTO_MAX_PAYLOAD + 3];
+    size_t frame_length = proto_encode_frame(frame, opcode, payload, length);
+    size_t text_length = strlen(text);
+    
+    for (int i = 0; i < 2; i++) {
+        session_t* target = room->game.players[i].session;
+        if (target == NULL) continue;
+        if (target->binary) {
+            queue_bytes(target, (const char*)frame, frame_length);
+        } else {
+            queue_bytes(target, text, text_length);
+        }
+    }
+    spectators_queue(room, text, text_length, frame, frame_length);
+}
+
+// Every reply below goes out in the form the target negotiated: a binary
+// frame, or the text verb plus its decorated message.
+
+// Replies that carry no data
+void send_simple(session_t* target, int opcode, const char* text) {
+    if (target == NULL) return;
+    if (target->binary) {
+        queue_frame(target, opcode, NULL, 0);
+    } else {
+        queue_message(target, text);
+    }
+}
+
+void send_error(session_t* target, proto_error_t code) {
+    if (target->binary) {
+        unsigned char payload[1] = { (unsigned char)code };
+        queue_frame(target, OP_ERROR, payload, 1);
+    } else {
+        char error_msg[128];
+        snprintf(error_msg, sizeof(error_msg), "ERROR %s\n", proto_error_text(code));
+        queue_message(target, error_msg);
+    }
+}
+
+void send_username_set(session_t* target) {
+    if (target->binary) {
+        queue_frame(target, OP_USERNAME_SET, NULL, 0);
+        return;
+    }
+    char user_confirm[256];
+    snprintf(user_confirm, sizeof(user_confirm), 
+        "USERNAME_SET %s%s⭐ Welcome, %s! ⭐%s\n", 
+        BOLD, CYAN, target->username, RESET);
+    queue_message(target, user_confirm);
+}
+
+void send_wait_player(session_t* target) {
+    if (target->binary) {
+        queue_frame(target, OP_WAIT_PLAYER, NULL, 0);
+        return;
+    }
+    char waiting_msg[256];
+    snprintf(waiting_msg, sizeof(waiting_msg),
+        "WAIT_PLAYER %s%sWaiting for another player to join... (or type BOT to play the computer)%s\n",
+        BOLD, YELLOW, RESET);
+    queue_message(target, waiting_msg);
+}
+
+// The token that takes the player's seat back if the connection drops,
+// and for how long it will be held
+void send_resume_token(session_t* target) {
+    if (target->binary) {
+        unsigned char payload[PROTO_TOKEN_BYTES + 2];
+        memcpy(payload, target->token, PROTO_TOKEN_BYTES);
+        proto_put_u16(payload + PROTO_TOKEN_BYTES, (unsigned int)resume_grace);
+        queue_frame(target, OP_RESUME_TOKEN, payload, sizeof(payload));
+        return;
+    }
+    char hex[2 * PROTO_TOKEN_BYTES + 1];
+    char token_msg[64];
+    proto_format_token(hex, target->token);
+    snprintf(token_msg, sizeof(token_msg), "RESUME_TOKEN %s %d\n", hex, resume_grace);
+    queue_message(target, token_msg);
+}
+
+// Tells a player that their opponent's connection dropped and how long
+// the seat waits for them
+void send_opponent_away(session_t* target, const char* opponent) {
+    if (target == NULL) return;
+    if (target->binary) {
+        unsigned char payload[2];
+        proto_put_u16(payload, (unsigned int)resume_grace);
+        queue_frame(target, OP_OPPONENT_AWAY, payload, 2);
+        return;
+    }
+    char away_msg[256];
+    snprintf(away_msg, sizeof(away_msg),
+        "OPPONENT_AWAY %d %s%s📡 %s lost their connection; their seat is held for %d seconds%s\n",
+        resume_grace, BOLD, YELLOW, opponent, resume_grace, RESET);
+    queue_message(target, away_msg);
+}
+
+// Says what ran out of time: "TIMEOUT <reason> <seat> <message>", seat
+// being -1 for the connection's own handshake or idle time and for a
+// placing neither player finished. Goes to target, or with target NULL
+// to the players and spectators of room.
+void send_timeout(room_t* room, session_t* target, proto_timeout_t reason, int seat, int missed,
+                  const char* message) {
+    char text[256];
+    unsigned char payload[4] = { (unsigned char)reason, seat < 0 ? 255 : (unsigned char)seat,
+                                 (unsigned char)missed, MISSED_TURNS_MAX };
+    snprintf(text, sizeof(text), "TIMEOUT %s %d %s%s⏰ %s ⏰%s\n", proto_timeout_name(reason), seat,
+        BOLD, YELLOW, message, RESET);
+    if (target == NULL) {
+        broadcast(room, text, OP_TIMEOUT, payload, 4);
+    } else if (target->binary) {
+        queue_frame(target, OP_TIMEOUT, payload, 4);
+    } else {
+        queue_message(target, text);
+    }
+}
+
+// Describes the fleet for the GAME_START text: "ONE 2-space ship" or
+// "3 ships (4, 3, 2 spaces)"
+void describe_fleet(char* out, size_t size, const board_config_t* config) {
+    if (config->ship_count == 1) {
+        snprintf(out, size, "ONE %d-space ship", config->ship_lengths[0]);
+        return;
+    }
+    size_t used = snprintf(out, size, "%d ships (", config->ship_count);
+    for (int i = 0; i < config->ship_count && used < size; i++) {
+        used += snprintf(out + used, size - used, "%s%d", i > 0 ? ", " : "", config->ship_lengths[i]);
+    }
+    if (used < size) snprintf(out + used, size - used, " spaces)");
+}
+
+// Board size and fleet, sent right after GAME_START
+void send_game_config(game_t* game, session_t* target) {
+    const board_config_t* config = &game->config;
+    if (target->binary) {
+        unsigned char payload[3 + PROTO_MAX_FLEET];
+        payload[0] = (unsigned char)config->rows;
+        payload[1] = (unsigned char)config->cols;
+        payload[2] = (unsigned char)config->ship_count;
+        for (int i = 0; i < config->ship_count; i++) {
+            payload[3 + i] = (unsigned char)config->ship_lengths[i];
+        }
+        queue_frame(target, OP_GAME_CONFIG, payload, 3 + config->ship_count);
+        return;
+    }
+    
+    char config_msg[128];
+    int len = snprintf(config_msg, sizeof(config_msg), "GAME_CONFIG %d %d", config->rows, config->cols);
+    for (int i = 0; i < config->ship_count; i++) {
+        len += snprintf(config_msg + len, sizeof(config_msg) - len, " %d", config->ship_lengths[i]);
+    }
+    snprintf(config_msg + len, sizeof(config_msg) - len, "\n");
+    queue_message(target, config_msg);
+}
+
+void announce_game_start(room_t* room) {
+    game_t* game = &room->game;
+    char start_msg[512] = "";
+    
+    for (int i = 0; i < 2; i++) {
+        session_t* target = game->players[i].session;
+        if (target == NULL) continue;
+        
+        if (target->binary) {
+            // Seat, then the opponent's name
+            unsigned char payload[1 + MAX_USERNAME];
+            const char* opponent = game->players[1 - i].username;
+            size_t len = strlen(opponent);
+            payload[0] = (unsigned char)i;
+            memcpy(payload + 1, opponent, len);
+            queue_frame(target, OP_GAME_START, payload, 1 + len);
+        } else {
+            if (start_msg[0] == '\0') {
+                char fleet[128];
+                describe_fleet(fleet, sizeof(fleet), &game->config);
+                snprintf(start_msg, sizeof(start_msg),
+                    "GAME_START %s%s🚢 Game Starting! 🚢%s\n"
+                    "%s vs %s\n"
+                    "Each player places %s on a %dx%d grid.\n"
+                    "Use: PLACE <pos> <H|V> (e.g., PLACE A1 H)\n",
+                    BOLD, MAGENTA, RESET,
+                    game->players[0].username, game->players[1].username,
+                    fleet, game->config.rows, game->config.cols);
+            }
+            queue_message(target, start_msg);
+            
+            // "SEAT <seat> <opponent>", the name last as it may hold spaces
+            char seat_msg[32 + MAX_USERNAME];
+            snprintf(seat_msg, sizeof(seat_msg), "SEAT %d %s\n", i, game->players[1 - i].username);
+            queue_message(target, seat_msg);
+        }
+        send_game_config(game, target);
+    }
+    logger_event(LOG_GAME_START, room->room_id, game->players[0].username,
+        game->players[1].username, NULL);
+}
+
+void send_ship_placed(game_t* game, int player_id) {
+    session_t* target = game->players[player_id].session;
+    const board_state_t* board = &game->players[player_id].board;
+    int remaining = game->config.ship_count - board->ships_placed;
+    if (target->binary) {
+        unsigned char payload[1] = { (unsigned char)remaining };
+        queue_frame(target, OP_SHIP_PLACED, payload, 1);
+        send_grid_state(game, player_id);
+        return;
+    }
+    
+    char success_msg[256];
+    if (remaining == 0) {
+        snprintf(success_msg, sizeof(success_msg),
+            "SHIP_PLACED %s%s✅ Ship placed successfully!%s\n",
+            BOLD, GREEN, RESET);
+    } else {
+        snprintf(success_msg, sizeof(success_msg),
+            "SHIP_PLACED %s%s✅ Ship placed! Next: %d-space ship (%d left)%s\n",
+            BOLD, GREEN, game->config.ship_lengths[board->ships_placed], remaining, RESET);
+    }
+    queue_message(target, success_msg);
+    send_colorful_grid(game, player_id);
+}
+
+// Tells the player to move that it is their turn and the other to wait
+void send_turn(game_t* game, const char* your_turn_text) {
+    send_simple(game->players[game->current_player].session, OP_YOUR_TURN, your_turn_text);
+    send_simple(game->players[1 - game->current_player].session, OP_WAIT_TURN,
+        "WAIT_TURN Wait for your opponent's move...\n");
+}
+
+void send_battle_start(room_t* room) {
+    game_t* game = &room->game;
+    char battle_msg[512];
+    unsigned char payload[1] = { (unsigned char)game->current_player };
+    
+    snprintf(battle_msg, sizeof(battle_msg),
+        "BATTLE_START %s%s⚔️ BATTLE BEGINS! ⚔️%s\n"
+        "%s goes first!\n",
+        BOLD, RED, RESET, game->players[game->current_player].username);
+    broadcast(room, battle_msg, OP_BATTLE_START, payload, 1);
+    send_turn(game, "YOUR_TURN It's your turn! Use ATTACK <pos>\n");
+}
+
+// The one snapshot a player taking their seat back gets in place of the
+// game's history: where the game stands, the board setup, both grids as
+// they are now and whose move it is
+void send_resumed(room_t* room, int seat) {
+    game_t* game = &room->game;
+    player_t* player = &game->players[seat];
+    session_t* target = player->session;
+    const char* opponent = game->players[1 - seat].username;
+    int playing = (game->state == PLAYING);
+    int remaining = game->config.ship_count - player->board.ships_placed;
+    
+    if (target->binary) {
+        unsigned char payload[4 + MAX_USERNAME];
+        size_t len = strlen(opponent);
+        payload[0] = (unsigned char)seat;
+        payload[1] = (unsigned char)playing;
+        payload[2] = (unsigned char)game->current_player;
+        payload[3] = (unsigned char)remaining;
+        memcpy(payload + 4, opponent, len);
+        queue_frame(target, OP_RESUMED, payload, 4 + len);
+    } else {
+        // "<seat> <PLACING|PLAYING> <seat to move> <ships to place> <opponent>"
+        char resumed_msg[128];
+        snprintf(resumed_msg, sizeof(resumed_msg), "RESUMED %d %s %d %d %s\n", seat,
+            playing ? "PLAYING" : "PLACING", game->current_player, remaining, opponent);
+        queue_message(target, resumed_msg);
+    }
+    send_game_config(game, target);
+    send_both_grids(game, seat);
+    
+    if (playing && game->current_player == seat) {
+        send_simple(target, OP_YOUR_TURN, "YOUR_TURN It's your turn! Use ATTACK <pos>\n");
+    } else if (playing) {
+        send_simple(target, OP_WAIT_TURN, "WAIT_TURN Wait for your opponent's move...\n");
+    }
+}
+
+// Reports an attack that process_attack() accepted, sends each player the
+// cell that changed in their view and says who moves next; spectators get
+// the report and a new view. The game state and turn must already reflect
+// the result; GAME_OVER means this attack sank the last ship.
+void send_attack_result(room_t* room, int attacker_id, int row, int col, int result, int sunk_length) {
+    game_t* game = &room->game;
+    session_t* attacker = game->players[attacker_id].session;
+    session_t* defender = game->players[1 - attacker_id].session;
+    const char* name = game->players[attacker_id].username;
+    int won = (game->state == GAME_OVER);
+    char text[512];
+    char pos[16];
+    snprintf(pos, sizeof(pos), "%c%d", 'A' + col, row + 1);
+    
+    // The attacker's own result, and the defender's if the game is over
+    if (attacker != NULL && attacker->binary) {
+        unsigned char payload[3] = { (unsigned char)col, (unsigned char)row, (unsigned char)sunk_length };
+        if (won) {
+            queue_frame(attacker, OP_WIN, NULL, 0);
+        } else if (result == ATTACK_SUNK) {
+            queue_frame(attacker, OP_SUNK, payload, 3);
+        } else {
+            queue_frame(attacker, result == ATTACK_HIT ? OP_HIT : OP_MISS, payload, 2);
+        }
+    } else if (attacker != NULL) {
+        if (won) {
+            snprintf(text, sizeof(text), "WIN %s%s🎉 VICTORY! You sunk their ship! 🎉%s\n",
+                BOLD, GREEN, RESET);
+        } else if (result == ATTACK_SUNK) {
+            snprintf(text, sizeof(text), "SUNK %s%s🚢 SUNK their %d-space ship at %s! 🚢%s\n",
+                BOLD, RED, sunk_length, pos, RESET);
+        } else if (result == ATTACK_HIT) {
+            snprintf(text, sizeof(text), "HIT %s%s🎯 HIT at %s! 🎯%s\n", BOLD, RED, pos, RESET);
+        } else {
+            snprintf(text, sizeof(text), "MISS %s%s💧 MISS at %s 💧%s\n", BOLD, BLUE, pos, RESET);
+        }
+        queue_message(attacker, text);
+    }
+    if (won && defender != NULL) {
+        snprintf(text, sizeof(text), "LOSE %s%s💀 DEFEAT! Your ship was sunk! 💀%s\n",
+            BOLD, RED, RESET);
+        send_simple(defender, OP_LOSE, text);
+    }
+    
+    // What both players and the spectators see
+    if (won) {
+        unsigned char payload[1] = { (unsigned char)attacker_id };
+        snprintf(text, sizeof(text), "GAME_OVER %s%s🏆 Game Over! %s wins! 🏆%s\n",
+            BOLD, YELLOW, name, RESET);
+        broadcast(room, text, OP_GAME_OVER, payload, 1);
+    } else {
+        unsigned char payload[4] = { (unsigned char)attacker_id, (unsigned char)col,
+                                     (unsigned char)row, (unsigned char)result };
+        snprintf(text, sizeof(text), "ATTACK_RESULT %s attacked %s - %s\n", name, pos,
+            result == ATTACK_SUNK ? "Ship sunk! 🚢" : result == ATTACK_HIT ? "HIT! 💥" : "Miss 💧");
+        broadcast(room, text, OP_ATTACK_RESULT, payload, 4);
+    }
+    spectators_send_view(room);
+    
+    // One cell changed in each player's view
+    send_grid_delta(game, attacker_id, BOARD_ENEMY, row, col);
+    send_grid_delta(game, 1 - attacker_id, BOARD_OWN, row, col);
+    
+    if (game->state == PLAYING) {
+        if (result == ATTACK_MISS) { // Only switch turn message on miss
+            send_turn(game, "YOUR_TURN Your turn! Use ATTACK <pos>\n");
+        } else { // Hit - same player continues
+            send_simple(attacker, OP_CONTINUE, "CONTINUE You hit! Go again! Use ATTACK <pos>\n");
+        }
+    }
+}
+
+// The current view, for one spectator that has just arrived or asked again
+void send_spectate_view(room_t* room, session_t* target) {
+    if (target->binary) {
+        unsigned char frame[PROTO_MAX_PAYLOAD + 3];
+        queue_bytes(target, (const char*)frame, spectate_frame(room, frame));
+        return;
+    }
+    char* text;
+    size_t len = spectate_text(room, &text);
+    if (len > 0) queue_bytes(target, text, len);
+}
+
+// Caller holds the room lock. Adds the session to the room's spectators.
+void spectator_link(room_t* room, session_t* session) {
+    // Large views go out without a copy where the model can collect the
+    // kernel's completions
+    if (io_model != MODEL_URING) {
+        outq_enable_zerocopy(&session->output, session->socket);
+    }
+    session->prev_spectator = NULL;
+    session->next_spectator = room->spectators;
+    if (room->spectators != NULL) room->spectators->prev_spectator = session;
+    room->spectators = session;
+    room->spectator_count[session->binary]++;
+    session->phase = SESSION_WATCHING;
+    __atomic_store_n(&session->watching, room, __ATOMIC_RELEASE);
+}
+
+// Caller holds the room lock. Adds the session to the room's spectators
+// and sends it the game as it stands.
+void spectator_attach(room_t* room, session_t* session) {
+    game_t* game = &room->game;
+    
+    spectator_link(room, session);
+    if (session->binary) {
+        unsigned char payload[5 + 2 * MAX_USERNAME];
+        size_t first = strlen(game->players[0].username);
+        size_t second = strlen(game->players[1].username);
+        proto_put_u32(payload, (unsigned int)room->room_id);
+        payload[4] = (unsigned char)first;
+        memcpy(payload + 5, game->players[0].username, first);
+        memcpy(payload + 5 + first, game->players[1].username, second);
+        queue_frame(session, OP_WATCHING, payload, 5 + first + second);
+    } else {
+        char watching_msg[256];
+        snprintf(watching_msg, sizeof(watching_msg), "WATCHING %d %s%s👀 Watching %s vs %s%s\n",
+            room->room_id, BOLD, CYAN, game->players[0].username, game->players[1].username, RESET);
+        queue_message(session, watching_msg);
+    }
+    send_game_config(game, session);
+    send_spectate_view(room, session);
+}
+
+// Caller holds the room lock
+void spectator_detach(room_t* room, session_t* session) {
+    if (session->prev_spectator != NULL) {
+        session->prev_spectator->next_spectator = session->next_spectator;
+    } else {
+        room->spectators = session->next_spectator;
+    }
+    if (session->next_spectator != NULL) {
+        session->next_spectator->prev_spectator = session->prev_spectator;
+    }
+    session->prev_spectator = NULL;
+    session->next_spectator = NULL;
+    room->spectator_count[session->binary]--;
+    session->phase = SESSION_HANDSHAKE;
+    session->handshake_at = now_ns();
+    __atomic_store_n(&session->watching, NULL, __ATOMIC_RELEASE);
+}
+
+// Caller holds the lock of the room, which is closing. Its spectators are
+// told and let go: they may watch another game, or pick a username to play.
+void spectators_end(room_t* room) {
+    if (room->spectators == NULL) return;
+    
+    char end_msg[128];
+    unsigned char frame[3];
+    snprintf(end_msg, sizeof(end_msg), "WATCH_END %s%s🏁 The game has ended%s\n", BOLD, YELLOW, RESET);
+    size_t frame_length = proto_encode_frame(frame, OP_WATCH_END, NULL, 0);
+    spectators_queue(room, end_msg, strlen(end_msg), frame, frame_length);
+    while (room->spectators != NULL) {
+        spectator_detach(room, room->spectators);
+    }
+}
+
+// Locks the room the session is watching, as room_acquire() does for
+// players
+room_t* room_acquire_watched(session_t* session) {
+    room_t* room = __atomic_load_n(&session->watching, __ATOMIC_ACQUIRE);
+    if (room == NULL) return NULL;
+    
+    lock_acquire(&room->lock, &room_lock_stats);
+    if (room->in_use && session->watching == room) {
+        return room;
+    }
+    lock_release(&room->lock);
+    return NULL;
+}
+
+// WATCH: a connection that has not chosen a username becomes a spectator
+// of the game in the room named, or else of the game started last. In
+// shards mode it is first handed over to the shard serving that game.
+// Returns as handle_command().
+int session_watch(session_t* session, const proto_command_t* cmd) {
+    if (session->has_username) {
+        send_error(session, ERR_CANNOT_WATCH);
+        outbox_flush();
+        return 0;
+    }
+    
+    lock_acquire(&registry_mutex, &registry_lock_stats);
+    room_t* room = NULL;
+    if (cmd->valid) {
+        room = room_lookup((int)cmd->room_id);
+    } else if (cmd->arg.length == 0) {
+        room = room_lookup(room_table.latest);
+    }
+#ifdef __linux__
+    if (room != NULL && io_model == MODEL_SHARDS && room->shard != session->shard) {
+        session->mail_room = room;
+        session->mail_room_generation = room->generation;
+        lock_release(&registry_mutex);
+        shard_hand_over(session, room->shard, NULL);
+        return 1;
+    }
+#endif
+    if (room != NULL) {
+        lock_acquire(&room->lock, &room_lock_stats);
+    }
+    lock_release(&registry_mutex);
+    
+    if (room != NULL) {
+        spectator_attach(room, session);
+        lock_release(&room->lock);
+    } else {
+        send_error(session, ERR_NO_SUCH_GAME);
+    }
+    outbox_flush();
+    return 0;
+}
+
+// Caller holds the room lock. When the room next needs looking at: a held
+// seat running out, or else a bot's move or the move (or placing) being
+// due. The clock stands still while a seat is held. 0 if nothing is timed.
+static unsigned long room_deadline(const room_t* room) {
+    unsigned long deadline = 0;
+    for (int p = 0; p < 2; p++) {
+        const player_t* player = &room->game.players[p];
+        if (player->held && (deadline == 0 || player->held_until < deadline)) deadline = player->held_until;
+    }
+    if (deadline != 0) return deadline;
+    if (room->bot_due != 0 && (room->turn_deadline == 0 || room->bot_due < room->turn_deadline)) {
+        return room->bot_due;
+    }
+    return room->turn_deadline;
+}
+
+// Caller holds the room lock. Makes sure the room's timer goes off by its
+// deadline. A timer already set for earlier is left alone and looks again
+// when it goes off, so most moves do not touch the wheel.
+static void room_schedule(room_t* room) {
+    unsigned long deadline = room_deadline(room);
+    if (deadline == 0 || (room->timer_due != 0 && room->timer_due <= deadline)) return;
+    room->timer_due = deadline;
+    timer_schedule(room->shard, &room->timer, deadline);
+}
+
+// Caller holds the room lock. Starts the clock on the next move: the
+// player to move has turn_timeout for it, and while placing both have
+// that long per ship. A bot to move fires once it has thought for
+// bot_think.
+static void room_start_clock(room_t* room) {
+    game_t* game = &room->game;
+    unsigned long now = now_ns();
+    room->bot_due = 0;
+    if (game->state == PLAYING && game->players[game->current_player].bot) {
+        room->bot_due = now + (unsigned long)bot_think * 1000000UL;
+    }
+    if (turn_timeout > 0) {
+        unsigned long span = (unsigned long)turn_timeout * 1000000000UL;
+        if (game->state == PLACING_SHIPS) span *= (unsigned long)game->config.ship_count;
+        room->turn_deadline = now + span;
+    }
+    room_schedule(room);
+}
+
+// Caller holds the room lock. Keeps the seat of a player whose connection
+// dropped during the game for resume_grace seconds, for a connection with
+// their token to take back, and tells the opponent. Returns 0 if it is
+// not held: the player quit, had no token, or the game has not started,
+// is over or has no one else left.
+static int seat_hold(room_t* room, session_t* session) {
+    game_t* game = &room->game;
+    int seat = session->seat;
+    if (resume_grace == 0 || !session->has_token || session->quitting || game->players_connected != 2 ||
+        (game->state != PLACING_SHIPS && game->state != PLAYING)) {
+        return 0;
+    }
+    
+    player_t* player = &game->players[seat];
+    lock_acquire(&held_mutex, &held_lock_stats);
+    int stored = held_insert(player->token, room);
+    lock_release(&held_mutex);
+    if (!stored) return 0;
+    
+    player->held = 1;
+    player->held_until = now_ns() + (unsigned long)resume_grace * 1000000000UL;
+    room_schedule(room);
+    send_opponent_away(game->players[1 - seat].session, player->username);
+    logger_event(LOG_SEAT_HELD, room->room_id, player->username, NULL, NULL);
+    return 1;
+}
+
+// Caller holds the room lock. Ends the game in favour of the opponent of
+// seat, which did not come back or did not move in time (why, as the
+// winner is told it); the room is closed for the caller to free.
+void seat_forfeit(room_t* room, int seat, const char* why) {
+    game_t* game = &room->game;
+    int winner = 1 - seat;
+    const char* name = game->players[winner].username;
+    char text[256];
+    unsigned char payload[1] = { (unsigned char)winner };
+    
+    game->state = GAME_OVER;
+    room_journal(room, JOURNAL_FORFEIT, seat);
+    snprintf(text, sizeof(text), "WIN %s%s🎉 VICTORY! %s 🎉%s\n", BOLD, GREEN, why, RESET);
+    send_simple(game->players[winner].session, OP_WIN, text);
+    snprintf(text, sizeof(text), "LOSE %s%s💀 DEFEAT! You ran out of time 💀%s\n", BOLD, RED, RESET);
+    send_simple(game->players[seat].session, OP_LOSE, text);
+    snprintf(text, sizeof(text), "GAME_OVER %s%s🏆 Game Over! %s wins! 🏆%s\n", BOLD, YELLOW, name, RESET);
+    broadcast(room, text, OP_GAME_OVER, payload, 1);
+    logger_event(LOG_GAME_WON, room->room_id, name, NULL, NULL);
+    room_close(room);
+}
+
+// Caller holds the room lock. The move (or placing) was not made in time.
+// Whoever has not placed their fleet forfeits, and if neither has, the
+// game is called off. A turn passes to the opponent, and the last of
+// MISSED_TURNS_MAX in a row let run out forfeits. Returns 1 if the game
+// is over, the room then being closed for the caller to free.
+static int room_clock_ran_out(room_t* room) {
+    game_t* game = &room->game;
+    char message[128];
+    room->turn_deadline = 0;
+    
+    if (game->state == PLACING_SHIPS) {
+        int late[2];
+        for (int p = 0; p < 2; p++) {
+            late[p] = !board_fleet_placed(&game->players[p].board, &game->config);
+            if (!late[p]) continue;
+            journal_record_t* record = room_journal(room, JOURNAL_TIMEOUT, p);
+            if (record != NULL) {
+                record->data.timeout.reason = TIMEOUT_PLACING;
+                record->data.timeout.missed = 1;
+            }
+            logger_event(LOG_TURN_TIMEOUT, room->room_id, game->players[p].username, NULL, "placing");
+        }
+        __atomic_fetch_add(&timeouts[TIMEOUT_PLACING], 1, __ATOMIC_RELAXED);
+        if (late[0] && late[1]) {
+            send_timeout(room, NULL, TIMEOUT_PLACING, -1, 1, "Neither fleet was placed in time; the game is off");
+            room_journal(room, JOURNAL_LEAVE, 0);
+            room_journal(room, JOURNAL_LEAVE, 1);
+            game->state = GAME_OVER;
+            room_close(room);
+            return 1;
+        }
+        int seat = late[0] ? 0 : 1;
+        snprintf(message, sizeof(message), "%s did not place their fleet in time", game->players[seat].username);
+        send_timeout(room, NULL, TIMEOUT_PLACING, seat, 1, message);
+        __atomic_fetch_add(&timeout_forfeits, 1, __ATOMIC_RELAXED);
+        seat_forfeit(room, seat, "Your opponent did not place their fleet in time");
+        return 1;
+    }
+    
+    int seat = game->current_player;
+    int missed = ++room->missed[seat];
+    journal_record_t* record = room_journal(room, JOURNAL_TIMEOUT, seat);
+    if (record != NULL) {
+        record->data.timeout.reason = TIMEOUT_TURN;
+        record->data.timeout.missed = (uint8_t)missed;
+    }
+    __atomic_fetch_add(&timeouts[TIMEOUT_TURN], 1, __ATOMIC_RELAXED);
+    logger_event(LOG_TURN_TIMEOUT, room->room_id, game->players[seat].username, NULL, "turn");
+    snprintf(message, sizeof(message), "%s ran out of time (%d of %d in a row)",
+        game->players[seat].username, missed, MISSED_TURNS_MAX);
+    send_timeout(room, NULL, TIMEOUT_TURN, seat, missed, message);
+    if (missed >= MISSED_TURNS_MAX) {
+        __atomic_fetch_add(&timeout_forfeits, 1, __ATOMIC_RELAXED);
+        seat_forfeit(room, seat, "Your opponent ran out of time");
+        return 1;
+    }
+    
+    game->current_player = 1 - seat;
+    room_journal(room, JOURNAL_TURN, game->current_player);
+    send_turn(game, "YOUR_TURN Your opponent ran out of time; your turn! Use ATTACK <pos>\n");
+    room_start_clock(room);
+    return 0;
+}
+
+// Caller holds the room lock. The player to move fires at (row, col), and
+// the game goes on: the turn passes on a miss, the shot is logged and
+// reported, and the clock starts on the next move. Returns -1 if the shot
+// is not allowed, changing nothing, 1 if it won the game, the room then
+// being closed for the caller to free, 0 otherwise.
+static int room_attack(room_t* room, int player_id, int row, int col) {
+    game_t* game = &room->game;
+    int sunk_length = 0;
+    int result = process_attack(game, player_id, row, col, &sunk_length);
+    if (result == -1) return -1;
+    
+    journal_record_t* record = room_journal(room, JOURNAL_ATTACK, player_id);
+    if (record != NULL) {
+        record->data.attack.row = (uint8_t)row;
+        record->data.attack.col = (uint8_t)col;
+        record->data.attack.result = (uint8_t)result;
+        record->data.attack.sunk_length = (uint8_t)sunk_length;
+    }
+    if (result == ATTACK_SUNK && board_defeated(&game->players[1 - player_id].board, &game->config)) {
+        game->state = GAME_OVER;
+        room_journal(room, JOURNAL_GAME_OVER, player_id);
+    } else if (result == ATTACK_MISS) {
+        // Switch turns on miss; the same player continues after a hit
+        game->current_player = 1 - game->current_player;
+        room_journal(room, JOURNAL_TURN, game->current_player);
+    }
+    send_attack_result(room, player_id, row, col, result, sunk_length);
+    room->missed[player_id] = 0;
+    
+    if (game->state == PLAYING) {
+        room_start_clock(room);
+        return 0;
+    }
+    // Finished games free their room straight away
+    logger_event(LOG_GAME_WON, room->room_id, game->players[player_id].username, NULL, NULL);
+    room_close(room);
+    return 1;
+}
+
+// Caller holds the room lock. The bot to move fires where its level
+// picks. Returns as room_attack().
+static int bot_move(room_t* room) {
+    game_t* game = &room->game;
+    int seat = game->current_player;
+    room->bot_due = 0;
+    
+    unsigned long start = now_ns();
+    int cell = ai_choose_attack(&game->players[1 - seat].board, &game->config,
+                                game->players[seat].bot_level, &room->bot_rng);
+    __atomic_fetch_add(&bot_move_ns, now_ns() - start, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&bot_moves, 1, __ATOMIC_RELAXED);
+    if (cell < 0) return 0;
+    return room_attack(room, seat, cell / game->config.cols, cell % game->config.cols);
+}
+
+// The room's timer went off. Forfeits a held seat whose time is up, makes
+// a bot's move once it is due, or runs the clock out if the move is
+// really due; otherwise sets the timer again for whatever is next.
+void room_on_timer(room_t* room) {
+    lock_acquire(&room->lock, &room_lock_stats);
+    int finished = 0;
+    if (room->in_use) {
+        game_t* game = &room->game;
+        unsigned long now = now_ns();
+        int held = 0;
+        room->timer_due = 0;
+        for (int p = 0; p < 2 && !finished; p++) {
+            if (!game->players[p].held) continue;
+            held = 1;
+            if (now >= game->players[p].held_until) {
+                seat_forfeit(room, p, "Your opponent did not come back");
+                finished = 1;
+            }
+        }
+        if (!finished && !held && room->bot_due != 0 && now >= room->bot_due &&
+            game->state == PLAYING && game->players[game->current_player].bot) {
+            finished = bot_move(room);
+        } else if (!finished && !held && room->turn_deadline != 0 && now >= room->turn_deadline) {
+            finished = room_clock_ran_out(room);
+        }
+        if (!finished) room_schedule(room);
+    }
+    lock_release(&room->lock);
+    if (finished) {
+        room_free(room, 1);
+    }
+    outbox_flush();
+}
+
+// Caller holds the room lock, if the model needs it. Seats the session in
+// place of the held player whose token it presented, if the room still
+// holds that seat, and sends it the game as it stands. Returns 1 if it
+// did, 0 if the token is no good here, -1 if the seat was held too long:
+// the game is then forfeit and the room closed for the caller to free.
+static int seat_resume(room_t* room, unsigned int generation, session_t* session, const unsigned char* token) {
+    if (!room->in_use || room->generation != generation) return 0;
+    game_t* game = &room->game;
+    int seat = -1;
+    for (int p = 0; p < 2; p++) {
+        if (game->players[p].held && memcmp(game->players[p].token, token, PROTO_TOKEN_BYTES) == 0) {
+            seat = p;
+        }
+    }
+    if (seat < 0) return 0;
+    player_t* player = &game->players[seat];
+    if (now_ns() >= player->held_until) {
+        seat_forfeit(room, seat, "Your opponent did not come back");
+        return -1;
+    }
+    
+    seat_release(room, seat);
+    memcpy(session->username, player->username, MAX_USERNAME);
+    session->has_username = 1;
+    memcpy(session->token, token, PROTO_TOKEN_BYTES);
+    session->has_token = 1;
+    room_seat_player(room, seat, session);
+    send_resumed(room, seat);
+    send_simple(game->players[1 - seat].session, OP_OPPONENT_BACK,
+        "OPPONENT_BACK Your opponent is back\n");
+    room_start_clock(room);     // the move's full time again
+    logger_event(LOG_RESUMED, room->room_id, player->username, NULL, NULL);
+    return 1;
+}
+
+// RESUME: a connection that has not chosen a username takes back the seat
+// its token holds. In shards mode it is first handed over to the shard
+// serving that game. Returns as handle_command().
+int session_resume(session_t* session, const proto_command_t* cmd) {
+    held_seat_t held;
+    int found = 0;
+    if (!session->has_username && cmd->valid) {
+        lock_acquire(&held_mutex, &held_lock_stats);
+        found = held_find(cmd->token, &held);
+        lock_release(&held_mutex);
+    }
+    if (!found) {
+        send_error(session, ERR_BAD_TOKEN);
+        outbox_flush();
+        return 0;
+    }
+    room_t* room = held.room;
+
+#ifdef __linux__
+    if (io_model == MODEL_SHARDS) {
+        lock_acquire(&registry_mutex, &registry_lock_stats);
+        shard_t* shard = room->in_use && room->generation == held.generation ? room->shard : NULL;
+        lock_release(&registry_mutex);
+        if (shard != NULL && shard != session->shard) {
+            memcpy(session->token, cmd->token, PROTO_TOKEN_BYTES);
+            session->mail_room = room;
+            session->mail_room_generation = held.generation;
+            session->mail_resume = 1;
+            shard_hand_over(session, shard, NULL);
+            return 1;
+        }
+    }
+#endif
+    lock_acquire(&room->lock, &room_lock_stats);
+    int status = seat_resume(room, held.generation, session, cmd->token);
+    lock_release(&room->lock);
+    if (status < 0) {
+        room_free(room, 1);
+    }
+    if (status <= 0) {
+        send_error(session, ERR_BAD_TOKEN);
+    }
+    outbox_flush();
+    return 0;
+}
+
+// Caller must hold registry_mutex. Pairs players that queued while the
+// room table was full, now that a room has been released. With shards the
+// first of them is asked to pair itself on its own shard.
+void matchmaking_retry(void) {
+#ifdef __linux__
+    if (io_model == MODEL_SHARDS) {
+        session_t* first = match_queue.head;
+        if (match_queue.length >= 2 && !__atomic_load_n(&first->mail_pending, __ATOMIC_RELAXED)) {
+            shard_post(first->shard, first, NULL);
+        }
+        return;
+    }
+#endif
+    while (match_queue.length >= 2 && room_table.free_head != -1) {
+        session_t* first = match_queue.head;
+        match_queue_remove(first);
+        room_t* room = matchmaking_enqueue(first);
+        if (room == NULL) break;
+        announce_game_start(room);
+        lock_release(&room->lock);
+    }
+}
+
+// Seats a session waiting for an opponent against the computer, playing
+// at level, and starts the game. Returns 1 if it did, 0 if every room is
+// taken (it waits on), -1 if the session was not waiting.
+static int session_play_bot(session_t* session, ai_level_t level) {
+    lock_acquire(&registry_mutex, &registry_lock_stats);
+    int waiting = session->waiting;
+    room_t* room = waiting ? matchmaking_bot(session, level) : NULL;
+    lock_release(&registry_mutex);
+    if (room == NULL) return waiting ? 0 : -1;
+    
+    announce_game_start(room);
+    lock_release(&room->lock);
+    outbox_flush();
+    return 1;
+}
+
+// Sets up a session for the connected socket in a free slot of the
+// table, in the handshake phase. NULL if every slot is taken.
+static session_t* session_attach(int client_socket) {
+    session_t* session = session_slot_alloc();
+    if (session == NULL) return NULL;
+    session->socket = client_socket;
+    session->refcount = 1;
+    pthread_mutex_init(&session->send_lock, NULL);
+    outq_init(&session->output);
+    session->wake_pipe[0] = session->wake_pipe[1] = -1;
+    ring_attach(&session->input, session_table.input + (size_t)session->index * INPUT_SLOT_SIZE,
+                INPUT_RING_SIZE, MAX_FRAME);
+    if (io_model == MODEL_THREADS) {
+        if (pipe(session->wake_pipe) < 0) {
+            pthread_mutex_destroy(&session->send_lock);
+            session_slot_release(session);
+            return NULL;
+        }
+        fcntl(session->wake_pipe[0], F_SETFL, O_NONBLOCK);
+        fcntl(session->wake_pipe[1], F_SETFL, O_NONBLOCK);
+    }
+    session->phase = SESSION_HANDSHAKE;
+    session->seat = -1;
+    wheel_timer_init(&session->timer, TIMER_SESSION);
+    session->handshake_at = session->active_at = now_ns();
+    return session;
+}
+
+// When a bot takes the seat opposite the session, waiting for an
+// opponent since waiting_at; 0 if none will
+static unsigned long session_bot_deadline(const session_t* session) {
+    if (bot_wait == 0 || session->phase != SESSION_LOBBY || !__atomic_load_n(&session->waiting, __ATOMIC_RELAXED)) {
+        return 0;
+    }
+    return session->waiting_at + (unsigned long)bot_wait * 1000000000UL;
+}
+
+// When the session runs out of time: the handshake from connecting (or
+// from the end of the game it watched), idle time from its last command
+// in the lobby, or its wait for an opponent if a bot comes before that.
+// 0 while it plays or watches, or if that is not timed.
+static unsigned long session_deadline(const session_t* session) {
+    if (session->phase == SESSION_HANDSHAKE && handshake_timeout > 0) {
+        return session->handshake_at + (unsigned long)handshake_timeout * 1000000000UL;
+    }
+    if (session->phase == SESSION_LOBBY) {
+        unsigned long deadline = idle_timeout > 0 ? session->active_at + (unsigned long)idle_timeout * 1000000000UL : 0;
+        unsigned long bot = session_bot_deadline(session);
+        return bot != 0 && (deadline == 0 || bot < deadline) ? bot : deadline;
+    }
+    return 0;
+}
+
+// Sets the session's timer for its deadline. Phases change without
+// touching it, so one in a game or watching is looked at again every
+// idle_timeout instead.
+static void session_arm_timer(session_t* session) {
+    unsigned long deadline = session_deadline(session);
+    if (deadline == 0 && idle_timeout > 0) {
+        deadline = now_ns() + (unsigned long)idle_timeout * 1000000000UL;
+    }
+    if (deadline != 0) {
+        timer_schedule(session->shard, &session->timer, deadline);
+    }
+}
+
+// The session's timer went off; called on the thread serving it. Returns
+// -1 if its time is up, having told it why, for the caller to close it.
+// Commands only note the time, so the timer may find it still has some.
+int session_on_timer(session_t* session) {
+    unsigned long now = now_ns();
+    unsigned long bot = session_bot_deadline(session);
+    if (bot != 0 && now >= bot) {
+        // With every room taken, wait as long again before the next try
+        if (session_play_bot(session, bot_level) == 0) session->waiting_at = now;
+        session_arm_timer(session);
+        return 0;
+    }
+    unsigned long deadline = session_deadline(session);
+    if (deadline == 0 || now < deadline) {
+        session_arm_timer(session);
+        return 0;
+    }
+    
+    char message[128];
+    proto_timeout_t reason = session->phase == SESSION_HANDSHAKE ? TIMEOUT_HANDSHAKE : TIMEOUT_IDLE;
+    if (reason == TIMEOUT_HANDSHAKE) {
+        snprintf(message, sizeof(message), "No username after %d seconds; disconnecting", handshake_timeout);
+    } else {
+        snprintf(message, sizeof(message), "Idle for %d seconds; disconnecting", idle_timeout);
+    }
+    send_timeout(NULL, session, reason, -1, 0, message);
+    outbox_flush();
+    __atomic_fetch_add(&timeouts[reason], 1, __ATOMIC_RELAXED);
+    logger_event(LOG_TIMED_OUT, 0, session->has_username ? session->username : "Unknown", NULL,
+        reason == TIMEOUT_HANDSHAKE ? "handshake" : "idle");
+    return -1;
+}
+
+// Sets up a session for a new connection served by shard (NULL in the
+// threads model) and welcomes it
+session_t* session_create(int client_socket, shard_t* shard) {
+    // Replies are several small writes; do not let Nagle hold them back
+    int nodelay = 1;
+    setsockopt(client_socket, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+    
+    session_t* session = session_attach(client_socket);
+    if (session == NULL) return NULL;
+    session->shard = shard;
+    session_arm_timer(session);
+    
+    char welcome_msg[256];
+    snprintf(welcome_msg, sizeof(welcome_msg),
+        "WELCOME %s%s🎉 Welcome to Mini Battleship! 🎉%s\nPlease enter your username (max %d chars):\n",
+        BOLD, GREEN, RESET, MAX_USERNAME - 1);
+    queue_message(session, welcome_msg);
+    outbox_flush();
+    return session;
+}
+
+// Decodes a binary-protocol frame: an opcode and its fixed-layout payload
+void parse_binary_command(const unsigned char* frame, size_t length, proto_command_t* cmd) {
+    if (length == 0) {
+        cmd->type = CMD_MALFORMED;
+        return;
+    }
+    
+    switch (frame[0]) {
+        case OP_USERNAME:
+            if (length < 2 || length > 1 + PROTO_MAX_NAME) {
+                cmd->type = CMD_MALFORMED;
+                break;
+            }
+            cmd->type = CMD_USERNAME;
+            cmd->arg.text = (const char*)frame + 1;
+            cmd->arg.length = length - 1;
+            break;
+        case OP_PLACE:
+            cmd->type = CMD_PLACE;
+            if (length == 4) {
+                cmd->valid = 1;
+                cmd->col = frame[1];
+                cmd->row = frame[2];
+                cmd->horizontal = (frame[3] != 0);
+            }
+            break;
+        case OP_ATTACK:
+            cmd->type = CMD_ATTACK;
+            if (length == 3) {
+                cmd->valid = 1;
+                cmd->col = frame[1];
+                cmd->row = frame[2];
+            }
+            break;
+        case OP_GRID:
+        case OP_RESYNC:
+            cmd->type = CMD_GRID;
+            break;
+        case OP_QUIT:
+            cmd->type = CMD_QUIT;
+            break;
+        case OP_WATCH:
+            cmd->type = CMD_WATCH;
+            if (length == 5) {
+                cmd->valid = 1;
+                cmd->room_id = proto_get_u32(frame + 1);
+            } else if (length != 1) {
+                cmd->type = CMD_MALFORMED;
+            }
+            break;
+        case OP_RESUME:
+            cmd->type = CMD_RESUME;
+            if (length == 1 + PROTO_TOKEN_BYTES) {
+                cmd->valid = 1;
+                memcpy(cmd->token, frame + 1, PROTO_TOKEN_BYTES);
+            }
+            break;
+        case OP_BOT:
+            cmd->type = CMD_BOT;
+            cmd->level = -1;
+            if (length == 1) {
+                cmd->valid = 1;
+            } else if (length == 2) {
+                cmd->valid = frame[1] < AI_LEVELS;
+                if (cmd->valid) cmd->level = frame[1];
+            } else {
+                cmd->type = CMD_MALFORMED;
+            }
+            break;
+        default:
+            cmd->type = CMD_MALFORMED;
+            break;
+    }
+}
+
+// Runs one frame received from the session. Returns -1 when the client
+// asked to leave, 1 when the session was handed to another shard, 0
+// otherwise.
+int handle_command(session_t* session, char* frame, size_t length) {
+    proto_command_t cmd;
+    memset(&cmd, 0, sizeof(cmd));
+    
+    if (session->binary) {
+        parse_binary_command((const unsigned char*)frame, length, &cmd);
+        logger_event(LOG_OPCODE, length > 0 ? (unsigned char)frame[0] : 0,
+            session->has_username ? session->username : "?", NULL, NULL);
+    } else {
+        proto_parse_text_command(frame, length, session->has_username, &cmd);
+        if (cmd.type == CMD_BOT && cmd.arg.length > 0) {
+            cmd.level = ai_parse_level(cmd.arg.text, cmd.arg.length);
+            cmd.valid = cmd.level >= 0;
+        }
+        logger_event(LOG_COMMAND, 0, session->has_username ? session->username : "?", NULL, frame);
+    }
+    trace_command(cmd.type);
+    session->active_at = now_ns();
+    
+    // Spectators watch until the game ends: they may ask for the view
+    // again, change framing or leave
+    if (__atomic_load_n(&session->watching, __ATOMIC_ACQUIRE) != NULL &&
+        cmd.type != CMD_FRAMING && cmd.type != CMD_QUIT) {
+        room_t* watched = cmd.type == CMD_GRID ? room_acquire_watched(session) : NULL;
+        if (watched != NULL) {
+            send_spectate_view(watched, session);
+            lock_release(&watched->lock);
+        } else {
+            send_error(session, cmd.type == CMD_GRID ? ERR_NO_GAME : ERR_SPECTATING);
+        }
+        outbox_flush();
+        return 0;
+    }
+    if (cmd.type == CMD_WATCH) {
+        return session_watch(session, &cmd);
+    }
+    if (cmd.type == CMD_RESUME) {
+        return session_resume(session, &cmd);
+    }
+    
+    if (cmd.type == CMD_CAPS) {
+        // Binary frames apply from the very next byte in either direction
+        if (proto_view_equals(cmd.arg, PROTO_CAPABILITY)) {
+            queue_message(session, "CAPS_OK " PROTO_CAPABILITY "\n");
+            session->binary = 1;
+            session->input.mode = FRAMING_LENGTH;
+        } else {
+            send_error(session, ERR_BAD_CAPABILITY);
+        }
+        outbox_flush();
+        return 0;
+    }
+    
+    // Handle username input
+    if (cmd.type == CMD_USERNAME && !session->has_username) {
+        // Cut at MAX_USERNAME - 1 bytes, or a NUL in a binary name
+        size_t name_length = cmd.arg.length < MAX_USERNAME - 1 ? cmd.arg.length : MAX_USERNAME - 1;
+        const char* nul = memchr(cmd.arg.text, '\0', name_length);
+        if (nul != NULL) name_length = (size_t)(nul - cmd.arg.text);
+        memcpy(session->username, cmd.arg.text, name_length);
+        session->username[name_length] = '\0';
+        session->has_username = 1;
+        session->phase = SESSION_LOBBY;
+        send_username_set(session);
+        if (resume_grace > 0 && random_token(session->token)) {
+            session->has_token = 1;
+            send_resume_token(session);
+        }
+#ifdef __linux__
+        if (io_model == MODEL_SHARDS) {
+            outbox_flush();
+            return shard_matchmake(session);
+        }
+#endif
+
+        // Pair with a waiting player, or wait for the next one
+        lock_acquire(&registry_mutex, &registry_lock_stats);
+        room_t* room = matchmaking_enqueue(session);
+        if (room != NULL) {
+            announce_game_start(room);
+            lock_release(&room->lock);
+        } else {
+            send_wait_player(session);
+        }
+        lock_release(&registry_mutex);
+        
+        outbox_flush();
+        return 0;
+    }
+    
+    // Play the computer instead of waiting for an opponent
+    if (cmd.type == CMD_BOT) {
+        int status = cmd.valid ? session_play_bot(session, cmd.level < 0 ? bot_level : (ai_level_t)cmd.level) : 0;
+        if (!cmd.valid) {
+            send_error(session, ERR_BOT_FORMAT);
+        } else if (status < 0) {
+            send_error(session, ERR_NOT_WAITING);
+        } else if (status == 0) {
+            send_wait_player(session);
+        }
+        outbox_flush();
+        return 0;
+    }
+    
+    room_t* room = room_acquire(session);
+    game_t* game = room ? &room->game : NULL;
+    int player_id = session->seat;
+    int room_finished = 0;
+    int quit = 0;
+    
+    if (cmd.type == CMD_PLACE) {
+        if (game == NULL || game->state != PLACING_SHIPS) {
+            send_error(session, ERR_NOT_PLACING);
+        } else if (board_fleet_placed(&game->players[player_id].board, &game->config)) {
+            send_error(session, ERR_ALREADY_PLACED);
+        } else if (!cmd.valid) {
+            send_error(session, ERR_PLACE_FORMAT);
+        } else if (!board_can_place(&game->players[player_id].board, &game->config,
+                                    cmd.row, cmd.col, cmd.horizontal)) {
+            send_error(session, ERR_BAD_PLACEMENT);
+        } else {
+            board_place(&game->players[player_id].board, &game->config, cmd.row, cmd.col, cmd.horizontal);
+            game->players[player_id].board_seq++;
+            journal_record_t* record = room_journal(room, JOURNAL_PLACE, player_id);
+            if (record != NULL) {
+                record->data.place.row = (uint8_t)cmd.row;
+                record->data.place.col = (uint8_t)cmd.col;
+                record->data.place.horizontal = (uint8_t)cmd.horizontal;
+            }
+            send_ship_placed(game, player_id);
+            
+            if (board_fleet_placed(&game->players[0].board, &game->config) &&
+                board_fleet_placed(&game->players[1].board, &game->config)) {
+                game->state = PLAYING;
+                room_journal(room, JOURNAL_TURN, game->current_player);
+                send_battle_start(room);
+                room_start_clock(room);
+            }
+        }
+    } else if (cmd.type == CMD_ATTACK) {
+        if (game == NULL || game->state != PLAYING) {
+            send_error(session, ERR_NOT_PLAYING);
+        } else if (game->current_player != player_id) {
+            send_error(session, ERR_NOT_YOUR_TURN);
+        } else if (!cmd.valid) {
+            send_error(session, ERR_ATTACK_FORMAT);
+        } else {
+            int status = room_attack(room, player_id, cmd.row, cmd.col);
+            if (status < 0) {
+                send_error(session, ERR_BAD_ATTACK);
+            }
+            room_finished = (status > 0);
+        }
+    } else if (cmd.type == CMD_GRID) {
+        if (game != NULL) {
+            send_both_grids(game, player_id);
+        } else {
+            send_error(session, ERR_NO_GAME);
+        }
+    } else if (cmd.type == CMD_FRAMING) {
+        // Length-prefixed framing applies from the very next byte received
+        if (proto_view_equals(cmd.arg, "LENGTH")) {
+            session->input.mode = FRAMING_LENGTH;
+            queue_message(session, "FRAMING_OK LENGTH\n");
+        } else if (proto_view_equals(cmd.arg, "LINES")) {
+            session->input.mode = FRAMING_LINES;
+            queue_message(session, "FRAMING_OK LINES\n");
+        } else {
+            send_error(session, ERR_FRAMING_FORMAT);
+        }
+    } else if (cmd.type == CMD_MALFORMED) {
+        send_error(session, ERR_BAD_FRAME);
+    } else if (cmd.type == CMD_QUIT) {
+        session->quitting = 1;
+        quit = 1;
+    }
+    
+    if (room != NULL) {
+        lock_release(&room->lock);
+        if (room_finished) {
+            room_free(room, 1);
+        }
+    }
+    
+    outbox_flush();
+    return quit ? -1 : 0;
+}
+
+// Leaves the matchmaking queue or room and drops the connection's own
+// reference; the socket closes once no queued reply still needs it.
+void session_close(session_t* session) {
+    session->closed = 1;
+    timer_cancel(session->shard, &session->timer);
+    lock_acquire(&registry_mutex, &registry_lock_stats);
+    match_queue_remove(session);
+    lock_release(&registry_mutex);
+    
+    room_t* room = room_acquire(session);
+    if (room != NULL) {
+        player_t* player = &room->game.players[session->seat];
+        if (!seat_hold(room, session)) {
+            room_journal(room, JOURNAL_LEAVE, session->seat);
+        }
+        player->session = NULL;
+        session->seat = -1;
+        __atomic_store_n(&session->room, NULL, __ATOMIC_RELEASE);
+        room->game.players_connected--;
+        
+        // A bot left alone waits for a held seat, and no longer
+        int empty = (room->game.players_connected == room->game.bots && !player->held);
+        if (empty) {
+            room_close(room);
+        }
+        lock_release(&room->lock);
+        if (empty) {
+            room_free(room, 0);
+        }
+    }
+    
+    room_t* watched = room_acquire_watched(session);
+    if (watched != NULL) {
+        spectator_detach(watched, session);
+        lock_release(&watched->lock);
+    }
+    
+    outbox_flush();
+    logger_event(LOG_DISCONNECT, 0, session->has_username ? session->username : "Unknown",
+        NULL, NULL);
+    session_unref(session);
+}
+
+// Runs every complete frame waiting in the session's input ring, in the
+// order received, unless the client is not reading its replies: then the
+// session is paused until its output drains. Returns -1 once the session
+// should be closed, 1 once it has been handed to another shard.
+int session_process_input(session_t* session) {
+    char* frame;
+    size_t length;
+    frame_status_t status;
+    
+    while (1) {
+        if (session_backlog(session) > OUTPUT_PAUSE_BYTES) {
+            session->input_paused = 1;
+            return 0;
+        }
+        status = ring_next_frame(&session->input, &frame, &length);
+        if (status == FRAME_NONE) break;
+        
+        if (status == FRAME_TOO_LONG) {
+            send_error(session, ERR_TOO_LONG);
+            outbox_flush();
+            continue;
+        }
+        trace_begin();
+        commands_run++;
+        int result = handle_command(session, frame, length);
+        trace_end();
+        if (result != 0) return result;
+    }
+    return 0;
+}
+
+// Flushes queued output once the socket is writable again, and resumes a
+// paused session whose backlog has drained. Returns as
+// session_process_input().
+int session_on_writable(session_t* session) {
+    lock_acquire(&session->send_lock, &send_lock_stats);
+    session_write(session, NULL, NULL, 0);
+    size_t backlog = session->output.bytes;
+    lock_release(&session->send_lock);
+    
+    if (session->input_paused && backlog <= OUTPUT_PAUSE_BYTES) {
+        session->input_paused = 0;
+        return session_process_input(session);
+    }
+    return 0;
+}
+
+// Runs every timer on the shard's wheel (the threads model's, for NULL)
+// that is due. A session whose time is up is closed with close_session,
+// except in the threads model, where its own thread is woken to look.
+void timers_run(shard_t* shard, void (*close_session)(session_t*)) {
+    timer_wheel_t* wheel = timer_wheel(shard);
+    uint64_t now = now_ns() / 1000000UL;
+    while (1) {
+        lock_acquire(&timer_mutex, &timer_lock_stats);
+        wheel_timer_t* timer = wheel_expire(wheel, now);
+        session_t* session = NULL;
+        if (timer != NULL && timer->tag == TIMER_SESSION) {
+            session = (session_t*)((char*)timer - offsetof(session_t, timer));
+            session_ref(session);
+        }
+        lock_release(&timer_mutex);
+        if (timer == NULL) return;
+        
+        if (session == NULL) {
+            room_on_timer((room_t*)((char*)timer - offsetof(room_t, timer)));
+            continue;
+        }
+        if (io_model == MODEL_THREADS) {
+            __atomic_store_n(&session->timer_fired, 1, __ATOMIC_RELEASE);
+            ssize_t ignored = write(session->wake_pipe[1], "", 1);
+            (void)ignored;
+        } else if (session_on_timer(session) < 0) {
+            close_session(session);
+        }
+        session_unref(session);
+    }
+}
+
+// Thread model: the connection's own thread waits for input, for room in
+// the socket while output is queued, and for other threads' wake-ups
+void* handle_client(void* arg) {
+    session_t* session = arg;
+    int client_socket = session->socket;
+    
+    while (1) {
+        struct pollfd fds[2] = {
+            { .fd = client_socket, .events = 0, .revents = 0 },
+            { .fd = session->wake_pipe[0], .events = POLLIN, .revents = 0 }
+        };
+        if (!session->input_paused) fds[0].events |= POLLIN;
+        if (session_backlog(session) > 0) fds[0].events |= POLLOUT;
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        
+        if (fds[1].revents & POLLIN) {
+            char drain[64];
+            while (read(session->wake_pipe[0], drain, sizeof(drain)) > 0) {}
+            if (__atomic_exchange_n(&session->timer_fired, 0, __ATOMIC_ACQUIRE) &&
+                session_on_timer(session) < 0) {
+                break;
+            }
+        }
+        if ((fds[0].revents & POLLERR) && session_reap(session) > 0) {
+            fds[0].revents &= ~POLLERR;
+        }
+        if ((fds[0].revents & POLLOUT) && session_on_writable(session) < 0) break;
+        if (fds[0].revents & POLLIN) {
+            char* dest;
+            size_t space = ring_write_space(&session->input, &dest);
+            ssize_t bytes_received = recv(client_socket, dest, space, 0);
+            if (bytes_received <= 0) break;
+            
+            trace_ready();
+            ring_commit(&session->input, bytes_received);
+            if (session_process_input(session) < 0) break;
+        } else if (fds[0].revents & (POLLHUP | POLLERR | POLLNVAL)) {
+            break;
+        }
+    }
+    
+    session_close(session);
+    thread_buffers_free();
+    return NULL;
+}
+
+// Opens a listening socket on server_port; with reuse_port set, several
+// sockets may share the port and the kernel spreads connections across them
+int open_listener(int reuse_port) {
+    struct sockaddr_in servaddr;
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        perror("Socket creation failed");
+        exit(1);
+    }
+    
+    int opt = 1;
+    if (setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) ||
+        (reuse_port && setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)))) {
+        perror("setsockopt failed");
+        exit(1);
+    }
+    
+    memset(&servaddr, 0, sizeof(servaddr));
+    servaddr.sin_family = AF_INET;
+    servaddr.sin_addr.s_addr = INADDR_ANY;
+    servaddr.sin_port = htons(server_port);
+    
+    if (bind(fd, (struct sockaddr*)&servaddr, sizeof(servaddr)) < 0) {
+        perror("Bind failed");
+        exit(1);
+    }
+    
+    if (listen(fd, SOMAXCONN) < 0) {
+        perror("Listen failed");
+        exit(1);
+    }
+    return fd;
+}
+
+int set_nonblocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    if (flags < 0) return -1;
+    return fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+
+void print_reactor_stats(void) {
+    if (shards == NULL) return;
+    
+    printf("%s%s📊 Reactors%s\n", BOLD, CYAN, RESET);
+    printf("  %-8s %10s %10s %12s %12s %10s\n",
+        "reactor", "accepted", "handed in", "syscalls", "commands", "per cmd");
+    for (int i = 0; i < shard_count; i++) {
+        unsigned long syscalls = __atomic_load_n(&shards[i].syscalls, __ATOMIC_RELAXED);
+        unsigned long commands = __atomic_load_n(&shards[i].commands, __ATOMIC_RELAXED);
+        printf("  %-8d %10lu %10lu %12lu %12lu %10.2f\n", i,
+            __atomic_load_n(&shards[i].accepted, __ATOMIC_RELAXED),
+            __atomic_load_n(&shards[i].handoffs_in, __ATOMIC_RELAXED),
+            syscalls, commands, commands ? (double)syscalls / commands : 0.0);
+    }
+    fflush(stdout);
+}
+
+void print_spectator_stats(void) {
+    unsigned long updates = __atomic_load_n(&spectator_updates, __ATOMIC_RELAXED);
+    if (updates == 0) return;
+    
+    printf("%s%s📊 Spectators%s\n", BOLD, CYAN, RESET);
+    printf("  %lu updates built, %lu spectator writes (%.1f MB), %lu zero-copy sends (%lu copied by the kernel)\n",
+        updates, __atomic_load_n(&spectator_writes, __ATOMIC_RELAXED),
+        __atomic_load_n(&spectator_bytes, __ATOMIC_RELAXED) / 1e6,
+        __atomic_load_n(&outq_zerocopy_sends, __ATOMIC_RELAXED),
+        __atomic_load_n(&outq_zerocopy_copied, __ATOMIC_RELAXED));
+    fflush(stdout);
+}
+
+void print_journal_stats(void) {
+    journal_stats_t stats;
+    journal_get_stats(&stats);
+    if (stats.segments == 0) return;
+    
+    printf("%s%s📊 Journal%s\n", BOLD, CYAN, RESET);
+    printf("  %lu records in %lu batches (%.1f per batch), %lu segments opened, %lu syncs",
+        stats.records, stats.batches, stats.batches > 0 ? (double)stats.records / stats.batches : 0.0,
+        stats.segments, stats.syncs);
+    if (stats.dropped > 0) printf(", %lu records dropped", stats.dropped);
+    printf("\n");
+    fflush(stdout);
+}
+
+// The wheels' counts are read as they stand: shards may be moving them
+void print_timer_stats(void) {
+    unsigned long pending = 0, fired = 0, cascaded = 0;
+    int wheels = shards != NULL ? shard_count : 1;
+    for (int i = 0; i < wheels; i++) {
+        const timer_wheel_t* wheel = shards != NULL ? &shards[i].timers : &thread_timers;
+        pending += __atomic_load_n(&wheel->count, __ATOMIC_RELAXED);
+        fired += __atomic_load_n(&wheel->fired, __ATOMIC_RELAXED);
+        cascaded += __atomic_load_n(&wheel->cascaded, __ATOMIC_RELAXED);
+    }
+    if (fired == 0 && pending == 0) return;
+    
+    printf("%s%s📊 Timers%s\n", BOLD, CYAN, RESET);
+    printf("  %lu pending, %lu fired, %lu moved down a ring; timed out: %lu handshakes, %lu idle, "
+        "%lu turns, %lu placings; %lu games forfeit\n", pending, fired, cascaded,
+        __atomic_load_n(&timeouts[TIMEOUT_HANDSHAKE], __ATOMIC_RELAXED),
+        __atomic_load_n(&timeouts[TIMEOUT_IDLE], __ATOMIC_RELAXED),
+        __atomic_load_n(&timeouts[TIMEOUT_TURN], __ATOMIC_RELAXED),
+        __atomic_load_n(&timeouts[TIMEOUT_PLACING], __ATOMIC_RELAXED),
+        __atomic_load_n(&timeout_forfeits, __ATOMIC_RELAXED));
+    fflush(stdout);
+}
+
+void print_bot_stats(void) {
+    unsigned long games = __atomic_load_n(&bot_games, __ATOMIC_RELAXED);
+    unsigned long moves = __atomic_load_n(&bot_moves, __ATOMIC_RELAXED);
+    unsigned long spent = __atomic_load_n(&bot_move_ns, __ATOMIC_RELAXED);
+    if (games == 0) return;
+    
+    printf("%s%s📊 Bots%s\n", BOLD, CYAN, RESET);
+    printf("  %lu games against the computer, %lu moves, %.2f us choosing each\n",
+        games, moves, moves > 0 ? spent / 1000.0 / moves : 0.0);
+    fflush(stdout);
+}
+
+// Handles signal flags raised while the loop was blocked. Returns -1 once
+// the server should stop.
+int check_signals(void) {
+    if (stats_requested) {
+        stats_requested = 0;
+        print_lock_stats();
+        print_trace_stats();
+        print_reactor_stats();
+        print_spectator_stats();
+        print_journal_stats();
+        print_timer_stats();
+        print_bot_stats();
+    }
+    if (upgrade_requested && io_model != MODEL_EPOLL) {
+        upgrade_requested = 0;
+        fprintf(stderr, "Hot restart is only supported with --mode epoll\n");
+    }
+    return shutdown_requested ? -1 : 0;
+}
+
+#ifdef __linux__
+
+static uring_t uring;                       // uring model
+static uring_buffers_t uring_buffers;
+
+// Publishes the calling reactor thread's counts for print_reactor_stats().
+// System calls on the I/O path are counted: waiting, accepting, receiving,
+// sending and handing connections between shards. close() and the socket
+// options set on each connection are the same in every model and left out.
+void reactor_account(shard_t* shard) {
+    unsigned long syscalls = io_syscalls + outq_syscalls;
+    if (io_model == MODEL_URING) syscalls += uring.enters;
+    __atomic_store_n(&shard->syscalls, syscalls, __ATOMIC_RELAXED);
+    __atomic_store_n(&shard->commands, commands_run, __ATOMIC_RELAXED);
+}
+
+// Accepts every pending connection; the listener is edge-triggered
+void accept_connections(shard_t* shard) {
+    while (1) {
+        struct sockaddr_in cliaddr;
+        socklen_t clilen = sizeof(cliaddr);
+        io_syscalls++;
+        int client_socket = accept4(shard->listen_fd, (struct sockaddr*)&cliaddr, &clilen, SOCK_NONBLOCK);
+        
+        if (client_socket < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                perror("Accept failed");
+            }
+            return;
+        }
+        
+        logger_event(LOG_CONNECT, cliaddr.sin_addr.s_addr, NULL, NULL, NULL);
+        
+        session_t* session = session_create(client_socket, shard);
+        if (session == NULL) {
+            close(client_socket);
+            continue;
+        }
+        __atomic_fetch_add(&shard->accepted, 1, __ATOMIC_RELAXED);
+        
+        // Edge-triggered EPOLLOUT only fires when a full socket drains
+        struct epoll_event ev = { .events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET,
+                                  .data.u64 = session_handle(session) };
+        io_syscalls++;
+        if (epoll_ctl(shard->epoll_fd, EPOLL_CTL_ADD, client_socket, &ev) < 0) {
+            perror("epoll_ctl failed");
+            session_close(session);
+        }
+    }
+}
+
+// Drains the socket until it would block, running commands as they
+// complete. Returns as session_process_input().
+int session_on_readable(session_t* session) {
+    while (!session->input_paused) {
+        char* dest;
+        size_t space = ring_write_space(&session->input, &dest);
+        io_syscalls++;
+        ssize_t bytes_received = recv(session->socket, dest, space, 0);
+        if (bytes_received > 0) {
+            ring_commit(&session->input, bytes_received);
+            int result = session_process_input(session);
+            if (result != 0) return result;
+        } else if (bytes_received == 0) {
+            return -1;
+        } else if (errno == EINTR) {
+            continue;
+        } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return 0;
+        } else {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Reactor: one event for a session. A paused session stays unread until
+// its output drains, and is read straight away once it does, since that
+// input's edge has already been reported.
+int session_on_event(session_t* session, unsigned int events) {
+    // Zero-copy completions are reported as EPOLLERR too
+    if ((events & EPOLLERR) && session_reap(session) > 0) {
+        events &= ~EPOLLERR;
+    }
+    if (events & EPOLLOUT) {
+        int result = session_on_writable(session);
+        if (result != 0) return result;
+    }
+    if (session->input_paused) {
+        return (events & (EPOLLHUP | EPOLLERR)) ? -1 : 0;
+    }
+    return session_on_readable(session);
+}
+
+// Leaves a message for shard: session has been handed to it to be seated
+// with partner or to watch session->mail_room, or, with neither, is one of
+// its waiting players to pair again. Holds a reference to both until the shard reads it. Callable from
+// any thread; the mailbox is a lock-free stack.
+void shard_post(shard_t* shard, session_t* session, session_t* partner) {
+    session_ref(session);
+    if (partner != NULL) session_ref(partner);
+    session->mail_partner = partner;
+    __atomic_store_n(&session->mail_pending, 1, __ATOMIC_RELAXED);
+    
+    session_t* head = __atomic_load_n(&shard->mailbox, __ATOMIC_RELAXED);
+    do {
+        session->next_mail = head;
+    } while (!__atomic_compare_exchange_n(&shard->mailbox, &head, session, 1,
+                                          __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+    
+    uint64_t one = 1;
+    io_syscalls++;
+    ssize_t ignored = write(shard->wake_fd, &one, sizeof(one));
+    (void)ignored;
+}
+
+// Hands the session over to shard, to be seated with partner or as its
+// mail says, and stops serving it here: this shard must not touch it again
+void shard_hand_over(session_t* session, shard_t* shard, session_t* partner) {
+    timer_cancel(session->shard, &session->timer);
+    io_syscalls++;
+    epoll_ctl(session->shard->epoll_fd, EPOLL_CTL_DEL, session->socket, NULL);
+    shard_post(shard, session, partner);
+}
+
+// The registry has room for another game
+static int room_available(void) {
+    return room_table.free_head != -1 || room_table.initialized < room_table.capacity;
+}
+
+// Shard model, called by the session's own shard with no locks held. Pairs
+// it with the longest-waiting player: in a room on this shard if that
+// player is here too, otherwise by handing the session over to the shard
+// the player is on. Returns 1 if it was handed over (this shard must not
+// touch it again), 0 otherwise.
+int shard_matchmake(session_t* session) {
+    lock_acquire(&registry_mutex, &registry_lock_stats);
+    session_t* opponent = match_queue.head;
+    if (opponent != NULL && opponent->shard != session->shard && room_available()) {
+        match_queue_remove(opponent);
+        session_ref(opponent);
+        lock_release(&registry_mutex);
+        
+        shard_hand_over(session, opponent->shard, opponent);
+        session_unref(opponent);    // shard_post() holds its own
+        return 1;
+    }
+    
+    room_t* room = matchmaking_enqueue(session);
+    if (room != NULL) {
+        announce_game_start(room);
+        lock_release(&room->lock);
+    } else {
+        send_wait_player(session);
+    }
+    lock_release(&registry_mutex);
+    outbox_flush();
+    return 0;
+}
+
+// Seats a session handed to this shard with the partner it was matched
+// with, both now served here. Returns 0 if the partner has gone or there
+// is no room left, leaving the session unseated.
+static int shard_seat(session_t* session, session_t* partner) {
+    if (partner->closed || partner->room != NULL) return 0;
+    
+    lock_acquire(&registry_mutex, &registry_lock_stats);
+    room_t* room = room_alloc();
+    if (room != NULL) {
+        room_seat_player(room, 0, partner);
+        room_seat_player(room, 1, session);
+        room->game.state = PLACING_SHIPS;
+        room_start_clock(room);
+    }
+    lock_release(&registry_mutex);
+    if (room == NULL) return 0;
+    
+    announce_game_start(room);
+    lock_release(&room->lock);
+    outbox_flush();
+    return 1;
+}
+
+// A session handed to this shard to watch one of its games: attaches it
+// if that game is still on. Returns as handle_command().
+static int shard_watch(session_t* session) {
+    room_t* room = session->mail_room;
+    session->mail_room = NULL;
+    
+    lock_acquire(&registry_mutex, &registry_lock_stats);
+    int live = room->in_use && room->generation == session->mail_room_generation &&
+               room->shard == session->shard;
+    lock_release(&registry_mutex);
+    
+    // Only this shard could end the game from here on
+    if (live) {
+        spectator_attach(room, session);
+    } else {
+        send_error(session, ERR_NO_SUCH_GAME);
+    }
+    outbox_flush();
+    return 0;
+}
+
+// A session handed to this shard to take back a seat in one of its games.
+// Returns as handle_command().
+static int shard_resume(session_t* session) {
+    room_t* room = session->mail_room;
+    session->mail_room = NULL;
+    session->mail_resume = 0;
+    
+    lock_acquire(&registry_mutex, &registry_lock_stats);
+    int live = room->in_use && room->generation == session->mail_room_generation &&
+               room->shard == session->shard;
+    lock_release(&registry_mutex);
+    
+    // Only this shard could end the game from here on
+    int status = live ? seat_resume(room, session->mail_room_generation, session, session->token) : 0;
+    if (status < 0) {
+        room_free(room, 1);
+    }
+    if (status <= 0) {
+        send_error(session, ERR_BAD_TOKEN);
+    }
+    outbox_flush();
+    return 0;
+}
+
+// Handles every message in the shard's mailbox, oldest first
+void shard_read_mail(shard_t* shard) {
+    uint64_t count;
+    io_syscalls++;
+    ssize_t ignored = read(shard->wake_fd, &count, sizeof(count));
+    (void)ignored;
+    
+    session_t* stack = __atomic_exchange_n(&shard->mailbox, NULL, __ATOMIC_ACQUIRE);
+    session_t* mail = NULL;
+    while (stack != NULL) {
+        session_t* next = stack->next_mail;
+        stack->next_mail = mail;
+        mail = stack;
+        stack = next;
+    }
+    
+    while (mail != NULL) {
+        session_t* session = mail;
+        session_t* partner = session->mail_partner;
+        mail = session->next_mail;
+        __atomic_store_n(&session->mail_pending, 0, __ATOMIC_RELAXED);
+        
+        if (session->shard != shard) {
+            // A connection handed over: serve it from here on
+            session->shard = shard;
+            session_arm_timer(session);
+            __atomic_fetch_add(&shard->handoffs_in, 1, __ATOMIC_RELAXED);
+            struct epoll_event ev = { .events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET,
+                                      .data.u64 = session_handle(session) };
+            int result = -1;
+            io_syscalls++;
+            if (epoll_ctl(shard->epoll_fd, EPOLL_CTL_ADD, session->socket, &ev) == 0) {
+                result = 0;
+                if (session->mail_room != NULL && session->mail_resume) {
+                    result = shard_resume(session);
+                } else if (session->mail_room != NULL) {
+                    result = shard_watch(session);
+                } else if (!shard_seat(session, partner)) {
+                    result = shard_matchmake(session);
+                }
+                // Frames that followed the username are still in the ring;
+                // the socket itself reports any readiness on being added
+                if (result == 0) {
+                    result = session_process_input(session);
+                }
+            }
+            if (result < 0) {
+                session_close(session);
+            }
+        } else if (!session->closed) {
+            // One of ours still waiting while rooms were short: try again
+            lock_acquire(&registry_mutex, &registry_lock_stats);
+            int waiting = session->waiting;
+            match_queue_remove(session);
+            lock_release(&registry_mutex);
+            if (waiting) {
+                shard_matchmake(session);
+            }
+        }
+        
+        if (partner != NULL) session_unref(partner);
+        session_unref(session);
+    }
+}
+
+// Creates the shard's epoll set holding its listener and mailbox
+void shard_init(shard_t* shard, int id, int listener) {
+    memset(shard, 0, sizeof(*shard));
+    shard->id = id;
+    shard->listen_fd = listener;
+    wheel_init(&shard->timers, now_ns() / 1000000UL);
+    shard->epoll_fd = epoll_create1(0);
+    shard->wake_fd = eventfd(0, EFD_NONBLOCK);
+    if (shard->epoll_fd < 0 || shard->wake_fd < 0) {
+        perror("Shard setup failed");
+        exit(1);
+    }
+    if (set_nonblocking(listener) < 0) {
+        perror("fcntl failed");
+        exit(1);
+    }
+    
+    struct epoll_event listen_ev = { .events = EPOLLIN | EPOLLET, .data.u64 = EPOLL_LISTENER };
+    struct epoll_event mail_ev = { .events = EPOLLIN, .data.u64 = EPOLL_MAILBOX };
+    if (epoll_ctl(shard->epoll_fd, EPOLL_CTL_ADD, listener, &listen_ev) < 0 ||
+        epoll_ctl(shard->epoll_fd, EPOLL_CTL_ADD, shard->wake_fd, &mail_ev) < 0) {
+        perror("epoll_ctl failed");
+        exit(1);
+    }
+}
+
+// Hot restart (epoll model): on SIGUSR2 the server runs its own binary
+// again, hands the new process the listener, every connection and every
+// game in progress, and exits once it has taken over. Players stay
+// connected throughout and only see their replies held up while it
+// happens. The state goes over as records (see upgrade.h), in this order:
+// HANDOFF_HELLO with the listener, a HANDOFF_ROOM per game, a
+// HANDOFF_SESSION per connection with its socket, each followed by
+// HANDOFF_OUTPUT records holding what the socket had not taken yet
+// (waiting players come last, in queue order), then HANDOFF_END. The
+// successor answers HANDOFF_READY once it serves them all; until then
+// this process gives nothing up, and if anything fails it carries on.
+#define HANDOFF_VERSION 4
+
+typedef enum {
+    HANDOFF_HELLO = 1,
+    HANDOFF_ROOM,
+    HANDOFF_SESSION,
+    HANDOFF_OUTPUT,
+    HANDOFF_END,
+    HANDOFF_READY
+} handoff_kind_t;
+
+typedef struct {
+    uint32_t kind;
+    uint32_t version;
+    int32_t pid;                // of the process handing over
+    int32_t rooms_initialized;
+    int32_t latest;
+    uint64_t games_started;
+    uint64_t games_finished;
+} handoff_hello_t;
+
+// A player's board as the moves that made it, so that the successor
+// rebuilds it through the board functions whatever its layout
+typedef struct {
+    char username[MAX_USERNAME];
+    int32_t has_username;
+    uint32_t board_seq;
+    int32_t ships_placed;
+    uint8_t ship_row[PROTO_MAX_FLEET];
+    uint8_t ship_col[PROTO_MAX_FLEET];
+    uint8_t ship_horizontal[PROTO_MAX_FLEET];
+    uint8_t shot[PROTO_MAX_CELLS];      // nonzero for each cell fired at
+    uint8_t token[PROTO_TOKEN_BYTES];
+    int32_t held;
+    uint32_t held_ms;           // left of the grace period
+    int32_t bot;
+    int32_t bot_level;
+} handoff_player_t;
+
+typedef struct {
+    uint32_t kind;
+    int32_t room_id;
+    uint32_t generation;
+    int32_t rows;
+    int32_t cols;
+    int32_t ship_count;
+    int32_t ship_lengths[PROTO_MAX_FLEET];
+    int32_t current_player;
+    int32_t state;
+    uint32_t spectate_seq;
+    uint32_t journal_game;
+    uint32_t journal_step;
+    int32_t timed;              // the move (or placing) is on the clock
+    uint32_t turn_ms;           // and this much of its time is left
+    int32_t missed[2];
+    uint64_t bot_rng;
+    handoff_player_t players[2];
+} handoff_room_t;
+
+typedef struct {
+    uint32_t kind;
+    int32_t binary;
+    int32_t phase;
+    int32_t has_username;
+    char username[MAX_USERNAME];
+    int32_t has_token;
+    uint8_t token[PROTO_TOKEN_BYTES];
+    int32_t room_id;            // seated in, or -1
+    int32_t seat;
+    int32_t watching;           // room spectated, or -1
+    int32_t waiting;            // in the matchmaking queue
+    int32_t input_paused;
+    int32_t output_failed;
+    int32_t framing;
+    int32_t discarding;
+    uint32_t skip;
+    uint32_t input_length;
+    char input[INPUT_RING_SIZE];    // received and not yet run; only input_length bytes are sent
+} handoff_session_t;
+
+typedef struct {
+    uint32_t kind;
+    uint32_t length;
+    char data[UPGRADE_RECORD_MAX - 8];
+} handoff_output_t;
+
+static int handoff_room(upgrade_stream_t* stream, room_t* room) {
+    handoff_room_t record;
+    memset(&record, 0, sizeof(record));
+    game_t* game = &room->game;
+    const board_config_t* config = &game->config;
+    record.kind = HANDOFF_ROOM;
+    record.room_id = room->room_id;
+    record.generation = room->generation;
+    record.rows = config->rows;
+    record.cols = config->cols;
+    record.ship_count = config->ship_count;
+    memcpy(record.ship_lengths, config->ship_lengths, sizeof(record.ship_lengths));
+    record.current_player = game->current_player;
+    record.state = game->state;
+    record.spectate_seq = room->spectate_seq;
+    record.journal_game = room->journal_game;
+    record.journal_step = room->journal_step;
+    record.timed = room->turn_deadline != 0;
+    if (record.timed) {
+        unsigned long now = now_ns();
+        record.turn_ms = room->turn_deadline > now ? (uint32_t)((room->turn_deadline - now) / 1000000UL) : 0;
+    }
+    record.missed[0] = room->missed[0];
+    record.missed[1] = room->missed[1];
+    record.bot_rng = room->bot_rng;
+    
+    for (int p = 0; p < 2; p++) {
+        const player_t* player = &game->players[p];
+        handoff_player_t* out = &record.players[p];
+        memcpy(out->username, player->username, MAX_USERNAME);
+        out->has_username = player->has_username;
+        out->board_seq = player->board_seq;
+        out->ships_placed = player->board.ships_placed;
+        for (int i = 0; i < player->board.ships_placed; i++) {
+            const ship_t* ship = &player->board.fleet[i];
+            out->ship_row[i] = (uint8_t)(ship->cell / config->cols);
+            out->ship_col[i] = (uint8_t)(ship->cell % config->cols);
+            out->ship_horizontal[i] = ship->stride == 1;
+        }
+        for (int cell = 0; cell < config->rows * config->cols; cell++) {
+            cell_state_t state = board_cell(&player->board, cell, 1);
+            out->shot[cell] = state == HIT || state == MISS;
+        }
+        memcpy(out->token, player->token, PROTO_TOKEN_BYTES);
+        out->held = player->held;
+        if (player->held) {
+            unsigned long now = now_ns();
+            out->held_ms = player->held_until > now ? (uint32_t)((player->held_until - now) / 1000000UL) : 0;
+        }
+        out->bot = player->bot;
+        out->bot_level = player->bot_level;
+    }
+    return upgrade_put(stream, &record, sizeof(record), -1);
+}
+
+static int handoff_session(upgrade_stream_t* stream, session_t* session) {
+    static handoff_session_t record;
+    static handoff_output_t output;
+    
+    memset(&record, 0, offsetof(handoff_session_t, input));
+    record.kind = HANDOFF_SESSION;
+    record.binary = session->binary;
+    record.phase = session->phase;
+    record.has_username = session->has_username;
+    memcpy(record.username, session->username, MAX_USERNAME);
+    record.has_token = session->has_token;
+    memcpy(record.token, session->token, PROTO_TOKEN_BYTES);
+    record.room_id = session->room != NULL ? session->room->room_id : -1;
+    record.seat = session->seat;
+    record.watching = session->watching != NULL ? session->watching->room_id : -1;
+    record.waiting = session->waiting;
+    record.input_paused = session->input_paused;
+    record.output_failed = session->output_failed;
+    record.framing = session->input.mode;
+    record.discarding = session->input.discarding;
+    record.skip = session->input.skip;
+    record.input_length = (uint32_t)ring_pending(&session->input, record.input);
+    if (upgrade_put(stream, &record, offsetof(handoff_session_t, input) + record.input_length,
+                    session->socket) < 0) {
+        return -1;
+    }
+    
+    output.kind = HANDOFF_OUTPUT;
+    for (size_t offset = 0; offset < session->output.bytes; offset += output.length) {
+        output.length = (uint32_t)outq_copy(&session->output, offset, output.data, sizeof(output.data));
+        if (upgrade_put(stream, &output, offsetof(handoff_output_t, data) + output.length, -1) < 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Writes every record up to HANDOFF_END. The journal is closed on the
+// way, for the successor to start the next segment.
+static int handoff_send(upgrade_stream_t* stream) {
+    handoff_hello_t hello;
+    memset(&hello, 0, sizeof(hello));
+    hello.kind = HANDOFF_HELLO;
+    hello.version = HANDOFF_VERSION;
+    hello.pid = (int32_t)getpid();
+    hello.rooms_initialized = room_table.initialized;
+    hello.latest = room_table.latest;
+    hello.games_started = room_table.games_started;
+    hello.games_finished = room_table.games_finished;
+    if (upgrade_put(stream, &hello, sizeof(hello), listen_fd) < 0) return -1;
+    
+    for (int i = 0; i < room_table.initialized; i++) {
+        room_t* room = &room_table.rooms[i];
+        if (room->in_use && handoff_room(stream, room) < 0) return -1;
+    }
+    for (int i = 0; i < session_table.initialized; i++) {
+        session_t* session = &session_table.sessions[i];
+        if (session->refcount == 0 || session->closed || session->waiting) continue;
+        if (handoff_session(stream, session) < 0) return -1;
+    }
+    for (session_t* session = match_queue.head; session != NULL; session = session->next_waiting) {
+        if (handoff_session(stream, session) < 0) return -1;
+    }
+    
+    journal_close();
+    uint32_t end = HANDOFF_END;
+    if (upgrade_put(stream, &end, sizeof(end), -1) < 0) return -1;
+    return upgrade_flush(stream);
+}
+
+// The path this binary was started by, made absolute but not resolved, so
+// a symlink in it (a "current" release link) is followed again at each hot
+// restart. With no slash in argv[0] the shell found it on PATH; look there
+// the same way, and failing that ask /proc/self/exe. NULL if none works.
+char* find_server_path(const char* argv0) {
+    char* path = NULL;
+    if (argv0[0] == '/') return strdup(argv0);
+    if (strchr(argv0, '/') != NULL) {
+        char* cwd = getcwd(NULL, 0);
+        if (cwd == NULL) return NULL;
+        size_t size = strlen(cwd) + 1 + strlen(argv0) + 1;
+        path = malloc(size);
+        if (path != NULL) snprintf(path, size, "%s/%s", cwd, argv0);
+        free(cwd);
+        return path;
+    }
+    
+    const char* search = getenv("PATH");
+    while (search != NULL && *search != '\0') {
+        const char* end = strchr(search, ':');
+        size_t length = end != NULL ? (size_t)(end - search) : strlen(search);
+        // An empty entry (or one that is not absolute) would depend on the working directory
+        if (length > 0 && search[0] == '/') {
+            size_t size = length + 1 + strlen(argv0) + 1;
+            path = malloc(size);
+            if (path == NULL) return NULL;
+            snprintf(path, size, "%.*s/%s", (int)length, search, argv0);
+            if (access(path, X_OK) == 0) return path;
+            free(path);
+        }
+        search = end != NULL ? end + 1 : NULL;
+    }
+    
+    char self[4096];
+    ssize_t length = readlink("/proc/self/exe", self, sizeof(self) - 1);
+    if (length <= 0) return NULL;
+    self[length] = '\0';
+    return strdup(self);
+}
+
+// Hands everything to a new process running the server's binary. Returns
+// 0 once it has taken over, or -1, having said why, if this process
+// carries on serving.
+int hand_off(void) {
+    if (server_path == NULL) {
+        fprintf(stderr, "Hot restart failed: cannot tell where this binary is\n");
+        return -1;
+    }
+    // Resolved now rather than at startup: whatever the path leads to today
+    char* binary = realpath(server_path, NULL);
+    if (binary == NULL) {
+        fprintf(stderr, "Hot restart failed: %s: %s\n", server_path, strerror(errno));
+        return -1;
+    }
+    int channel;
+    pid_t child = upgrade_spawn(binary, server_argv, &channel);
+    if (child < 0) {
+        perror("Hot restart failed");
+        free(binary);
+        return -1;
+    }
+    printf("%s%s🔄 Hot restart: handing over to pid %d (%s)%s\n", BOLD, YELLOW, (int)child, binary, RESET);
+    free(binary);
+    fflush(stdout);
+    
+    upgrade_stream_t* stream = malloc(sizeof(upgrade_stream_t));
+    int ready = 0;
+    if (stream != NULL) {
+        upgrade_stream_init(stream, channel);
+        const void* record;
+        int fd;
+        ready = handoff_send(stream) == 0 && upgrade_get(stream, &record, &fd) == sizeof(uint32_t) &&
+                *(const uint32_t*)record == HANDOFF_READY;
+        free(stream);
+    }
+    close(channel);
+    if (ready) {
+        successor = child;
+        return 0;
+    }
+    
+    kill(child, SIGKILL);
+    waitpid(child, NULL, 0);
+    fprintf(stderr, "Hot restart failed: the new process did not take over; still serving\n");
+    if (journal_dir != NULL && !journal_enabled() &&
+        journal_open(journal_dir, journal_sync, journal_interval, 0) < 0) {
+        fprintf(stderr, "Journal stopped\n");
+    }
+    return -1;
+}
+
+static int take_over_hello(shard_t* reactor, const handoff_hello_t* hello, int fd) {
+    if (hello->version != HANDOFF_VERSION || fd < 0 ||
+        hello->rooms_initialized < 0 || hello->rooms_initialized > room_table.capacity) {
+        return -1;
+    }
+    listen_fd = fd;
+    shard_init(reactor, 0, listen_fd);
+    for (int i = 0; i < hello->rooms_initialized; i++) {
+        pthread_mutex_init(&room_table.rooms[i].lock, NULL);
+        wheel_timer_init(&room_table.rooms[i].timer, TIMER_ROOM);
+        room_table.rooms[i].room_id = i;
+    }
+    room_table.initialized = hello->rooms_initialized;
+    room_table.latest = hello->latest;
+    room_table.games_started = hello->games_started;
+    room_table.games_finished = hello->games_finished;
+    return 0;
+}
+
+static int take_over_room(shard_t* reactor, const handoff_room_t* record) {
+    if (record->room_id < 0 || record->room_id >= room_table.initialized) return -1;
+    room_t* room = &room_table.rooms[record->room_id];
+    if (room->in_use) return -1;
+    
+    board_config_t config;
+    memset(&config, 0, sizeof(config));
+    config.rows = record->rows;
+    config.cols = record->cols;
+    config.words = bitboard_words(config.rows * config.cols);
+    config.ship_count = record->ship_count;
+    memcpy(config.ship_lengths, record->ship_lengths, sizeof(config.ship_lengths));
+    if (config.rows < 1 || config.rows > PROTO_MAX_ROWS || config.cols < 1 || config.cols > PROTO_MAX_COLS ||
+        config.ship_count < 1 || config.ship_count > PROTO_MAX_FLEET || board_config_check(&config) != NULL) {
+        return -1;
+    }
+    // The seat to move indexes players[], and the state must be a game_state_t
+    if (record->current_player < 0 || record->current_player > 1 ||
+        record->state < WAITING_FOR_PLAYERS || record->state > GAME_OVER) {
+        return -1;
+    }
+    
+    game_t* game = &room->game;
+    if (init_game(room, &config) != 0) return -1;
+    game->current_player = record->current_player;
+    game->state = (game_state_t)record->state;
+    for (int p = 0; p < 2; p++) {
+        const handoff_player_t* in = &record->players[p];
+        player_t* player = &game->players[p];
+        memcpy(player->username, in->username, MAX_USERNAME - 1);
+        player->username[MAX_USERNAME - 1] = '\0';
+        player->has_username = in->has_username;
+        player->board_seq = in->board_seq;
+        if (in->ships_placed < 0 || in->ships_placed > config.ship_count) return -1;
+        for (int i = 0; i < in->ships_placed; i++) {
+            if (!board_can_place(&player->board, &config, in->ship_row[i], in->ship_col[i],
+                                 in->ship_horizontal[i])) {
+                return -1;
+            }
+            board_place(&player->board, &config, in->ship_row[i], in->ship_col[i], in->ship_horizontal[i]);
+        }
+        for (int cell = 0; cell < config.rows * config.cols; cell++) {
+            int sunk_length;
+            if (in->shot[cell]) {
+                board_attack(&player->board, &config, cell / config.cols, cell % config.cols, &sunk_length);
+            }
+        }
+        memcpy(player->token, in->token, PROTO_TOKEN_BYTES);
+        if (in->bot) {
+            if (in->bot_level < 0 || in->bot_level >= AI_LEVELS) return -1;
+            player->bot = 1;
+            player->bot_level = (ai_level_t)in->bot_level;
+            game->players_connected++;
+            game->bots++;
+        }
+    }
+    room->in_use = 1;
+    room->next_free = -1;
+    room->generation = record->generation;
+    room->spectate_seq = record->spectate_seq;
+    room->journal_game = record->journal_game;
+    room->journal_step = (uint16_t)record->journal_step;
+    room->shard = reactor;
+    room_table.active++;
+    
+    // Held seats and the move keep what was left of their time
+    for (int p = 0; p < 2; p++) {
+        player_t* player = &game->players[p];
+        room->missed[p] = record->missed[p];
+        if (!record->players[p].held) continue;
+        if (!held_insert(player->token, room)) return -1;
+        player->held = 1;
+        player->held_until = now_ns() + (unsigned long)record->players[p].held_ms * 1000000UL;
+    }
+    room->timer_due = 0;
+    room->turn_deadline = record->timed ? now_ns() + (unsigned long)record->turn_ms * 1000000UL : 0;
+    room->bot_rng = record->bot_rng;
+    room->bot_due = 0;
+    if (game->state == PLAYING && game->players[game->current_player].bot) {
+        room->bot_due = now_ns() + (unsigned long)bot_think * 1000000UL;   // thinks afresh
+    }
+    room_schedule(room);
+    return 0;
+}
+
+static session_t* take_over_session(shard_t* reactor, const handoff_session_t* record, size_t length, int fd) {
+    if (fd < 0 || length < offsetof(handoff_session_t, input) || record->input_length > INPUT_RING_SIZE ||
+        length != offsetof(handoff_session_t, input) + record->input_length) {
+        return NULL;
+    }
+    session_t* session = session_attach(fd);
+    if (session == NULL) return NULL;
+    session->shard = reactor;
+    session->binary = record->binary != 0;
+    session->phase = (session_phase_t)record->phase;
+    session->has_username = record->has_username;
+    memcpy(session->username, record->username, MAX_USERNAME - 1);
+    session->has_token = record->has_token;
+    memcpy(session->token, record->token, PROTO_TOKEN_BYTES);
+    session->input_paused = record->input_paused;
+    session->output_failed = record->output_failed;
+    
+    session->input.mode = record->framing == FRAMING_LENGTH ? FRAMING_LENGTH : FRAMING_LINES;
+    session->input.discarding = record->discarding;
+    session->input.skip = record->skip;
+    for (size_t copied = 0; copied < record->input_length; ) {
+        char* dest;
+        size_t space = ring_write_space(&session->input, &dest);
+        size_t count = record->input_length - copied < space ? record->input_length - copied : space;
+        memcpy(dest, record->input + copied, count);
+        ring_commit(&session->input, count);
+        copied += count;
+    }
+    
+    if (record->room_id >= 0) {
+        room_t* room = room_lookup(record->room_id);
+        if (room == NULL || (record->seat != 0 && record->seat != 1) ||
+            room->game.players[record->seat].session != NULL) {
+            return NULL;
+        }
+        room->game.players[record->seat].session = session;
+        room->game.players_connected++;
+        session->seat = record->seat;
+        session->room = room;
+    } else if (record->watching >= 0) {
+        room_t* room = room_lookup(record->watching);
+        if (room == NULL) return NULL;
+        spectator_link(room, session);
+    } else if (record->waiting) {
+        match_queue_append(session);
+    }
+    
+    session_arm_timer(session);
+    
+    struct epoll_event ev = { .events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET,
+                              .data.u64 = session_handle(session) };
+    if (epoll_ctl(reactor->epoll_fd, EPOLL_CTL_ADD, fd, &ev) < 0) return NULL;
+    return session;
+}
+
+// A new process taking over from the one that started it: rebuilds its
+// rooms and sessions from the records on channel and tells it to go.
+// Exits if the handoff cannot be completed, leaving it to carry on.
+void take_over(shard_t* reactor, int channel) {
+    upgrade_stream_t* stream = malloc(sizeof(upgrade_stream_t));
+    if (stream == NULL) {
+        perror("Hot restart failed");
+        exit(1);
+    }
+    upgrade_stream_init(stream, channel);
+    
+    int predecessor = 0;
+    int sessions = 0;
+    session_t* last = NULL;
+    while (1) {
+        const void* record;
+        int fd;
+        ssize_t length = upgrade_get(stream, &record, &fd);
+        uint32_t kind = length >= (ssize_t)sizeof(uint32_t) ? *(const uint32_t*)record : 0;
+        if (kind == HANDOFF_END) break;
+        
+        int status = -1;
+        switch (kind) {
+            case HANDOFF_HELLO:
+                if (length == sizeof(handoff_hello_t) && listen_fd < 0) {
+                    predecessor = ((const handoff_hello_t*)record)->pid;
+                    status = take_over_hello(reactor, record, fd);
+                }
+                break;
+            case HANDOFF_ROOM:
+                if (length == sizeof(handoff_room_t) && listen_fd >= 0) {
+                    status = take_over_room(reactor, record);
+                }
+                break;
+            case HANDOFF_SESSION:
+                if (listen_fd >= 0) {
+                    last = take_over_session(reactor, record, length, fd);
+                    status = last != NULL ? 0 : -1;
+                    sessions++;
+                }
+                break;
+            case HANDOFF_OUTPUT:
+                if (last != NULL && length >= (ssize_t)offsetof(handoff_output_t, data)) {
+                    const handoff_output_t* output = record;
+                    struct iovec iov = { (void*)output->data, output->length };
+                    if (output->length == length - offsetof(handoff_output_t, data)) {
+                        status = outq_push(&last->output, &iov, NULL, 1);
+                    }
+                }
+                break;
+            default:
+                break;
+        }
+        if (status < 0) {
+            fprintf(stderr, "Hot restart failed: the handoff was cut short or not understood\n");
+            exit(1);
+        }
+    }
+    if (listen_fd < 0) {
+        fprintf(stderr, "Hot restart failed: no listener was handed over\n");
+        exit(1);
+    }
+    
+    for (int i = room_table.initialized - 1; i >= 0; i--) {
+        room_t* room = &room_table.rooms[i];
+        if (room->in_use) continue;
+        room->next_free = room_table.free_head;
+        room_table.free_head = i;
+    }
+    if (journal_dir != NULL && journal_open(journal_dir, journal_sync, journal_interval, 0) < 0) {
+        exit(1);
+    }
+    
+    uint32_t ready = HANDOFF_READY;
+    if (upgrade_put(stream, &ready, sizeof(ready), -1) < 0 || upgrade_flush(stream) < 0) {
+        fprintf(stderr, "Hot restart failed: pid %d did not wait for the handoff\n", predecessor);
+        exit(1);
+    }
+    free(stream);
+    close(channel);
+    printf("%s%s🔄 Took over %d connections and %d games from pid %d%s\n", BOLD, GREEN,
+        sessions, room_table.active, predecessor, RESET);
+    fflush(stdout);
+}
+
+void run_epoll_loop(shard_t* shard) {
+    // Signals are only let in while waiting, so none slips in between
+    // checking the flags and going to sleep. Shard threads already have
+    // them blocked and leave them to the main thread.
+    sigset_t mask, original;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGINT);
+    sigaddset(&mask, SIGUSR1);
+    sigaddset(&mask, SIGUSR2);
+    pthread_sigmask(SIG_BLOCK, &mask, &original);
+    
+    struct epoll_event events[MAX_EVENTS];
+    while (1) {
+        reactor_account(shard);
+        io_syscalls++;
+        int timeout = wheel_timeout(&shard->timers, now_ns() / 1000000UL);
+        // Sockets closed with zero-copy sends in flight wait for them here
+        if (outq_sweep() > 0 && (timeout < 0 || timeout > OUTQ_SWEEP_MS)) timeout = OUTQ_SWEEP_MS;
+        int n = epoll_pwait(shard->epoll_fd, events, MAX_EVENTS, timeout, &original);
+        if (io_model == MODEL_EPOLL && check_signals() < 0) return;
+        if (io_model == MODEL_EPOLL && upgrade_requested) {
+            // On failure the events just reported are still served
+            upgrade_requested = 0;
+            if (hand_off() == 0) return;
+            if (n < 0) continue;    // errno is no longer epoll_pwait()'s
+        }
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            perror("epoll_wait failed");
+            exit(1);
+        }
+        
+        trace_ready();
+        for (int i = 0; i < n; i++) {
+            uint64_t source = events[i].data.u64;
+            session_t* session;
+            if (source == EPOLL_LISTENER) {
+                accept_connections(shard);
+            } else if (source == EPOLL_MAILBOX) {
+                shard_read_mail(shard);
+            } else if ((session = session_lookup(source)) == NULL) {
+                continue;       // the session ended earlier in this batch
+            } else if (session_on_event(session, events[i].events) < 0) {
+                session_close(session);
+            }
+        }
+        timers_run(shard, session_close);
+    }
+}
+
+void* shard_main(void* arg) {
+    shard_t* shard = arg;
+    
+    if (pin_shards) {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(shard->id % sysconf(_SC_NPROCESSORS_ONLN), &cpus);
+        if (pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) != 0) {
+            fprintf(stderr, "Could not pin shard %d\n", shard->id);
+        }
+    }
+    run_epoll_loop(shard);
+    return NULL;
+}
+
+// Starts one reactor thread per shard, each on its own SO_REUSEPORT
+// listener, and waits for signals on the main thread
+void run_shards(void) {
+    shards = calloc(shard_count, sizeof(shard_t));
+    if (shards == NULL) {
+        perror("Shard allocation failed");
+        exit(1);
+    }
+    
+    // Shard threads inherit a mask that leaves the signals to main
+    sigset_t mask, original;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGINT);
+    sigaddset(&mask, SIGUSR1);
+    sigaddset(&mask, SIGUSR2);
+    pthread_sigmask(SIG_BLOCK, &mask, &original);
+    
+    for (int i = 0; i < shard_count; i++) {
+        shard_init(&shards[i], i, i == 0 ? listen_fd : open_listener(1));
+        if (pthread_create(&shards[i].thread, NULL, shard_main, &shards[i]) != 0) {
+            perror("Thread creation failed");
+            exit(1);
+        }
+    }
+    
+    while (1) {
+        sigsuspend(&original);
+        if (check_signals() < 0) return;
+    }
+}
+
+// io_uring model: a single thread owns every session, as in the epoll
+// reactor, but accepts, receives and sends are requests that complete
+// later. One multishot accept and one multishot receive per connection
+// stay armed, receives land in provided buffers, and each pass of the
+// loop submits all new requests and waits in one io_uring_enter().
+// The low bits of a request's user_data say what it was for.
+typedef enum {
+    URING_ACCEPT = 1,
+    URING_RECV,
+    URING_SEND,
+    URING_CANCEL
+} uring_op_t;
+
+#define URING_OP_MASK 7
+
+static struct io_uring_sqe* uring_prepare(int opcode, int fd, session_t* session, uring_op_t op) {
+    struct io_uring_sqe* sqe = uring_get_sqe(&uring);
+    if (sqe == NULL) {
+        perror("io_uring_enter failed");
+        exit(1);
+    }
+    sqe->opcode = opcode;
+    sqe->fd = fd;
+    sqe->user_data = (session != NULL ? session_handle(session) : 0) | op;
+    return sqe;
+}
+
+static void uring_arm_accept(void) {
+    struct io_uring_sqe* sqe = uring_prepare(IORING_OP_ACCEPT, listen_fd, NULL, URING_ACCEPT);
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+}
+
+// Each outstanding request holds a reference until its last completion
+static void uring_arm_recv(session_t* session) {
+    struct io_uring_sqe* sqe = uring_prepare(IORING_OP_RECV, session->socket, session, URING_RECV);
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = uring_buffers.group;
+    session_ref(session);
+    session->recv_armed = 1;
+}
+
+// A paused session stops receiving, so the client feels TCP backpressure
+// as it would under epoll; the multishot receive ends with -ECANCELED
+static void uring_cancel_recv(session_t* session) {
+    struct io_uring_sqe* sqe = uring_prepare(IORING_OP_ASYNC_CANCEL, -1, NULL, URING_CANCEL);
+    sqe->addr = session_handle(session) | URING_RECV;
+    session->recv_cancelling = 1;
+}
+
+static void uring_send_queued(session_t* session) {
+    int n = outq_peek(&session->output, session->send_iov, URING_SEND_IOV);
+    memset(&session->send_msg, 0, sizeof(session->send_msg));
+    session->send_msg.msg_iov = session->send_iov;
+    session->send_msg.msg_iovlen = n;
+    
+    struct io_uring_sqe* sqe = uring_prepare(IORING_OP_SENDMSG, session->socket, session, URING_SEND);
+    sqe->addr = (uintptr_t)&session->send_msg;
+    sqe->msg_flags = MSG_NOSIGNAL;
+    session_ref(session);
+    session->send_inflight = 1;
+}
+
+// session_write() for the uring model: the bytes are queued and go out
+// with the session's next send request, one at a time so they stay in
+// order. Returns as outq_write().
+int uring_send(session_t* session, const struct iovec* iov, outq_shared_t* const* owners, int count) {
+    if (session->closed && !session->send_inflight) {
+        return outq_write(&session->output, session->socket, iov, owners, count);
+    }
+    if (outq_push(&session->output, iov, owners, count) < 0) return -1;
+    if (session->closed) return 1;
+    if (!session->send_inflight && session->output.bytes > 0) {
+        uring_send_queued(session);
+    }
+    return session->output.bytes > 0 ? 1 : 0;
+}
+
+// The receive keeps going until its cancellation is submitted, so a
+// client flooding commands it does not read the replies to can get well
+// ahead; past OUTPUT_PAUSE_BYTES of held input it is dropped instead of
+// held back by TCP as under epoll. Returns -1 to close the session.
+static int uring_hold(session_t* session, const char* data, size_t length) {
+    if (session->held_length + length > OUTPUT_PAUSE_BYTES) {
+        logger_event(LOG_NOT_READING, 0, session->has_username ? session->username : "?",
+            NULL, NULL);
+        return -1;
+    }
+    if (session->held_length + length > session->held_capacity) {
+        size_t capacity = session->held_capacity ? session->held_capacity : 4096;
+        while (capacity < session->held_length + length) capacity *= 2;
+        char* held = realloc(session->held, capacity);
+        if (held == NULL) return -1;
+        session->held = held;
+        session->held_capacity = capacity;
+    }
+    memcpy(session->held + session->held_length, data, length);
+    session->held_length += length;
+    return 0;
+}
+
+// Moves received bytes into the input ring and runs the commands they
+// complete, until done or the session pauses. Returns the bytes taken,
+// or -1 once the session should be closed.
+static long uring_feed(session_t* session, const char* data, size_t length) {
+    size_t taken = 0;
+    while (taken < length && !session->input_paused) {
+        char* dest;
+        size_t space = ring_write_space(&session->input, &dest);
+        if (space == 0) break;
+        size_t n = length - taken < space ? length - taken : space;
+        memcpy(dest, data + taken, n);
+        ring_commit(&session->input, n);
+        taken += n;
+        if (session_process_input(session) < 0) return -1;
+    }
+    return (long)taken;
+}
+
+// Input that arrives while the session is paused, or behind input held
+// back earlier, waits in session->held. Returns -1 to close the session.
+static int uring_take_input(session_t* session, const char* data, size_t length) {
+    long taken = 0;
+    if (session->held_length == 0 && !session->input_paused) {
+        taken = uring_feed(session, data, length);
+        if (taken < 0) return -1;
+    }
+    if ((size_t)taken < length && uring_hold(session, data + taken, length - taken) < 0) return -1;
+    return 0;
+}
+
+// Once a paused session has caught up: runs the input held back while
+// it was paused and starts receiving again. Returns -1 to close it.
+static int uring_resume(session_t* session) {
+    if (session->input_paused) return 0;
+    if (session->held_length > 0) {
+        long taken = uring_feed(session, session->held, session->held_length);
+        if (taken < 0) return -1;
+        session->held_length -= taken;
+        memmove(session->held, session->held + taken, session->held_length);
+    }
+    if (!session->input_paused && session->held_length == 0 && !session->recv_armed) {
+        uring_arm_recv(session);
+    }
+    return 0;
+}
+
+// Ends the session's outstanding requests, so their references go and
+// the socket is closed with the last one: shutting down the read side
+// ends the receive, and a send waiting on a client that is not reading is
+// cancelled. As under epoll, replies still queued then go only as far as
+// the socket takes them without blocking.
+static void uring_close(session_t* session) {
+    io_syscalls++;
+    shutdown(session->socket, SHUT_RD);
+    if (session->send_inflight) {
+        struct io_uring_sqe* sqe = uring_prepare(IORING_OP_ASYNC_CANCEL, -1, NULL, URING_CANCEL);
+        sqe->addr = session_handle(session) | URING_SEND;
+    }
+    session_close(session);
+}
+
+static void uring_on_accept(shard_t* reactor, int result, unsigned int flags) {
+    if (!(flags & IORING_CQE_F_MORE)) {
+        uring_arm_accept();
+    }
+    if (result < 0) {
+        errno = -result;
+        perror("Accept failed");
+        return;
+    }
+    
+    // Multishot accept leaves out the peer's address; only the log wants it
+    if (logger_wants(LOG_CONNECT)) {
+        struct sockaddr_in cliaddr;
+        socklen_t clilen = sizeof(cliaddr);
+        io_syscalls++;
+        if (getpeername(result, (struct sockaddr*)&cliaddr, &clilen) == 0) {
+            logger_event(LOG_CONNECT, cliaddr.sin_addr.s_addr, NULL, NULL, NULL);
+        }
+    }
+    
+    session_t* session = session_create(result, reactor);
+    if (session == NULL) {
+        close(result);
+        return;
+    }
+    reactor->accepted++;
+    uring_arm_recv(session);
+}
+
+static void uring_on_recv(session_t* session, int result, unsigned int flags) {
+    int failed = 0;
+    if (result > 0) {
+        unsigned int id = flags >> IORING_CQE_BUFFER_SHIFT;
+        if (!session->closed) {
+            failed = uring_take_input(session, uring_buffer(&uring_buffers, id), result) < 0;
+        }
+        uring_buffer_return(&uring_buffers, id);
+    } else if (result == 0 || (result != -ENOBUFS && result != -ECANCELED)) {
+        failed = 1;
+    }
+    
+    int ended = !(flags & IORING_CQE_F_MORE);
+    if (ended) {
+        session->recv_armed = 0;
+        session->recv_cancelling = 0;
+    }
+    if (!session->closed) {
+        if (failed || session->output_failed) {
+            uring_close(session);
+        } else if (session->input_paused || session->held_length > 0) {
+            if (session->recv_armed && !session->recv_cancelling) uring_cancel_recv(session);
+        } else if (!session->recv_armed) {
+            // Ran out of buffers, or was cancelled and has since resumed
+            uring_arm_recv(session);
+        }
+    }
+    if (ended) session_unref(session);
+}
+
+static void uring_on_send(session_t* session, int result) {
+    session->send_inflight = 0;
+    if (result > 0) {
+        outq_consume(&session->output, result);
+    }
+    
+    if (session->closed) {
+        if (!session->output_failed) {
+            outq_write(&session->output, session->socket, NULL, NULL, 0);
+        }
+        outq_clear(&session->output);
+    } else if (result < 0 || session->output_failed) {
+        if (!session->output_failed) {
+            session->output_failed = 1;
+            io_syscalls++;
+            shutdown(session->socket, SHUT_RDWR);
+        }
+        outq_clear(&session->output);
+        uring_close(session);
+    } else if (session_on_writable(session) < 0 || uring_resume(session) < 0) {
+        uring_close(session);
+    }
+    session_unref(session);
+}
+
+void run_uring_loop(shard_t* reactor) {
+    // Signals are only let in while waiting, so none slips in between
+    // checking the flags and going to sleep. A signal does not always make
+    // the wait fail with EINTR, so the flags are checked after every wait.
+    sigset_t mask, original;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGINT);
+    sigaddset(&mask, SIGUSR1);
+    sigaddset(&mask, SIGUSR2);
+    pthread_sigmask(SIG_BLOCK, &mask, &original);
+    
+    uring_arm_accept();
+    while (1) {
+        reactor_account(reactor);
+        int timeout = wheel_timeout(&reactor->timers, now_ns() / 1000000UL);
+        int submitted = uring_submit(&uring, 1, &original, timeout);
+        if (check_signals() < 0) return;
+        if (submitted < 0 && submitted != -ETIME) {
+            if (submitted == -EINTR) continue;
+            errno = -submitted;
+            perror("io_uring_enter failed");
+            exit(1);
+        }
+        
+        trace_ready();
+        struct io_uring_cqe* cqe;
+        while ((cqe = uring_peek_cqe(&uring)) != NULL) {
+            uint64_t data = cqe->user_data;
+            int result = cqe->res;
+            unsigned int flags = cqe->flags;
+            uring_cqe_seen(&uring);
+            
+            // Each request holds a reference, so its session cannot have ended
+            session_t* session = session_lookup(data & ~(uint64_t)URING_OP_MASK);
+            switch (data & URING_OP_MASK) {
+                case URING_ACCEPT:
+                    uring_on_accept(reactor, result, flags);
+                    break;
+                case URING_RECV:
+                    uring_on_recv(session, result, flags);
+                    break;
+                case URING_SEND:
+                    uring_on_send(session, result);
+                    break;
+                default:
+                    break;
+            }
+        }
+        timers_run(reactor, uring_close);
+    }
+}
+#endif
+
+void run_thread_loop(void) {
+    struct sockaddr_in cliaddr;
+    socklen_t clilen = sizeof(cliaddr);
+    
+    // The signals stay blocked except while pselect() waits, so none
+    // slips in between checking the flags and going to sleep. Client
+    // threads inherit the mask, so recv() in a game is never interrupted.
+    sigset_t mask, original;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGINT);
+    sigaddset(&mask, SIGUSR1);
+    sigaddset(&mask, SIGUSR2);
+    pthread_sigmask(SIG_BLOCK, &mask, &original);
+    
+    // A connection reset between pselect() and accept() must not leave
+    // accept() blocking with signals shut out
+    if (set_nonblocking(listen_fd) < 0) {
+        perror("fcntl failed");
+        exit(1);
+    }
+    
+    // Every timer is run here, between accepts. A client thread setting
+    // one for before the loop would wake writes to timer_pipe.
+    wheel_init(&thread_timers, now_ns() / 1000000UL);
+    if (pipe(timer_pipe) < 0 || set_nonblocking(timer_pipe[0]) < 0 || set_nonblocking(timer_pipe[1]) < 0) {
+        perror("Timer pipe failed");
+        exit(1);
+    }
+    int max_fd = listen_fd > timer_pipe[0] ? listen_fd : timer_pipe[0];
+    
+    while (1) {
+        lock_acquire(&timer_mutex, &timer_lock_stats);
+        uint64_t now = now_ns() / 1000000UL;
+        int timeout = wheel_timeout(&thread_timers, now);
+        timer_wakeup = timeout < 0 ? UINT64_MAX : now + (uint64_t)timeout;
+        lock_release(&timer_mutex);
+        // Sockets closed with zero-copy sends in flight wait for them here
+        if (outq_sweep() > 0 && (timeout < 0 || timeout > OUTQ_SWEEP_MS)) timeout = OUTQ_SWEEP_MS;
+        struct timespec wait = { timeout / 1000, (long)(timeout % 1000) * 1000000L };
+        
+        fd_set ready;
+        FD_ZERO(&ready);
+        FD_SET(listen_fd, &ready);
+        FD_SET(timer_pipe[0], &ready);
+        int n = pselect(max_fd + 1, &ready, NULL, NULL, timeout < 0 ? NULL : &wait, &original);
+        if (check_signals() < 0) return;
+        if (n > 0 && FD_ISSET(timer_pipe[0], &ready)) {
+            char drain[64];
+            while (read(timer_pipe[0], drain, sizeof(drain)) > 0) {}
+        }
+        timers_run(NULL, NULL);
+        if (n <= 0 || !FD_ISSET(listen_fd, &ready)) continue;
+        
+        int client_socket = accept(listen_fd, (struct sockaddr*)&cliaddr, &clilen);
+        if (client_socket < 0) {
+            if (errno != EINTR && errno != EAGAIN && errno != EWOULDBLOCK) {
+                perror("Accept failed");
+            }
+            continue;
+        }
+        
+        logger_event(LOG_CONNECT, cliaddr.sin_addr.s_addr, NULL, NULL, NULL);
+        
+        // The session comes from the table here, and its thread starts with it
+        session_t* session = session_create(client_socket, NULL);
+        if (session == NULL) {
+            close(client_socket);
+            continue;
+        }
+        pthread_t thread_id;
+        if (pthread_create(&thread_id, NULL, handle_client, session) != 0) {
+            perror("Thread creation failed");
+            session_unref(session);
+            continue;
+        }
+        pthread_detach(thread_id);
+    }
+}
+
+// Lifts the open-file limit so large connection counts are not capped at 1024
+void raise_fd_limit(void) {
+    struct rlimit rl;
+    if (getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur < rl.rlim_max) {
+        rl.rlim_cur = rl.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &rl);
+    }
+}
+
+// A whole number from 0 to max, in whatever unit the option takes, or -1
+int parse_count(const char* text, long max) {
+    char* end;
+    long count = strtol(text, &end, 10);
+    if (*end != '\0' || end == text || count < 0 || count > max) return -1;
+    return (int)count;
+}
+
+void usage(const char* prog) {
+    fprintf(stderr,
+        "Usage: %s [--mode threads|epoll|shards|uring] [--shards N] [--pin] [--port N] [--board ROWSxCOLS]\n"
+        "          [--fleet L1,L2,...] [--no-trace] [--log-level debug|info|warn|off] [--max-sessions N]\n"
+        "          [--journal DIR] [--journal-sync none|batch|MS] [--resume-grace SECONDS]\n"
+        "          [--handshake-timeout SECONDS] [--idle-timeout SECONDS] [--turn-timeout SECONDS]\n"
+        "          [--bot-wait SECONDS] [--bot-level easy|normal|hard] [--bot-think MS]\n"
+        "  --shards    reactor threads in shards mode (default one per CPU)\n"
+        "  --pin       pin each shard to its own CPU\n"
+        "  --board     board size, up to %dx%d (default %dx%d)\n"
+        "  --fleet     ship lengths in placement order, up to %d ships (default %s)\n"
+        "  --no-trace  do not time commands phase by phase\n"
+        "  --log-level debug logs every command; info (default) connections and games\n"
+        "  --max-sessions  connections served at once (default %d); more are refused\n"
+        "  --journal   append every game event to segment files in DIR (see ./replay)\n"
+        "  --journal-sync  force the journal to disk after every batch, every MS\n"
+        "              milliseconds, or never (none, the default: left to the kernel)\n"
+        "  --resume-grace  how long a dropped player's seat waits for them to resume\n"
+        "              (default %d, up to %d seconds; 0 gives it up at once)\n"
+        "  --handshake-timeout  seconds a connection has to pick a username (default %d)\n"
+        "  --idle-timeout  seconds a player may sit idle between games (default %d)\n"
+        "  --turn-timeout  seconds for each move, and per ship for placing the fleet\n"
+        "              (default %d); a turn that runs out passes, and %d in a row forfeit\n"
+        "              (each up to %d seconds; 0 never times out)\n"
+        "  --bot-wait  seconds a player waits for an opponent before the computer\n"
+        "              takes the seat (default %d; 0 only when asked for with BOT)\n"
+        "  --bot-level how well that bot plays (default normal)\n"
+        "  --bot-think milliseconds a bot takes over each move (default %d, up to %d)\n"
+        "SIGUSR1 prints statistics; SIGUSR2 hands every connection and game to the\n"
+        "binary on disk again and exits (a hot restart, epoll mode only)\n",
+        prog, PROTO_MAX_ROWS, PROTO_MAX_COLS, DEFAULT_ROWS, DEFAULT_COLS, PROTO_MAX_FLEET, DEFAULT_FLEET,
+        MAX_SESSIONS, RESUME_GRACE, RESUME_GRACE_MAX, HANDSHAKE_TIMEOUT, IDLE_TIMEOUT, TURN_TIMEOUT,
+        MISSED_TURNS_MAX, TIMEOUT_MAX, BOT_WAIT, BOT_THINK_MS, BOT_THINK_MAX);
+    exit(1);
+}
+
+// An option given a count parse_count() refused
+void bad_count(const char* prog, const char* option, long max, const char* unit) {
+    fprintf(stderr, "%s takes whole %s from 0 to %ld\n", option, unit, max);
+    usage(prog);
+}
+
+int main(int argc, char* argv[]) {
+    int takeover_fd = -1;
+    board_config_default(&default_config);
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--mode") == 0 && i + 1 < argc) {
+            i++;
+            if (strcmp(argv[i], "threads") == 0) {
+                io_model = MODEL_THREADS;
+            } else if (strcmp(argv[i], "epoll") == 0 || strcmp(argv[i], "shards") == 0 ||
+                       strcmp(argv[i], "uring") == 0) {
+#ifdef __linux__
+                io_model = strcmp(argv[i], "epoll") == 0 ? MODEL_EPOLL :
+                           strcmp(argv[i], "shards") == 0 ? MODEL_SHARDS : MODEL_URING;
+#else
+                fprintf(stderr, "%s is only available on Linux\n", argv[i]);
+                exit(1);
+#endif
+            } else {
+                usage(argv[0]);
+            }
+        } else if (strcmp(argv[i], "--max-sessions") == 0 && i + 1 < argc) {
+            max_sessions = atoi(argv[++i]);
+            if (max_sessions < 2) usage(argv[0]);
+        } else if (strcmp(argv[i], "--shards") == 0 && i + 1 < argc) {
+            shard_count = atoi(argv[++i]);
+            if (shard_count < 1) usage(argv[0]);
+        } else if (strcmp(argv[i], "--pin") == 0) {
+            pin_shards = 1;
+        } else if (strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+            server_port = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--board") == 0 && i + 1 < argc) {
+            if (board_config_set_size(&default_config, argv[++i]) < 0) usage(argv[0]);
+        } else if (strcmp(argv[i], "--fleet") == 0 && i + 1 < argc) {
+            if (board_config_set_fleet(&default_config, argv[++i]) < 0) usage(argv[0]);
+        } else if (strcmp(argv[i], "--no-trace") == 0) {
+            tracing = 0;
+        } else if (strcmp(argv[i], "--log-level") == 0 && i + 1 < argc) {
+            log_level = logger_parse_level(argv[++i]);
+            if (log_level < 0) usage(argv[0]);
+        } else if (strcmp(argv[i], "--journal") == 0 && i + 1 < argc) {
+            journal_dir = argv[++i];
+        } else if (strcmp(argv[i], "--journal-sync") == 0 && i + 1 < argc) {
+            if (journal_parse_sync(argv[++i], &journal_sync, &journal_interval) < 0) usage(argv[0]);
+        } else if (strcmp(argv[i], "--resume-grace") == 0 && i + 1 < argc) {
+            resume_grace = parse_count(argv[++i], RESUME_GRACE_MAX);
+            if (resume_grace < 0) bad_count(argv[0], "--resume-grace", RESUME_GRACE_MAX, "seconds");
+        } else if (strcmp(argv[i], "--handshake-timeout") == 0 && i + 1 < argc) {
+            handshake_timeout = parse_count(argv[++i], TIMEOUT_MAX);
+            if (handshake_timeout < 0) bad_count(argv[0], "--handshake-timeout", TIMEOUT_MAX, "seconds");
+        } else if (strcmp(argv[i], "--idle-timeout") == 0 && i + 1 < argc) {
+            idle_timeout = parse_count(argv[++i], TIMEOUT_MAX);
+            if (idle_timeout < 0) bad_count(argv[0], "--idle-timeout", TIMEOUT_MAX, "seconds");
+        } else if (strcmp(argv[i], "--turn-timeout") == 0 && i + 1 < argc) {
+            turn_timeout = parse_count(argv[++i], TIMEOUT_MAX);
+            if (turn_timeout < 0) bad_count(argv[0], "--turn-timeout", TIMEOUT_MAX, "seconds");
+        } else if (strcmp(argv[i], "--bot-wait") == 0 && i + 1 < argc) {
+            bot_wait = parse_count(argv[++i], TIMEOUT_MAX);
+            if (bot_wait < 0) bad_count(argv[0], "--bot-wait", TIMEOUT_MAX, "seconds");
+        } else if (strcmp(argv[i], "--bot-level") == 0 && i + 1 < argc) {
+            i++;
+            int level = ai_parse_level(argv[i], strlen(argv[i]));
+            if (level < 0) usage(argv[0]);
+            bot_level = (ai_level_t)level;
+        } else if (strcmp(argv[i], "--bot-think") == 0 && i + 1 < argc) {
+            bot_think = parse_count(argv[++i], BOT_THINK_MAX);
+            if (bot_think < 0) bad_count(argv[0], "--bot-think", BOT_THINK_MAX, "milliseconds");
+        } else if (strcmp(argv[i], "--takeover-fd") == 0 && i + 1 < argc) {
+            // Added by a hot restart: the predecessor's end of the handoff
+            takeover_fd = atoi(argv[++i]);
+        } else {
+            usage(argv[0]);
+        }
+    }
+    const char* problem = board_config_check(&default_config);
+    if (problem != NULL) {
+        fprintf(stderr, "Invalid game setup: %s\n", problem);
+        exit(1);
+    }
+    if (takeover_fd >= 0 && io_model != MODEL_EPOLL) {
+        fprintf(stderr, "Hot restart is only supported with --mode epoll\n");
+        exit(1);
+    }
+    server_path = find_server_path(argv[0]);
+    server_argv = argv;
+    
+    // No SA_RESTART: a wait interrupted by a signal must return
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = signal_handler;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGUSR1, &sa, NULL);
+    sigaction(SIGUSR2, &sa, NULL);
+    signal(SIGPIPE, SIG_IGN);
+    raise_fd_limit();
+    if (resume_grace > 0 && (random_fd = open("/dev/urandom", O_RDONLY | O_CLOEXEC)) < 0) {
+        perror("/dev/urandom");
+        fprintf(stderr, "Seats of dropped players will not be held\n");
+        resume_grace = 0;
+    }
+    room_table_init(MAX_ROOMS);
+    held_table_init(MAX_ROOMS);
+    session_table_init(max_sessions);
+    // A successor opens the journal once its predecessor has closed it
+    if (journal_dir != NULL && takeover_fd < 0 &&
+        journal_open(journal_dir, journal_sync, journal_interval, 1) < 0) {
+        exit(1);
+    }
+    if (tracing) {
+        trace_init(CMD_TYPES);
+    }
+    logger_init(log_level);
+    
+    if (shard_count == 0) {
+        shard_count = (int)sysconf(_SC_NPROCESSORS_ONLN);
+        if (shard_count < 1) shard_count = 1;
+    }
+    if (takeover_fd < 0) {
+        listen_fd = open_listener(io_model == MODEL_SHARDS);
+    }
+#ifdef __linux__
+    if (io_model == MODEL_URING) {
+        // Kernels without io_uring, or with it disabled, get the epoll reactor
+        int error = uring_init(&uring, URING_ENTRIES);
+        if (error == 0) {
+            error = uring_buffers_init(&uring, &uring_buffers, 0, URING_BUFFERS, URING_BUFFER_SIZE);
+            if (error != 0) uring_free(&uring);
+        }
+        if (error != 0) {
+            fprintf(stderr, "io_uring unavailable (%s), using epoll\n", strerror(-error));
+            io_model = MODEL_EPOLL;
+        }
+    }
+#endif
+
+    printf("%s%s🚢 Mini Battleship Server 🚢%s\n", BOLD, CYAN, RESET);
+    if (io_model == MODEL_SHARDS) {
+        printf("%s%sRunning on port %d (%d shards%s)%s\n", BOLD, GREEN, server_port,
+            shard_count, pin_shards ? ", pinned" : "", RESET);
+    } else {
+        printf("%s%sRunning on port %d (%s)%s\n", BOLD, GREEN, server_port,
+            io_model == MODEL_EPOLL ? "epoll" : io_model == MODEL_URING ? "io_uring" : "threads", RESET);
+    }
+    printf("%s%sWaiting for players to join...%s\n", BOLD, YELLOW, RESET);
+
+#ifdef __linux__
+    static shard_t reactor;     // the single reactor of the epoll and uring models
+    if (io_model == MODEL_EPOLL || io_model == MODEL_URING) {
+        shards = &reactor;
+        shard_count = 1;
+    }
+    if (io_model == MODEL_EPOLL) {
+        if (takeover_fd >= 0) {
+            take_over(&reactor, takeover_fd);
+        } else {
+            shard_init(&reactor, 0, listen_fd);
+        }
+        run_epoll_loop(&reactor);
+    } else if (io_model == MODEL_URING) {
+        reactor.listen_fd = listen_fd;
+        wheel_init(&reactor.timers, now_ns() / 1000000UL);
+        run_uring_loop(&reactor);
+    } else if (io_model == MODEL_SHARDS) {
+        run_shards();
+    } else {
+        run_thread_loop();
+    }
+#else
+    run_thread_loop();
+#endif
+
+    logger_stop();
+    if (successor != 0) {
+        printf("\n%s%s🔄 Handed over to pid %d%s\n", BOLD, GREEN, (int)successor, RESET);
+    } else {
+        printf("\n%s%s🛑 Shutting down server...%s\n", BOLD, RED, RESET);
+    }
+    print_lock_stats();
+    print_trace_stats();
+    print_reactor_stats();
+    print_spectator_stats();
+    journal_close();
+    print_journal_stats();
+    print_timer_stats();
+    print_bot_stats();
+    close(listen_fd);
+    return 0;
+}
@@ -0,0 +1,353 @@
+#define _GNU_SOURCE
+
+/*
+ * File: simulate.c
+ * Author: [Your Name]
+ * Date: October 17, 2026
+ * Description: Offline self-play for the game core
+ *              Plays complete games between firing strategies with no
+ *              sockets in the way: fleets are laid out through the
+ *              server's placement checks (board_can_place() and
+ *              board_place()) and every shot goes through board_attack(),
+ *              with the server's turn rule (a hit fires again, a miss
+ *              passes the turn, seat 0 starts). The games are spread over
+ *              one thread per core, each with its own random generator
+ *              and counters, merged at the end.
+ *
+ *              Every pairing of the chosen strategies, a strategy against
+ *              itself included, gets the same share of the games, and
+ *              each pairing swaps seats every other game. Prints games/s,
+ *              moves per game, and each strategy's win rate and shots per
+ *              win, overall (over the seats it took, both in a game
+ *              against itself) and per pairing.
+ *
+ *              A new strategy is a row in the strategies table.
+ *
+ * Usage: ./simulate [-g games] [-t threads] [-b RxC] [-f fleet] [-s list] [-r seed]
+ *        gcc -Wall -Wextra -std=c99 -pedantic -pthread -O2 -o simulate simulate.c ai.c board.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+#include "ai.h"
+#include "board.h"
+#include "protocol.h"
+
+#define MAX_STRATEGIES 8
+#define MAX_PAIRINGS (MAX_STRATEGIES * (MAX_STRATEGIES + 1) / 2)
+#define MAX_THREADS 256
+
+// One side of a game: how it fires, and what it keeps between its shots
+typedef struct {
+    int strategy;
+    unsigned short order[PROTO_MAX_CELLS];      // random: the cells in the order they are fired at
+    int next;
+} shooter_t;
+
+typedef struct {
+    const char* name;
+    ai_level_t level;                           // for ai_choose_attack(); unused by random
+    void (*start)(shooter_t* shooter, const board_config_t* config, uint64_t* rng);
+    int (*choose)(shooter_t* shooter, const board_state_t* enemy, const board_config_t* config,
+                  uint64_t* rng);
+} strategy_t;
+
+// Results of one pairing; seat a is the first strategy named
+typedef struct {
+    unsigned long games;
+    unsigned long wins_a;
+    unsigned long first_wins;                   // won by the seat that fired first
+    unsigned long moves;
+    unsigned long shots_a;                      // fired by a in the games it won
+    unsigned long shots_b;
+} pairing_stats_t;
+
+// A thread's games and counters, a cache line apart from the next one's
+typedef struct {
+    pthread_t thread;
+    unsigned long games;
+    uint64_t rng;
+    unsigned long invalid;                      // shots board_attack() refused
+    pairing_stats_t pairings[MAX_PAIRINGS];
+} __attribute__((aligned(64))) worker_t;
+
+// Fires at every cell once, in an order shuffled at the start of the game
+static void start_random(shooter_t* shooter, const board_config_t* config, uint64_t* rng) {
+    int cells = config->rows * config->cols;
+    for (int i = 0; i < cells; i++) {
+        shooter->order[i] = (unsigned short)i;
+    }
+    for (int i = cells - 1; i > 0; i--) {
+        int j = (int)((ai_random(rng) >> 32) % (uint64_t)(i + 1));
+        unsigned short tmp = shooter->order[i];
+        shooter->order[i] = shooter->order[j];
+        shooter->order[j] = tmp;
+    }
+    shooter->next = 0;
+}
+
+static int choose_random(shooter_t* shooter, const board_state_t* enemy, const board_config_t* config,
+                         uint64_t* rng) {
+    (void)enemy;
+    (void)rng;
+    return shooter->next < config->rows * config->cols ? shooter->order[shooter->next++] : -1;
+}
+
+static int choose_ai(shooter_t* shooter, const board_state_t* enemy, const board_config_t* config,
+                     uint64_t* rng);
+
+static const strategy_t strategies[] = {
+    { "random", AI_EASY, start_random, choose_random },
+    { "easy", AI_EASY, NULL, choose_ai },
+    { "normal", AI_NORMAL, NULL, choose_ai },
+    { "hard", AI_HARD, NULL, choose_ai }
+};
+#define STRATEGY_COUNT ((int)(sizeof(strategies) / sizeof(strategies[0])))
+
+static int choose_ai(shooter_t* shooter, const board_state_t* enemy, const board_config_t* config,
+                     uint64_t* rng) {
+    return ai_choose_attack(enemy, config, strategies[shooter->strategy].level, rng);
+}
+
+// Global configuration, read-only once the workers start
+board_config_t config;
+int chosen[MAX_STRATEGIES];                     // indexes into strategies
+int chosen_count = 0;
+int pairing_a[MAX_PAIRINGS];                    // chosen[] index of each pairing's two sides
+int pairing_b[MAX_PAIRINGS];
+int pairing_count = 0;
+
+double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Plays one game between shooters[0], who fires first, and shooters[1].
+// Returns the winning seat and adds up the shots each fired; -1 if a
+// strategy ran out of cells or chose one board_attack() refused.
+static int play_game(shooter_t* shooters, int* shots, uint64_t* rng, unsigned long* invalid) {
+    bitword_t masks[2][BOARD_MAX_STORAGE_WORDS];
+    board_state_t boards[2];
+    
+    for (int seat = 0; seat < 2; seat++) {
+        boards[seat].masks = masks[seat];
+        ai_place_fleet(&boards[seat], &config, rng);
+        const strategy_t* strategy = &strategies[shooters[seat].strategy];
+        if (strategy->start != NULL) strategy->start(&shooters[seat], &config, rng);
+        shots[seat] = 0;
+    }
+    
+    int seat = 0;
+    while (1) {
+        board_state_t* enemy = &boards[1 - seat];
+        int cell = strategies[shooters[seat].strategy].choose(&shooters[seat], enemy, &config, rng);
+        if (cell < 0) return -1;
+        
+        int sunk_length;
+        int result = board_attack(enemy, &config, cell / config.cols, cell % config.cols, &sunk_length);
+        if (result < 0) {
+            (*invalid)++;
+            return -1;
+        }
+        shots[seat]++;
+        if (result == ATTACK_MISS) {
+            seat = 1 - seat;
+        } else if (result == ATTACK_SUNK && board_defeated(enemy, &config)) {
+            return seat;
+        }
+    }
+}
+
+// Plays the thread's share of games, going round the pairings and
+// swapping seats each time round
+static void* worker_main(void* arg) {
+    worker_t* worker = arg;
+    shooter_t shooters[2];
+    int shots[2];
+    
+    for (unsigned long game = 0; game < worker->games; game++) {
+        int pairing = (int)(game % pairing_count);
+        int swapped = (int)((game / pairing_count) & 1);
+        shooters[swapped].strategy = chosen[pairing_a[pairing]];
+        shooters[1 - swapped].strategy = chosen[pairing_b[pairing]];
+        
+        int winner = play_game(shooters, shots, &worker->rng, &worker->invalid);
+        if (winner < 0) continue;
+        
+        // Back from seats to the pairing's sides: a sat in seat swapped
+        pairing_stats_t* stats = &worker->pairings[pairing];
+        stats->games++;
+        stats->moves += shots[0] + shots[1];
+        if (winner == 0) stats->first_wins++;
+        if (winner == swapped) {
+            stats->wins_a++;
+            stats->shots_a += shots[winner];
+        } else {
+            stats->shots_b += shots[winner];
+        }
+    }
+    return NULL;
+}
+
+// Reads a comma-separated list of strategy names into chosen[]
+static int parse_strategies(const char* list) {
+    chosen_count = 0;
+    while (*list != '\0') {
+        size_t length = strcspn(list, ",");
+        int found = -1;
+        for (int i = 0; i < STRATEGY_COUNT; i++) {
+            if (strlen(strategies[i].name) == length && strncmp(strategies[i].name, list, length) == 0) {
+                found = i;
+            }
+        }
+        if (found < 0 || chosen_count == MAX_STRATEGIES) return -1;
+        chosen[chosen_count++] = found;
+        list += length;
+        if (*list == ',') list++;
+    }
+    return chosen_count > 0 ? 0 : -1;
+}
+
+static void usage(const char* prog) {
+    fprintf(stderr,
+        "Usage: %s [-g games] [-t threads] [-b RxC] [-f fleet] [-s list] [-r seed]\n"
+        "  -g  games to play in all (default 1000000)\n"
+        "  -t  threads (default: one per core)\n"
+        "  -b  board size, as the server's --board (default 4x4)\n"
+        "  -f  ship lengths, as the server's --fleet (default 2)\n"
+        "  -s  strategies to pair up, comma-separated: random, easy, normal, hard (default all)\n"
+        "  -r  seed for the random generators (default from the clock)\n", prog);
+    exit(1);
+}
+
+int main(int argc, char* argv[]) {
+    unsigned long games = 1000000;
+    int threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    uint64_t seed = (uint64_t)time(NULL);
+    const char* size = NULL;
+    const char* fleet = NULL;
+    int opt;
+    
+    board_config_default(&config);
+    for (int i = 0; i < STRATEGY_COUNT; i++) {
+        chosen[chosen_count++] = i;
+    }
+    while ((opt = getopt(argc, argv, "g:t:b:f:s:r:")) != -1) {
+        switch (opt) {
+            case 'g': games = strtoul(optarg, NULL, 10); break;
+            case 't': threads = atoi(optarg); break;
+            case 'b': size = optarg; break;
+            case 'f': fleet = optarg; break;
+            case 's': if (parse_strategies(optarg) < 0) usage(argv[0]); break;
+            case 'r': seed = strtoull(optarg, NULL, 10); break;
+            default: usage(argv[0]);
+        }
+    }
+    if (optind != argc || games == 0 || threads < 1 || threads > MAX_THREADS) usage(argv[0]);
+    if ((size != NULL && board_config_set_size(&config, size) < 0) ||
+        (fleet != NULL && board_config_set_fleet(&config, fleet) < 0)) {
+        usage(argv[0]);
+    }
+    const char* problem = board_config_check(&config);
+    if (problem != NULL) {
+        fprintf(stderr, "%s\n", problem);
+        return 1;
+    }
+    
+    for (int a = 0; a < chosen_count; a++) {
+        for (int b = a; b < chosen_count; b++) {
+            pairing_a[pairing_count] = a;
+            pairing_b[pairing_count] = b;
+            pairing_count++;
+        }
+    }
+    
+    worker_t* workers = aligned_alloc(64, threads * sizeof(worker_t));
+    if (workers == NULL) {
+        perror("aligned_alloc failed");
+        return 1;
+    }
+    memset(workers, 0, threads * sizeof(worker_t));
+    
+    double start = now_seconds();
+    for (int i = 0; i < threads; i++) {
+        workers[i].games = games / threads + ((unsigned long)i < games % threads);
+        workers[i].rng = ai_seed(seed * MAX_THREADS + i);
+        if (pthread_create(&workers[i].thread, NULL, worker_main, &workers[i]) != 0) {
+            perror("pthread_create failed");
+            return 1;
+        }
+    }
+    for (int i = 0; i < threads; i++) {
+        pthread_join(workers[i].thread, NULL);
+    }
+    double elapsed = now_seconds() - start;
+    
+    // Merge the threads' counters, then each strategy's over its pairings
+    pairing_stats_t totals[MAX_PAIRINGS];
+    unsigned long invalid = 0;
+    memset(totals, 0, sizeof(totals));
+    for (int i = 0; i < threads; i++) {
+        invalid += workers[i].invalid;
+        for (int p = 0; p < pairing_count; p++) {
+            pairing_stats_t* from = &workers[i].pairings[p];
+            totals[p].games += from->games;
+            totals[p].wins_a += from->wins_a;
+            totals[p].first_wins += from->first_wins;
+            totals[p].moves += from->moves;
+            totals[p].shots_a += from->shots_a;
+            totals[p].shots_b += from->shots_b;
+        }
+    }
+    
+    unsigned long played = 0, moves = 0, first_wins = 0;
+    unsigned long side_games[MAX_STRATEGIES] = { 0 };
+    unsigned long side_wins[MAX_STRATEGIES] = { 0 };
+    unsigned long side_shots[MAX_STRATEGIES] = { 0 };
+    for (int p = 0; p < pairing_count; p++) {
+        const pairing_stats_t* stats = &totals[p];
+        int a = pairing_a[p], b = pairing_b[p];
+        played += stats->games;
+        moves += stats->moves;
+        first_wins += stats->first_wins;
+        side_games[a] += stats->games;
+        side_games[b] += stats->games;
+        side_wins[a] += stats->wins_a;
+        side_wins[b] += stats->games - stats->wins_a;
+        side_shots[a] += stats->shots_a;
+        side_shots[b] += stats->shots_b;
+    }
+    
+    printf("board %dx%d, %d ship%s; %lu games on %d thread%s in %.3f s: %.0f games/s, %.1f moves/game\n",
+        config.rows, config.cols, config.ship_count, config.ship_count == 1 ? "" : "s", played,
+        threads, threads == 1 ? "" : "s", elapsed, played / elapsed, played ? (double)moves / played : 0.0);
+    printf("seat that fires first wins %.1f%%\n", played ? 100.0 * first_wins / played : 0.0);
+    if (invalid > 0) printf("%lu games dropped for a shot board_attack() refused\n", invalid);
+    
+    printf("\n%-8s %12s %7s %10s\n", "strategy", "seats", "win %", "shots/win");
+    for (int s = 0; s < chosen_count; s++) {
+        printf("%-8s %12lu %7.1f %10.1f\n", strategies[chosen[s]].name, side_games[s],
+            side_games[s] ? 100.0 * side_wins[s] / side_games[s] : 0.0,
+            side_wins[s] ? (double)side_shots[s] / side_wins[s] : 0.0);
+    }
+    
+    printf("\n%-17s %12s %10s %7s %7s\n", "pairing", "games", "moves/game", "a win %", "first %");
+    for (int p = 0; p < pairing_count; p++) {
+        const pairing_stats_t* stats = &totals[p];
+        char name[32];
+        snprintf(name, sizeof(name), "%s v %s", strategies[chosen[pairing_a[p]]].name,
+            strategies[chosen[pairing_b[p]]].name);
+        printf("%-17s %12lu %10.1f %7.1f %7.1f\n", name, stats->games,
+            stats->games ? (double)stats->moves / stats->games : 0.0,
+            stats->games ? 100.0 * stats->wins_a / stats->games : 0.0,
+            stats->games ? 100.0 * stats->first_wins / stats->games : 0.0);
+    }
+    
+    free(workers);
+    return invalid > 0 ? 2 : 0;
+}
@@ -0,0 +1,188 @@
+/*
+ * File: trace.c
+ * Author: [Your Name]
+ * Date: October 17, 2026
+ * Description: Per-phase latency tracing of client commands (see trace.h)
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "histogram.h"
+#include "trace.h"
+
+// Histograms per phase plus the whole command, for each command type
+#define TRACE_SERIES (TRACE_PHASES + 1)
+
+// One thread's histograms, kept on a list so trace_print() can find them.
+// When the thread exits the block passes to the next thread that traces,
+// counts and all, so memory follows the peak number of threads rather
+// than how many have come and gone.
+typedef struct trace_stats {
+    struct trace_stats* next;
+    struct trace_stats* next_spare;
+    histogram_t series[];       // command * TRACE_SERIES + phase
+} trace_stats_t;
+
+// The command this thread is timing
+typedef struct {
+    int active;
+    int command;
+    trace_phase_t phase;
+    uint64_t ready;
+    uint64_t mark;              // start of the current phase
+    uint64_t phase_ns[TRACE_PHASES];
+    trace_stats_t* stats;
+} trace_state_t;
+
+static const char* phase_names[TRACE_SERIES] = { "recv", "parse", "lock", "logic", "send", "total" };
+
+static int trace_commands = 0;      // 0 while tracing is off
+static trace_stats_t* all_stats = NULL;
+static trace_stats_t* spare_stats = NULL;       // blocks of threads that have exited
+static pthread_mutex_t stats_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t stats_key;
+static __thread trace_state_t current;
+
+static size_t stats_size(void) {
+    return sizeof(trace_stats_t) + (size_t)trace_commands * TRACE_SERIES * sizeof(histogram_t);
+}
+
+static void merge_stats(trace_stats_t* into, const trace_stats_t* from) {
+    for (int i = 0; i < trace_commands * TRACE_SERIES; i++) {
+        histogram_merge(&into->series[i], &from->series[i]);
+    }
+}
+
+// Thread exit: the block is free for another thread to record into
+static void stats_retire(void* data) {
+    trace_stats_t* stats = data;
+    
+    pthread_mutex_lock(&stats_mutex);
+    stats->next_spare = spare_stats;
+    spare_stats = stats;
+    pthread_mutex_unlock(&stats_mutex);
+}
+
+// This thread's histograms, taken on its first traced command. NULL if
+// memory is short; that command then goes unrecorded.
+static trace_stats_t* thread_stats(void) {
+    if (current.stats != NULL) return current.stats;
+    
+    pthread_mutex_lock(&stats_mutex);
+    trace_stats_t* stats = spare_stats;
+    if (stats != NULL) {
+        spare_stats = stats->next_spare;
+    } else if ((stats = calloc(1, stats_size())) != NULL) {
+        stats->next = all_stats;
+        all_stats = stats;
+    }
+    pthread_mutex_unlock(&stats_mutex);
+    if (stats == NULL) return NULL;
+    pthread_setspecific(stats_key, stats);
+    current.stats = stats;
+    return stats;
+}
+
+void trace_init(int commands) {
+    trace_commands = commands;
+    if (pthread_key_create(&stats_key, stats_retire) != 0) {
+        trace_commands = 0;
+    }
+}
+
+uint64_t trace_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+void trace_ready(void) {
+    if (trace_commands == 0) return;
+    current.ready = trace_now();
+}
+
+void trace_begin(void) {
+    if (trace_commands == 0) return;
+    uint64_t now = trace_now();
+    
+    memset(current.phase_ns, 0, sizeof(current.phase_ns));
+    current.phase_ns[TRACE_RECV] = current.ready != 0 && now > current.ready ? now - current.ready : 0;
+    current.mark = now;
+    current.phase = TRACE_PARSE;
+    current.command = -1;
+    current.active = 1;
+}
+
+// Closes the running phase and starts phase
+static void switch_phase(trace_phase_t phase) {
+    uint64_t now = trace_now();
+    current.phase_ns[current.phase] += now - current.mark;
+    current.mark = now;
+    current.phase = phase;
+}
+
+void trace_command(int command) {
+    if (!current.active) return;
+    current.command = command;
+    switch_phase(TRACE_LOGIC);
+}
+
+void trace_lock_wait(uint64_t start, uint64_t end) {
+    if (!current.active || start < current.mark) return;
+    current.phase_ns[current.phase] += start - current.mark;
+    current.phase_ns[TRACE_LOCK] += end - start;
+    current.mark = end;
+}
+
+void trace_sending(void) {
+    if (!current.active || current.phase == TRACE_SEND) return;
+    switch_phase(TRACE_SEND);
+}
+
+void trace_end(void) {
+    if (!current.active) return;
+    current.active = 0;
+    if (current.command < 0 || current.command >= trace_commands) return;
+    
+    switch_phase(current.phase);
+    trace_stats_t* stats = thread_stats();
+    if (stats == NULL) return;
+    
+    histogram_t* series = &stats->series[current.command * TRACE_SERIES];
+    uint64_t total = 0;
+    for (int i = 0; i < TRACE_PHASES; i++) {
+        histogram_record(&series[i], current.phase_ns[i]);
+        total += current.phase_ns[i];
+    }
+    histogram_record(&series[TRACE_PHASES], total);
+}
+
+void trace_print(FILE* out, const char* const* names) {
+    if (trace_commands == 0) return;
+    trace_stats_t* all = calloc(1, stats_size());
+    if (all == NULL) return;
+    
+    pthread_mutex_lock(&stats_mutex);
+    for (trace_stats_t* stats = all_stats; stats != NULL; stats = stats->next) {
+        merge_stats(all, stats);
+    }
+    pthread_mutex_unlock(&stats_mutex);
+    
+    fprintf(out, "  %-10s %-6s %10s %9s %9s %9s %9s %9s\n",
+        "command", "phase", "count", "p50 us", "p90 us", "p99 us", "p99.9 us", "max us");
+    for (int command = 0; command < trace_commands; command++) {
+        const histogram_t* series = &all->series[command * TRACE_SERIES];
+        if (series[TRACE_PHASES].count == 0) continue;
+        
+        for (int i = 0; i < TRACE_SERIES; i++) {
+            const histogram_t* h = &series[i];
+            fprintf(out, "  %-10s %-6s %10llu %9.1f %9.1f %9.1f %9.1f %9.1f\n",
+                i == 0 ? names[command] : "", phase_names[i], (unsigned long long)h->count,
+                histogram_percentile(h, 50) / 1e3, histogram_percentile(h, 90) / 1e3,
+                histogram_percentile(h, 99) / 1e3, histogram_percentile(h, 99.9) / 1e3, h->max / 1e3);
+        }
+    }
+    free(all);
+}
@@ -0,0 +1,58 @@
+/*
+ * File: trace.h
+ * Author: [Your Name]
+ * Date: October 17, 2026
+ * Description: Per-phase latency tracing of client commands
+ *              Each command is timed through five phases with the monotonic
+ *              clock: recv (input known ready until the command starts:
+ *              reading it and waiting behind other work on the thread),
+ *              parse, lock (waiting on contended locks), logic, and send
+ *              (writing the replies). Every thread records into its own
+ *              histograms, one per command type and phase, so recording
+ *              takes no lock; trace_print() merges all of them.
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+typedef enum {
+    TRACE_RECV,
+    TRACE_PARSE,
+    TRACE_LOCK,
+    TRACE_LOGIC,
+    TRACE_SEND,
+    TRACE_PHASES
+} trace_phase_t;
+
+// Turns tracing on for command types 0 .. commands-1. Call once, before
+// any other thread starts; without it every call below does nothing.
+void trace_init(int commands);
+
+uint64_t trace_now(void);
+
+// Input became ready on this thread (epoll_wait or a blocking recv returned)
+void trace_ready(void);
+
+// A command is about to be framed and parsed
+void trace_begin(void);
+
+// The command was parsed as type command; its logic starts
+void trace_command(int command);
+
+// This thread waited on a lock from start to end (trace_now() times)
+void trace_lock_wait(uint64_t start, uint64_t end);
+
+// The command's replies are being written
+void trace_sending(void);
+
+// The command is done: its phases go into this thread's histograms
+void trace_end(void);
+
+// Percentiles per command type and phase, merged over every thread that
+// ever traced; names[i] labels command type i. Safe while others record.
+void trace_print(FILE* out, const char* const* names);
+
+#endif
@@ -0,0 +1,207 @@
+/*
+ * File: upgrade.c
+ * Author: [Your Name]
+ * Date: October 17, 2026
+ * Description: Hot restart plumbing (see upgrade.h)
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/time.h>
+#include "upgrade.h"
+
+// Each record is preceded by its length and whether a descriptor goes
+// with it, and padded to keep the next one aligned
+typedef struct {
+    uint32_t length;
+    uint32_t has_fd;
+} record_header_t;
+
+#define PADDED(length) (((length) + 7) & ~(size_t)7)
+
+// Closes every descriptor from first up. Runs between fork() and exec(),
+// so limit is looked up beforehand.
+static void close_from(int first, long limit) {
+#ifdef SYS_close_range
+    if (syscall(SYS_close_range, first, ~0U, 0) == 0) return;
+#endif
+    for (long fd = first; fd < limit; fd++) {
+        close((int)fd);
+    }
+}
+
+pid_t upgrade_spawn(const char* path, char* const argv[], int* channel) {
+    int argc = 0;
+    while (argv[argc] != NULL) argc++;
+    char** args = malloc((argc + 3) * sizeof(char*));
+    if (args == NULL) return -1;
+    int n = 0;
+    for (int i = 0; i < argc; i++) {
+        if (strcmp(argv[i], "--takeover-fd") == 0) {
+            i++;
+            continue;
+        }
+        args[n++] = argv[i];
+    }
+    char fd_text[16];
+    snprintf(fd_text, sizeof(fd_text), "%d", UPGRADE_CHANNEL_FD);
+    args[n++] = "--takeover-fd";
+    args[n++] = fd_text;
+    args[n] = NULL;
+    
+    int pair[2];
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET, 0, pair) < 0) {
+        free(args);
+        return -1;
+    }
+    long limit = sysconf(_SC_OPEN_MAX);
+    pid_t pid = fork();
+    if (pid == 0) {
+        sigset_t none;
+        sigemptyset(&none);
+        sigprocmask(SIG_SETMASK, &none, NULL);
+        if (pair[1] != UPGRADE_CHANNEL_FD && dup2(pair[1], UPGRADE_CHANNEL_FD) < 0) _exit(127);
+        close_from(UPGRADE_CHANNEL_FD + 1, limit);
+        execv(path, args);
+        _exit(127);
+    }
+    free(args);
+    close(pair[1]);
+    if (pid < 0) {
+        close(pair[0]);
+        return -1;
+    }
+    
+    // A successor that hangs must not hang this process too
+    struct timeval timeout = { UPGRADE_TIMEOUT_MS / 1000, (UPGRADE_TIMEOUT_MS % 1000) * 1000 };
+    setsockopt(pair[0], SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    setsockopt(pair[0], SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    *channel = pair[0];
+    return pid;
+}
+
+void upgrade_stream_init(upgrade_stream_t* stream, int channel) {
+    stream->channel = channel;
+    stream->used = 0;
+    stream->offset = 0;
+    stream->fd_count = 0;
+    stream->fd_next = 0;
+}
+
+int upgrade_flush(upgrade_stream_t* stream) {
+    if (stream->used == 0) return 0;
+    
+    struct iovec iov = { stream->buffer, stream->used };
+    union {
+        struct cmsghdr header;
+        char space[CMSG_SPACE(sizeof(int) * UPGRADE_FDS_MAX)];
+    } control;
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    if (stream->fd_count > 0) {
+        size_t fd_bytes = sizeof(int) * stream->fd_count;
+        msg.msg_control = control.space;
+        msg.msg_controllen = CMSG_SPACE(fd_bytes);
+        struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(fd_bytes);
+        memcpy(CMSG_DATA(cmsg), stream->fds, fd_bytes);
+    }
+    
+    ssize_t sent;
+    do {
+        sent = sendmsg(stream->channel, &msg, 0);
+    } while (sent < 0 && errno == EINTR);
+    if (sent != (ssize_t)stream->used) return -1;
+    stream->used = 0;
+    stream->fd_count = 0;
+    return 0;
+}
+
+int upgrade_put(upgrade_stream_t* stream, const void* record, size_t length, int fd) {
+    if (length > UPGRADE_RECORD_MAX) return -1;
+    size_t size = sizeof(record_header_t) + PADDED(length);
+    if (stream->used + size > UPGRADE_MESSAGE_MAX ||
+        (fd >= 0 && stream->fd_count == UPGRADE_FDS_MAX)) {
+        if (upgrade_flush(stream) < 0) return -1;
+    }
+    
+    record_header_t header = { (uint32_t)length, fd >= 0 };
+    memcpy(stream->buffer + stream->used, &header, sizeof(header));
+    memcpy(stream->buffer + stream->used + sizeof(header), record, length);
+    stream->used += size;
+    if (fd >= 0) stream->fds[stream->fd_count++] = fd;
+    return 0;
+}
+
+// Receives the next message and the descriptors sent with it
+static int receive_message(upgrade_stream_t* stream) {
+    struct iovec iov = { stream->buffer, sizeof(stream->buffer) };
+    union {
+        struct cmsghdr header;
+        char space[CMSG_SPACE(sizeof(int) * UPGRADE_FDS_MAX)];
+    } control;
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.space;
+    msg.msg_controllen = sizeof(control.space);
+    
+    ssize_t received;
+    do {
+        received = recvmsg(stream->channel, &msg, 0);
+    } while (received < 0 && errno == EINTR);
+    if (received <= 0 || (msg.msg_flags & (MSG_TRUNC | MSG_CTRUNC))) return -1;
+    
+    stream->used = (size_t)received;
+    stream->offset = 0;
+    stream->fd_count = 0;
+    stream->fd_next = 0;
+    for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) continue;
+        int count = (int)((cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int));
+        if (count > UPGRADE_FDS_MAX - stream->fd_count) return -1;
+        memcpy(stream->fds + stream->fd_count, CMSG_DATA(cmsg), count * sizeof(int));
+        stream->fd_count += count;
+    }
+    return 0;
+}
+
+ssize_t upgrade_get(upgrade_stream_t* stream, const void** record, int* fd) {
+    if (stream->offset >= stream->used && receive_message(stream) < 0) return -1;
+    
+    record_header_t header;
+    if (stream->used - stream->offset < sizeof(header)) return -1;
+    memcpy(&header, stream->buffer + stream->offset, sizeof(header));
+    size_t start = stream->offset + sizeof(header);
+    if (header.length > stream->used - start) return -1;
+    
+    *fd = -1;
+    if (header.has_fd) {
+        if (stream->fd_next == stream->fd_count) return -1;
+        *fd = stream->fds[stream->fd_next++];
+    }
+    *record = stream->buffer + start;
+    stream->offset = start + PADDED(header.length);
+    if (stream->offset >= stream->used) {
+        // The record stays in the buffer, which the next put may reuse
+        stream->used = 0;
+        stream->offset = 0;
+        stream->fd_count = 0;
+        stream->fd_next = 0;
+    }
+    return header.length;
+}
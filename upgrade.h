@@ -0,0 +1,63 @@
+/*
+ * File: upgrade.h
+ * Author: [Your Name]
+ * Date: October 17, 2026
+ * Description: Hot restart plumbing: starting the new binary and handing
+ *              it state over a Unix socket
+ *              The running server starts its successor with one end of a
+ *              SOCK_SEQPACKET socket pair, then writes it a stream of
+ *              records: its own serialized state, each record optionally
+ *              carrying an open descriptor (a listener, a client socket).
+ *              Records are packed into messages of up to
+ *              UPGRADE_MESSAGE_MAX bytes and the descriptors of a message
+ *              travel with it as SCM_RIGHTS, so each connection costs no
+ *              system call of its own. What the records mean is up to the
+ *              server.
+ */
+
+#ifndef UPGRADE_H
+#define UPGRADE_H
+
+#include <stddef.h>
+#include <sys/types.h>
+
+#define UPGRADE_MESSAGE_MAX 65536   // bytes per message
+#define UPGRADE_RECORD_MAX 32768    // bytes per record, header excluded
+#define UPGRADE_FDS_MAX 250         // descriptors per message (Linux allows 253)
+#define UPGRADE_CHANNEL_FD 3        // where the new process finds its end
+#define UPGRADE_TIMEOUT_MS 10000    // longest wait on the other process
+
+typedef struct {
+    int channel;
+    char buffer[UPGRADE_MESSAGE_MAX];
+    size_t used;            // writing: bytes packed; reading: message length
+    size_t offset;          // reading: next record
+    int fds[UPGRADE_FDS_MAX];
+    int fd_count;
+    int fd_next;            // reading: descriptor of the next record that has one
+} upgrade_stream_t;
+
+// Starts path with argv (NULL-terminated, any "--takeover-fd N" in it
+// dropped) followed by "--takeover-fd 3", holding the other end of a new
+// socket pair as descriptor 3 and no other descriptor past stderr. The
+// child starts with no signal blocked. Returns its pid, with *channel set
+// to this end, or -1.
+pid_t upgrade_spawn(const char* path, char* const argv[], int* channel);
+
+void upgrade_stream_init(upgrade_stream_t* stream, int channel);
+
+// Appends a record of length bytes (up to UPGRADE_RECORD_MAX) carrying
+// fd, or no descriptor if fd is -1, sending the message first if the
+// record does not fit in it. Returns -1 if the channel failed.
+int upgrade_put(upgrade_stream_t* stream, const void* record, size_t length, int fd);
+
+// Sends the records appended so far
+int upgrade_flush(upgrade_stream_t* stream);
+
+// Reads the next record, receiving a new message when the current one is
+// used up. *record points at it until the next call and *fd is the
+// descriptor it carries, or -1. Returns its length, or -1 if the channel
+// failed or closed. Descriptors of a message never read are leaked.
+ssize_t upgrade_get(upgrade_stream_t* stream, const void** record, int* fd);
+
+#endif
@@ -0,0 +1,205 @@
+/*
+ * File: uring.c
+ * Author: [Your Name]
+ * Date: October 17, 2026
+ * Description: Minimal io_uring wrapper over the raw system calls (see uring.h)
+ */
+
+#define _GNU_SOURCE
+
+#ifdef __linux__
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include "uring.h"
+
+static int sys_setup(unsigned int entries, struct io_uring_params* params) {
+    return (int)syscall(__NR_io_uring_setup, entries, params);
+}
+
+static int sys_enter(int fd, unsigned int submit, unsigned int wait, unsigned int flags,
+                     const void* arg, size_t size) {
+    return (int)syscall(__NR_io_uring_enter, fd, submit, wait, flags, arg, size);
+}
+
+static int sys_register(int fd, unsigned int opcode, void* arg, unsigned int count) {
+    return (int)syscall(__NR_io_uring_register, fd, opcode, arg, count);
+}
+
+int uring_init(uring_t* ring, unsigned int entries) {
+    struct io_uring_params params;
+    memset(ring, 0, sizeof(*ring));
+    
+    // Completions outnumber submissions: multishot operations post many.
+    // Only this thread submits, and it need not be interrupted to run
+    // completion work.
+    memset(&params, 0, sizeof(params));
+    params.flags = IORING_SETUP_CQSIZE | IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_COOP_TASKRUN;
+    params.cq_entries = entries * 4;
+    ring->fd = sys_setup(entries, &params);
+    if (ring->fd < 0 && errno == EINVAL) {
+        // Older kernels know neither hint
+        memset(&params, 0, sizeof(params));
+        params.flags = IORING_SETUP_CQSIZE;
+        params.cq_entries = entries * 4;
+        ring->fd = sys_setup(entries, &params);
+    }
+    if (ring->fd < 0) return -errno;
+    // Waits with a timeout need the extended argument (5.11)
+    if (!(params.features & IORING_FEAT_SINGLE_MMAP) || !(params.features & IORING_FEAT_EXT_ARG)) {
+        close(ring->fd);
+        return -ENOSYS;
+    }
+    
+    // One mapping holds both ring headers; the entries are separate
+    size_t sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+    size_t cq_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    ring->rings_size = sq_size > cq_size ? sq_size : cq_size;
+    ring->rings = mmap(NULL, ring->rings_size, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+    if (ring->rings == MAP_FAILED) {
+        int error = errno;
+        close(ring->fd);
+        return -error;
+    }
+    
+    ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    ring->sqes = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+    if (ring->sqes == MAP_FAILED) {
+        int error = errno;
+        munmap(ring->rings, ring->rings_size);
+        close(ring->fd);
+        return -error;
+    }
+    
+    char* sq = ring->rings;
+    ring->sq_head = (unsigned int*)(sq + params.sq_off.head);
+    ring->sq_tail = (unsigned int*)(sq + params.sq_off.tail);
+    ring->sq_mask = *(unsigned int*)(sq + params.sq_off.ring_mask);
+    ring->sq_array = (unsigned int*)(sq + params.sq_off.array);
+    ring->sq_entries = params.sq_entries;
+    ring->sq_local_tail = *ring->sq_tail;
+    
+    char* cq = ring->rings;
+    ring->cq_head = (unsigned int*)(cq + params.cq_off.head);
+    ring->cq_tail = (unsigned int*)(cq + params.cq_off.tail);
+    ring->cq_mask = *(unsigned int*)(cq + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+    return 0;
+}
+
+void uring_free(uring_t* ring) {
+    munmap(ring->sqes, ring->sqes_size);
+    munmap(ring->rings, ring->rings_size);
+    close(ring->fd);
+}
+
+struct io_uring_sqe* uring_get_sqe(uring_t* ring) {
+    unsigned int head = __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+    if (ring->sq_local_tail - head >= ring->sq_entries) {
+        if (uring_submit(ring, 0, NULL, -1) < 0) return NULL;
+        head = __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+        if (ring->sq_local_tail - head >= ring->sq_entries) return NULL;
+    }
+    
+    unsigned int index = ring->sq_local_tail & ring->sq_mask;
+    struct io_uring_sqe* sqe = &ring->sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    ring->sq_array[index] = index;
+    ring->sq_local_tail++;
+    return sqe;
+}
+
+int uring_submit(uring_t* ring, unsigned int wait, const sigset_t* mask, int timeout_ms) {
+    // Counted from the kernel's head: entries an interrupted call left
+    // behind go again
+    __atomic_store_n(ring->sq_tail, ring->sq_local_tail, __ATOMIC_RELEASE);
+    unsigned int submit = ring->sq_local_tail - __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+    
+    struct __kernel_timespec timeout = { timeout_ms / 1000, (long long)(timeout_ms % 1000) * 1000000 };
+    struct io_uring_getevents_arg arg;
+    memset(&arg, 0, sizeof(arg));
+    arg.sigmask = (uint64_t)(uintptr_t)mask;
+    arg.sigmask_sz = _NSIG / 8;
+    arg.ts = timeout_ms >= 0 ? (uint64_t)(uintptr_t)&timeout : 0;
+    
+    unsigned int flags = IORING_ENTER_EXT_ARG | (wait > 0 ? IORING_ENTER_GETEVENTS : 0);
+    ring->enters++;
+    int result = sys_enter(ring->fd, submit, wait, flags, &arg, sizeof(arg));
+    return result < 0 ? -errno : result;
+}
+
+struct io_uring_cqe* uring_peek_cqe(uring_t* ring) {
+    unsigned int head = *ring->cq_head;
+    if (head == __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE)) return NULL;
+    return &ring->cqes[head & ring->cq_mask];
+}
+
+void uring_cqe_seen(uring_t* ring) {
+    __atomic_store_n(ring->cq_head, *ring->cq_head + 1, __ATOMIC_RELEASE);
+}
+
+int uring_buffers_init(uring_t* ring, uring_buffers_t* buffers, int group,
+                       unsigned int count, unsigned int size) {
+    memset(buffers, 0, sizeof(*buffers));
+    size_t ring_size = count * sizeof(struct io_uring_buf);
+    void* memory = mmap(NULL, ring_size, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) return -errno;
+    buffers->ring = memory;
+    buffers->data = malloc((size_t)count * size);
+    if (buffers->data == NULL) {
+        munmap(memory, ring_size);
+        return -ENOMEM;
+    }
+    buffers->count = count;
+    buffers->size = size;
+    buffers->group = group;
+    
+    struct io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = (unsigned long)buffers->ring;
+    reg.ring_entries = count;
+    reg.bgid = group;
+    if (sys_register(ring->fd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+        int error = errno;
+        free(buffers->data);
+        munmap(memory, ring_size);
+        return -error;
+    }
+    
+    for (unsigned int id = 0; id < count; id++) {
+        uring_buffer_return(buffers, id);
+    }
+    return 0;
+}
+
+void uring_buffers_free(uring_t* ring, uring_buffers_t* buffers) {
+    struct io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.bgid = buffers->group;
+    sys_register(ring->fd, IORING_UNREGISTER_PBUF_RING, &reg, 1);
+    munmap(buffers->ring, buffers->count * sizeof(struct io_uring_buf));
+    free(buffers->data);
+}
+
+char* uring_buffer(uring_buffers_t* buffers, unsigned int id) {
+    return buffers->data + (size_t)id * buffers->size;
+}
+
+void uring_buffer_return(uring_buffers_t* buffers, unsigned int id) {
+    unsigned short tail = buffers->ring->tail;
+    struct io_uring_buf* buf = &buffers->ring->bufs[tail & (buffers->count - 1)];
+    buf->addr = (unsigned long)uring_buffer(buffers, id);
+    buf->len = buffers->size;
+    buf->bid = id;
+    __atomic_store_n(&buffers->ring->tail, (unsigned short)(tail + 1), __ATOMIC_RELEASE);
+}
+
+#endif
@@ -0,0 +1,85 @@
+/*
+ * File: uring.h
+ * Author: [Your Name]
+ * Date: October 17, 2026
+ * Description: Minimal io_uring wrapper over the raw system calls (Linux)
+ *              Maps the submission and completion rings, hands out
+ *              submission entries, and submits every prepared entry while
+ *              waiting for completions with a single io_uring_enter().
+ *              Also sets up a ring of provided buffers that receive
+ *              operations pick from, so no buffer is tied up per
+ *              connection while it waits for input.
+ */
+
+#ifndef URING_H
+#define URING_H
+
+#ifdef __linux__
+
+#include <stddef.h>
+#include <signal.h>
+#include <linux/io_uring.h>
+
+typedef struct {
+    int fd;
+    unsigned int* sq_head;
+    unsigned int* sq_tail;
+    unsigned int sq_mask;
+    unsigned int* sq_array;
+    struct io_uring_sqe* sqes;
+    unsigned int sq_entries;
+    unsigned int sq_local_tail;     // prepared entries not yet published
+    unsigned int* cq_head;
+    unsigned int* cq_tail;
+    unsigned int cq_mask;
+    struct io_uring_cqe* cqes;
+    void* rings;                    // both ring headers share one mapping
+    size_t rings_size;
+    size_t sqes_size;
+    unsigned long enters;           // io_uring_enter() calls made
+} uring_t;
+
+// Provided buffers: count buffers of size bytes each, registered as a group
+typedef struct {
+    struct io_uring_buf_ring* ring;
+    char* data;
+    unsigned int count;             // a power of two
+    unsigned int size;
+    int group;
+} uring_buffers_t;
+
+// Sets up a ring with room for entries submissions. Returns 0, or -errno
+// if io_uring is not available (old kernel, or disabled by policy).
+int uring_init(uring_t* ring, unsigned int entries);
+void uring_free(uring_t* ring);
+
+// A zeroed submission entry to fill in; it goes to the kernel with the
+// next uring_submit(). When the ring is full the prepared entries are
+// submitted first, so this only returns NULL if that fails.
+struct io_uring_sqe* uring_get_sqe(uring_t* ring);
+
+// Submits every prepared entry and waits until at least wait completions
+// are ready, or timeout_ms has passed (-1: no limit), with the signal mask
+// set to mask while it waits (NULL leaves it alone). Returns the number
+// submitted, or -errno (-EINTR on a signal, -ETIME on the timeout).
+int uring_submit(uring_t* ring, unsigned int wait, const sigset_t* mask, int timeout_ms);
+
+// The oldest unread completion, or NULL; uring_cqe_seen() releases it
+struct io_uring_cqe* uring_peek_cqe(uring_t* ring);
+void uring_cqe_seen(uring_t* ring);
+
+// Allocates and registers count buffers of size bytes as buffer group
+// group, all available to the kernel. Returns 0 or -errno.
+int uring_buffers_init(uring_t* ring, uring_buffers_t* buffers, int group,
+                       unsigned int count, unsigned int size);
+void uring_buffers_free(uring_t* ring, uring_buffers_t* buffers);
+
+// Start of buffer id, as reported by a completion
+char* uring_buffer(uring_buffers_t* buffers, unsigned int id);
+
+// Gives buffer id back to the kernel once its bytes have been used
+void uring_buffer_return(uring_buffers_t* buffers, unsigned int id);
+
+#endif
+
+#endif
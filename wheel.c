@@ -0,0 +1,170 @@
+/*
+ * File: wheel.c
+ * Author: [Your Name]
+ * Date: October 17, 2026
+ * Description: Hierarchical timing wheel (see wheel.h)
+ */
+
+#include <string.h>
+#include "wheel.h"
+
+#define SLOT_MASK (WHEEL_SLOTS - 1)
+#define DUE_SLOT (WHEEL_LEVELS * WHEEL_SLOTS)
+#define WHEEL_SPAN ((uint64_t)1 << (WHEEL_BITS * WHEEL_LEVELS))     // ticks the rings cover
+
+void wheel_init(timer_wheel_t* wheel, uint64_t now_ms) {
+    memset(wheel, 0, sizeof(*wheel));
+    wheel->tick = now_ms / WHEEL_TICK_MS;
+}
+
+void wheel_timer_init(wheel_timer_t* timer, int tag) {
+    memset(timer, 0, sizeof(*timer));
+    timer->tag = tag;
+}
+
+int wheel_scheduled(const wheel_timer_t* timer) {
+    return timer->pprev != NULL;
+}
+
+static void link_timer(timer_wheel_t* wheel, wheel_timer_t* timer, unsigned int slot) {
+    wheel_timer_t** head = &wheel->slots[slot];
+    timer->next = *head;
+    if (*head != NULL) (*head)->pprev = &timer->next;
+    *head = timer;
+    timer->pprev = head;
+    timer->slot = slot;
+    if (slot != DUE_SLOT) wheel->occupied[slot >> WHEEL_BITS] |= (uint64_t)1 << (slot & SLOT_MASK);
+}
+
+static void unlink_timer(timer_wheel_t* wheel, wheel_timer_t* timer) {
+    *timer->pprev = timer->next;
+    if (timer->next != NULL) timer->next->pprev = timer->pprev;
+    timer->next = NULL;
+    timer->pprev = NULL;
+    if (timer->slot != DUE_SLOT && wheel->slots[timer->slot] == NULL) {
+        wheel->occupied[timer->slot >> WHEEL_BITS] &= ~((uint64_t)1 << (timer->slot & SLOT_MASK));
+    }
+}
+
+// Files the timer in the ring whose span covers how far off it is, in the
+// slot its list will be moved down from (or fire from) on time. Timers
+// past the top ring's span wait in its furthest slot and are filed again.
+static void place_timer(timer_wheel_t* wheel, wheel_timer_t* timer) {
+    if (timer->expires <= wheel->tick) {
+        link_timer(wheel, timer, DUE_SLOT);
+        return;
+    }
+    uint64_t when = timer->expires;
+    uint64_t ahead = when - wheel->tick;
+    if (ahead >= WHEEL_SPAN) {
+        ahead = WHEEL_SPAN - 1;
+        when = wheel->tick + ahead;
+    }
+    int level = 0;
+    while (ahead >= (uint64_t)WHEEL_SLOTS << (WHEEL_BITS * level)) {
+        level++;
+    }
+    link_timer(wheel, timer, level * WHEEL_SLOTS + ((when >> (WHEEL_BITS * level)) & SLOT_MASK));
+}
+
+void wheel_schedule(timer_wheel_t* wheel, wheel_timer_t* timer, uint64_t deadline_ms) {
+    if (timer->pprev != NULL) {
+        unlink_timer(wheel, timer);
+    } else {
+        wheel->count++;
+    }
+    timer->expires = (deadline_ms + WHEEL_TICK_MS - 1) / WHEEL_TICK_MS;
+    place_timer(wheel, timer);
+}
+
+void wheel_cancel(timer_wheel_t* wheel, wheel_timer_t* timer) {
+    if (timer->pprev == NULL) return;
+    unlink_timer(wheel, timer);
+    wheel->count--;
+}
+
+// Files every timer of a slot again, now that the ring below has come
+// round to the stretch of ticks the slot stands for
+static void cascade(timer_wheel_t* wheel, unsigned int slot) {
+    wheel_timer_t* timer = wheel->slots[slot];
+    wheel->slots[slot] = NULL;
+    wheel->occupied[slot >> WHEEL_BITS] &= ~((uint64_t)1 << (slot & SLOT_MASK));
+    while (timer != NULL) {
+        wheel_timer_t* next = timer->next;
+        place_timer(wheel, timer);
+        wheel->cascaded++;
+        timer = next;
+    }
+}
+
+// Moves the clock on a tick: each ring the ones below have wrapped round
+// into moves its slot for the coming stretch down, and the timers of the
+// tick's own slot become due
+static void run_tick(timer_wheel_t* wheel) {
+    uint64_t tick = ++wheel->tick;
+    for (int level = 1; level < WHEEL_LEVELS; level++) {
+        if (tick & (((uint64_t)1 << (WHEEL_BITS * level)) - 1)) break;
+        cascade(wheel, level * WHEEL_SLOTS + ((tick >> (WHEEL_BITS * level)) & SLOT_MASK));
+    }
+    
+    unsigned int slot = tick & SLOT_MASK;
+    wheel_timer_t* timer = wheel->slots[slot];
+    wheel->slots[slot] = NULL;
+    wheel->occupied[0] &= ~((uint64_t)1 << slot);
+    while (timer != NULL) {
+        wheel_timer_t* next = timer->next;
+        link_timer(wheel, timer, DUE_SLOT);
+        timer = next;
+    }
+}
+
+wheel_timer_t* wheel_expire(timer_wheel_t* wheel, uint64_t now_ms) {
+    uint64_t target = now_ms / WHEEL_TICK_MS;
+    while (wheel->slots[DUE_SLOT] == NULL && wheel->tick < target) {
+        if (wheel->count == 0) {
+            wheel->tick = target;
+            break;
+        }
+        if (wheel->occupied[0] == 0) {
+            // Nothing happens before the first ring wraps round: skip to it
+            uint64_t last = wheel->tick | SLOT_MASK;
+            if (last > wheel->tick) {
+                wheel->tick = last < target ? last : target;
+                continue;
+            }
+        }
+        run_tick(wheel);
+    }
+    
+    wheel_timer_t* timer = wheel->slots[DUE_SLOT];
+    if (timer == NULL) return NULL;
+    unlink_timer(wheel, timer);
+    wheel->count--;
+    wheel->fired++;
+    return timer;
+}
+
+int wheel_timeout(const timer_wheel_t* wheel, uint64_t now_ms) {
+    if (wheel->slots[DUE_SLOT] != NULL) return 0;
+    if (wheel->count == 0) return -1;
+    
+    // Ticks to the next slot of the first ring with timers, or to the
+    // next turn of it if a higher ring has timers to move down then
+    uint64_t ahead = WHEEL_SLOTS;
+    uint64_t ring = wheel->occupied[0];
+    if (ring != 0) {
+        unsigned int from = (wheel->tick + 1) & SLOT_MASK;
+        uint64_t rotated = from != 0 ? (ring >> from) | (ring << (WHEEL_SLOTS - from)) : ring;
+        ahead = (uint64_t)__builtin_ctzll(rotated) + 1;
+    }
+    for (int level = 1; level < WHEEL_LEVELS; level++) {
+        if (wheel->occupied[level] != 0) {
+            uint64_t turn = WHEEL_SLOTS - (wheel->tick & SLOT_MASK);
+            if (turn < ahead) ahead = turn;
+            break;
+        }
+    }
+    
+    uint64_t wake_ms = (wheel->tick + ahead) * WHEEL_TICK_MS;
+    return wake_ms > now_ms ? (int)(wake_ms - now_ms) : 0;
+}
@@ -0,0 +1,74 @@
+/*
+ * File: wheel.h
+ * Author: [Your Name]
+ * Date: October 17, 2026
+ * Description: Hierarchical timing wheel
+ *              Timers are kept in WHEEL_LEVELS rings of WHEEL_SLOTS lists
+ *              each. The first ring has a slot per tick, the next a slot
+ *              per WHEEL_SLOTS ticks, and so on; a timer goes in the ring
+ *              whose span covers how far off it is, and its list moves
+ *              down a ring each time the ring below wraps round, until it
+ *              reaches a slot of its own tick. Scheduling and cancelling
+ *              are a list insert and unlink whatever the number of timers,
+ *              and running the wheel costs a step per tick plus one move
+ *              per timer and ring. A timer never fires before its deadline,
+ *              and at most one tick after it.
+ *
+ *              Timers are embedded in whatever they time, and the wheel
+ *              keeps no other memory. It takes no lock: each wheel belongs
+ *              to one thread, or is guarded by its owner.
+ */
+
+#ifndef WHEEL_H
+#define WHEEL_H
+
+#include <stdint.h>
+
+#define WHEEL_TICK_MS 100           // resolution
+#define WHEEL_BITS 6
+#define WHEEL_SLOTS (1 << WHEEL_BITS)
+#define WHEEL_LEVELS 4              // 2^24 ticks, 19 days; later deadlines wait at the top
+
+typedef struct wheel_timer {
+    struct wheel_timer* next;
+    struct wheel_timer** pprev;     // NULL while not scheduled
+    uint64_t expires;               // tick it is due at
+    unsigned int slot;              // list it is on
+    int tag;                        // left to the owner: what the timer is for
+} wheel_timer_t;
+
+typedef struct {
+    wheel_timer_t* slots[WHEEL_LEVELS * WHEEL_SLOTS + 1];  // the last holds timers already due
+    uint64_t occupied[WHEEL_LEVELS];    // a bit per slot that has timers
+    uint64_t tick;                  // every timer up to this tick is due
+    unsigned long count;            // scheduled, due ones included
+    unsigned long fired;
+    unsigned long cascaded;         // moves down a ring
+} timer_wheel_t;
+
+// A wheel whose clock starts at now_ms (any monotonic milliseconds)
+void wheel_init(timer_wheel_t* wheel, uint64_t now_ms);
+
+// A timer not scheduled anywhere, tagged for its owner
+void wheel_timer_init(wheel_timer_t* timer, int tag);
+
+int wheel_scheduled(const wheel_timer_t* timer);
+
+// Sets the timer to fire once deadline_ms has passed, moving it if it was
+// already scheduled. A deadline already past fires on the next run.
+void wheel_schedule(timer_wheel_t* wheel, wheel_timer_t* timer, uint64_t deadline_ms);
+
+// Unschedules the timer if it is scheduled
+void wheel_cancel(timer_wheel_t* wheel, wheel_timer_t* timer);
+
+// Takes the next timer due by now_ms off the wheel, or returns NULL when
+// none is. Call until it does: a timer may be scheduled again, and others
+// scheduled or cancelled, between calls.
+wheel_timer_t* wheel_expire(timer_wheel_t* wheel, uint64_t now_ms);
+
+// Milliseconds from now_ms until the wheel should next be run, 0 if a
+// timer is due, or -1 if nothing is scheduled. Never later than the next
+// deadline, and no more than a turn of the first ring away.
+int wheel_timeout(const timer_wheel_t* wheel, uint64_t now_ms);
+
+#endif